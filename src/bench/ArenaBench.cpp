@@ -0,0 +1,114 @@
+#include "Bench.hpp"
+#include "../engine/scene/Scene.hpp"
+#include "../engine/util/Profiler.hpp"
+
+#include <stdio.h>
+#include <sys/resource.h>
+
+static constexpr uint32_t MESH_COUNT = 4000;
+static constexpr uint32_t VERTEX_COUNT = 1000; /* per mesh, about 200 MiB with the indices */
+static constexpr uint32_t CULL_PASS_COUNT = 10;
+static constexpr uint32_t MESH_STRIDE = 1543; /* prime, so a pass visits every mesh out of allocation order */
+
+static uint64_t get_page_faults();
+
+static int run_arena(
+    uint32_t 				arena_flags
+    );
+
+static void fill_mesh(
+    me::Mesh* 				mesh
+    );
+
+static uint32_t cull_meshes(
+    me::Scene 				&scene
+    );
+
+
+int me::bench::arena(int argc, char** argv)
+{
+  /* the same code with only the page size changing, explicit huge pages fall back if the pool is empty */
+  run_arena(ARENA_NORMAL_PAGES_FLAG);
+  run_arena(0);
+  run_arena(ARENA_HUGETLB_FLAG);
+  return 0;
+}
+
+
+uint64_t get_page_faults()
+{
+  rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_minflt + usage.ru_majflt;
+}
+
+int run_arena(
+    uint32_t 				arena_flags
+    )
+{
+  me::Scene scene(me::Scene::DEFAULT_ARENA_SIZE, arena_flags);
+
+  /* the meshes are built the way a loader does, a vertex at a time */
+  uint64_t faults = get_page_faults();
+  uint64_t start = me::Profiler::get_time();
+  for (uint32_t i = 0; i < MESH_COUNT; i++)
+  {
+    me::MeshItem* mesh_item = scene.arena.allocate<me::MeshItem>();
+    mesh_item->mesh = scene.arena.allocate<me::Mesh>(&scene.arena);
+    mesh_item->flags = me::MESH_VISIBLE_FLAG | me::MESH_ARENA_FLAG;
+    fill_mesh(mesh_item->mesh);
+    scene.meshes.push_back(mesh_item);
+  }
+  double build_milliseconds = static_cast<double>(me::Profiler::get_time() - start) / 1000000.0;
+  uint64_t build_faults = get_page_faults() - faults;
+
+  /* reading every vertex is where the page size shows up as tlb misses */
+  uint32_t visible_count = 0;
+  start = me::Profiler::get_time();
+  for (uint32_t i = 0; i < CULL_PASS_COUNT; i++)
+    visible_count += cull_meshes(scene);
+  double cull_milliseconds = static_cast<double>(me::Profiler::get_time() - start) / 1000000.0 / CULL_PASS_COUNT;
+
+  printf("%s: build %.3f ms, %lu page faults, %lu MiB used, cull pass %.3f ms (%u visible)\n",
+      me::arena_page_type_name(scene.arena.get_page_type()), build_milliseconds, build_faults,
+      scene.arena.get_used() / (1024 * 1024), cull_milliseconds, visible_count / CULL_PASS_COUNT);
+  return 0;
+}
+
+void fill_mesh(
+    me::Mesh* 				mesh
+    )
+{
+  for (uint32_t i = 0; i < VERTEX_COUNT; i++)
+  {
+    float x = static_cast<float>(i);
+    mesh->vertices.push_back({{x, x, x}, {0.0F, 0.0F, 1.0F}, {0.0F, 0.0F}, {1.0F, 1.0F, 1.0F, 1.0F}});
+  }
+  for (uint32_t i = 0; i < VERTEX_COUNT; i++)
+    mesh->indices.push_back({i});
+}
+
+uint32_t cull_meshes(
+    me::Scene 				&scene
+    )
+{
+  /* bounds of the indexed vertices against a fixed box, like a cpu frustum cull without precomputed bounds */
+  uint32_t visible_count = 0;
+  for (uint32_t i = 0; i < MESH_COUNT; i++)
+  {
+    const me::Mesh* mesh = scene.meshes[(i * MESH_STRIDE) % MESH_COUNT]->mesh;
+    float min = mesh->vertices[0].position[0], max = min;
+    for (size_t j = 0; j < mesh->indices.size(); j++)
+    {
+      const me::Vertex &vertex = mesh->vertices[mesh->indices[j].index];
+      for (uint8_t k = 0; k < 3; k++)
+      {
+	min = vertex.position[k] < min ? vertex.position[k] : min;
+	max = vertex.position[k] > max ? vertex.position[k] : max;
+      }
+    }
+    if (max >= 0.0F && min <= static_cast<float>(VERTEX_COUNT / 2))
+      visible_count++;
+  }
+  return visible_count;
+}
@@ -0,0 +1,50 @@
+#ifndef ME_BENCH_HPP
+  #define ME_BENCH_HPP
+
+#include "../engine/renderer/Renderer.hpp"
+
+#include <stdint.h>
+
+namespace me::bench {
+
+  /* a device without a surface, so the cases run on machines without a display, like lavapipe on ci */
+  struct BenchDevice {
+    RendererModule* renderer;
+    EngineInfo engine_info;
+    PhysicalDevice physical_device;
+    Device device;
+    Queue graphics_queue;
+    Queue transfer_queue;
+    CommandPool transfer_command_pool;
+  };
+
+  int create_bench_device(
+      const char* 				pipeline_cache_path, /* optional */
+      BenchDevice 				&bench_device
+      );
+
+  int cleanup_bench_device(
+      BenchDevice 				&bench_device
+      );
+
+  /* every case prints its results to stdout and returns non-zero if it failed */
+  typedef int (*BenchFunction)(int argc, char** argv);
+
+  struct BenchCase {
+    const char* name;
+    const char* description;
+    BenchFunction function;
+  };
+
+  int arena(int argc, char** argv);
+  int defragment(int argc, char** argv);
+  int draw_list(int argc, char** argv);
+  int indirect(int argc, char** argv);
+  int memory(int argc, char** argv);
+  int mesh_upload(int argc, char** argv);
+  int pipeline_cache(int argc, char** argv);
+  int residency(int argc, char** argv);
+
+}
+
+#endif
@@ -0,0 +1,91 @@
+#include "Bench.hpp"
+#include "../engine/renderer/vulkan/Vulkan.hpp"
+
+static int create_queue(
+    me::RendererModule* 			renderer,
+    me::Device 					device,
+    me::QueueType 				queue_type,
+    me::Queue 					&queue
+    );
+
+
+int me::bench::create_bench_device(
+    const char* 				pipeline_cache_path,
+    BenchDevice 				&bench_device
+    )
+{
+  bench_device.renderer = new Vulkan;
+  bench_device.engine_info.application_info.name = "MurderEngineBench";
+  bench_device.engine_info.application_info.version = 1;
+
+  /* no surface, so no instance extensions */
+  EngineInitInfo engine_init_info = {};
+  engine_init_info.engine_info = &bench_device.engine_info;
+  engine_init_info.alloc = allocator();
+  engine_init_info.extension_count = 0;
+  engine_init_info.extensions = nullptr;
+  engine_init_info.debug = false;
+  bench_device.renderer->init_engine(engine_init_info);
+
+  uint32_t physical_device_count;
+  bench_device.renderer->enumerate_physical_devices(physical_device_count, nullptr);
+  if (physical_device_count == 0)
+    throw exception("no vulkan device to run on");
+  PhysicalDevice physical_devices[physical_device_count];
+  bench_device.renderer->enumerate_physical_devices(physical_device_count, physical_devices);
+  bench_device.physical_device = physical_devices[0];
+
+  DeviceCreateInfo device_create_info = {};
+  device_create_info.type = STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+  device_create_info.next = nullptr;
+  device_create_info.surface = nullptr;
+  device_create_info.physical_device_count = 1;
+  device_create_info.physical_devices = &bench_device.physical_device;
+  device_create_info.frame_count = 2;
+  device_create_info.thread_count = 1;
+  device_create_info.pipeline_cache_path = pipeline_cache_path;
+  device_create_info.pipeline_thread_count = 1;
+  device_create_info.profiler = nullptr;
+  bench_device.renderer->create_device(device_create_info, bench_device.device);
+
+  create_queue(bench_device.renderer, bench_device.device, QUEUE_GRAPHICS_TYPE, bench_device.graphics_queue);
+  create_queue(bench_device.renderer, bench_device.device, QUEUE_TRANSFER_TYPE, bench_device.transfer_queue);
+
+  CommandPoolCreateInfo command_pool_create_info = {};
+  command_pool_create_info.type = STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+  command_pool_create_info.next = nullptr;
+  command_pool_create_info.device = bench_device.device;
+  command_pool_create_info.queue = bench_device.transfer_queue;
+  command_pool_create_info.transient = false;
+  command_pool_create_info.resettable = false;
+  bench_device.renderer->create_command_pool(command_pool_create_info, bench_device.transfer_command_pool);
+  return 0;
+}
+
+int me::bench::cleanup_bench_device(
+    BenchDevice 				&bench_device
+    )
+{
+  bench_device.renderer->cleanup_command_pool(bench_device.device, bench_device.transfer_command_pool);
+  bench_device.renderer->cleanup_device(bench_device.device);
+  bench_device.renderer->terminate_engine();
+  delete bench_device.renderer;
+  return 0;
+}
+
+
+int create_queue(
+    me::RendererModule* 			renderer,
+    me::Device 					device,
+    me::QueueType 				queue_type,
+    me::Queue 					&queue
+    )
+{
+  me::QueueCreateInfo queue_create_info = {};
+  queue_create_info.type = me::STRUCTURE_TYPE_QUEUE_CREATE_INFO;
+  queue_create_info.next = nullptr;
+  queue_create_info.device = device;
+  queue_create_info.queue_type = queue_type;
+  renderer->create_queue(queue_create_info, queue);
+  return 0;
+}
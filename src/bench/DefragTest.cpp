@@ -0,0 +1,215 @@
+#include "Bench.hpp"
+#include "../engine/renderer/vulkan/Vulkan.hpp"
+#include "../engine/renderer/vulkan/Memory.hpp"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static constexpr uint32_t FRAME_COUNT = 2;
+static constexpr uint32_t BUFFER_COUNT = 96; /* more than one 64 MiB block */
+static constexpr size_t BUFFER_SIZE = 1024 * 1024;
+static constexpr uint32_t KEPT_STRIDE = 8; /* every 8th buffer stays, the blocks end up mostly empty */
+static constexpr uint32_t DEFRAGMENT_FRAME_COUNT = 8;
+
+static int render_frame(
+    me::bench::BenchDevice 			&bench_device,
+    me::Frame* 					frames,
+    uint64_t 					frame_number,
+    uint32_t 					&moved_count
+    );
+
+static bool read_buffer(
+    me::bench::BenchDevice 			&bench_device,
+    me::CommandPool 				graphics_command_pool,
+    me::Buffer 					buffer,
+    uint32_t 					index,
+    uint32_t* 					words
+    );
+
+
+int me::bench::defragment(int argc, char** argv)
+{
+  BenchDevice bench_device;
+  create_bench_device(nullptr, bench_device);
+  RendererModule* renderer = bench_device.renderer;
+
+  Frame frames[FRAME_COUNT];
+  FrameCreateInfo frame_create_info = {};
+  frame_create_info.type = STRUCTURE_TYPE_FRAME_CREATE_INFO;
+  frame_create_info.next = nullptr;
+  frame_create_info.device = bench_device.device;
+  renderer->create_frames(frame_create_info, FRAME_COUNT, frames);
+
+  /* staging buffers are device local and registered with the defragmenter, every one gets its own pattern */
+  static constexpr size_t word_count = BUFFER_SIZE / sizeof(uint32_t);
+  uint32_t* words = static_cast<uint32_t*>(malloc(BUFFER_SIZE));
+  Buffer buffers[BUFFER_COUNT];
+  for (uint32_t i = 0; i < BUFFER_COUNT; i++)
+  {
+    BufferCreateInfo buffer_create_info = {};
+    buffer_create_info.type = STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    buffer_create_info.next = nullptr;
+    buffer_create_info.physical_device = bench_device.physical_device;
+    buffer_create_info.device = bench_device.device;
+    buffer_create_info.usage = BUFFER_USAGE_VERTEX_BUFFER;
+    buffer_create_info.write_method = BUFFER_WRITE_METHOD_STAGING;
+    buffer_create_info.size = BUFFER_SIZE;
+    renderer->create_buffer(buffer_create_info, buffers[i]);
+
+    for (size_t j = 0; j < word_count; j++)
+      words[j] = static_cast<uint32_t>(i * word_count + j);
+
+    BufferWriteInfo buffer_write_info = {};
+    buffer_write_info.physical_device = bench_device.physical_device;
+    buffer_write_info.device = bench_device.device;
+    buffer_write_info.byte_count = BUFFER_SIZE;
+    buffer_write_info.bytes = words;
+    renderer->buffer_write(buffer_write_info, buffers[i]);
+  }
+
+  for (uint32_t i = 0; i < BUFFER_COUNT; i++)
+  {
+    if (i % KEPT_STRIDE != 0)
+      renderer->cleanup_buffer(bench_device.device, buffers[i]);
+  }
+
+  /* the moves are copies on the graphics queue, so they run with the frames */
+  uint32_t moved_count = 0;
+  uint64_t frame_number = 0;
+  for (; frame_number < DEFRAGMENT_FRAME_COUNT; frame_number++)
+  {
+    uint32_t frame_moved_count;
+    render_frame(bench_device, frames, frame_number, frame_moved_count);
+    moved_count += frame_moved_count;
+  }
+
+  /* preparing every frame once more waits for all of them */
+  for (uint32_t i = 0; i < FRAME_COUNT; i++)
+  {
+    FramePrepareInfo frame_prepare_info = {};
+    frame_prepare_info.device = bench_device.device;
+    frame_prepare_info.swapchain = nullptr;
+    frame_prepare_info.frame = frames[i];
+    frame_prepare_info.frame_index = i;
+
+    FramePrepared frame_prepared;
+    renderer->frame_prepare(frame_prepare_info, frame_prepared);
+  }
+
+  CommandPoolCreateInfo command_pool_create_info = {};
+  command_pool_create_info.type = STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+  command_pool_create_info.next = nullptr;
+  command_pool_create_info.device = bench_device.device;
+  command_pool_create_info.queue = bench_device.graphics_queue;
+  command_pool_create_info.transient = true;
+  command_pool_create_info.resettable = false;
+  CommandPool graphics_command_pool;
+  renderer->create_command_pool(command_pool_create_info, graphics_command_pool);
+
+  /* a moved buffer must still be a copy source for the next move and keep what was written to it */
+  int failures = 0;
+  if (moved_count == 0)
+  {
+    printf("no staging buffer was moved\n");
+    failures++;
+  }
+  for (uint32_t i = 0; i < BUFFER_COUNT; i += KEPT_STRIDE)
+  {
+    if (!(reinterpret_cast<Buffer_T*>(buffers[i])->vk_usage & VK_BUFFER_USAGE_TRANSFER_SRC_BIT))
+    {
+      printf("buffer %u can't be a copy source\n", i);
+      failures++;
+    }
+
+    if (!read_buffer(bench_device, graphics_command_pool, buffers[i], i, words))
+    {
+      printf("buffer %u lost its contents\n", i);
+      failures++;
+    }
+  }
+
+  printf("%u staging buffers moved in %u frames, %d failures\n", moved_count, DEFRAGMENT_FRAME_COUNT, failures);
+
+  for (uint32_t i = 0; i < BUFFER_COUNT; i += KEPT_STRIDE)
+    renderer->cleanup_buffer(bench_device.device, buffers[i]);
+  free(words);
+  renderer->cleanup_command_pool(bench_device.device, graphics_command_pool);
+  renderer->cleanup_frames(bench_device.device, FRAME_COUNT, frames);
+  cleanup_bench_device(bench_device);
+  return failures > 0 ? 1 : 0;
+}
+
+
+int render_frame(
+    me::bench::BenchDevice 			&bench_device,
+    me::Frame* 					frames,
+    uint64_t 					frame_number,
+    uint32_t 					&moved_count
+    )
+{
+  me::RendererModule* renderer = bench_device.renderer;
+  uint32_t frame_index = frame_number % FRAME_COUNT;
+
+  me::FramePrepareInfo frame_prepare_info = {};
+  frame_prepare_info.device = bench_device.device;
+  frame_prepare_info.swapchain = nullptr;
+  frame_prepare_info.frame = frames[frame_index];
+  frame_prepare_info.frame_index = frame_index;
+
+  me::FramePrepared frame_prepared;
+  renderer->frame_prepare(frame_prepare_info, frame_prepared);
+
+  renderer->defragment(bench_device.device, BUFFER_COUNT * BUFFER_SIZE, moved_count);
+
+  /* nothing is drawn, the submit only carries the uploads and copies */
+  me::FrameRenderInfo frame_render_info = {};
+  frame_render_info.device = bench_device.device;
+  frame_render_info.queue = bench_device.graphics_queue;
+  frame_render_info.prepared = frame_prepared;
+  frame_render_info.image = nullptr;
+  frame_render_info.frame = frames[frame_index];
+  frame_render_info.image_index = 0;
+  frame_render_info.frame_index = frame_index;
+  frame_render_info.command_buffer_count = 0;
+  frame_render_info.command_buffers = nullptr;
+
+  me::FrameRendered frame_rendered;
+  renderer->frame_render(frame_render_info, frame_rendered);
+  return 0;
+}
+
+bool read_buffer(
+    me::bench::BenchDevice 			&bench_device,
+    me::CommandPool 				graphics_command_pool,
+    me::Buffer 					buffer,
+    uint32_t 					index,
+    uint32_t* 					words
+    )
+{
+  /* there is no readback of buffers in the renderer, so this goes through the backend */
+  me::Device_T* device = reinterpret_cast<me::Device_T*>(bench_device.device);
+  me::Buffer_T* source = reinterpret_cast<me::Buffer_T*>(buffer);
+
+  VkBuffer vk_buffer;
+  me::memory::Allocation allocation;
+  me::memory::create_buffer(*device->memory_allocator, device->vk_device, source->size,
+      VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_SHARING_MODE_EXCLUSIVE,
+      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, vk_buffer, allocation);
+
+  /* the moves were recorded on the graphics queue, which owns the buffers now */
+  me::memory::copy_buffer(device->vk_device, reinterpret_cast<me::CommandPool_T*>(graphics_command_pool)->vk_command_pool,
+      reinterpret_cast<me::Queue_T*>(bench_device.graphics_queue)->vk_queue, source->size, source->vk_buffer, 0, vk_buffer, VK_NULL_HANDLE);
+
+  void* data;
+  device->memory_allocator->map(allocation, data);
+
+  /* the pattern the buffer was written with */
+  size_t word_count = source->size / sizeof(uint32_t);
+  for (size_t i = 0; i < word_count; i++)
+    words[i] = static_cast<uint32_t>(index * word_count + i);
+  bool same = memcmp(data, words, source->size) == 0;
+
+  me::memory::destroy_buffer(*device->memory_allocator, device->vk_device, vk_buffer, allocation);
+  return same;
+}
@@ -0,0 +1,98 @@
+#include "Bench.hpp"
+#include "../engine/renderer/DrawList.hpp"
+#include "../engine/util/Profiler.hpp"
+
+#include <stdio.h>
+
+static constexpr uint32_t PIPELINE_COUNT = 4;
+static constexpr uint32_t DESCRIPTOR_COUNT = 16;
+static constexpr uint32_t MATERIAL_COUNT = 64; /* every material has its pipeline and descriptor */
+static constexpr uint32_t MESH_COUNT = 256;
+static constexpr uint32_t DRAW_COUNT = 10000;
+static constexpr uint32_t SORT_COUNT = 20;
+
+/* stand-ins for the states, the draw list only compares their addresses */
+static char pipelines[PIPELINE_COUNT];
+static char descriptors[DESCRIPTOR_COUNT];
+static char materials[MATERIAL_COUNT];
+static char meshes[MESH_COUNT];
+
+static uint32_t next_random(
+    uint32_t 					&state
+    );
+
+static int add_draws(
+    me::DrawList 				&draw_list
+    );
+
+
+int me::bench::draw_list(int argc, char** argv)
+{
+  DrawList draw_list;
+
+  /* the same draws every time, so the sorts are comparable */
+  uint64_t sort_time = 0;
+  for (uint32_t i = 0; i < SORT_COUNT; i++)
+  {
+    draw_list.clear();
+    add_draws(draw_list);
+
+    uint64_t start = Profiler::get_time();
+    draw_list.sort();
+    sort_time += Profiler::get_time() - start;
+  }
+  double sort_milliseconds = static_cast<double>(sort_time) / 1000000.0 / SORT_COUNT;
+
+  const DrawListStats &stats = draw_list.get_stats();
+  printf("%u draws of %u materials and %u meshes, sorted in %.3f ms\n", stats.draw_count, MATERIAL_COUNT, MESH_COUNT, sort_milliseconds);
+  printf("submission order: %u pipeline, %u descriptor and %u vertex buffer binds (%u with a buffer per mesh)\n",
+      stats.unsorted_pipeline_binds, stats.unsorted_descriptor_binds, 1U, stats.unsorted_mesh_changes);
+  printf("sorted: %u pipeline, %u descriptor and %u vertex buffer binds (%u with a buffer per mesh)\n",
+      stats.sorted_pipeline_binds, stats.sorted_descriptor_binds, 1U, stats.sorted_mesh_changes);
+
+  /* sorted, every pipeline and every descriptor of a pipeline is bound once */
+  int failures = 0;
+  if (stats.sorted_pipeline_binds != PIPELINE_COUNT || stats.sorted_descriptor_binds != DESCRIPTOR_COUNT)
+  {
+    printf("expected %u pipeline and %u descriptor binds after sorting\n", PIPELINE_COUNT, DESCRIPTOR_COUNT);
+    failures++;
+  }
+  if (stats.sorted_mesh_changes > stats.unsorted_mesh_changes)
+  {
+    printf("sorting changed meshes more often\n");
+    failures++;
+  }
+  return failures > 0 ? 1 : 0;
+}
+
+
+uint32_t next_random(
+    uint32_t 					&state
+    )
+{
+  state = state * 1664525 + 1013904223;
+  return state >> 8;
+}
+
+int add_draws(
+    me::DrawList 				&draw_list
+    )
+{
+  /* in random order, like items added as a scene is walked */
+  uint32_t random = 1;
+  for (uint32_t i = 0; i < DRAW_COUNT; i++)
+  {
+    uint32_t material = next_random(random) % MATERIAL_COUNT;
+    uint32_t mesh = next_random(random) % MESH_COUNT;
+
+    me::DrawItem draw;
+    draw.pipeline = &pipelines[material % PIPELINE_COUNT];
+    draw.descriptor = &descriptors[material % DESCRIPTOR_COUNT];
+    draw.material = reinterpret_cast<me::Material*>(&materials[material]);
+    draw.mesh = reinterpret_cast<me::Mesh*>(&meshes[mesh]);
+    draw.first_instance = i;
+    draw.instance_count = 1;
+    draw_list.add(draw);
+  }
+  return 0;
+}
@@ -0,0 +1,323 @@
+#include "Bench.hpp"
+#include "../engine/renderer/Shader.hpp"
+#include "../engine/scene/Mesh.hpp"
+#include "../engine/renderer/vulkan/Vulkan.hpp"
+#include "../engine/renderer/vulkan/Memory.hpp"
+
+#include <lme/file.hpp>
+
+#include <stdio.h>
+#include <string.h>
+
+static constexpr uint32_t FRAME_COUNT = 2;
+static constexpr uint32_t MESH_COUNT = 64;
+static constexpr uint32_t VERTEX_COUNT = 1000; /* the meshes almost fill the smallest geometry pool */
+static constexpr uint32_t INDEX_COUNT = 4000;
+static constexpr uint32_t KEPT_STRIDE = 2; /* every other mesh stays, which leaves the pool fragmented */
+static constexpr uint32_t OBJECT_COUNT = 4096;
+
+static int render_frame(
+    me::bench::BenchDevice 			&bench_device,
+    me::Frame* 					frames,
+    uint64_t 					frame_number,
+    uint32_t 					command_buffer_count,
+    me::CommandBuffer* 				command_buffers
+    );
+
+static int read_buffer(
+    me::bench::BenchDevice 			&bench_device,
+    me::CommandPool 				graphics_command_pool,
+    VkBuffer 					buffer,
+    VkDeviceSize 				size,
+    void* 					data
+    );
+
+
+int me::bench::indirect(int argc, char** argv)
+{
+  BenchDevice bench_device;
+  create_bench_device(nullptr, bench_device);
+  RendererModule* renderer = bench_device.renderer;
+
+  /* the shader of the game, so it runs from the repository root like the game */
+  size_t cull_shader_len;
+  char* cull_shader_data;
+  File::read(File("src/res/cull.spv"), cull_shader_len, cull_shader_data);
+
+  ShaderConfig shader_config = {};
+  shader_config.entry_point = "main";
+  Shader* cull_shader = new Shader(SHADER_TYPE_COMPUTE, {cull_shader_len, cull_shader_data}, shader_config);
+
+  Frame frames[FRAME_COUNT];
+  FrameCreateInfo frame_create_info = {};
+  frame_create_info.type = STRUCTURE_TYPE_FRAME_CREATE_INFO;
+  frame_create_info.next = nullptr;
+  frame_create_info.device = bench_device.device;
+  renderer->create_frames(frame_create_info, FRAME_COUNT, frames);
+
+  IndirectDrawListCreateInfo indirect_draw_list_create_info = {};
+  indirect_draw_list_create_info.type = STRUCTURE_TYPE_INDIRECT_DRAW_LIST_CREATE_INFO;
+  indirect_draw_list_create_info.next = nullptr;
+  indirect_draw_list_create_info.device = bench_device.device;
+  indirect_draw_list_create_info.frame_count = FRAME_COUNT;
+  indirect_draw_list_create_info.capacity = OBJECT_COUNT;
+  indirect_draw_list_create_info.cull_shader = cull_shader;
+  IndirectDrawList draw_list;
+  renderer->create_indirect_draw_list(indirect_draw_list_create_info, draw_list);
+
+  Mesh* meshes[MESH_COUNT];
+  for (uint32_t i = 0; i < MESH_COUNT; i++)
+  {
+    meshes[i] = new Mesh;
+    for (uint32_t j = 0; j < VERTEX_COUNT; j++)
+    {
+      float x = static_cast<float>(j);
+      meshes[i]->vertices.push_back({{x, x, x}, {0.0F, 0.0F, 1.0F}, {0.0F, 0.0F}, {1.0F, 1.0F, 1.0F, 1.0F}});
+    }
+    for (uint32_t j = 0; j < INDEX_COUNT; j++)
+      meshes[i]->indices.push_back({j % VERTEX_COUNT});
+  }
+
+  SetupMeshInfo setup_mesh_info = {};
+  setup_mesh_info.physical_device = bench_device.physical_device;
+  setup_mesh_info.device = bench_device.device;
+  setup_mesh_info.transfer_queue = bench_device.transfer_queue;
+  setup_mesh_info.transfer_command_pool = bench_device.transfer_command_pool;
+  renderer->setup_meshes(setup_mesh_info, MESH_COUNT, meshes);
+
+  /* the ranges of the removed meshes are free once the frames that could draw them have finished */
+  for (uint32_t i = 0; i < MESH_COUNT; i++)
+  {
+    if (i % KEPT_STRIDE != 0)
+    {
+      renderer->cleanup_mesh(bench_device.device, meshes[i]);
+      delete meshes[i];
+      meshes[i] = nullptr;
+    }
+  }
+  uint64_t frame_number = 0;
+  for (; frame_number <= FRAME_COUNT; frame_number++)
+    render_frame(bench_device, frames, frame_number, 0, nullptr);
+
+  /* objects cycle through the kept meshes, the even ones are inside the frustum */
+  static constexpr uint32_t kept_count = MESH_COUNT / KEPT_STRIDE;
+  Mesh* object_meshes[OBJECT_COUNT];
+  math::vec4f object_bounds[OBJECT_COUNT];
+  for (uint32_t i = 0; i < OBJECT_COUNT; i++)
+  {
+    object_meshes[i] = meshes[(i % kept_count) * KEPT_STRIDE];
+    object_bounds[i] = {i % 2 == 0 ? 0.0F : 10.0F, 0.0F, 0.0F, 0.5F};
+  }
+
+  uint32_t frame_index = frame_number % FRAME_COUNT;
+  FramePrepareInfo frame_prepare_info = {};
+  frame_prepare_info.device = bench_device.device;
+  frame_prepare_info.swapchain = nullptr;
+  frame_prepare_info.frame = frames[frame_index];
+  frame_prepare_info.frame_index = frame_index;
+
+  FramePrepared frame_prepared;
+  renderer->frame_prepare(frame_prepare_info, frame_prepared);
+
+  IndirectDrawListWriteInfo indirect_draw_list_write_info = {};
+  indirect_draw_list_write_info.device = bench_device.device;
+  indirect_draw_list_write_info.frame_index = frame_index;
+  indirect_draw_list_write_info.object_count = OBJECT_COUNT;
+  indirect_draw_list_write_info.meshes = object_meshes;
+  indirect_draw_list_write_info.bounds = object_bounds;
+  renderer->indirect_draw_list_write(indirect_draw_list_write_info, draw_list);
+
+  /* packing the pool after the write moves the ranges the objects were written with */
+  uint32_t first_indices[MESH_COUNT];
+  for (uint32_t i = 0; i < MESH_COUNT; i += KEPT_STRIDE)
+    first_indices[i] = meshes[i]->first_index;
+
+  uint32_t moved_count;
+  renderer->defragment(bench_device.device, MESH_COUNT * (VERTEX_COUNT * sizeof(Vertex) + INDEX_COUNT * sizeof(Index)), moved_count);
+
+  uint32_t moved_mesh_count = 0;
+  for (uint32_t i = 0; i < MESH_COUNT; i += KEPT_STRIDE)
+    moved_mesh_count += meshes[i]->first_index != first_indices[i] ? 1 : 0;
+
+  CommandBufferCreateInfo command_buffer_create_info = {};
+  command_buffer_create_info.type = STRUCTURE_TYPE_COMMAND_BUFFER_CREATE_INFO;
+  command_buffer_create_info.next = nullptr;
+  command_buffer_create_info.device = bench_device.device;
+  command_buffer_create_info.command_pool = nullptr;
+  command_buffer_create_info.usage = COMMAND_BUFFER_USAGE_RENDERING;
+  command_buffer_create_info.thread_index = 0;
+  command_buffer_create_info.secondary = false;
+
+  CommandBuffer command_buffer;
+  renderer->create_command_buffers(command_buffer_create_info, 1, &command_buffer);
+  renderer->cmd_record_start(command_buffer);
+
+  /* a unit cube */
+  CmdCullIndirectInfo cmd_cull_indirect_info = {};
+  cmd_cull_indirect_info.device = bench_device.device;
+  cmd_cull_indirect_info.draw_list = draw_list;
+  cmd_cull_indirect_info.frustum_planes[0] = {1.0F, 0.0F, 0.0F, 1.0F};
+  cmd_cull_indirect_info.frustum_planes[1] = {-1.0F, 0.0F, 0.0F, 1.0F};
+  cmd_cull_indirect_info.frustum_planes[2] = {0.0F, 1.0F, 0.0F, 1.0F};
+  cmd_cull_indirect_info.frustum_planes[3] = {0.0F, -1.0F, 0.0F, 1.0F};
+  cmd_cull_indirect_info.frustum_planes[4] = {0.0F, 0.0F, 1.0F, 1.0F};
+  cmd_cull_indirect_info.frustum_planes[5] = {0.0F, 0.0F, -1.0F, 1.0F};
+  renderer->cmd_cull_indirect(cmd_cull_indirect_info, command_buffer);
+  renderer->cmd_record_stop(command_buffer);
+
+  FrameRenderInfo frame_render_info = {};
+  frame_render_info.device = bench_device.device;
+  frame_render_info.queue = bench_device.graphics_queue;
+  frame_render_info.prepared = frame_prepared;
+  frame_render_info.image = nullptr;
+  frame_render_info.frame = frames[frame_index];
+  frame_render_info.image_index = 0;
+  frame_render_info.frame_index = frame_index;
+  frame_render_info.command_buffer_count = 1;
+  frame_render_info.command_buffers = &command_buffer;
+
+  FrameRendered frame_rendered;
+  renderer->frame_render(frame_render_info, frame_rendered);
+
+  /* preparing every frame once more waits for all of them */
+  for (uint32_t i = 0; i < FRAME_COUNT; i++)
+  {
+    frame_prepare_info.frame = frames[i];
+    frame_prepare_info.frame_index = i;
+    renderer->frame_prepare(frame_prepare_info, frame_prepared);
+  }
+
+  CommandPoolCreateInfo command_pool_create_info = {};
+  command_pool_create_info.type = STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+  command_pool_create_info.next = nullptr;
+  command_pool_create_info.device = bench_device.device;
+  command_pool_create_info.queue = bench_device.graphics_queue;
+  command_pool_create_info.transient = true;
+  command_pool_create_info.resettable = false;
+  CommandPool graphics_command_pool;
+  renderer->create_command_pool(command_pool_create_info, graphics_command_pool);
+
+  /* the commands and the count never leave the device, so they are read through the backend */
+  const Device_T* device = reinterpret_cast<Device_T*>(bench_device.device);
+  const IndirectDrawList_T* list = reinterpret_cast<IndirectDrawList_T*>(draw_list);
+  VkDrawIndexedIndirectCommand* commands = new VkDrawIndexedIndirectCommand[OBJECT_COUNT];
+  read_buffer(bench_device, graphics_command_pool, list->vk_command_buffer, OBJECT_COUNT * sizeof(VkDrawIndexedIndirectCommand), commands);
+
+  /* packed commands are counted on the device, otherwise every object has its slot and culled ones draw nothing */
+  bool compact = device->draw_indirect_count && device->multi_draw_indirect;
+  uint32_t command_count = OBJECT_COUNT;
+  if (compact)
+    read_buffer(bench_device, graphics_command_pool, list->vk_count_buffer, sizeof(uint32_t), &command_count);
+
+  int failures = 0;
+  uint32_t visible_count = 0, stale_count = 0;
+  for (uint32_t i = 0; i < command_count; i++)
+  {
+    const VkDrawIndexedIndirectCommand &command = commands[i];
+    if (command.instanceCount == 0)
+      continue;
+    visible_count++;
+
+    const Mesh* mesh = command.firstInstance < OBJECT_COUNT ? object_meshes[command.firstInstance] : nullptr;
+    if (mesh == nullptr || command.firstInstance % 2 != 0)
+    {
+      printf("command %u draws object %u, which is outside the frustum\n", i, command.firstInstance);
+      failures++;
+    }else if (command.firstIndex != mesh->first_index || command.vertexOffset != static_cast<int32_t>(mesh->vertex_offset) ||
+	command.indexCount != mesh->index_count)
+      stale_count++;
+  }
+
+  printf("%u objects, %u visible, %u of %u meshes moved after the write, %u commands with stale ranges\n",
+      OBJECT_COUNT, visible_count, moved_mesh_count, kept_count, stale_count);
+
+  if (moved_mesh_count == 0)
+  {
+    printf("the geometry pool wasn't packed\n");
+    failures++;
+  }
+  if (visible_count != OBJECT_COUNT / 2)
+  {
+    printf("expected %u visible objects\n", OBJECT_COUNT / 2);
+    failures++;
+  }
+  if (stale_count > 0)
+    failures++;
+
+  delete[] commands;
+  for (uint32_t i = 0; i < MESH_COUNT; i += KEPT_STRIDE)
+  {
+    renderer->cleanup_mesh(bench_device.device, meshes[i]);
+    delete meshes[i];
+  }
+  renderer->cleanup_command_pool(bench_device.device, graphics_command_pool);
+  renderer->cleanup_indirect_draw_list(bench_device.device, draw_list);
+  renderer->cleanup_frames(bench_device.device, FRAME_COUNT, frames);
+  delete cull_shader;
+  cleanup_bench_device(bench_device);
+  return failures > 0 ? 1 : 0;
+}
+
+
+int render_frame(
+    me::bench::BenchDevice 			&bench_device,
+    me::Frame* 					frames,
+    uint64_t 					frame_number,
+    uint32_t 					command_buffer_count,
+    me::CommandBuffer* 				command_buffers
+    )
+{
+  me::RendererModule* renderer = bench_device.renderer;
+  uint32_t frame_index = frame_number % FRAME_COUNT;
+
+  me::FramePrepareInfo frame_prepare_info = {};
+  frame_prepare_info.device = bench_device.device;
+  frame_prepare_info.swapchain = nullptr;
+  frame_prepare_info.frame = frames[frame_index];
+  frame_prepare_info.frame_index = frame_index;
+
+  me::FramePrepared frame_prepared;
+  renderer->frame_prepare(frame_prepare_info, frame_prepared);
+
+  me::FrameRenderInfo frame_render_info = {};
+  frame_render_info.device = bench_device.device;
+  frame_render_info.queue = bench_device.graphics_queue;
+  frame_render_info.prepared = frame_prepared;
+  frame_render_info.image = nullptr;
+  frame_render_info.frame = frames[frame_index];
+  frame_render_info.image_index = 0;
+  frame_render_info.frame_index = frame_index;
+  frame_render_info.command_buffer_count = command_buffer_count;
+  frame_render_info.command_buffers = command_buffers;
+
+  me::FrameRendered frame_rendered;
+  renderer->frame_render(frame_render_info, frame_rendered);
+  return 0;
+}
+
+int read_buffer(
+    me::bench::BenchDevice 			&bench_device,
+    me::CommandPool 				graphics_command_pool,
+    VkBuffer 					buffer,
+    VkDeviceSize 				size,
+    void* 					data
+    )
+{
+  me::Device_T* device = reinterpret_cast<me::Device_T*>(bench_device.device);
+
+  VkBuffer vk_buffer;
+  me::memory::Allocation allocation;
+  me::memory::create_buffer(*device->memory_allocator, device->vk_device, size,
+      VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_SHARING_MODE_EXCLUSIVE,
+      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, vk_buffer, allocation);
+
+  me::memory::copy_buffer(device->vk_device, reinterpret_cast<me::CommandPool_T*>(graphics_command_pool)->vk_command_pool,
+      reinterpret_cast<me::Queue_T*>(bench_device.graphics_queue)->vk_queue, size, buffer, 0, vk_buffer, VK_NULL_HANDLE);
+
+  void* mapped;
+  device->memory_allocator->map(allocation, mapped);
+  memcpy(data, mapped, size);
+
+  me::memory::destroy_buffer(*device->memory_allocator, device->vk_device, vk_buffer, allocation);
+  return 0;
+}
@@ -0,0 +1,39 @@
+#include "Bench.hpp"
+
+#include <stdio.h>
+#include <string.h>
+
+static const me::bench::BenchCase bench_cases[] = {
+  {"arena", "build scene meshes in the scene arena and on the heap", me::bench::arena},
+  {"defragment", "move staging buffers out of a mostly empty block, fails if a moved buffer loses its contents", me::bench::defragment},
+  {"draw_list", "sort 10k draws of 64 materials and count the binds in submission and sorted order", me::bench::draw_list},
+  {"indirect", "cull objects on the device after the geometry pool moved, fails if a draw command has stale ranges", me::bench::indirect},
+  {"memory", "create, write and free sub-allocated buffers, fails if memory is lost", me::bench::memory},
+  {"mesh_upload", "upload 1k and 10k meshes one at a time and in a single batch", me::bench::mesh_upload},
+  {"pipeline_cache", "create the same pipelines with a cold and a warm pipeline cache", me::bench::pipeline_cache},
+  {"residency", "draw more meshes than the residency budget holds, fails if the pool exceeds it or never shrinks", me::bench::residency}
+};
+
+int main(int argc, char** argv)
+{
+  static constexpr uint32_t bench_case_count = sizeof(bench_cases) / sizeof(bench_cases[0]);
+
+  /* runs the named cases, or all of them */
+  int failed = 0;
+  for (uint32_t i = 0; i < bench_case_count; i++)
+  {
+    bool selected = argc < 2;
+    for (int j = 1; j < argc && !selected; j++)
+      selected = strcmp(argv[j], bench_cases[i].name) == 0;
+    if (!selected)
+      continue;
+
+    printf("== %s: %s\n", bench_cases[i].name, bench_cases[i].description);
+    if (bench_cases[i].function(argc, argv) != 0)
+    {
+      printf("== %s failed\n", bench_cases[i].name);
+      failed++;
+    }
+  }
+  return failed > 0 ? 1 : 0;
+}
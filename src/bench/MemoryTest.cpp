@@ -0,0 +1,108 @@
+#include "Bench.hpp"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static constexpr uint32_t BUFFER_COUNT = 512;
+static constexpr uint32_t ROUND_COUNT = 4;
+
+static int get_heap_used(
+    me::bench::BenchDevice 			&bench_device,
+    uint32_t 					heap_count,
+    size_t* 					used
+    );
+
+
+int me::bench::memory(int argc, char** argv)
+{
+  BenchDevice bench_device;
+  create_bench_device(nullptr, bench_device);
+  RendererModule* renderer = bench_device.renderer;
+
+  uint32_t heap_count;
+  renderer->get_memory_budget(bench_device.device, heap_count, nullptr);
+  size_t initial_used[heap_count];
+  get_heap_used(bench_device, heap_count, initial_used);
+
+  /* sizes from 256 bytes to 4 MiB, mixed host visible and device local, freed in a shuffled order
+   * so blocks fill up, split and merge again */
+  srand(1);
+  int failures = 0;
+  for (uint32_t round = 0; round < ROUND_COUNT; round++)
+  {
+    Buffer buffers[BUFFER_COUNT];
+    for (uint32_t i = 0; i < BUFFER_COUNT; i++)
+    {
+      BufferCreateInfo buffer_create_info = {};
+      buffer_create_info.type = STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+      buffer_create_info.next = nullptr;
+      buffer_create_info.physical_device = bench_device.physical_device;
+      buffer_create_info.device = bench_device.device;
+      buffer_create_info.usage = i % 3 == 0 ? BUFFER_USAGE_UNIFORM_BUFFER : BUFFER_USAGE_VERTEX_BUFFER;
+      buffer_create_info.write_method = i % 2 == 0 ? BUFFER_WRITE_METHOD_STANDARD : BUFFER_WRITE_METHOD_STAGING;
+      buffer_create_info.size = static_cast<size_t>(256) << (rand() % 15);
+      renderer->create_buffer(buffer_create_info, buffers[i]);
+
+      /* neighbouring allocations must not overlap, every mapped buffer keeps its own pattern */
+      if (buffer_create_info.write_method == BUFFER_WRITE_METHOD_STANDARD)
+      {
+	void* data;
+	renderer->get_buffer_data(buffers[i], data);
+	memset(data, static_cast<int>(i & 0xFF), buffer_create_info.size);
+      }
+    }
+
+    for (uint32_t i = 0; i < BUFFER_COUNT; i += 2)
+    {
+      void* data;
+      renderer->get_buffer_data(buffers[i], data);
+      const uint8_t* bytes = static_cast<const uint8_t*>(data);
+      if (bytes[0] != (i & 0xFF) || bytes[255] != (i & 0xFF))
+      {
+	printf("round %u: buffer %u was overwritten\n", round, i);
+	failures++;
+      }
+    }
+
+    for (uint32_t i = BUFFER_COUNT - 1; i > 0; i--)
+    {
+      uint32_t j = rand() % (i + 1);
+      Buffer buffer = buffers[i];
+      buffers[i] = buffers[j];
+      buffers[j] = buffer;
+    }
+    for (uint32_t i = 0; i < BUFFER_COUNT; i++)
+      renderer->cleanup_buffer(bench_device.device, buffers[i]);
+
+    /* blocks may stay allocated for reuse, but nothing in them may still be in use */
+    size_t used[heap_count];
+    get_heap_used(bench_device, heap_count, used);
+    for (uint32_t i = 0; i < heap_count; i++)
+    {
+      if (used[i] != initial_used[i])
+      {
+	printf("round %u: heap %u has %lu bytes in use after freeing every buffer, %lu before\n", round, i, used[i], initial_used[i]);
+	failures++;
+      }
+    }
+  }
+
+  printf("%u rounds of %u buffers, %d failures\n", ROUND_COUNT, BUFFER_COUNT, failures);
+  cleanup_bench_device(bench_device);
+  return failures > 0 ? 1 : 0;
+}
+
+
+int get_heap_used(
+    me::bench::BenchDevice 			&bench_device,
+    uint32_t 					heap_count,
+    size_t* 					used
+    )
+{
+  me::MemoryHeapBudget budgets[heap_count];
+  bench_device.renderer->get_memory_budget(bench_device.device, heap_count, budgets);
+  for (uint32_t i = 0; i < heap_count; i++)
+    used[i] = budgets[i].used;
+  return 0;
+}
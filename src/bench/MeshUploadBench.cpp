@@ -0,0 +1,99 @@
+#include "Bench.hpp"
+#include "../engine/scene/Mesh.hpp"
+#include "../engine/util/Profiler.hpp"
+
+#include <stdio.h>
+
+static constexpr uint32_t MESH_COUNTS[] = {1000, 10000};
+static constexpr uint32_t VERTEX_COUNT = 24; /* per mesh, a cube with its own normals per face */
+static constexpr uint32_t INDEX_COUNT = 36;
+
+static void fill_mesh(
+    me::Mesh* 				mesh,
+    uint32_t 					mesh_index
+    );
+
+static int upload_meshes(
+    uint32_t 					mesh_count,
+    bool 					batched,
+    double 					&milliseconds
+    );
+
+
+int me::bench::mesh_upload(int argc, char** argv)
+{
+  /* every run gets a new device, so the geometry pool and the staging ring start out empty */
+  for (uint32_t mesh_count : MESH_COUNTS)
+  {
+    double single_milliseconds, batched_milliseconds;
+    upload_meshes(mesh_count, false, single_milliseconds);
+    upload_meshes(mesh_count, true, batched_milliseconds);
+
+    printf("%u meshes: setup_mesh %.3f ms, setup_meshes %.3f ms (%.1fx)\n", mesh_count,
+	single_milliseconds, batched_milliseconds, single_milliseconds / batched_milliseconds);
+  }
+  return 0;
+}
+
+
+void fill_mesh(
+    me::Mesh* 				mesh,
+    uint32_t 					mesh_index
+    )
+{
+  float x = static_cast<float>(mesh_index);
+  for (uint32_t i = 0; i < VERTEX_COUNT; i++)
+  {
+    float y = static_cast<float>(i);
+    mesh->vertices.push_back({{x, y, 0.0F}, {0.0F, 0.0F, 1.0F}, {0.0F, 0.0F}, {1.0F, 1.0F, 1.0F, 1.0F}});
+  }
+  for (uint32_t i = 0; i < INDEX_COUNT; i++)
+    mesh->indices.push_back({i % VERTEX_COUNT});
+}
+
+int upload_meshes(
+    uint32_t 					mesh_count,
+    bool 					batched,
+    double 					&milliseconds
+    )
+{
+  me::bench::BenchDevice bench_device;
+  me::bench::create_bench_device(nullptr, bench_device);
+  me::RendererModule* renderer = bench_device.renderer;
+
+  me::Mesh* meshes[mesh_count];
+  for (uint32_t i = 0; i < mesh_count; i++)
+  {
+    meshes[i] = new me::Mesh;
+    fill_mesh(meshes[i], i);
+  }
+
+  me::SetupMeshInfo setup_mesh_info = {};
+  setup_mesh_info.physical_device = bench_device.physical_device;
+  setup_mesh_info.device = bench_device.device;
+  setup_mesh_info.transfer_queue = bench_device.transfer_queue;
+  setup_mesh_info.transfer_command_pool = bench_device.transfer_command_pool;
+
+  /* measured until the device has finished the copies, not just until they are submitted */
+  uint64_t start = me::Profiler::get_time();
+  if (batched)
+    renderer->setup_meshes(setup_mesh_info, mesh_count, meshes);
+  else
+  {
+    for (uint32_t i = 0; i < mesh_count; i++)
+      renderer->setup_mesh(setup_mesh_info, meshes[i]);
+  }
+
+  me::TransferTicket ticket;
+  renderer->transfer_flush(bench_device.device, ticket);
+  renderer->transfer_wait(bench_device.device, ticket);
+  milliseconds = static_cast<double>(me::Profiler::get_time() - start) / 1000000.0;
+
+  for (uint32_t i = 0; i < mesh_count; i++)
+  {
+    renderer->cleanup_mesh(bench_device.device, meshes[i]);
+    delete meshes[i];
+  }
+  me::bench::cleanup_bench_device(bench_device);
+  return 0;
+}
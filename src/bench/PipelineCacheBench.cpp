@@ -0,0 +1,194 @@
+#include "Bench.hpp"
+#include "../engine/renderer/Shader.hpp"
+#include "../engine/scene/Mesh.hpp"
+#include "../engine/renderer/Instancing.hpp"
+#include "../engine/util/Profiler.hpp"
+
+#include <lme/file.hpp>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <limits.h>
+
+/* every combination is its own pipeline, the same way on every run */
+static constexpr me::CullMode CULL_MODES[] = {me::CULL_MODE_BACK, me::CULL_MODE_FRONT, me::CULL_MODE_NONE};
+static constexpr me::FrontFace FRONT_FACES[] = {me::FRONT_FACE_CLOCKWISE, me::FRONT_FACE_COUNTER_CLOCKWISE};
+static constexpr uint32_t PIPELINE_COUNT = 6;
+
+static int create_pipelines(
+    const char* 				pipeline_cache_path,
+    me::Shader** 				shaders,
+    double 					&milliseconds
+    );
+
+
+int me::bench::pipeline_cache(int argc, char** argv)
+{
+  /* the shaders of the game, so it runs from the repository root like the game */
+  size_t vert_shader_len;
+  char* vert_shader_data;
+  File::read(File("src/res/vert.spv"), vert_shader_len, vert_shader_data);
+
+  size_t frag_shader_len;
+  char* frag_shader_data;
+  File::read(File("src/res/frag.spv"), frag_shader_len, frag_shader_data);
+
+  ShaderConfig shader_config = {};
+  shader_config.entry_point = "main";
+
+  Shader* shaders[2];
+  shaders[0] = new Shader(SHADER_TYPE_VERTEX, {vert_shader_len, vert_shader_data}, shader_config);
+  shaders[1] = new Shader(SHADER_TYPE_FRAGMENT, {frag_shader_len, frag_shader_data}, shader_config);
+
+  /* a file of its own, so the user's cache is neither used nor replaced */
+  const char* temporary_directory = getenv("TMPDIR");
+  char pipeline_cache_path[PATH_MAX];
+  snprintf(pipeline_cache_path, PATH_MAX, "%s/murder_engine_bench.pipeline_cache",
+      temporary_directory != nullptr ? temporary_directory : "/tmp");
+  remove(pipeline_cache_path);
+
+  /* the first device writes the cache on cleanup, the second one is seeded from it */
+  double cold_milliseconds, warm_milliseconds;
+  create_pipelines(pipeline_cache_path, shaders, cold_milliseconds);
+  create_pipelines(pipeline_cache_path, shaders, warm_milliseconds);
+  remove(pipeline_cache_path);
+
+  printf("%u pipelines: cold cache %.3f ms, warm cache %.3f ms (%.1fx)\n", PIPELINE_COUNT,
+      cold_milliseconds, warm_milliseconds, cold_milliseconds / warm_milliseconds);
+
+  delete shaders[0];
+  delete shaders[1];
+  return 0;
+}
+
+
+int create_pipelines(
+    const char* 				pipeline_cache_path,
+    me::Shader** 				shaders,
+    double 					&milliseconds
+    )
+{
+  me::bench::BenchDevice bench_device;
+  me::bench::create_bench_device(pipeline_cache_path, bench_device);
+  me::RendererModule* renderer = bench_device.renderer;
+
+  /* an offscreen render pass like the game's */
+  static constexpr uint32_t attachment_count = 2;
+  me::AttachmentDescription attachment_descriptions[attachment_count];
+  attachment_descriptions[0].attachment_type = me::ATTACHMENT_TYPE_COLOR;
+  attachment_descriptions[0].format = me::FORMAT_VECTOR4_8UNORM;
+  attachment_descriptions[0].samples = me::SAMPLE_COUNT_1;
+  attachment_descriptions[0].transient = false;
+  attachment_descriptions[0].first_pass = 0;
+  attachment_descriptions[0].last_pass = 0;
+
+  attachment_descriptions[1].attachment_type = me::ATTACHMENT_TYPE_DEPTH;
+  attachment_descriptions[1].format = me::FORMAT_DEPTH_32FLOAT;
+  attachment_descriptions[1].samples = me::SAMPLE_COUNT_1;
+  attachment_descriptions[1].transient = false;
+  attachment_descriptions[1].first_pass = 0;
+  attachment_descriptions[1].last_pass = 0;
+
+  me::AttachmentCreateInfo attachment_create_info = {};
+  attachment_create_info.type = me::STRUCTURE_TYPE_ATTACHMENT_CREATE_INFO;
+  attachment_create_info.next = nullptr;
+  attachment_create_info.device = bench_device.device;
+  attachment_create_info.size = {64, 64};
+  attachment_create_info.descriptions = attachment_descriptions;
+  me::Attachment attachments[attachment_count];
+  renderer->create_attachments(attachment_create_info, attachment_count, attachments);
+
+  me::RenderPassCreateInfo render_pass_create_info = {};
+  render_pass_create_info.type = me::STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+  render_pass_create_info.next = nullptr;
+  render_pass_create_info.device = bench_device.device;
+  render_pass_create_info.swapchain = nullptr;
+  render_pass_create_info.attachment_count = attachment_count;
+  render_pass_create_info.attachments = attachments;
+  render_pass_create_info.pass_index = 0;
+  me::RenderPass render_pass;
+  renderer->create_render_pass(render_pass_create_info, render_pass);
+
+  /* the vertex input of the game's pipeline */
+  static constexpr uint32_t vertex_binding_count = 2;
+  me::ShaderBinding vertex_bindings[vertex_binding_count];
+  vertex_bindings[0] = {0, sizeof(me::Vertex), false};
+  vertex_bindings[1] = {1, sizeof(me::InstanceData), true};
+
+  static constexpr uint32_t vertex_attribute_count = 7;
+  me::ShaderAttribute vertex_attributes[vertex_attribute_count];
+  vertex_attributes[0] = {"position", 0, 0, offsetof(me::Vertex, position), me::FORMAT_VECTOR3_32FLOAT};
+  vertex_attributes[1] = {"normal", 0, 1, offsetof(me::Vertex, normal), me::FORMAT_VECTOR3_32FLOAT};
+  vertex_attributes[2] = {"tex_coord", 0, 2, offsetof(me::Vertex, tex_coord), me::FORMAT_VECTOR2_32FLOAT};
+  vertex_attributes[3] = {"color", 0, 3, offsetof(me::Vertex, color), me::FORMAT_VECTOR4_32FLOAT};
+  vertex_attributes[4] = {"instance_position", 1, 4, offsetof(me::InstanceData, position), me::FORMAT_VECTOR4_32FLOAT};
+  vertex_attributes[5] = {"instance_rotation", 1, 5, offsetof(me::InstanceData, rotation), me::FORMAT_VECTOR4_32FLOAT};
+  vertex_attributes[6] = {"instance_scale", 1, 6, offsetof(me::InstanceData, scale), me::FORMAT_VECTOR4_32FLOAT};
+
+  me::ShaderCreateInfo shader_create_info = {};
+  shader_create_info.type = me::STRUCTURE_TYPE_SHADER_CREATE_INFO;
+  shader_create_info.next = nullptr;
+  shader_create_info.vertex_binding_count = vertex_binding_count;
+  shader_create_info.vertex_bindings = vertex_bindings;
+  shader_create_info.vertex_attribute_count = vertex_attribute_count;
+  shader_create_info.vertex_attributes = vertex_attributes;
+  shader_create_info.shader_count = 2;
+  shader_create_info.shaders = shaders;
+  shader_create_info.topology = me::TOPOLOGY_TRIANGLE_LIST;
+
+  me::MultisamplingCreateInfo multisampling_create_info = {};
+  multisampling_create_info.type = me::STRUCTURE_TYPE_MULTISAMPLING_CREATE_INFO;
+  multisampling_create_info.next = nullptr;
+  multisampling_create_info.samples = me::SAMPLE_COUNT_1;
+
+  me::Viewport viewport;
+  viewport.location = {0.0F, 0.0F};
+  viewport.size = {64.0F, 64.0F};
+  me::Scissor scissor;
+  scissor.offset = {0, 0};
+  scissor.size = {64, 64};
+
+  /* only the pipeline creation is measured, the device and the cache file are the same for both runs */
+  me::Pipeline pipelines[PIPELINE_COUNT];
+  uint32_t pipeline_count = 0;
+  uint64_t start = me::Profiler::get_time();
+  for (me::CullMode cull_mode : CULL_MODES)
+  {
+    for (me::FrontFace front_face : FRONT_FACES)
+    {
+      me::RasterizerCreateInfo rasterizer_create_info = {};
+      rasterizer_create_info.type = me::STRUCTURE_TYPE_RASTERIZER_CREATE_INFO;
+      rasterizer_create_info.next = nullptr;
+      rasterizer_create_info.polygon_mode = me::POLYGON_MODE_FILL;
+      rasterizer_create_info.front_face = front_face;
+      rasterizer_create_info.cull_mode = cull_mode;
+
+      me::PipelineCreateInfo pipeline_create_info = {};
+      pipeline_create_info.type = me::STRUCTURE_TYPE_PIPELINE_CREATE_INFO;
+      pipeline_create_info.next = nullptr;
+      pipeline_create_info.device = bench_device.device;
+      pipeline_create_info.render_pass = render_pass;
+      pipeline_create_info.viewport_count = 1;
+      pipeline_create_info.viewports = &viewport;
+      pipeline_create_info.scissor_count = 1;
+      pipeline_create_info.scissors = &scissor;
+      pipeline_create_info.rasterizer_create_info = &rasterizer_create_info;
+      pipeline_create_info.multisampling_create_info = &multisampling_create_info;
+      pipeline_create_info.shader_create_info = &shader_create_info;
+      pipeline_create_info.descriptor_set_count = 0;
+      pipeline_create_info.descriptor_sets = nullptr;
+      pipeline_create_info.push_constant_size = 0;
+      pipeline_create_info.bindless = false;
+      renderer->create_pipeline(pipeline_create_info, pipelines[pipeline_count++]);
+    }
+  }
+  milliseconds = static_cast<double>(me::Profiler::get_time() - start) / 1000000.0;
+
+  for (uint32_t i = 0; i < pipeline_count; i++)
+    renderer->cleanup_pipeline(bench_device.device, pipelines[i]);
+  renderer->cleanup_render_pass(bench_device.device, render_pass);
+  renderer->cleanup_attachments(bench_device.device, attachment_count, attachments);
+  me::bench::cleanup_bench_device(bench_device);
+  return 0;
+}
@@ -0,0 +1,183 @@
+#include "Bench.hpp"
+#include "../engine/scene/Mesh.hpp"
+
+#include <lme/math/math.hpp>
+
+#include <stdio.h>
+
+static constexpr uint32_t FRAME_COUNT = 2;
+static constexpr uint32_t MESH_COUNT = 2000;
+static constexpr uint32_t VERTEX_COUNT = 1000; /* per mesh, with the indices about 60 KiB */
+static constexpr uint32_t INDEX_COUNT = 3000;
+static constexpr uint32_t WINDOW_SIZE = 256; /* meshes drawn per frame, about 15 MiB */
+static constexpr uint32_t WINDOW_STEP = 64;
+static constexpr uint32_t STREAM_FRAME_COUNT = 200;
+static constexpr uint32_t IDLE_FRAME_COUNT = 20;
+static constexpr uint32_t IDLE_MESH_COUNT = 8;
+static constexpr size_t BUDGET = 32 * 1024 * 1024;
+
+static size_t get_device_local_allocated(
+    me::bench::BenchDevice 			&bench_device
+    );
+
+static int render_frame(
+    me::bench::BenchDevice 			&bench_device,
+    me::Frame* 					frames,
+    uint64_t 					frame_number,
+    uint32_t 					mesh_count,
+    me::Mesh** 					meshes
+    );
+
+
+int me::bench::residency(int argc, char** argv)
+{
+  BenchDevice bench_device;
+  create_bench_device(nullptr, bench_device);
+  RendererModule* renderer = bench_device.renderer;
+
+  Frame frames[FRAME_COUNT];
+  FrameCreateInfo frame_create_info = {};
+  frame_create_info.type = STRUCTURE_TYPE_FRAME_CREATE_INFO;
+  frame_create_info.next = nullptr;
+  frame_create_info.device = bench_device.device;
+  renderer->create_frames(frame_create_info, FRAME_COUNT, frames);
+
+  /* about 120 MiB of geometry, 4 times the budget */
+  Mesh* meshes[MESH_COUNT];
+  for (uint32_t i = 0; i < MESH_COUNT; i++)
+  {
+    meshes[i] = new Mesh;
+    for (uint32_t j = 0; j < VERTEX_COUNT; j++)
+    {
+      float x = static_cast<float>(j);
+      meshes[i]->vertices.push_back({{x, x, x}, {0.0F, 0.0F, 1.0F}, {0.0F, 0.0F}, {1.0F, 1.0F, 1.0F, 1.0F}});
+    }
+    for (uint32_t j = 0; j < INDEX_COUNT; j++)
+      meshes[i]->indices.push_back({j % VERTEX_COUNT});
+  }
+
+  SetupMeshInfo setup_mesh_info = {};
+  setup_mesh_info.physical_device = bench_device.physical_device;
+  setup_mesh_info.device = bench_device.device;
+  setup_mesh_info.transfer_queue = bench_device.transfer_queue;
+  setup_mesh_info.transfer_command_pool = bench_device.transfer_command_pool;
+
+  /* only what fits in the budget is uploaded here, the rest when it is first drawn */
+  size_t initial_allocated = get_device_local_allocated(bench_device);
+  renderer->set_residency_budget(bench_device.device, BUDGET);
+  renderer->setup_meshes(setup_mesh_info, MESH_COUNT, meshes);
+
+  /* a window of meshes moves over all of them, the ones it left are evicted */
+  uint64_t frame_number = 0;
+  size_t peak_allocated = 0;
+  for (uint32_t i = 0; i < STREAM_FRAME_COUNT; i++, frame_number++)
+  {
+    uint32_t first = (i * WINDOW_STEP) % (MESH_COUNT - WINDOW_SIZE);
+    render_frame(bench_device, frames, frame_number, WINDOW_SIZE, meshes + first);
+    size_t allocated = get_device_local_allocated(bench_device);
+    if (allocated > initial_allocated)
+      peak_allocated = me::math::max(peak_allocated, allocated - initial_allocated);
+  }
+
+  /* with few meshes drawn the pool shrinks and its memory goes back to the heap */
+  for (uint32_t i = 0; i < IDLE_FRAME_COUNT; i++, frame_number++)
+    render_frame(bench_device, frames, frame_number, IDLE_MESH_COUNT, meshes);
+  size_t allocated = get_device_local_allocated(bench_device);
+  size_t idle_allocated = allocated > initial_allocated ? allocated - initial_allocated : 0;
+
+  printf("budget %lu KiB, peak %lu KiB more device local memory, %lu KiB more after %u idle frames\n",
+      BUDGET / 1024, peak_allocated / 1024, idle_allocated / 1024, IDLE_FRAME_COUNT);
+
+  /* a resized pool keeps its old buffers for the frames in flight, so twice the budget at most */
+  int failures = 0;
+  if (peak_allocated > 2 * BUDGET)
+  {
+    printf("the geometry pool went over twice its budget\n");
+    failures++;
+  }
+  if (peak_allocated == 0 || idle_allocated >= peak_allocated)
+  {
+    printf("evicting meshes gave no memory back\n");
+    failures++;
+  }
+
+  /* preparing every frame once more waits for all of them */
+  for (uint32_t i = 0; i < FRAME_COUNT; i++)
+  {
+    FramePrepareInfo frame_prepare_info = {};
+    frame_prepare_info.device = bench_device.device;
+    frame_prepare_info.swapchain = nullptr;
+    frame_prepare_info.frame = frames[i];
+    frame_prepare_info.frame_index = i;
+
+    FramePrepared frame_prepared;
+    renderer->frame_prepare(frame_prepare_info, frame_prepared);
+  }
+
+  for (uint32_t i = 0; i < MESH_COUNT; i++)
+  {
+    renderer->cleanup_mesh(bench_device.device, meshes[i]);
+    delete meshes[i];
+  }
+  renderer->cleanup_frames(bench_device.device, FRAME_COUNT, frames);
+  cleanup_bench_device(bench_device);
+  return failures > 0 ? 1 : 0;
+}
+
+
+size_t get_device_local_allocated(
+    me::bench::BenchDevice 			&bench_device
+    )
+{
+  uint32_t heap_count;
+  bench_device.renderer->get_memory_budget(bench_device.device, heap_count, nullptr);
+  me::MemoryHeapBudget budgets[heap_count];
+  bench_device.renderer->get_memory_budget(bench_device.device, heap_count, budgets);
+
+  size_t allocated = 0;
+  for (uint32_t i = 0; i < heap_count; i++)
+  {
+    if (budgets[i].device_local)
+      allocated += budgets[i].allocated;
+  }
+  return allocated;
+}
+
+int render_frame(
+    me::bench::BenchDevice 			&bench_device,
+    me::Frame* 					frames,
+    uint64_t 					frame_number,
+    uint32_t 					mesh_count,
+    me::Mesh** 					meshes
+    )
+{
+  me::RendererModule* renderer = bench_device.renderer;
+  uint32_t frame_index = frame_number % FRAME_COUNT;
+
+  me::FramePrepareInfo frame_prepare_info = {};
+  frame_prepare_info.device = bench_device.device;
+  frame_prepare_info.swapchain = nullptr;
+  frame_prepare_info.frame = frames[frame_index];
+  frame_prepare_info.frame_index = frame_index;
+
+  me::FramePrepared frame_prepared;
+  renderer->frame_prepare(frame_prepare_info, frame_prepared);
+
+  renderer->make_meshes_resident(bench_device.device, mesh_count, meshes);
+
+  /* nothing is drawn, the submit only makes the frame wait for the uploads and copies */
+  me::FrameRenderInfo frame_render_info = {};
+  frame_render_info.device = bench_device.device;
+  frame_render_info.queue = bench_device.graphics_queue;
+  frame_render_info.prepared = frame_prepared;
+  frame_render_info.image = nullptr;
+  frame_render_info.frame = frames[frame_index];
+  frame_render_info.image_index = 0;
+  frame_render_info.frame_index = frame_index;
+  frame_render_info.command_buffer_count = 0;
+  frame_render_info.command_buffers = nullptr;
+
+  me::FrameRendered frame_rendered;
+  renderer->frame_render(frame_render_info, frame_rendered);
+  return 0;
+}
@@ -39,6 +39,15 @@ int me::MurderEngine::terminate()
   running = false;
   logger.info("terminating...");
 
+  terminate_modules();
+  return 0;
+}
+
+int me::MurderEngine::terminate_on_error()
+{
+  running = false;
+  logger.info("terminating after an error...");
+
   terminate_modules();
 
   abort();
@@ -55,8 +64,9 @@ int me::MurderEngine::translate_semaphore(const Semaphore &semaphore, const stri
   {
     logger.debug("received '%s' flag from module [%s]",
 	module_semaphore_flag_name(MODULE_SEMAPHORE_TERMINATE_FLAG), module_str);
-    if (running)
-      terminate();
+
+    /* the main loop returns after this tick and the caller terminates the modules */
+    running = false;
   }
 
   /* notify */
@@ -79,7 +89,7 @@ int me::MurderEngine::init_modules()
     }catch(const exception &e)
     {
       logger.err("failed to initialize module '%s'\n\t%s", module->get_name().c_str(), e.get_message());
-      terminate();
+      terminate_on_error();
     }
   }
   return 0;
@@ -99,7 +109,7 @@ int me::MurderEngine::tick_modules()
     }catch(const exception &e)
     {
       logger.err("received an error from module '%s'\n\t%s", module->get_name().c_str(), e.get_message());
-      terminate();
+      terminate_on_error();
     }
   }
   return 0;
@@ -115,8 +125,8 @@ int me::MurderEngine::terminate_modules()
       translate_semaphore(semaphore, module->get_name());
     }catch(const exception &e)
     {
+      /* the other modules are still terminated */
       logger.err("failed to terminate module '%s'\n\t%s", module->get_name().c_str(), e.get_message());
-      terminate();
     }
   }
   return 0;
@@ -30,11 +30,16 @@ namespace me {
 
     explicit MurderEngine(const EngineInfo &engine_info, const EngineBus &engine_bus);
 
+    /* runs the main loop until a module sets 'MODULE_SEMAPHORE_TERMINATE_FLAG' */
     int initialize(int argc, char** argv);
+    /* terminates the modules after the main loop has returned */
     int terminate();
 
   protected:
 
+    /* terminates the modules and aborts, for modules that failed */
+    int terminate_on_error();
+
     int translate_semaphore(const Semaphore &semaphore, const string_view &module);
 
     int init_modules();
@@ -8,7 +8,7 @@ me::ColladaFormat::ColladaFormat()
 
 int me::ColladaFormat::read(const me::File &file, size_t len, const char* data, allocator &alloc, Scene &scene)
 {
-  ColladaContext context = {file, alloc};
+  ColladaContext context = {file, alloc, scene.arena};
 
   char* iter = const_cast<char*>(data);
 
@@ -75,7 +75,7 @@ int me::ColladaFormat::parse_geometry(ColladaContext &context, rapidxml::xml_nod
 {
   rapidxml::xml_attribute<>* id_attrib = geometry_node->first_attribute("id");
   rapidxml::xml_attribute<>* name_attrib = geometry_node->first_attribute("name");
-  geometry.identifier = id_attrib->value();
+  geometry.identifier = intern(id_attrib->value(), id_attrib->value_size());
   geometry.name = name_attrib->value();
 
   rapidxml::xml_node<>* mesh_node = geometry_node->first_node("mesh");
@@ -88,13 +88,20 @@ int me::ColladaFormat::parse_geometry(ColladaContext &context, rapidxml::xml_nod
 
       if (strcmp("float_array", node->name()) == 0)
       {
-	string identifier = node->first_attribute("id")->value();
+	rapidxml::xml_attribute<>* array_id_attrib = node->first_attribute("id");
+	Symbol identifier = intern(array_id_attrib->value(), array_id_attrib->value_size());
 	string value = node->value();
 
 	size_t float_count;
 	value.split(' ', float_count, nullptr);
 	string_view floats[float_count];
 	value.split(' ', float_count, floats);
+
+	float* array = context.arena.allocate_array<float>(float_count);
+	char temp[128];
+	for (size_t i = 0; i < float_count; i++)
+	  array[i] = strfloat(floats[i].size(), floats[i].c_str(temp));
+	geometry.arrays[identifier] = array;
       }
 
       source_node = source_node->next_sibling();
@@ -107,14 +114,16 @@ int me::ColladaFormat::parse_material(ColladaContext &context, rapidxml::xml_nod
 {
   rapidxml::xml_attribute<>* id_attrib = material_node->first_attribute("id");
   rapidxml::xml_attribute<>* name_attrib = material_node->first_attribute("name");
-  material.identifier = id_attrib->value();
+  material.identifier = intern(id_attrib->value(), id_attrib->value_size());
   material.name = name_attrib->value();
 
   rapidxml::xml_node<>* node = material_node->first_node();
   if (strcmp("instance_effect", node->name()) == 0)
   {
-    string url = node->first_attribute("url")->value();
-    material.effect = &context.effects[url.substr(1)];
+    /* only urls into this document are resolved, skipping the '#'. the material has no effect otherwise */
+    rapidxml::xml_attribute<>* url_attrib = node->first_attribute("url");
+    if (url_attrib != nullptr && url_attrib->value_size() > 1 && url_attrib->value()[0] == '#')
+      material.effect = &context.effects[intern(url_attrib->value() + 1, url_attrib->value_size() - 1)];
   }
   return 0;
 }
@@ -123,7 +132,7 @@ int me::ColladaFormat::parse_image(ColladaContext &context, rapidxml::xml_node<>
 {
   rapidxml::xml_attribute<>* id_attrib = image_node->first_attribute("id");
   rapidxml::xml_attribute<>* name_attrib = image_node->first_attribute("name");
-  image.identifier = id_attrib->value();
+  image.identifier = intern(id_attrib->value(), id_attrib->value_size());
   image.name = name_attrib->value();
 
   rapidxml::xml_node<>* node = image_node->first_node();
@@ -137,7 +146,7 @@ int me::ColladaFormat::parse_image(ColladaContext &context, rapidxml::xml_node<>
 int me::ColladaFormat::parse_effect(ColladaContext &context, rapidxml::xml_node<>* effect_node, ColladaEffect &effect)
 {
   rapidxml::xml_attribute<>* id_attrib = effect_node->first_attribute("id");
-  effect.identifier = id_attrib->value();
+  effect.identifier = intern(id_attrib->value(), id_attrib->value_size());
 
   rapidxml::xml_node<>* profile_node = effect_node->first_node("profile_COMMON");
 
@@ -146,7 +155,8 @@ int me::ColladaFormat::parse_effect(ColladaContext &context, rapidxml::xml_node<
   {
     if (strcmp("newparam", node->name()) == 0)
     {
-      const char* param_name = node->first_attribute("sid")->value();
+      rapidxml::xml_attribute<>* sid_attrib = node->first_attribute("sid");
+      Symbol param_name = intern(sid_attrib->value(), sid_attrib->value_size());
       ColladaEffectParamType param_type;
       const char* param_value;
 
@@ -162,11 +172,11 @@ int me::ColladaFormat::parse_effect(ColladaContext &context, rapidxml::xml_node<
       if (strcmp("init_from", node->name()) == 0)
 	param_value = node->value();
       else if (strcmp("source", node->name()) == 0)
-	param_value = effect.params[string(node->value())].second;
+	param_value = effect.params[intern(node->value(), node->value_size())].second;
       else
 	param_value = nullptr;
 
-      effect.params[string(param_name)] = {param_type, param_value};
+      effect.params[param_name] = {param_type, param_value};
     }else if (strcmp("technique", node->name()) == 0)
     {
       node = node->first_node();
@@ -198,7 +208,7 @@ int me::ColladaFormat::parse_color(ColladaContext &context, rapidxml::xml_base<>
   if (strcmp("texture", color_node->name()) == 0)
   {
     color.type = MATERIAL_COLOR_IMAGE;
-    color.image = context.images[string(color_node->value())].image;
+    color.image = context.images[intern(color_node->value(), color_node->value_size())].image;
   }else if (strcmp("color", color_node->name()) == 0)
   {
     string float_str = color_node->value();
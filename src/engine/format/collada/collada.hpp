@@ -2,6 +2,7 @@
   #define ME_FORMAT_COLLADA_HPP
 
 #include "../Format.hpp"
+#include "../../util/Symbol.hpp"
 
 #include <lme/map.hpp>
 
@@ -22,8 +23,8 @@ namespace me {
 
 
   struct ColladaEffect {
-    string identifier;
-    map<string, pair<ColladaEffectParamType, const char*>> params;
+    Symbol identifier;
+    map<Symbol, pair<ColladaEffectParamType, const char*>> params;
     ColladaEffectTechnique technique;
     MaterialColor emission;
     MaterialColor diffuse;
@@ -31,30 +32,31 @@ namespace me {
   };
 
   struct ColladaImage {
-    string identifier;
+    Symbol identifier;
     string name;
     Image* image;
   };
 
   struct ColladaMaterial {
-    string identifier;
+    Symbol identifier;
     string name;
     ColladaEffect* effect;
   };
 
   struct ColladaGeometry {
-    string identifier;
+    Symbol identifier;
     string name;
-    map<string, float*> arrays;
+    map<Symbol, float*> arrays;
   };
 
   struct ColladaContext {
     const File &file;
     allocator &alloc;
-    map<string, ColladaImage> images;
-    map<string, ColladaEffect> effects;
-    map<string, ColladaMaterial> materials;
-    map<string, ColladaGeometry> geometries;
+    Arena &arena;
+    map<Symbol, ColladaImage> images;
+    map<Symbol, ColladaEffect> effects;
+    map<Symbol, ColladaMaterial> materials;
+    map<Symbol, ColladaGeometry> geometries;
   };
 
   class ColladaFormat : public Format {
@@ -2,6 +2,15 @@
 
 #include <lme/string_buffer.hpp>
 
+static me::MeshItem* create_mesh_item(
+    me::Arena* 				arena
+    );
+
+static me::Vertex& get_vertex(
+    me::Mesh* 				mesh,
+    size_t 				index
+    );
+
 me::OBJFormat::OBJFormat()
   : Format(FORMAT_TYPE_MESH, "wavefront:obj")
 {
@@ -12,9 +21,7 @@ int me::OBJFormat::read(const me::File &file, size_t len, const char* data, Resu
   string_buffer buffer(len, data);
 
   MeshItem* mesh_item = nullptr;
-  size_t position_index = 0, normal_index = 0, texture_index = 0, color_index = 0, face_index = 0;
-  vector<Vertex> vertices;
-  vector<Index> indices;
+  size_t position_index = 0, normal_index = 0, texture_index = 0, color_index = 0;
   while (buffer.has_next())
   {
     buffer.skip_whitespace();
@@ -27,14 +34,24 @@ int me::OBJFormat::read(const me::File &file, size_t len, const char* data, Resu
     {
       if (mesh_item != nullptr)
 	result.meshes.push_back(mesh_item);
-      mesh_item = new MeshItem;
-      mesh_item->identifier = buffer.next_literial();
+      mesh_item = create_mesh_item(result.arena);
+      mesh_item->identifier = intern(buffer.next_literial());
+      mesh_item->mesh->identifier = mesh_item->identifier;
       position_index = 0;
+      normal_index = 0;
       texture_index = 0;
       color_index = 0;
       buffer.skip_line();
     }else if (c == 'v')
     {
+      /* files without objects are one mesh, named after the file */
+      if (mesh_item == nullptr)
+      {
+	mesh_item = create_mesh_item(result.arena);
+	mesh_item->identifier = intern(file.get_name());
+	mesh_item->mesh->identifier = mesh_item->identifier;
+      }
+
       if (buffer.peek_char() == 'n')
       {
 	buffer.next_char(); /* skipping the 'n' */
@@ -51,7 +68,7 @@ int me::OBJFormat::read(const me::File &file, size_t len, const char* data, Resu
 	pos_str = buffer.next_float(pos_len);
 	float z = strfloat(pos_len, pos_str);
 
-	vertices[normal_index++].normal = {x, y, z};
+	get_vertex(mesh_item->mesh, normal_index++).normal = {x, y, z};
       }else if (buffer.peek_char() == 't')
       {
 	buffer.next_char(); /* skipping the 't' */
@@ -65,7 +82,7 @@ int me::OBJFormat::read(const me::File &file, size_t len, const char* data, Resu
 	pos_str = buffer.next_float(pos_len);
 	float y = strfloat(pos_len, pos_str);
 
-	vertices[texture_index++].tex_coord = {x, y};
+	get_vertex(mesh_item->mesh, texture_index++).tex_coord = {x, y};
       }else
       {
 	size_t pos_len;
@@ -80,14 +97,13 @@ int me::OBJFormat::read(const me::File &file, size_t len, const char* data, Resu
 	pos_str = buffer.next_float(pos_len);
 	float z = strfloat(pos_len, pos_str);
 
-	vertices[position_index++].position = {x, y, z};
+	get_vertex(mesh_item->mesh, position_index++).position = {x, y, z};
       }
       buffer.skip_line();
-    }else if (c == 'f')
+    }else if (c == 'f' && mesh_item != nullptr)
     {
-      uint32_t indices[12];
-
-      for (uint8_t i = 0; i < 4; i++)
+      /* triangles of position indices, indices are relative to the file and the meshes are not split by them */
+      for (uint8_t i = 0; i < 3; i++)
       {
 	size_t index_len;
 	const char* index_str;
@@ -95,12 +111,26 @@ int me::OBJFormat::read(const me::File &file, size_t len, const char* data, Resu
 	index_str = buffer.next_integer(index_len);
 	uint32_t x = struint32(index_len, index_str);
 
-	indices[face_index++] = x - 1;
+	mesh_item->mesh->indices.push_back({x - 1});
       }
+      buffer.skip_line();
     }
 
   }
 
+  if (mesh_item != nullptr)
+    result.meshes.push_back(mesh_item);
+  return 0;
+}
+
+int me::OBJFormat::read(const me::File &file, size_t len, const char* data, allocator &alloc, Scene &scene)
+{
+  Result result;
+  result.arena = &scene.arena;
+  read(file, len, data, result);
+
+  for (MeshItem* mesh_item : result.meshes)
+    scene.meshes.push_back(mesh_item);
   return 0;
 }
 
@@ -111,3 +141,36 @@ bool me::OBJFormat::recognize(const me::File &file)
   const string suffix = file.get_suffix();
   return suffix == "obj";
 }
+
+
+me::MeshItem* create_mesh_item(
+    me::Arena* 				arena
+    )
+{
+  me::MeshItem* mesh_item;
+  if (arena != nullptr)
+  {
+    mesh_item = arena->allocate<me::MeshItem>();
+    mesh_item->mesh = arena->allocate<me::Mesh>(arena);
+    mesh_item->flags = me::MESH_VISIBLE_FLAG | me::MESH_ARENA_FLAG;
+  }else
+  {
+    mesh_item = new me::MeshItem();
+    mesh_item->mesh = new me::Mesh;
+    mesh_item->flags = me::MESH_VISIBLE_FLAG;
+  }
+  mesh_item->material = nullptr;
+  mesh_item->scale = {1.0F, 1.0F, 1.0F};
+  return mesh_item;
+}
+
+me::Vertex& get_vertex(
+    me::Mesh* 				mesh,
+    size_t 				index
+    )
+{
+  /* positions, normals and texture coordinates fill the vertices independently */
+  if (index >= mesh->vertices.size())
+    mesh->vertices.resize(index + 1);
+  return mesh->vertices[index];
+}
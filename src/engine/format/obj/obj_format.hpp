@@ -2,7 +2,8 @@
   #define ME_FORMAT_OBJ_HPP
 
 #include "../Format.hpp"
-#include "../../scene/Mesh.hpp"
+#include "../../scene/Scene.hpp"
+#include "../../memory/Arena.hpp"
 
 namespace me {
 
@@ -11,6 +12,7 @@ namespace me {
   public:
 
     struct Result {
+      Arena* arena = nullptr; /* optional, items and meshes are allocated with 'new' if nullptr, 'MESH_ARENA_FLAG' tells them apart */
       vector<MeshItem*> meshes;
     };
 
@@ -19,6 +21,8 @@ namespace me {
     OBJFormat();
 
     int read(const me::File &file, size_t len, const char* data, Result &result);
+    /* the meshes are allocated from the scene's arena */
+    int read(const me::File &file, size_t len, const char* data, allocator &alloc, Scene &scene);
 
     bool recognize(const me::File &file) override;
 
@@ -0,0 +1,170 @@
+#include "Arena.hpp"
+
+#include <lme/string.hpp>
+
+#include <sys/mman.h>
+#include <errno.h>
+#include <string.h>
+
+static size_t align_up(size_t value, size_t alignment)
+{
+  return (value + alignment - 1) & ~(alignment - 1);
+}
+
+me::Arena::Arena(size_t reserve_size, uint32_t flags)
+  : committed(0), used(0), flags(flags), page_type(ARENA_PAGE_TYPE_NORMAL)
+{
+  reserved = align_up(reserve_size, HUGE_PAGE_SIZE);
+
+  /* over-reserve by one huge page so the base can be aligned to a huge page boundary,
+   * otherwise the kernel can't back the first/last pages with huge pages */
+  size_t mapping_size = reserved + HUGE_PAGE_SIZE;
+  void* mapping = mmap(nullptr, mapping_size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  if (mapping == MAP_FAILED)
+    throw exception("failed to reserve %lu bytes of virtual memory [%s]", reserved, strerror(errno));
+
+  char* aligned = reinterpret_cast<char*>(align_up(reinterpret_cast<size_t>(mapping), HUGE_PAGE_SIZE));
+  size_t head = aligned - static_cast<char*>(mapping);
+  size_t tail = mapping_size - head - reserved;
+  if (head > 0)
+    munmap(mapping, head);
+  if (tail > 0)
+    munmap(aligned + reserved, tail);
+
+  base = aligned;
+
+  if (flags & ARENA_NORMAL_PAGES_FLAG)
+  {
+    page_type = ARENA_PAGE_TYPE_NORMAL;
+#ifdef MADV_NOHUGEPAGE
+    madvise(base, reserved, MADV_NOHUGEPAGE);
+#endif
+    return;
+  }
+
+#ifdef MAP_HUGETLB
+  if (flags & ARENA_HUGETLB_FLAG)
+    page_type = ARENA_PAGE_TYPE_HUGETLB;
+  else
+#endif
+    page_type = ARENA_PAGE_TYPE_TRANSPARENT_HUGE;
+
+#ifdef MADV_HUGEPAGE
+  if (page_type == ARENA_PAGE_TYPE_TRANSPARENT_HUGE && madvise(base, reserved, MADV_HUGEPAGE) != 0)
+    page_type = ARENA_PAGE_TYPE_NORMAL;
+#else
+  if (page_type == ARENA_PAGE_TYPE_TRANSPARENT_HUGE)
+    page_type = ARENA_PAGE_TYPE_NORMAL;
+#endif
+}
+
+me::Arena::~Arena()
+{
+  munmap(base, reserved);
+}
+
+void* me::Arena::allocate(size_t size, size_t alignment)
+{
+  size_t offset = align_up(used, alignment);
+  if (offset + size > reserved)
+    throw exception("arena out of memory. \e[31m%lu\e[0m > %lu", offset + size, reserved);
+
+  if (offset + size > committed)
+    commit(offset + size);
+
+  used = offset + size;
+  return base + offset;
+}
+
+void* me::Arena::reallocate(void* data, size_t size, size_t new_size, size_t alignment)
+{
+  /* the latest allocation ends at 'used', it can grow without moving */
+  if (data != nullptr && static_cast<char*>(data) + size == base + used)
+  {
+    size_t offset = static_cast<char*>(data) - base;
+    if (offset + new_size > reserved)
+      throw exception("arena out of memory. \e[31m%lu\e[0m > %lu", offset + new_size, reserved);
+
+    if (offset + new_size > committed)
+      commit(offset + new_size);
+
+    used = offset + new_size;
+    return data;
+  }
+
+  void* new_data = allocate(new_size, alignment);
+  if (data != nullptr)
+    memcpy(new_data, data, size < new_size ? size : new_size);
+  return new_data;
+}
+
+void me::Arena::reset()
+{
+  /* give the pages back to the kernel but keep the reservation.
+   * mapping over the range replaces it in one step, unmapping first would leave a hole another thread could map into */
+  if (committed > 0)
+  {
+    void* mapping = mmap(base, committed, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_FIXED, -1, 0);
+    if (mapping == MAP_FAILED)
+      throw exception("failed to release %lu bytes of arena memory [%s]", committed, strerror(errno));
+#ifdef MADV_HUGEPAGE
+    if (page_type == ARENA_PAGE_TYPE_TRANSPARENT_HUGE)
+      madvise(base, committed, MADV_HUGEPAGE);
+#endif
+#ifdef MADV_NOHUGEPAGE
+    if (flags & ARENA_NORMAL_PAGES_FLAG)
+      madvise(base, committed, MADV_NOHUGEPAGE);
+#endif
+  }
+  committed = 0;
+  used = 0;
+}
+
+void me::Arena::commit(size_t size)
+{
+  size_t new_committed = align_up(size, HUGE_PAGE_SIZE);
+  char* begin = base + committed;
+  size_t length = new_committed - committed;
+
+#ifdef MAP_HUGETLB
+  if (page_type == ARENA_PAGE_TYPE_HUGETLB)
+  {
+    /* explicit huge pages are reserved from the hugetlb pool when mapped,
+     * if the pool is empty mmap fails here instead of faulting later */
+    void* mapping = mmap(begin, length, PROT_READ | PROT_WRITE,
+	MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED | MAP_HUGETLB, -1, 0);
+    if (mapping != MAP_FAILED)
+    {
+      committed = new_committed;
+      return;
+    }
+
+    /* fallback to transparent huge pages for the rest of the arena */
+    page_type = ARENA_PAGE_TYPE_TRANSPARENT_HUGE;
+    mapping = mmap(begin, reserved - committed, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_FIXED, -1, 0);
+    if (mapping == MAP_FAILED)
+      throw exception("failed to reserve the arena again without huge pages [%s]", strerror(errno));
+#ifdef MADV_HUGEPAGE
+    if (madvise(begin, reserved - committed, MADV_HUGEPAGE) != 0)
+      page_type = ARENA_PAGE_TYPE_NORMAL;
+#else
+    page_type = ARENA_PAGE_TYPE_NORMAL;
+#endif
+  }
+#endif
+
+  if (mprotect(begin, length, PROT_READ | PROT_WRITE) != 0)
+    throw exception("failed to commit %lu bytes of arena memory [%s]", length, strerror(errno));
+  committed = new_committed;
+}
+
+const char* me::arena_page_type_name(ArenaPageType type)
+{
+  switch (type)
+  {
+    case ARENA_PAGE_TYPE_HUGETLB: return "ARENA_PAGE_TYPE_HUGETLB";
+    case ARENA_PAGE_TYPE_TRANSPARENT_HUGE: return "ARENA_PAGE_TYPE_TRANSPARENT_HUGE";
+    case ARENA_PAGE_TYPE_NORMAL: return "ARENA_PAGE_TYPE_NORMAL";
+    default: return "?";
+  }
+}
@@ -0,0 +1,93 @@
+#ifndef ME_ARENA_HPP
+  #define ME_ARENA_HPP
+
+#include <new>
+
+namespace me {
+
+  enum ArenaFlags {
+    ARENA_HUGETLB_FLAG = 1, /* try explicit huge pages (MAP_HUGETLB) before transparent huge pages */
+    ARENA_NORMAL_PAGES_FLAG = 1 << 1 /* never use huge pages, even if transparent huge pages are always on */
+  };
+
+  enum ArenaPageType {
+    ARENA_PAGE_TYPE_HUGETLB,
+    ARENA_PAGE_TYPE_TRANSPARENT_HUGE,
+    ARENA_PAGE_TYPE_NORMAL
+  };
+
+
+  /* linear allocator over a virtual memory range reserved up front.
+   * memory is committed in huge page sized steps and only released on 'reset()' or destruction,
+   * objects allocated from the arena are never destructed */
+  class Arena {
+
+  public:
+
+    static constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+  protected:
+
+    char* base;
+    size_t reserved;
+    size_t committed;
+    size_t used;
+    uint32_t flags;
+    ArenaPageType page_type;
+
+  public:
+
+    explicit Arena(size_t reserve_size, uint32_t flags = 0);
+    ~Arena();
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    [[nodiscard]] void* allocate(size_t size, size_t alignment);
+
+    template<typename T, typename... A>
+    [[nodiscard]] T* allocate(A&&... args)
+    {
+      return new (allocate(sizeof(T), alignof(T))) T(static_cast<A&&>(args)...);
+    }
+
+    template<typename T>
+    [[nodiscard]] T* allocate_array(size_t count)
+    {
+      T* array = static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+      for (size_t i = 0; i < count; i++)
+	new (array + i) T();
+      return array;
+    }
+
+    /* grows the latest allocation in place, any other is copied into a new allocation and its memory stays used */
+    [[nodiscard]] void* reallocate(void* data, size_t size, size_t new_size, size_t alignment);
+
+    void reset();
+
+    size_t get_used() const
+    {
+      return used;
+    }
+
+    size_t get_committed() const
+    {
+      return committed;
+    }
+
+    ArenaPageType get_page_type() const
+    {
+      return page_type;
+    }
+
+  protected:
+
+    void commit(size_t size);
+
+  };
+
+  const char* arena_page_type_name(ArenaPageType type);
+
+}
+
+#endif
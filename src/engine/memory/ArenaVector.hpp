@@ -0,0 +1,120 @@
+#ifndef ME_ARENA_VECTOR_HPP
+  #define ME_ARENA_VECTOR_HPP
+
+#include "Arena.hpp"
+
+#include <lme/string.hpp>
+
+#include <stdlib.h>
+#include <string.h>
+
+namespace me {
+
+  /* growable array of plain structs, in an arena if it has one and on the heap otherwise.
+   * elements are moved with 'memcpy' and never destructed.
+   * arena memory is given back with the arena, heap memory by the destructor */
+  template<typename T>
+  class ArenaVector {
+
+  protected:
+
+    Arena* arena;
+    T* items;
+    size_t count;
+    size_t capacity;
+
+  public:
+
+    explicit ArenaVector(Arena* arena = nullptr)
+      : arena(arena), items(nullptr), count(0), capacity(0)
+    {
+    }
+
+    ~ArenaVector()
+    {
+      if (arena == nullptr)
+	free(items);
+    }
+
+    ArenaVector(const ArenaVector&) = delete;
+    ArenaVector& operator=(const ArenaVector&) = delete;
+
+    void reserve(size_t new_capacity)
+    {
+      if (new_capacity <= capacity)
+	return;
+
+      if (arena != nullptr)
+	items = static_cast<T*>(arena->reallocate(items, sizeof(T) * capacity, sizeof(T) * new_capacity, alignof(T)));
+      else
+      {
+	T* new_items = static_cast<T*>(realloc(items, sizeof(T) * new_capacity));
+	if (new_items == nullptr)
+	  throw exception("failed to grow an array to %lu elements", new_capacity);
+	items = new_items;
+      }
+      capacity = new_capacity;
+    }
+
+    /* new elements are zeroed */
+    void resize(size_t new_count)
+    {
+      if (new_count > capacity)
+	reserve(new_count > capacity * 2 ? new_count : capacity * 2);
+      if (new_count > count)
+	memset(static_cast<void*>(items + count), 0, sizeof(T) * (new_count - count));
+      count = new_count;
+    }
+
+    void push_back(const T &item)
+    {
+      if (count == capacity)
+	reserve(capacity > 0 ? capacity * 2 : 16);
+      items[count++] = item;
+    }
+
+    void clear()
+    {
+      count = 0;
+    }
+
+    T* data()
+    {
+      return items;
+    }
+
+    const T* data() const
+    {
+      return items;
+    }
+
+    size_t size() const
+    {
+      return count;
+    }
+
+    T& operator[](size_t index)
+    {
+      return items[index];
+    }
+
+    const T& operator[](size_t index) const
+    {
+      return items[index];
+    }
+
+    T* begin()
+    {
+      return items;
+    }
+
+    T* end()
+    {
+      return items + count;
+    }
+
+  };
+
+}
+
+#endif
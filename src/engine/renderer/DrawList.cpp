@@ -0,0 +1,261 @@
+#include "DrawList.hpp"
+
+static size_t hash_state(
+    const void* 				state
+    );
+
+static int count_binds(
+    const me::DrawItem* 			draws,
+    const uint32_t* 				order,
+    uint32_t 					draw_count,
+    uint32_t 					&pipeline_binds,
+    uint32_t 					&descriptor_binds,
+    uint32_t 					&material_changes,
+    uint32_t 					&mesh_changes
+    );
+
+
+me::DrawList::DrawList()
+{
+  pipeline_ids.count = 0;
+  descriptor_ids.count = 0;
+  material_ids.count = 0;
+  mesh_ids.count = 0;
+  pipeline_ids.next_id = 1;
+  descriptor_ids.next_id = 1;
+  material_ids.next_id = 1;
+  mesh_ids.next_id = 1;
+  stats = { };
+}
+
+int me::DrawList::clear()
+{
+  draws.resize(0);
+  keys.resize(0);
+  sorted_draws.resize(0);
+  return 0;
+}
+
+int me::DrawList::release(const void* state)
+{
+  /* the pointer is only in the table of its kind, looking in the others is cheap */
+  release_state_id(pipeline_ids, state);
+  release_state_id(descriptor_ids, state);
+  release_state_id(material_ids, state);
+  release_state_id(mesh_ids, state);
+  return 0;
+}
+
+int me::DrawList::add(const DrawItem &draw)
+{
+  uint64_t key = 0;
+  key |= static_cast<uint64_t>(get_state_id(pipeline_ids, draw.pipeline)) << (3 * STATE_BITS);
+  key |= static_cast<uint64_t>(get_state_id(descriptor_ids, draw.descriptor)) << (2 * STATE_BITS);
+  key |= static_cast<uint64_t>(get_state_id(material_ids, draw.material)) << STATE_BITS;
+  key |= static_cast<uint64_t>(get_state_id(mesh_ids, draw.mesh));
+
+  draws.push_back(draw);
+  keys.push_back(key);
+  return 0;
+}
+
+int me::DrawList::sort()
+{
+  uint32_t draw_count = draws.size();
+
+  order.resize(draw_count);
+  scratch_keys.resize(draw_count);
+  scratch_order.resize(draw_count);
+  for (uint32_t i = 0; i < draw_count; i++)
+    order[i] = i;
+
+  stats = { };
+  stats.draw_count = draw_count;
+  count_binds(draws.data(), order.data(), draw_count,
+      stats.unsorted_pipeline_binds, stats.unsorted_descriptor_binds, stats.unsorted_material_changes, stats.unsorted_mesh_changes);
+
+  /* least significant byte first, the sort is stable so draws with the same key keep the order they were added in.
+   * bytes that are the same for every draw (most of the id bits in small scenes) are skipped */
+  uint64_t* source_keys = keys.data();
+  uint32_t* source_order = order.data();
+  uint64_t* destination_keys = scratch_keys.data();
+  uint32_t* destination_order = scratch_order.data();
+  for (uint32_t shift = 0; shift < 64; shift += 8)
+  {
+    uint32_t offsets[256] = { };
+    for (uint32_t i = 0; i < draw_count; i++)
+      offsets[(source_keys[i] >> shift) & 0xFF]++;
+
+    if (draw_count == 0 || offsets[(source_keys[0] >> shift) & 0xFF] == draw_count)
+      continue;
+
+    uint32_t offset = 0;
+    for (uint32_t i = 0; i < 256; i++)
+    {
+      uint32_t count = offsets[i];
+      offsets[i] = offset;
+      offset += count;
+    }
+
+    for (uint32_t i = 0; i < draw_count; i++)
+    {
+      uint32_t position = offsets[(source_keys[i] >> shift) & 0xFF]++;
+      destination_keys[position] = source_keys[i];
+      destination_order[position] = source_order[i];
+    }
+
+    uint64_t* keys_swap = source_keys;
+    source_keys = destination_keys;
+    destination_keys = keys_swap;
+    uint32_t* order_swap = source_order;
+    source_order = destination_order;
+    destination_order = order_swap;
+  }
+
+  sorted_draws.resize(draw_count);
+  for (uint32_t i = 0; i < draw_count; i++)
+    sorted_draws[i] = draws[source_order[i]];
+
+  count_binds(draws.data(), source_order, draw_count,
+      stats.sorted_pipeline_binds, stats.sorted_descriptor_binds, stats.sorted_material_changes, stats.sorted_mesh_changes);
+  return 0;
+}
+
+uint32_t me::DrawList::get_state_id(StateTable &table, const void* state)
+{
+  if (state == nullptr)
+    return 0;
+
+  /* at most half full */
+  if ((table.count + 1) * 2 > table.slots.size())
+    grow_state_table(table);
+
+  size_t mask = table.slots.size() - 1;
+  size_t index = hash_state(state) & mask;
+  while (table.slots[index].state != nullptr && table.slots[index].state != state)
+    index = (index + 1) & mask;
+
+  if (table.slots[index].state == nullptr)
+  {
+    uint32_t id;
+    if (table.free_ids.size() > 0)
+    {
+      id = table.free_ids[table.free_ids.size() - 1];
+      table.free_ids.resize(table.free_ids.size() - 1);
+    }else
+    {
+      id = table.next_id < MAX_STATE_ID ? table.next_id++ : MAX_STATE_ID;
+    }
+
+    table.count++;
+    table.slots[index].state = state;
+    table.slots[index].id = id;
+  }
+  return table.slots[index].id;
+}
+
+int me::DrawList::release_state_id(StateTable &table, const void* state)
+{
+  if (state == nullptr || table.slots.size() == 0)
+    return 0;
+
+  size_t mask = table.slots.size() - 1;
+  size_t index = hash_state(state) & mask;
+  while (table.slots[index].state != nullptr && table.slots[index].state != state)
+    index = (index + 1) & mask;
+
+  if (table.slots[index].state == nullptr)
+    return 0;
+
+  /* the last id is shared by every state after it */
+  if (table.slots[index].id != MAX_STATE_ID)
+    table.free_ids.push_back(table.slots[index].id);
+  table.count--;
+
+  /* shifts the following slots of the probe sequence back, so no lookup stops at the hole */
+  size_t next = (index + 1) & mask;
+  while (table.slots[next].state != nullptr)
+  {
+    size_t home = hash_state(table.slots[next].state) & mask;
+    if (((next - home) & mask) >= ((next - index) & mask))
+    {
+      table.slots[index] = table.slots[next];
+      index = next;
+    }
+    next = (next + 1) & mask;
+  }
+  table.slots[index] = {nullptr, 0};
+  return 0;
+}
+
+int me::DrawList::grow_state_table(StateTable &table)
+{
+  vector<StateSlot> slots;
+  slots.resize(table.slots.size() > 0 ? table.slots.size() * 2 : 64);
+  for (size_t i = 0; i < slots.size(); i++)
+    slots[i] = {nullptr, 0};
+
+  size_t mask = slots.size() - 1;
+  for (size_t i = 0; i < table.slots.size(); i++)
+  {
+    if (table.slots[i].state == nullptr)
+      continue;
+
+    size_t index = hash_state(table.slots[i].state) & mask;
+    while (slots[index].state != nullptr)
+      index = (index + 1) & mask;
+    slots[index] = table.slots[i];
+  }
+
+  table.slots.resize(slots.size());
+  for (size_t i = 0; i < slots.size(); i++)
+    table.slots[i] = slots[i];
+  return 0;
+}
+
+
+size_t hash_state(
+    const void* 				state
+    )
+{
+  /* the low bits of a pointer are mostly alignment */
+  uint64_t value = reinterpret_cast<uintptr_t>(state);
+  value ^= value >> 33;
+  value *= 0xFF51AFD7ED558CCDULL;
+  value ^= value >> 33;
+  return static_cast<size_t>(value);
+}
+
+int count_binds(
+    const me::DrawItem* 			draws,
+    const uint32_t* 				order,
+    uint32_t 					draw_count,
+    uint32_t 					&pipeline_binds,
+    uint32_t 					&descriptor_binds,
+    uint32_t 					&material_changes,
+    uint32_t 					&mesh_changes
+    )
+{
+  /* the same rules as 'cmd_draw_list', a new pipeline also binds the descriptor again */
+  pipeline_binds = 0;
+  descriptor_binds = 0;
+  material_changes = 0;
+  mesh_changes = 0;
+
+  const me::DrawItem* previous = nullptr;
+  for (uint32_t i = 0; i < draw_count; i++)
+  {
+    const me::DrawItem &draw = draws[order[i]];
+    bool pipeline_changed = previous == nullptr || draw.pipeline != previous->pipeline;
+    if (pipeline_changed)
+      pipeline_binds++;
+    if (draw.descriptor != nullptr && (pipeline_changed || draw.descriptor != previous->descriptor))
+      descriptor_binds++;
+    if (previous == nullptr || draw.material != previous->material)
+      material_changes++;
+    if (previous == nullptr || draw.mesh != previous->mesh)
+      mesh_changes++;
+    previous = &draw;
+  }
+  return 0;
+}
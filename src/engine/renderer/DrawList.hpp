@@ -0,0 +1,110 @@
+#ifndef ME_DRAW_LIST_HPP
+  #define ME_DRAW_LIST_HPP
+
+#include "Types.hpp"
+
+#include <lme/vector.hpp>
+
+namespace me {
+
+  /* binds 'cmd_draw_list' makes for the draws, in the order they were added and in sorted order.
+   * the geometry pool's vertex buffer is bound once per list, mesh changes are the binds a buffer per mesh would need */
+  struct DrawListStats {
+    uint32_t draw_count;
+    uint32_t unsorted_pipeline_binds;
+    uint32_t unsorted_descriptor_binds;
+    uint32_t unsorted_material_changes;
+    uint32_t unsorted_mesh_changes;
+    uint32_t sorted_pipeline_binds;
+    uint32_t sorted_descriptor_binds;
+    uint32_t sorted_material_changes;
+    uint32_t sorted_mesh_changes;
+  };
+
+  /* collects the draws of a frame and sorts them by a 64 bit key of their state,
+   * from the most to the least expensive to change: pipeline, descriptor, material and mesh.
+   * every state gets a small id the first time it is added, the ids are kept between frames
+   * so the same scene sorts the same way every frame */
+  class DrawList {
+
+  public:
+
+    static constexpr uint32_t STATE_BITS = 16;
+    static constexpr uint32_t MAX_STATE_ID = (1 << STATE_BITS) - 1; /* states after this share the last id */
+
+  protected:
+
+    struct StateSlot {
+      const void* state;
+      uint32_t id;
+    };
+
+    /* open addressing table from a state pointer to its id, id 0 is nullptr */
+    struct StateTable {
+      vector<StateSlot> slots;
+      uint32_t count;
+      uint32_t next_id;
+      vector<uint32_t> free_ids; /* of released states */
+    };
+
+    StateTable pipeline_ids;
+    StateTable descriptor_ids;
+    StateTable material_ids;
+    StateTable mesh_ids;
+
+    vector<DrawItem> draws;
+    vector<uint64_t> keys;
+    vector<uint32_t> order;
+    vector<uint64_t> scratch_keys;
+    vector<uint32_t> scratch_order;
+    vector<DrawItem> sorted_draws;
+
+    DrawListStats stats;
+
+  public:
+
+    DrawList();
+
+    /* forgets the draws, the state ids are kept */
+    int clear();
+
+    /* forgets the id of a pipeline, descriptor, material or mesh that is destroyed,
+     * so a new state at the same address doesn't sort with draws of the old one. the id is reused */
+    int release(
+	const void* 					state
+	);
+
+    int add(
+	const DrawItem 					&draw
+	);
+
+    /* radix sorts the draws by their key, 'get_draws' returns them in sorted order afterwards */
+    int sort();
+
+    const DrawItem* get_draws() const
+    {
+      return sorted_draws.data();
+    }
+
+    uint32_t get_draw_count() const
+    {
+      return sorted_draws.size();
+    }
+
+    /* of the last 'sort' */
+    const DrawListStats& get_stats() const
+    {
+      return stats;
+    }
+
+  protected:
+
+    uint32_t get_state_id(StateTable &table, const void* state);
+    int release_state_id(StateTable &table, const void* state);
+    int grow_state_table(StateTable &table);
+
+  };
+
+}
+
+#endif
@@ -0,0 +1,82 @@
+#include "Instancing.hpp"
+
+#include <string.h>
+
+int me::InstanceBatcher::build(
+    Pipeline 						pipeline,
+    Descriptor 						descriptor,
+    uint32_t 						item_count,
+    MeshItem** 						items
+    )
+{
+  /* the draw list sorts items with the same mesh and material next to each other,
+   * 'first_instance' carries the item index through the sort */
+  draw_list.clear();
+  for (uint32_t i = 0; i < item_count; i++)
+  {
+    const MeshItem* item = items[i];
+    if (!(item->flags & MESH_VISIBLE_FLAG) || item->mesh == nullptr)
+      continue;
+
+    draw_list.add({pipeline, descriptor, item->material, item->mesh, i, 1});
+  }
+  draw_list.sort();
+
+  const DrawItem* draws = draw_list.get_draws();
+  uint32_t draw_count = draw_list.get_draw_count();
+
+  instances.resize(draw_count);
+  batches.resize(0);
+  for (uint32_t i = 0; i < draw_count; i++)
+  {
+    const MeshItem* item = items[draws[i].first_instance];
+
+    InstanceData &instance = instances[i];
+    instance.position[0] = item->position[0];
+    instance.position[1] = item->position[1];
+    instance.position[2] = item->position[2];
+    instance.position[3] = 1.0F;
+    instance.rotation[0] = item->rotation[0];
+    instance.rotation[1] = item->rotation[1];
+    instance.rotation[2] = item->rotation[2];
+    instance.rotation[3] = 0.0F;
+    instance.scale[0] = item->scale[0];
+    instance.scale[1] = item->scale[1];
+    instance.scale[2] = item->scale[2];
+    instance.scale[3] = 1.0F;
+
+    /* the pipeline and descriptor are the same for every item, so only the mesh and material split batches */
+    if (batches.size() > 0)
+    {
+      DrawItem &batch = batches[batches.size() - 1];
+      if (batch.mesh == draws[i].mesh && batch.material == draws[i].material)
+      {
+	batch.instance_count++;
+	continue;
+      }
+    }
+    batches.push_back({pipeline, descriptor, draws[i].material, draws[i].mesh, i, 1});
+  }
+  return 0;
+}
+
+int me::InstanceBatcher::write(
+    RendererModule* 					renderer,
+    Device 						device,
+    Buffer 						buffer,
+    size_t 						buffer_size
+    )
+{
+  size_t size = instances.size() * sizeof(InstanceData);
+  if (size > buffer_size)
+    throw exception("instance buffer is too small for the batched instances. \e[31m%lu\e[0m > %lu", size, buffer_size);
+
+  if (size == 0)
+    return 0;
+
+  void* data;
+  renderer->get_buffer_data(buffer, data);
+  memcpy(data, instances.data(), size);
+  renderer->buffer_flush(device, buffer, 0, size);
+  return 0;
+}
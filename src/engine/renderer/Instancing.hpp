@@ -0,0 +1,87 @@
+#ifndef ME_INSTANCING_HPP
+  #define ME_INSTANCING_HPP
+
+#include "DrawList.hpp"
+#include "Renderer.hpp"
+
+#include <lme/vector.hpp>
+
+namespace me {
+
+  /* per-instance vertex data, three 'FORMAT_VECTOR4_32FLOAT' attributes of a 'ShaderBinding::per_instance' binding.
+   * the vertex shader builds the model transform from them, w is unused */
+  struct InstanceData {
+    float position[4];
+    float rotation[4];
+    float scale[4];
+  };
+
+  /* groups the visible mesh items that share a mesh and a material into one instanced draw.
+   * the instances of a batch are consecutive in the instance data, so every batch is a
+   * 'firstInstance' range of a single instance buffer */
+  class InstanceBatcher {
+
+  protected:
+
+    DrawList draw_list;
+    vector<InstanceData> instances;
+    vector<DrawItem> batches;
+
+  public:
+
+    /* replaces the batches of the last build, items without 'MESH_VISIBLE_FLAG' are skipped */
+    int build(
+	Pipeline 					pipeline,
+	Descriptor 					descriptor,
+	uint32_t 					item_count,
+	MeshItem** 					items
+	);
+
+    /* copies the instance data to a persistently mapped 'BUFFER_WRITE_METHOD_STANDARD' buffer */
+    int write(
+	RendererModule* 				renderer,
+	Device 						device,
+	Buffer 						buffer,
+	size_t 						buffer_size
+	);
+
+    /* see 'DrawList::release' */
+    int release(
+	const void* 					state
+	)
+    {
+      return draw_list.release(state);
+    }
+
+    /* draws for 'cmd_draw_list', sorted by state */
+    const DrawItem* get_batches() const
+    {
+      return batches.data();
+    }
+
+    uint32_t get_batch_count() const
+    {
+      return batches.size();
+    }
+
+    const InstanceData* get_instances() const
+    {
+      return instances.data();
+    }
+
+    uint32_t get_instance_count() const
+    {
+      return instances.size();
+    }
+
+    /* of the items before they were batched */
+    const DrawListStats& get_stats() const
+    {
+      return draw_list.get_stats();
+    }
+
+  };
+
+}
+
+#endif
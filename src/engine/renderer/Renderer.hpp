@@ -41,11 +41,20 @@ namespace me {
     virtual int create_buffer(const BufferCreateInfo &buffer_create_info, Buffer &buffer) = 0;
     virtual int create_render_pass(const RenderPassCreateInfo &render_pass_create_info, RenderPass &render_pass) = 0;
     virtual int create_pipeline(const PipelineCreateInfo &pipeline_create_info, Pipeline &pipeline) = 0;
+    /* compiles the pipeline on a background thread into the device's pipeline cache and returns right away.
+     * the create info and the shaders with their code are copied, only the render pass must stay alive until the build is done */
+    virtual int create_pipeline_async(const PipelineCreateInfo &pipeline_create_info, PipelineBuild &build) = 0;
     virtual int create_framebuffer(const FramebufferCreateInfo &framebuffer_create_info, Framebuffer &framebuffer) = 0;
     virtual int create_descriptor_pool(const DescriptorPoolCreateInfo &descriptor_pool_create_info, DescriptorPool &descriptor_pool) = 0;
     virtual int create_descriptors(const DescriptorCreateInfo &descriptor_create_info, uint32_t descriptor_count, Descriptor* descriptors) = 0;
     virtual int create_command_pool(const CommandPoolCreateInfo &command_pool_create_info, CommandPool &command_pool) = 0;
     virtual int create_command_buffers(const CommandBufferCreateInfo &command_buffer_create_info, uint32_t buffer_count, CommandBuffer* buffers) = 0;
+    virtual int create_uniform_ring(const UniformRingCreateInfo &uniform_ring_create_info, UniformRing &uniform_ring) = 0;
+    /* the attachments are placed in as few memory blocks as their lifetimes allow,
+     * an aliased attachment must be cleared or fully written at the start of its first pass */
+    virtual int create_attachments(const AttachmentCreateInfo &attachment_create_info, uint32_t attachment_count, Attachment* attachments) = 0;
+    virtual int create_indirect_draw_list(const IndirectDrawListCreateInfo &indirect_draw_list_create_info, IndirectDrawList &draw_list) = 0;
+    virtual int create_readback_ring(const ReadbackRingCreateInfo &readback_ring_create_info, ReadbackRing &readback_ring) = 0;
 
     virtual int cleanup_surface(Surface surface) = 0;
     virtual int cleanup_device(Device device) = 0;
@@ -54,20 +63,89 @@ namespace me {
     virtual int cleanup_frames(Device device, uint32_t frame_count, Frame* frames) = 0;
     virtual int cleanup_render_pass(Device device, RenderPass render_pass) = 0;
     virtual int cleanup_pipeline(Device device, Pipeline pipeline) = 0;
+    /* waits for a pending build. a built pipeline isn't cleaned up with the build, it needs its own 'cleanup_pipeline' */
+    virtual int cleanup_pipeline_build(Device device, PipelineBuild build) = 0;
     virtual int cleanup_framebuffer(Device device, Framebuffer framebuffer) = 0;
+    virtual int cleanup_buffer(Device device, Buffer buffer) = 0;
     virtual int cleanup_descriptor_pool(Device device, DescriptorPool descriptor_pool) = 0;
     virtual int cleanup_descriptors(Device device, DescriptorPool descriptor_pool, uint32_t descriptor_count, Descriptor* descriptors) = 0;
     virtual int cleanup_command_pool(Device device, CommandPool command_pool) = 0;
     virtual int cleanup_command_buffers(Device device, CommandPool command_pool, uint32_t buffer_count, CommandBuffer* buffers) = 0;
+    /* returns every command buffer of the pool to the initial state, none of them may be in use by the device */
+    virtual int reset_command_pool(Device device, CommandPool command_pool) = 0;
+    virtual int cleanup_uniform_ring(Device device, UniformRing uniform_ring) = 0;
+    virtual int cleanup_attachments(Device device, uint32_t attachment_count, Attachment* attachments) = 0;
+    virtual int cleanup_indirect_draw_list(Device device, IndirectDrawList draw_list) = 0;
+    /* waits for the copies that were submitted */
+    virtual int cleanup_readback_ring(Device device, ReadbackRing readback_ring) = 0;
 
     virtual int buffer_write(const BufferWriteInfo &buffer_write_info, Buffer buffer) = 0;
+    /* makes writes through the pointer from 'get_buffer_data' visible to the device */
+    virtual int buffer_flush(Device device, Buffer buffer, size_t offset, size_t size) = 0;
+
+    /* 'BUFFER_WRITE_METHOD_STAGING' writes are recorded and only submitted on 'transfer_flush' or 'frame_render'.
+     * the returned ticket is reached once everything written before the flush is on the device */
+    virtual int transfer_flush(Device device, TransferTicket &ticket) = 0;
+    virtual int transfer_wait(Device device, TransferTicket ticket) = 0;
+    virtual int transfer_is_complete(Device device, TransferTicket ticket, bool &complete) = 0;
+
+    /* call once per frame before recording, from the thread that prepares the frames.
+     * packs the mesh geometry when its free space is fragmented, or moves 'BUFFER_WRITE_METHOD_STAGING' buffers
+     * out of sparsely used memory blocks so the blocks can be freed. either way at most 'byte_budget' bytes are copied.
+     * descriptors from a descriptor pool are written again with the moved buffers, their pipeline must outlive them.
+     * buffers added to the bindless table are never moved.
+     * if 'moved_count' isn't 0, command buffers recorded before with those buffers must be recorded again */
+    virtual int defragment(Device device, size_t byte_budget, uint32_t &moved_count) = 0;
+
+    /* adds a 'BUFFER_USAGE_STORAGE' buffer to the storage buffer array of the bindless table,
+     * shaders of bindless pipelines reach it at 'index'. the index stays valid until it is removed */
+    virtual int bindless_add_buffer(Device device, Buffer buffer, uint32_t &index) = 0;
+    virtual int bindless_remove_buffer(Device device, uint32_t index) = 0;
+
+    /* per-draw uniform data is pushed into the region of the current frame,
+     * the returned offset is used as the dynamic offset of a 'DESCRIPTOR_TYPE_UNIFORM_DYNAMIC' descriptor.
+     * the region of a frame is reused once that frame index begins again */
+    virtual int uniform_ring_begin_frame(UniformRing uniform_ring, uint32_t frame_index) = 0;
+    virtual int uniform_ring_push(UniformRing uniform_ring, const void* data, size_t size, uint32_t &offset) = 0;
+
+    /* replaces the objects of the frame, evicted meshes are streamed in like in 'make_meshes_resident' and from the same thread.
+     * the draw of object i has 'firstInstance' i, so shaders can index per-object data with 'gl_InstanceIndex'.
+     * the meshes must stay alive until 'cmd_cull_indirect', which reads their ranges again if the geometry pool moved them */
+    virtual int indirect_draw_list_write(const IndirectDrawListWriteInfo &indirect_draw_list_write_info, IndirectDrawList draw_list) = 0;
+
+    /* never blocks. the oldest copy once the device has finished it, copies are read in the order they were recorded.
+     * it stays valid until 'readback_ring_release', which frees its slot for another copy */
+    virtual int readback_ring_acquire(ReadbackRing readback_ring, Readback &readback, bool &available) = 0;
+    virtual int readback_ring_release(ReadbackRing readback_ring) = 0;
 
     virtual int cmd_record_start(CommandBuffer command_buffer) = 0;
     virtual int cmd_record_stop(CommandBuffer command_buffer) = 0;
+    /* starts a secondary command buffer for one submit, it continues the render pass of the primary command buffer that executes it.
+     * secondary command buffers from different command pools can be recorded on different threads.
+     * the viewport and scissor cover the framebuffer, without one they must be set with 'cmd_set_viewport' */
+    virtual int cmd_record_secondary_start(const CmdRecordSecondaryInfo &cmd_record_secondary_info, CommandBuffer command_buffer) = 0;
+    virtual int cmd_execute(CommandBuffer command_buffer, uint32_t secondary_count, CommandBuffer* secondaries) = 0;
     virtual int cmd_begin_render_pass(const CmdBeginRenderPassInfo &cmd_begin_render_pass_info, CommandBuffer command_buffer) = 0;
     virtual int cmd_end_render_pass(CommandBuffer command_buffer) = 0;
+    /* replaces the viewport and scissor that beginning a render pass or a secondary command buffer sets to the whole framebuffer */
+    virtual int cmd_set_viewport(const CmdSetViewportInfo &cmd_set_viewport_info, CommandBuffer command_buffer) = 0;
     virtual int cmd_bind_descriptors(const CmdBindDescriptorsInfo &cmd_bind_descriptors_info, CommandBuffer command_buffer) = 0;
     virtual int cmd_draw_meshes(const CmdDrawMeshesInfo &cmd_draw_meshes_info, CommandBuffer command_buffer) = 0;
+    /* binds the pipeline and descriptor of a draw only when they differ from the previous draw,
+     * the geometry pool's buffers are bound once for all of them. draws without a pipeline are skipped */
+    virtual int cmd_draw_list(const CmdDrawListInfo &cmd_draw_list_info, CommandBuffer command_buffer) = 0;
+    /* culls the objects of the last write against the frustum on the device, recorded outside of a render pass */
+    virtual int cmd_cull_indirect(const CmdCullIndirectInfo &cmd_cull_indirect_info, CommandBuffer command_buffer) = 0;
+    /* draws the objects that survived 'cmd_cull_indirect' without reading anything back to the host */
+    virtual int cmd_draw_indirect(const CmdDrawIndirectInfo &cmd_draw_indirect_info, CommandBuffer command_buffer) = 0;
+    /* gpu time of the commands up to 'cmd_end_profile_region', read back a few frames later into 'DeviceCreateInfo::profiler'.
+     * render passes are timed on their own. only for frame command buffers, the label must stay valid as long as the profiler.
+     * inside a render pass recorded in secondary command buffers regions go into the secondaries */
+    virtual int cmd_begin_profile_region(const char* label, CommandBuffer command_buffer, ProfileRegion &region) = 0;
+    virtual int cmd_end_profile_region(ProfileRegion region, CommandBuffer command_buffer) = 0;
+    /* copies an attachment into the next free slot of the ring, recorded after the render pass that wrote it.
+     * if every slot is in use the copy is skipped, it never waits for the host to read */
+    virtual int cmd_readback(const CmdReadbackInfo &cmd_readback_info, CommandBuffer command_buffer) = 0;
 
     virtual int frame_prepare(const FramePrepareInfo &frame_prepare_info, FramePresented &frame_prepared) = 0;
     virtual int frame_render(const FrameRenderInfo &frame_render_info, FrameRendered &frame_rendered) = 0;
@@ -75,10 +153,32 @@ namespace me {
 
     virtual int get_physical_device_properties(PhysicalDevice physical_device, PhysicalDeviceProperties &physical_device_properties) = 0;
     virtual int get_swapchain_image_count(Device device, Swapchain swapchain, uint32_t &image_count) = 0;
+    /* the size of the swapchain's images, framebuffers for them must have the same size */
+    virtual int get_swapchain_extent(Swapchain swapchain, math::vec2u &extent) = 0;
+    /* pointer to the persistently mapped memory of a 'BUFFER_WRITE_METHOD_STANDARD' buffer */
+    virtual int get_buffer_data(Buffer buffer, void* &data) = 0;
+    /* 'budgets' can be nullptr to get 'heap_count' */
+    virtual int get_memory_budget(Device device, uint32_t &heap_count, MemoryHeapBudget* budgets) = 0;
+    /* never blocks. 'pipeline' is the built pipeline once the build is ready, until then (or if it failed) it is 'fallback'.
+     * with a nullptr fallback the draws of the pipeline are skipped by 'cmd_draw_list' */
+    virtual int get_pipeline_build(PipelineBuild build, Pipeline fallback, PipelineBuildStatus &status, Pipeline &pipeline) = 0;
+    /* the buffer to bind to a 'DESCRIPTOR_TYPE_UNIFORM_DYNAMIC' descriptor */
+    virtual int get_uniform_ring_buffer(UniformRing uniform_ring, Buffer &buffer) = 0;
 
     virtual int frame_prepared_get_image_index(FramePrepared frame_prepared, uint32_t &image_index) = 0;
 
     virtual int setup_mesh(const SetupMeshInfo &setup_mesh_info, Mesh* mesh) = 0;
+    /* uploads the meshes in one staging pass with a single submit. meshes that don't fit
+     * in the residency budget anymore are uploaded by 'make_meshes_resident' when they are drawn */
+    virtual int setup_meshes(const SetupMeshInfo &setup_mesh_info, uint32_t mesh_count, Mesh** meshes) = 0;
+    virtual int cleanup_mesh(Device device, Mesh* mesh) = 0;
+    /* streams in the meshes that were evicted and marks them as drawn this frame.
+     * call it from the thread that prepares the frames before recording draws of the meshes,
+     * the draw commands only read their geometry ranges and may be recorded on other threads */
+    virtual int make_meshes_resident(Device device, uint32_t mesh_count, Mesh** meshes) = 0;
+    /* mesh geometry is kept resident within what the heap's memory budget leaves for it,
+     * least recently drawn meshes are evicted above it. this caps it lower, 0 removes the cap */
+    virtual int set_residency_budget(Device device, size_t bytes) = 0;
 
   };
 
@@ -8,7 +8,8 @@ namespace me {
   enum ShaderType {
     SHADER_TYPE_VERTEX,
     SHADER_TYPE_FRAGMENT,
-    SHADER_TYPE_GEOMETRY
+    SHADER_TYPE_GEOMETRY,
+    SHADER_TYPE_COMPUTE
   };
 
 
@@ -16,6 +16,7 @@ const char* me::descriptor_type_name(DescriptorType type)
   switch (type)
   {
     case DESCRIPTOR_TYPE_UNIFORM: return "DESCRIPTOR_TYPE_UNIFORM";
+    case DESCRIPTOR_TYPE_UNIFORM_DYNAMIC: return "DESCRIPTOR_TYPE_UNIFORM_DYNAMIC";
     case DESCRIPTOR_TYPE_NONE: return "DESCRIPTOR_TYPE_NONE";
     default: return "?";
   }
@@ -3,6 +3,7 @@
 
 #include "../surface/Surface.hpp"
 #include "../EngineInfo.hpp"
+#include "../util/Profiler.hpp"
 #include "Shader.hpp"
 
 #include <lme/math/vector.hpp>
@@ -27,6 +28,10 @@ namespace me {
     STRUCTURE_TYPE_DESCRIPTOR_CREATE_INFO,
     STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
     STRUCTURE_TYPE_COMMAND_BUFFER_CREATE_INFO,
+    STRUCTURE_TYPE_UNIFORM_RING_CREATE_INFO,
+    STRUCTURE_TYPE_ATTACHMENT_CREATE_INFO,
+    STRUCTURE_TYPE_INDIRECT_DRAW_LIST_CREATE_INFO,
+    STRUCTURE_TYPE_READBACK_RING_CREATE_INFO,
     STRUCTURE_TYPE_NONE
   };
 
@@ -87,6 +92,9 @@ namespace me {
     FORMAT_VECTOR2_32FLOAT,
     FORMAT_VECTOR3_32FLOAT,
     FORMAT_VECTOR4_32FLOAT,
+    FORMAT_VECTOR4_8UNORM,
+    FORMAT_VECTOR4_16FLOAT,
+    FORMAT_DEPTH_32FLOAT,
     FORMAT_NONE
   };
   
@@ -98,8 +106,15 @@ namespace me {
     BUFFER_USAGE_NONE
   };
   
+  enum AttachmentType {
+    ATTACHMENT_TYPE_COLOR,
+    ATTACHMENT_TYPE_DEPTH,
+    ATTACHMENT_TYPE_NONE
+  };
+  
   enum DescriptorType {
     DESCRIPTOR_TYPE_UNIFORM,
+    DESCRIPTOR_TYPE_UNIFORM_DYNAMIC, /* offset is given per draw */
     DESCRIPTOR_TYPE_NONE
   };
   
@@ -114,8 +129,14 @@ namespace me {
     BUFFER_WRITE_METHOD_STAGING
   };
 
+  enum PipelineBuildStatus {
+    PIPELINE_BUILD_STATUS_PENDING,
+    PIPELINE_BUILD_STATUS_READY,
+    PIPELINE_BUILD_STATUS_FAILED
+  };
+
   enum FrameFlags {
-    FRAME_SWAPCHAIN_REFRESH_FLAG
+    FRAME_SWAPCHAIN_REFRESH_FLAG = 0x01 /* the swapchain doesn't match the surface anymore, a prepared frame with it can't be rendered */
   };
  
   
@@ -134,10 +155,17 @@ namespace me {
   typedef void* Descriptor;
   typedef void* CommandPool;
   typedef void* CommandBuffer;
+  typedef void* UniformRing;
+  typedef void* Attachment;
+  typedef void* IndirectDrawList;
+  typedef void* PipelineBuild;
+  typedef void* ReadbackRing;
 
   typedef uint32_t FramePrepared;
   typedef uint32_t FrameRendered;
   typedef uint32_t FramePresented;
+  typedef uint64_t TransferTicket;
+  typedef uint32_t ProfileRegion;
 
 
   struct PhysicalDeviceProperties {
@@ -149,6 +177,15 @@ namespace me {
     uint32_t api_version;
   };
 
+  struct MemoryHeapBudget {
+    size_t size;
+    size_t budget;
+    size_t usage; /* usage of the whole process if the device supports 'VK_EXT_memory_budget' */
+    size_t allocated; /* bytes allocated from the heap by the renderer */
+    size_t used; /* bytes of 'allocated' in use by resources */
+    bool device_local;
+  };
+
   struct Viewport {
     math::vec2f location;
     math::vec2f size;
@@ -162,6 +199,7 @@ namespace me {
   struct ShaderBinding {
     uint32_t binding;
     uint32_t stride;
+    bool per_instance; /* advances once per instance instead of once per vertex */
   };
   
   struct ShaderAttribute {
@@ -199,6 +237,11 @@ namespace me {
     Surface surface; /* optional */
     uint32_t physical_device_count;
     PhysicalDevice* physical_devices;
+    uint32_t frame_count; /* frames in flight, used to size per-frame resources */
+    uint32_t thread_count; /* threads recording frame command buffers at the same time, 0 for 1 */
+    const char* pipeline_cache_path; /* optional, compiled pipelines are kept in this file between runs */
+    uint32_t pipeline_thread_count; /* background threads compiling 'create_pipeline_async' pipelines, 0 for 1 */
+    Profiler* profiler; /* optional, receives the gpu time of render passes and profile regions */
   };
 
   struct QueueCreateInfo {
@@ -223,6 +266,7 @@ namespace me {
     void* next;
     Device device;
     Surface surface;
+    Swapchain old_swapchain; /* optional, the swapchain this one replaces. it still needs 'cleanup_swapchain' once no frame uses it */
   };
 
   struct SwapchainImageCreateInfo {
@@ -242,7 +286,10 @@ namespace me {
     StructureType type;
     void* next;
     Device device;
-    Swapchain swapchain;
+    Swapchain swapchain; /* nullptr for an offscreen render pass that renders into its attachments only */
+    uint32_t attachment_count; /* optional attachments after the swapchain image, at most one 'ATTACHMENT_TYPE_DEPTH' */
+    Attachment* attachments; /* if they are multisampled the swapchain image is their resolve target */
+    uint32_t pass_index; /* position of the pass in the frame, within 'first_pass' and 'last_pass' of every attachment */
   };
   
   struct RasterizerCreateInfo {
@@ -276,13 +323,17 @@ namespace me {
     void* next;
     Device device;
     RenderPass render_pass;
-    uint32_t viewport_count;
+    uint32_t viewport_count; /* viewports and scissors are dynamic state, only the counts are part of the pipeline */
     Viewport* viewports;
     uint32_t scissor_count;
     Scissor* scissors;
     RasterizerCreateInfo* rasterizer_create_info;
     MultisamplingCreateInfo* multisampling_create_info;
     ShaderCreateInfo* shader_create_info;
+    uint32_t descriptor_set_count; /* 0 for one set with a 'DESCRIPTOR_TYPE_UNIFORM' binding */
+    DescriptorType* descriptor_sets; /* descriptor type of the single binding in each set */
+    uint32_t push_constant_size; /* bytes of per-draw push constants, 0 for none */
+    bool bindless; /* set 0 is the device's bindless table, 'descriptor_sets' start at set 1 */
   };
   
   struct FramebufferCreateInfo {
@@ -290,18 +341,20 @@ namespace me {
     void* next;
     Device device;
     /* ? old TODO: the swapchain is being modifed */
-    SwapchainImage image;
+    SwapchainImage image; /* nullptr for offscreen render passes */
     RenderPass render_pass;
     math::vec2u offset;
     math::vec2u size;
+    uint32_t attachment_count; /* the same attachments as 'RenderPassCreateInfo::attachments' */
+    Attachment* attachments;
   };
   
   struct DescriptorPoolCreateInfo {
     StructureType type;
     void* next;
     Device device;
-    DescriptorType descriptor_type;
-    uint32_t descriptor_count;
+    DescriptorType descriptor_type; /* 'DESCRIPTOR_TYPE_NONE' for pools of every type */
+    uint32_t descriptor_count; /* sets in the first pool, more pools are added as needed */
   };
   
   struct DescriptorCreateInfo {
@@ -309,12 +362,13 @@ namespace me {
     void* next;
     Device device;
     Pipeline pipeline;
-    DescriptorPool descriptor_pool;
+    DescriptorPool descriptor_pool; /* nullptr to allocate from the current frame, the sets are only valid during it */
     DescriptorType descriptor_type;
+    uint32_t set; /* index of the set in 'PipelineCreateInfo::descriptor_sets' */
     uint32_t buffer_count;
     Buffer* buffers;
     uint32_t offset;
-    uint32_t range;
+    uint32_t range; /* size of one draw's data for 'DESCRIPTOR_TYPE_UNIFORM_DYNAMIC' */
   };
   
   struct CommandPoolCreateInfo {
@@ -322,21 +376,73 @@ namespace me {
     void* next;
     Device device;
     Queue queue;
+    bool transient; /* command buffers are short-lived and re-recorded often */
+    bool resettable; /* command buffers can be reset one by one when recording starts again */
   };
   
   struct CommandBufferCreateInfo {
     StructureType type;
     void* next;
     Device device;
-    CommandPool command_pool;
+    CommandPool command_pool; /* nullptr to allocate from the device's pools of the current frame, valid only during it */
     CommandBufferUsage usage;
+    uint32_t thread_index; /* pools of the current frame are per thread, less than 'DeviceCreateInfo::thread_count' */
+    bool secondary; /* recorded inside a render pass and executed by a primary command buffer with 'cmd_execute' */
+  };
+
+  struct UniformRingCreateInfo {
+    StructureType type;
+    void* next;
+    Device device;
+    uint32_t frame_count; /* frames in flight, each frame has its own region */
+    size_t frame_size; /* bytes available for each frame */
+  };
+  
+  /* 'first_pass' and 'last_pass' are the 'RenderPassCreateInfo::pass_index' of the first and last render pass
+   * of a frame that use the attachment. attachments created together whose pass ranges don't overlap share memory */
+  struct AttachmentDescription {
+    AttachmentType attachment_type;
+    Format format;
+    SampleCount samples;
+    bool transient; /* contents don't outlive the render pass, kept in lazily allocated memory where available */
+    uint32_t first_pass;
+    uint32_t last_pass;
+  };
+
+  struct AttachmentCreateInfo {
+    StructureType type;
+    void* next;
+    Device device;
+    math::vec2u size;
+    AttachmentDescription* descriptions; /* one per attachment */
+  };
+  
+  /* objects are culled by 'cull_shader' on the device, which writes the draw commands of the visible ones */
+  struct IndirectDrawListCreateInfo {
+    StructureType type;
+    void* next;
+    Device device;
+    uint32_t frame_count; /* frames in flight, each frame writes its own objects */
+    uint32_t capacity; /* objects per frame */
+    Shader* cull_shader; /* 'SHADER_TYPE_COMPUTE', res/cull.spv built from res/cull.comp */
+  };
+
+  /* host visible buffers that finished frames are copied into without waiting for them,
+   * a slot is in use from 'cmd_readback' until its copy has been read and released */
+  struct ReadbackRingCreateInfo {
+    StructureType type;
+    void* next;
+    Device device;
+    math::vec2u size; /* of the attachments read back */
+    Format format;
+    uint32_t slot_count; /* copies in flight or waiting to be read, 0 for 1 */
   };
   
   struct BufferWriteInfo {
     PhysicalDevice physical_device;
     Device device;
-    Queue transfer_queue; /* required if write_method is 'WRITE_METHOD_STAGING' */
-    CommandPool transfer_command_pool; /* required if write_method is 'WRITE_METHOD_STAGING' */
+    Queue transfer_queue; /* unused, staging writes are uploaded on the device's transfer queue */
+    CommandPool transfer_command_pool; /* unused, staging writes are uploaded on the device's transfer queue */
     size_t byte_count;
     void* bytes;
   };
@@ -346,6 +452,17 @@ namespace me {
     RenderPass render_pass;
     Framebuffer framebuffer;
     float clear_values[4];
+    bool secondary; /* the render pass is recorded in secondary command buffers */
+  };
+
+  struct CmdSetViewportInfo {
+    Viewport viewport;
+    Scissor scissor;
+  };
+
+  struct CmdRecordSecondaryInfo {
+    RenderPass render_pass;
+    Framebuffer framebuffer; /* optional, the framebuffer the primary command buffer renders to */
   };
   
   struct CmdBindDescriptorsInfo {
@@ -355,22 +472,84 @@ namespace me {
   };
   
   struct CmdDrawMeshesInfo {
+    Device device;
     Pipeline pipeline;
     uint32_t mesh_count;
     class Mesh** meshes;
+    Descriptor dynamic_descriptor; /* optional 'DESCRIPTOR_TYPE_UNIFORM_DYNAMIC' set, rebound per mesh */
+    uint32_t dynamic_set; /* set index of 'dynamic_descriptor' */
+    uint32_t* dynamic_offsets; /* one per mesh, from 'uniform_ring_push' */
+    uint32_t push_constant_size; /* optional */
+    const void* push_constants; /* 'push_constant_size' bytes per mesh */
+  };
+
+  /* one draw of 'cmd_draw_list', its state is only bound if it differs from the previous draw */
+  struct DrawItem {
+    Pipeline pipeline;
+    Descriptor descriptor; /* optional, bound to 'CmdDrawListInfo::descriptor_set' */
+    class Material* material; /* sorted by, materials have no device state yet */
+    class Mesh* mesh;
+    uint32_t first_instance;
+    uint32_t instance_count; /* 0 for 1 */
+  };
+
+  struct CmdDrawListInfo {
+    Device device;
+    uint32_t draw_count;
+    const DrawItem* draws; /* sorted by state, see 'DrawList' */
+    uint32_t descriptor_set;
+    Buffer instance_buffer; /* optional 'BUFFER_USAGE_VERTEX_BUFFER' with per-instance data, see 'InstanceBatcher' */
+    uint32_t instance_binding; /* the 'ShaderBinding::per_instance' binding it is bound to */
+  };
+
+  struct IndirectDrawListWriteInfo {
+    Device device;
+    uint32_t frame_index;
+    uint32_t object_count;
+    class Mesh** meshes;
+    const math::vec4f* bounds; /* world space bounding sphere per mesh, center in xyz and radius in w */
+  };
+
+  struct CmdCullIndirectInfo {
+    Device device;
+    IndirectDrawList draw_list;
+    math::vec4f frustum_planes[6]; /* normals point inside, a point is inside if dot(xyz, p) + w >= 0 */
+  };
+
+  struct CmdDrawIndirectInfo {
+    Device device;
+    Pipeline pipeline;
+    IndirectDrawList draw_list;
+  };
+
+  struct CmdReadbackInfo {
+    ReadbackRing readback_ring;
+    Attachment attachment; /* not transient, with the size and format of the ring */
+    Frame frame; /* the frame the command buffer is rendered with */
+    uint64_t tag; /* returned with the copy, like a frame number */
+  };
+
+  /* a copy in host memory, tightly packed rows. valid until 'readback_ring_release' */
+  struct Readback {
+    const void* data;
+    size_t size;
+    math::vec2u extent;
+    uint64_t tag;
+    uint32_t dropped_count; /* copies skipped since the last readback because every slot was in use */
   };
 
   struct FramePrepareInfo {
     Device device;
-    Swapchain swapchain;
+    Swapchain swapchain; /* nullptr for offscreen frames, no image is acquired */
     Frame frame;
+    uint32_t frame_index; /* per-frame resources of this index are reused once the frame's fence has signaled */
   };
 
   struct FrameRenderInfo {
     Device device;
     Queue queue;
     FramePrepared prepared;
-    SwapchainImage image;
+    SwapchainImage image; /* nullptr for offscreen frames, they don't wait for an image and aren't presented */
     Frame frame;
     uint32_t image_index;
     uint32_t frame_index;
@@ -0,0 +1,245 @@
+#include "Vulkan.hpp"
+#include "Util.hpp"
+
+#include <lme/math/math.hpp>
+
+struct AttachmentPlacement {
+  VkMemoryRequirements memory_requirements;
+  VkDeviceSize offset;
+  uint32_t first_pass;
+  uint32_t last_pass;
+};
+
+static int create_attachment_image(
+    VkDevice 					device,
+    VkAllocationCallbacks* 			allocation,
+    const me::AttachmentDescription 		&description,
+    const me::math::vec2u 			&size,
+    VkImage 					&image
+    );
+
+static int place_attachments(
+    uint32_t 					placement_count,
+    AttachmentPlacement** 			placements,
+    VkMemoryRequirements 			&memory_requirements
+    );
+
+
+int me::Vulkan::create_attachments(const AttachmentCreateInfo &attachment_create_info, uint32_t attachment_count, Attachment* attachments)
+{
+  VERIFY_CREATE_INFO(attachment_create_info, STRUCTURE_TYPE_ATTACHMENT_CREATE_INFO);
+
+  VkDevice vk_device = reinterpret_cast<Device_T*>(attachment_create_info.device)->vk_device;
+  memory::DeviceAllocator* memory_allocator = reinterpret_cast<Device_T*>(attachment_create_info.device)->memory_allocator;
+
+  VkImage vk_images[attachment_count];
+  AttachmentPlacement placements[attachment_count];
+  for (uint32_t i = 0; i < attachment_count; i++)
+  {
+    const AttachmentDescription &description = attachment_create_info.descriptions[i];
+    if (description.first_pass > description.last_pass)
+      throw exception("in 'create_attachments()' AttachmentDescription[%u]::first_pass must not be after 'last_pass'. %u > \e[33m%u\e[0m",
+	  i, description.first_pass, description.last_pass);
+
+    create_attachment_image(vk_device, vk_allocation, description, attachment_create_info.size, vk_images[i]);
+    vkGetImageMemoryRequirements(vk_device, vk_images[i], &placements[i].memory_requirements);
+    placements[i].offset = 0;
+    placements[i].first_pass = description.first_pass;
+    placements[i].last_pass = description.last_pass;
+  }
+
+  /* transient attachments can use lazily allocated memory, the others can't, so they are aliased separately */
+  AttachmentMemory_T* attachment_memories[2] = {nullptr, nullptr};
+  for (uint32_t group = 0; group < 2; group++)
+  {
+    bool transient = group == 1;
+
+    uint32_t placement_count = 0;
+    AttachmentPlacement* group_placements[attachment_count];
+    for (uint32_t i = 0; i < attachment_count; i++)
+    {
+      if (attachment_create_info.descriptions[i].transient == transient)
+	group_placements[placement_count++] = &placements[i];
+    }
+
+    if (placement_count == 0)
+      continue;
+
+    VkMemoryRequirements vk_memory_requirements;
+    place_attachments(placement_count, group_placements, vk_memory_requirements);
+
+    if (vk_memory_requirements.memoryTypeBits == 0)
+      throw exception("in 'create_attachments()' the attachments have no memory type in common");
+
+    VkMemoryPropertyFlags vk_memory_property_flags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+    if (transient && memory_allocator->has_memory_type(vk_memory_requirements.memoryTypeBits,
+	  VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT))
+      vk_memory_property_flags |= VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT;
+
+    memory::Allocation allocation;
+    memory_allocator->allocate(vk_memory_requirements, vk_memory_property_flags, allocation, true);
+    attachment_memories[group] = alloc.allocate<AttachmentMemory_T>(allocation, placement_count);
+  }
+
+  for (uint32_t i = 0; i < attachment_count; i++)
+  {
+    const AttachmentDescription &description = attachment_create_info.descriptions[i];
+    AttachmentMemory_T* attachment_memory = attachment_memories[description.transient ? 1 : 0];
+
+    VkResult result = vkBindImageMemory(vk_device, vk_images[i], attachment_memory->allocation.block->vk_memory,
+	attachment_memory->allocation.offset + placements[i].offset);
+    if (result != VK_SUCCESS)
+      throw exception("failed to bind attachment memory [%s]", util::get_result_string(result));
+
+    VkFormat vk_format = util::get_vulkan_format(description.format);
+
+    VkImageViewCreateInfo image_view_create_info = { };
+    image_view_create_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    image_view_create_info.pNext = nullptr;
+    image_view_create_info.flags = 0;
+    image_view_create_info.image = vk_images[i];
+    image_view_create_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    image_view_create_info.format = vk_format;
+    image_view_create_info.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
+    image_view_create_info.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
+    image_view_create_info.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
+    image_view_create_info.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
+    image_view_create_info.subresourceRange.aspectMask = description.attachment_type == ATTACHMENT_TYPE_DEPTH ? VK_IMAGE_ASPECT_DEPTH_BIT : VK_IMAGE_ASPECT_COLOR_BIT;
+    image_view_create_info.subresourceRange.baseMipLevel = 0;
+    image_view_create_info.subresourceRange.levelCount = 1;
+    image_view_create_info.subresourceRange.baseArrayLayer = 0;
+    image_view_create_info.subresourceRange.layerCount = 1;
+
+    VkImageView vk_image_view;
+    result = vkCreateImageView(vk_device, &image_view_create_info, vk_allocation, &vk_image_view);
+    if (result != VK_SUCCESS)
+      throw exception("failed to create attachment image view [%s]", util::get_result_string(result));
+
+    attachments[i] = alloc.allocate<Attachment_T>(vk_images[i], vk_image_view, vk_format, util::get_vulkan_sample_count(description.samples),
+	description.attachment_type, description.transient, description.first_pass, description.last_pass, attachment_memory);
+  }
+  return 0;
+}
+
+int me::Vulkan::cleanup_attachments(Device device, uint32_t attachment_count, Attachment* attachments)
+{
+  VkDevice vk_device = reinterpret_cast<Device_T*>(device)->vk_device;
+  memory::DeviceAllocator* memory_allocator = reinterpret_cast<Device_T*>(device)->memory_allocator;
+
+  for (uint32_t i = 0; i < attachment_count; i++)
+  {
+    Attachment_T* attachment = reinterpret_cast<Attachment_T*>(attachments[i]);
+    vkDestroyImageView(vk_device, attachment->vk_image_view, vk_allocation);
+    vkDestroyImage(vk_device, attachment->vk_image, vk_allocation);
+
+    /* the memory goes with the last attachment aliasing it */
+    if (--attachment->memory->reference_count == 0)
+    {
+      memory_allocator->free(attachment->memory->allocation);
+      alloc.deallocate(attachment->memory);
+    }
+    alloc.deallocate(attachment);
+  }
+  return 0;
+}
+
+
+int create_attachment_image(
+    VkDevice 					device,
+    VkAllocationCallbacks* 			allocation,
+    const me::AttachmentDescription 		&description,
+    const me::math::vec2u 			&size,
+    VkImage 					&image
+    )
+{
+  VkImageUsageFlags image_usage = VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT;
+  if (description.attachment_type == me::ATTACHMENT_TYPE_DEPTH)
+    image_usage |= VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+  else
+    image_usage |= VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+
+  /* transient images can only be attachments, other attachments may be sampled or copied later */
+  if (description.transient)
+    image_usage |= VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+  else
+    image_usage |= VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+
+  VkImageCreateInfo image_create_info = { };
+  image_create_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+  image_create_info.pNext = nullptr;
+  image_create_info.flags = 0;
+  image_create_info.imageType = VK_IMAGE_TYPE_2D;
+  image_create_info.format = me::util::get_vulkan_format(description.format);
+  image_create_info.extent.width = size[0];
+  image_create_info.extent.height = size[1];
+  image_create_info.extent.depth = 1;
+  image_create_info.mipLevels = 1;
+  image_create_info.arrayLayers = 1;
+  image_create_info.samples = me::util::get_vulkan_sample_count(description.samples);
+  image_create_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+  image_create_info.usage = image_usage;
+  image_create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+  image_create_info.queueFamilyIndexCount = 0;
+  image_create_info.pQueueFamilyIndices = nullptr;
+  image_create_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+  VkResult result = vkCreateImage(device, &image_create_info, allocation, &image);
+  if (result != VK_SUCCESS)
+    throw me::exception("failed to create attachment image [%s]", me::util::get_result_string(result));
+  return 0;
+}
+
+int place_attachments(
+    uint32_t 					placement_count,
+    AttachmentPlacement** 			placements,
+    VkMemoryRequirements 			&memory_requirements
+    )
+{
+  /* largest first, smaller attachments then fill the gaps next to them */
+  for (uint32_t i = 1; i < placement_count; i++)
+  {
+    AttachmentPlacement* placement = placements[i];
+    uint32_t j = i;
+    for (; j > 0 && placements[j - 1]->memory_requirements.size < placement->memory_requirements.size; j--)
+      placements[j] = placements[j - 1];
+    placements[j] = placement;
+  }
+
+  memory_requirements.size = 0;
+  memory_requirements.alignment = 1;
+  memory_requirements.memoryTypeBits = UINT32_MAX;
+
+  for (uint32_t i = 0; i < placement_count; i++)
+  {
+    AttachmentPlacement* placement = placements[i];
+    VkDeviceSize alignment = placement->memory_requirements.alignment;
+    VkDeviceSize size = placement->memory_requirements.size;
+
+    /* the lowest offset that doesn't overlap an already placed attachment that is alive at the same time.
+     * the candidates are the start of the memory and the end of every such attachment */
+    VkDeviceSize offset = 0;
+    bool overlaps = true;
+    while (overlaps)
+    {
+      overlaps = false;
+      for (uint32_t j = 0; j < i; j++)
+      {
+	const AttachmentPlacement* other = placements[j];
+	if (other->last_pass < placement->first_pass || other->first_pass > placement->last_pass)
+	  continue;
+
+	if (offset < other->offset + other->memory_requirements.size && other->offset < offset + size)
+	{
+	  offset = (other->offset + other->memory_requirements.size + alignment - 1) / alignment * alignment;
+	  overlaps = true;
+	}
+      }
+    }
+
+    placement->offset = offset;
+    memory_requirements.size = me::math::max(memory_requirements.size, offset + size);
+    memory_requirements.alignment = me::math::max(memory_requirements.alignment, alignment);
+    memory_requirements.memoryTypeBits &= placement->memory_requirements.memoryTypeBits;
+  }
+  return 0;
+}
@@ -0,0 +1,212 @@
+#include "Bindless.hpp"
+#include "Util.hpp"
+
+#include <lme/math/math.hpp>
+
+me::descriptor::BindlessTable::BindlessTable(VkDevice device, VkAllocationCallbacks* allocation, uint32_t frame_count,
+    uint32_t max_storage_buffers, uint32_t max_sampled_images)
+  : vk_device(device), vk_allocation(allocation), frame_count(frame_count > 0 ? frame_count : 1)
+{
+  frame = 0;
+  buffer_slots.capacity = math::min(max_storage_buffers, MAX_STORAGE_BUFFERS);
+  buffer_slots.next = 0;
+  image_slots.capacity = math::min(max_sampled_images, MAX_SAMPLED_IMAGES);
+  image_slots.next = 0;
+}
+
+int me::descriptor::BindlessTable::initialize()
+{
+  uint32_t binding_count = 2;
+  VkDescriptorSetLayoutBinding descriptor_set_layout_bindings[binding_count];
+  descriptor_set_layout_bindings[0].binding = STORAGE_BUFFER_BINDING;
+  descriptor_set_layout_bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+  descriptor_set_layout_bindings[0].descriptorCount = buffer_slots.capacity;
+  descriptor_set_layout_bindings[0].stageFlags = VK_SHADER_STAGE_ALL;
+  descriptor_set_layout_bindings[0].pImmutableSamplers = nullptr;
+  descriptor_set_layout_bindings[1].binding = SAMPLED_IMAGE_BINDING;
+  descriptor_set_layout_bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+  descriptor_set_layout_bindings[1].descriptorCount = image_slots.capacity;
+  descriptor_set_layout_bindings[1].stageFlags = VK_SHADER_STAGE_ALL;
+  descriptor_set_layout_bindings[1].pImmutableSamplers = nullptr;
+
+  /* unused elements may hold anything and elements can change while the set is bound */
+  VkDescriptorBindingFlags descriptor_binding_flags[binding_count];
+  for (uint32_t i = 0; i < binding_count; i++)
+    descriptor_binding_flags[i] = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT |
+      VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;
+
+  VkDescriptorSetLayoutBindingFlagsCreateInfo descriptor_set_layout_binding_flags_create_info = { };
+  descriptor_set_layout_binding_flags_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+  descriptor_set_layout_binding_flags_create_info.pNext = nullptr;
+  descriptor_set_layout_binding_flags_create_info.bindingCount = binding_count;
+  descriptor_set_layout_binding_flags_create_info.pBindingFlags = descriptor_binding_flags;
+
+  VkDescriptorSetLayoutCreateInfo descriptor_set_layout_create_info = { };
+  descriptor_set_layout_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+  descriptor_set_layout_create_info.pNext = &descriptor_set_layout_binding_flags_create_info;
+  descriptor_set_layout_create_info.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+  descriptor_set_layout_create_info.bindingCount = binding_count;
+  descriptor_set_layout_create_info.pBindings = descriptor_set_layout_bindings;
+
+  VkResult result = vkCreateDescriptorSetLayout(vk_device, &descriptor_set_layout_create_info, vk_allocation, &vk_descriptor_set_layout);
+  if (result != VK_SUCCESS)
+    throw exception("failed to create bindless descriptor set layout [%s]", util::get_result_string(result));
+
+  VkDescriptorPoolSize descriptor_pool_sizes[binding_count];
+  descriptor_pool_sizes[0].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+  descriptor_pool_sizes[0].descriptorCount = buffer_slots.capacity;
+  descriptor_pool_sizes[1].type = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+  descriptor_pool_sizes[1].descriptorCount = image_slots.capacity;
+
+  VkDescriptorPoolCreateInfo descriptor_pool_create_info = { };
+  descriptor_pool_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+  descriptor_pool_create_info.pNext = nullptr;
+  descriptor_pool_create_info.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+  descriptor_pool_create_info.maxSets = 1;
+  descriptor_pool_create_info.poolSizeCount = binding_count;
+  descriptor_pool_create_info.pPoolSizes = descriptor_pool_sizes;
+
+  result = vkCreateDescriptorPool(vk_device, &descriptor_pool_create_info, vk_allocation, &vk_descriptor_pool);
+  if (result != VK_SUCCESS)
+    throw exception("failed to create bindless descriptor pool [%s]", util::get_result_string(result));
+
+  VkDescriptorSetAllocateInfo descriptor_set_allocate_info = { };
+  descriptor_set_allocate_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+  descriptor_set_allocate_info.pNext = nullptr;
+  descriptor_set_allocate_info.descriptorPool = vk_descriptor_pool;
+  descriptor_set_allocate_info.descriptorSetCount = 1;
+  descriptor_set_allocate_info.pSetLayouts = &vk_descriptor_set_layout;
+
+  result = vkAllocateDescriptorSets(vk_device, &descriptor_set_allocate_info, &vk_descriptor_set);
+  if (result != VK_SUCCESS)
+    throw exception("failed to allocate bindless descriptor set [%s]", util::get_result_string(result));
+  return 0;
+}
+
+int me::descriptor::BindlessTable::cleanup()
+{
+  vkDestroyDescriptorPool(vk_device, vk_descriptor_pool, vk_allocation);
+  vkDestroyDescriptorSetLayout(vk_device, vk_descriptor_set_layout, vk_allocation);
+  return 0;
+}
+
+int me::descriptor::BindlessTable::add_buffer(
+    VkBuffer 						buffer,
+    VkDeviceSize 					offset,
+    VkDeviceSize 					range,
+    uint32_t 						&index
+    )
+{
+  acquire_slot(buffer_slots, index);
+
+  VkDescriptorBufferInfo descriptor_buffer_info = { };
+  descriptor_buffer_info.buffer = buffer;
+  descriptor_buffer_info.offset = offset;
+  descriptor_buffer_info.range = range;
+
+  VkWriteDescriptorSet write_descriptor_set = { };
+  write_descriptor_set.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+  write_descriptor_set.pNext = nullptr;
+  write_descriptor_set.dstSet = vk_descriptor_set;
+  write_descriptor_set.dstBinding = STORAGE_BUFFER_BINDING;
+  write_descriptor_set.dstArrayElement = index;
+  write_descriptor_set.descriptorCount = 1;
+  write_descriptor_set.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+  write_descriptor_set.pImageInfo = nullptr;
+  write_descriptor_set.pBufferInfo = &descriptor_buffer_info;
+  write_descriptor_set.pTexelBufferView = nullptr;
+
+  vkUpdateDescriptorSets(vk_device, 1, &write_descriptor_set, 0, nullptr);
+  return 0;
+}
+
+int me::descriptor::BindlessTable::add_image(
+    VkImageView 					image_view,
+    VkImageLayout 					image_layout,
+    uint32_t 						&index
+    )
+{
+  acquire_slot(image_slots, index);
+
+  VkDescriptorImageInfo descriptor_image_info = { };
+  descriptor_image_info.sampler = VK_NULL_HANDLE;
+  descriptor_image_info.imageView = image_view;
+  descriptor_image_info.imageLayout = image_layout;
+
+  VkWriteDescriptorSet write_descriptor_set = { };
+  write_descriptor_set.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+  write_descriptor_set.pNext = nullptr;
+  write_descriptor_set.dstSet = vk_descriptor_set;
+  write_descriptor_set.dstBinding = SAMPLED_IMAGE_BINDING;
+  write_descriptor_set.dstArrayElement = index;
+  write_descriptor_set.descriptorCount = 1;
+  write_descriptor_set.descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+  write_descriptor_set.pImageInfo = &descriptor_image_info;
+  write_descriptor_set.pBufferInfo = nullptr;
+  write_descriptor_set.pTexelBufferView = nullptr;
+
+  vkUpdateDescriptorSets(vk_device, 1, &write_descriptor_set, 0, nullptr);
+  return 0;
+}
+
+int me::descriptor::BindlessTable::remove_buffer(
+    uint32_t 						index
+    )
+{
+  return release_slot(buffer_slots, index);
+}
+
+int me::descriptor::BindlessTable::remove_image(
+    uint32_t 						index
+    )
+{
+  return release_slot(image_slots, index);
+}
+
+int me::descriptor::BindlessTable::begin_frame()
+{
+  frame++;
+  reclaim_slots(buffer_slots);
+  reclaim_slots(image_slots);
+  return 0;
+}
+
+int me::descriptor::BindlessTable::acquire_slot(Slots &slots, uint32_t &index)
+{
+  if (slots.free.size() > 0)
+  {
+    index = slots.free[slots.free.size() - 1];
+    slots.free.resize(slots.free.size() - 1);
+    return 0;
+  }
+
+  if (slots.next == slots.capacity)
+    throw exception("bindless descriptor array is full (%u)", slots.capacity);
+
+  index = slots.next++;
+  return 0;
+}
+
+int me::descriptor::BindlessTable::release_slot(Slots &slots, uint32_t index)
+{
+  slots.released.push_back({index, frame + frame_count});
+  return 0;
+}
+
+int me::descriptor::BindlessTable::reclaim_slots(Slots &slots)
+{
+  size_t index = 0;
+  while (index < slots.released.size())
+  {
+    if (slots.released[index].frame > frame)
+    {
+      index++;
+      continue;
+    }
+
+    slots.free.push_back(slots.released[index].index);
+    slots.released[index] = slots.released[slots.released.size() - 1];
+    slots.released.resize(slots.released.size() - 1);
+  }
+  return 0;
+}
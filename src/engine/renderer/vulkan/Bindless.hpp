@@ -0,0 +1,103 @@
+#ifndef ME_VULKAN_BINDLESS_HPP
+  #define ME_VULKAN_BINDLESS_HPP
+
+#include <lme/vector.hpp>
+
+#include <vulkan/vulkan.h>
+
+namespace me::descriptor {
+
+  /* one update-after-bind descriptor set per device with large arrays of storage buffers and sampled images.
+   * resources are added once and shaders reach them through their index, so a bindless pipeline
+   * binds this set once per command buffer instead of binding descriptors per draw */
+  class BindlessTable {
+
+  public:
+
+    static constexpr uint32_t STORAGE_BUFFER_BINDING = 0;
+    static constexpr uint32_t SAMPLED_IMAGE_BINDING = 1;
+
+    static constexpr uint32_t MAX_STORAGE_BUFFERS = 16 * 1024;
+    static constexpr uint32_t MAX_SAMPLED_IMAGES = 16 * 1024;
+
+  protected:
+
+    struct Released {
+      uint32_t index;
+      uint64_t frame; /* reusable once this frame has been reached */
+    };
+
+    struct Slots {
+      uint32_t capacity;
+      uint32_t next; /* never used above this */
+      vector<uint32_t> free;
+      vector<Released> released;
+    };
+
+    VkDevice vk_device;
+    VkAllocationCallbacks* vk_allocation;
+
+    uint32_t frame_count;
+    uint64_t frame;
+
+    VkDescriptorPool vk_descriptor_pool;
+    VkDescriptorSetLayout vk_descriptor_set_layout;
+    VkDescriptorSet vk_descriptor_set;
+
+    Slots buffer_slots;
+    Slots image_slots;
+
+  public:
+
+    /* 'max_storage_buffers' and 'max_sampled_images' are the update-after-bind limits of the device */
+    BindlessTable(VkDevice device, VkAllocationCallbacks* allocation, uint32_t frame_count,
+	uint32_t max_storage_buffers, uint32_t max_sampled_images);
+
+    int initialize();
+    int cleanup();
+
+    int add_buffer(
+	VkBuffer 					buffer,
+	VkDeviceSize 					offset,
+	VkDeviceSize 					range,
+	uint32_t 					&index
+	);
+
+    int add_image(
+	VkImageView 					image_view,
+	VkImageLayout 					image_layout,
+	uint32_t 					&index
+	);
+
+    /* the index is reused 'frame_count' frames later, when no frame in flight can read it */
+    int remove_buffer(
+	uint32_t 					index
+	);
+
+    int remove_image(
+	uint32_t 					index
+	);
+
+    int begin_frame();
+
+    VkDescriptorSetLayout get_descriptor_set_layout() const
+    {
+      return vk_descriptor_set_layout;
+    }
+
+    VkDescriptorSet get_descriptor_set() const
+    {
+      return vk_descriptor_set;
+    }
+
+  protected:
+
+    int acquire_slot(Slots &slots, uint32_t &index);
+    int release_slot(Slots &slots, uint32_t index);
+    int reclaim_slots(Slots &slots);
+
+  };
+
+}
+
+#endif
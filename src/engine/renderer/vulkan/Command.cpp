@@ -5,10 +5,26 @@ static int allocate_command_buffers(
     VkDevice 					device,
     VkAllocationCallbacks* 			allocation,
     VkCommandPool 				command_pool,
+    VkCommandBufferLevel 			level,
     uint32_t 					count,
     VkCommandBuffer*				command_buffers
     );
 
+static int set_viewport(
+    VkCommandBuffer 				command_buffer,
+    const VkViewport 				&viewport,
+    const VkRect2D 				&scissor
+    );
+
+static int set_framebuffer_viewport(
+    VkCommandBuffer 				command_buffer,
+    VkExtent2D 					extent
+    );
+
+static int check_resident(
+    const me::Mesh* 				mesh
+    );
+
 
 int me::Vulkan::create_command_buffers(const CommandBufferCreateInfo &command_buffer_create_info,
     uint32_t buffer_count, CommandBuffer* buffers)
@@ -16,13 +32,29 @@ int me::Vulkan::create_command_buffers(const CommandBufferCreateInfo &command_bu
   VERIFY_CREATE_INFO(command_buffer_create_info, STRUCTURE_TYPE_COMMAND_BUFFER_CREATE_INFO);
 
   VkDevice vk_device = reinterpret_cast<Device_T*>(command_buffer_create_info.device)->vk_device;
+
+  /* without a pool the buffers come from the calling thread's pool of the current frame and are recycled with it */
+  if (command_buffer_create_info.command_pool == nullptr)
+  {
+    command::FrameCommandAllocator* frame_commands = reinterpret_cast<Device_T*>(command_buffer_create_info.device)->frame_commands;
+    CommandBuffer_T* frame_command_buffers[buffer_count];
+    frame_commands->allocate(command_buffer_create_info.thread_index, command_buffer_create_info.secondary, command_buffer_create_info.usage,
+	buffer_count, frame_command_buffers);
+
+    for (uint32_t i = 0; i < buffer_count; i++)
+      buffers[i] = frame_command_buffers[i];
+    return 0;
+  }
+
   VkCommandPool vk_command_pool = reinterpret_cast<CommandPool_T*>(command_buffer_create_info.command_pool)->vk_command_pool;
 
   VkCommandBuffer vk_command_buffers[buffer_count];
-  allocate_command_buffers(vk_device, vk_allocation, vk_command_pool, buffer_count, vk_command_buffers);
+  allocate_command_buffers(vk_device, vk_allocation, vk_command_pool,
+      command_buffer_create_info.secondary ? VK_COMMAND_BUFFER_LEVEL_SECONDARY : VK_COMMAND_BUFFER_LEVEL_PRIMARY, buffer_count, vk_command_buffers);
 
   for (uint32_t i = 0; i < buffer_count; i++)
-    buffers[i] = alloc.allocate<CommandBuffer_T>(vk_command_buffers[i], command_buffer_create_info.usage);
+    buffers[i] = alloc.allocate<CommandBuffer_T>(vk_command_buffers[i], command_buffer_create_info.usage, command_buffer_create_info.secondary,
+	nullptr, query::TimestampProfiler::NO_REGION);
   return 0;
 }
 
@@ -30,6 +62,9 @@ int me::Vulkan::cmd_record_start(CommandBuffer command_buffer)
 {
   VkCommandBuffer vk_command_buffer = reinterpret_cast<CommandBuffer_T*>(command_buffer)->vk_command_buffer;
 
+  if (reinterpret_cast<CommandBuffer_T*>(command_buffer)->secondary)
+    throw exception("in 'cmd_record_start()' 'CommandBuffer[%p]' is secondary, use 'cmd_record_secondary_start()'", command_buffer);
+
   VkCommandBufferBeginInfo command_buffer_begin_info = { };
   command_buffer_begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
   command_buffer_begin_info.pNext = nullptr;
@@ -42,6 +77,48 @@ int me::Vulkan::cmd_record_start(CommandBuffer command_buffer)
   return 0;
 }
 
+int me::Vulkan::cmd_record_secondary_start(const CmdRecordSecondaryInfo &cmd_record_secondary_info, CommandBuffer command_buffer)
+{
+  VkCommandBuffer vk_command_buffer = reinterpret_cast<CommandBuffer_T*>(command_buffer)->vk_command_buffer;
+  VkRenderPass vk_render_pass = reinterpret_cast<RenderPass_T*>(cmd_record_secondary_info.render_pass)->vk_render_pass;
+
+  if (!reinterpret_cast<CommandBuffer_T*>(command_buffer)->secondary)
+    throw exception("in 'cmd_record_secondary_start()' 'CommandBuffer[%p]' must be secondary", command_buffer);
+
+  VkFramebuffer vk_framebuffer = VK_NULL_HANDLE;
+  VkExtent2D vk_framebuffer_extent = {0, 0};
+  if (cmd_record_secondary_info.framebuffer != nullptr)
+  {
+    vk_framebuffer = reinterpret_cast<Framebuffer_T*>(cmd_record_secondary_info.framebuffer)->vk_framebuffer;
+    vk_framebuffer_extent = reinterpret_cast<Framebuffer_T*>(cmd_record_secondary_info.framebuffer)->vk_extent;
+  }
+
+  VkCommandBufferInheritanceInfo command_buffer_inheritance_info = { };
+  command_buffer_inheritance_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+  command_buffer_inheritance_info.pNext = nullptr;
+  command_buffer_inheritance_info.renderPass = vk_render_pass;
+  command_buffer_inheritance_info.subpass = 0;
+  command_buffer_inheritance_info.framebuffer = vk_framebuffer;
+  command_buffer_inheritance_info.occlusionQueryEnable = VK_FALSE;
+  command_buffer_inheritance_info.queryFlags = 0;
+  command_buffer_inheritance_info.pipelineStatistics = 0;
+
+  VkCommandBufferBeginInfo command_buffer_begin_info = { };
+  command_buffer_begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+  command_buffer_begin_info.pNext = nullptr;
+  command_buffer_begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+  command_buffer_begin_info.pInheritanceInfo = &command_buffer_inheritance_info;
+
+  VkResult result = vkBeginCommandBuffer(vk_command_buffer, &command_buffer_begin_info);
+  if (result != VK_SUCCESS)
+    throw exception("failed to begin secondary command buffer [%s]", util::get_result_string(result));
+
+  /* dynamic state isn't inherited from the primary command buffer */
+  if (vk_framebuffer != VK_NULL_HANDLE)
+    set_framebuffer_viewport(vk_command_buffer, vk_framebuffer_extent);
+  return 0;
+}
+
 int me::Vulkan::cmd_record_stop(CommandBuffer command_buffer)
 {
   VkCommandBuffer vk_command_buffer = reinterpret_cast<CommandBuffer_T*>(command_buffer)->vk_command_buffer;
@@ -57,7 +134,9 @@ int me::Vulkan::cmd_begin_render_pass(const CmdBeginRenderPassInfo &cmd_begin_re
   VkCommandBuffer vk_command_buffer = reinterpret_cast<CommandBuffer_T*>(command_buffer)->vk_command_buffer;
   VkRenderPass vk_render_pass = reinterpret_cast<RenderPass_T*>(cmd_begin_render_pass_info.render_pass)->vk_render_pass;
   VkFramebuffer vk_framebuffer = reinterpret_cast<Framebuffer_T*>(cmd_begin_render_pass_info.framebuffer)->vk_framebuffer;
-  VkExtent2D vk_image_extent = reinterpret_cast<Swapchain_T*>(cmd_begin_render_pass_info.swapchain)->vk_image_extent;
+  VkExtent2D vk_framebuffer_extent = reinterpret_cast<Framebuffer_T*>(cmd_begin_render_pass_info.framebuffer)->vk_extent;
+  uint32_t attachment_count = reinterpret_cast<RenderPass_T*>(cmd_begin_render_pass_info.render_pass)->attachment_count;
+  uint32_t depth_attachment = reinterpret_cast<RenderPass_T*>(cmd_begin_render_pass_info.render_pass)->depth_attachment;
 
   CommandBufferUsage command_buffer_usage = reinterpret_cast<CommandBuffer_T*>(command_buffer)->usage;
 
@@ -71,21 +150,41 @@ int me::Vulkan::cmd_begin_render_pass(const CmdBeginRenderPassInfo &cmd_begin_re
   render_pass_begin_info.renderPass = vk_render_pass;
   render_pass_begin_info.framebuffer = vk_framebuffer;
   render_pass_begin_info.renderArea.offset = {0, 0};
-  render_pass_begin_info.renderArea.extent = vk_image_extent;
+  render_pass_begin_info.renderArea.extent = vk_framebuffer_extent;
 
-  /* create clear values */
-  uint32_t clear_value_count = 1;
+  /* create clear values, color attachments share the clear color and depth is cleared to the far plane */
+  uint32_t clear_value_count = attachment_count;
   VkClearValue clear_values[clear_value_count];
-  clear_values[0].color.float32[0] = cmd_begin_render_pass_info.clear_values[0];
-  clear_values[0].color.float32[1] = cmd_begin_render_pass_info.clear_values[1];
-  clear_values[0].color.float32[2] = cmd_begin_render_pass_info.clear_values[2];
-  clear_values[0].color.float32[3] = cmd_begin_render_pass_info.clear_values[3];
+  for (uint32_t i = 0; i < clear_value_count; i++)
+  {
+    if (i == depth_attachment)
+    {
+      clear_values[i].depthStencil.depth = 1.0F;
+      clear_values[i].depthStencil.stencil = 0;
+      continue;
+    }
+    clear_values[i].color.float32[0] = cmd_begin_render_pass_info.clear_values[0];
+    clear_values[i].color.float32[1] = cmd_begin_render_pass_info.clear_values[1];
+    clear_values[i].color.float32[2] = cmd_begin_render_pass_info.clear_values[2];
+    clear_values[i].color.float32[3] = cmd_begin_render_pass_info.clear_values[3];
+  }
 
   render_pass_begin_info.clearValueCount = clear_value_count;
   render_pass_begin_info.pClearValues = clear_values;
 
+  /* a primary command buffer can only execute secondaries inside a pass of secondary contents, so its timestamps go outside.
+   * the secondaries themselves can write timestamps inside the pass */
+  query::TimestampProfiler* timestamps = reinterpret_cast<CommandBuffer_T*>(command_buffer)->timestamps;
+  if (timestamps != nullptr)
+    timestamps->begin_region("render pass", vk_command_buffer, reinterpret_cast<CommandBuffer_T*>(command_buffer)->render_pass_region);
+
   /* begin recording */
-  vkCmdBeginRenderPass(vk_command_buffer, &render_pass_begin_info, VK_SUBPASS_CONTENTS_INLINE);
+  vkCmdBeginRenderPass(vk_command_buffer, &render_pass_begin_info,
+      cmd_begin_render_pass_info.secondary ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS : VK_SUBPASS_CONTENTS_INLINE);
+
+  /* secondary command buffers set their own */
+  if (!cmd_begin_render_pass_info.secondary)
+    set_framebuffer_viewport(vk_command_buffer, vk_framebuffer_extent);
   return 0;
 }
 
@@ -94,6 +193,74 @@ int me::Vulkan::cmd_end_render_pass(CommandBuffer command_buffer)
   VkCommandBuffer vk_command_buffer = reinterpret_cast<CommandBuffer_T*>(command_buffer)->vk_command_buffer;
 
   vkCmdEndRenderPass(vk_command_buffer);
+
+  query::TimestampProfiler* timestamps = reinterpret_cast<CommandBuffer_T*>(command_buffer)->timestamps;
+  uint32_t &render_pass_region = reinterpret_cast<CommandBuffer_T*>(command_buffer)->render_pass_region;
+  if (timestamps != nullptr)
+  {
+    timestamps->end_region(render_pass_region, vk_command_buffer);
+    render_pass_region = query::TimestampProfiler::NO_REGION;
+  }
+  return 0;
+}
+
+int me::Vulkan::cmd_begin_profile_region(const char* label, CommandBuffer command_buffer, ProfileRegion &region)
+{
+  VkCommandBuffer vk_command_buffer = reinterpret_cast<CommandBuffer_T*>(command_buffer)->vk_command_buffer;
+  query::TimestampProfiler* timestamps = reinterpret_cast<CommandBuffer_T*>(command_buffer)->timestamps;
+
+  region = query::TimestampProfiler::NO_REGION;
+  if (timestamps != nullptr)
+    timestamps->begin_region(label, vk_command_buffer, region);
+  return 0;
+}
+
+int me::Vulkan::cmd_end_profile_region(ProfileRegion region, CommandBuffer command_buffer)
+{
+  VkCommandBuffer vk_command_buffer = reinterpret_cast<CommandBuffer_T*>(command_buffer)->vk_command_buffer;
+  query::TimestampProfiler* timestamps = reinterpret_cast<CommandBuffer_T*>(command_buffer)->timestamps;
+
+  if (timestamps != nullptr)
+    timestamps->end_region(region, vk_command_buffer);
+  return 0;
+}
+
+int me::Vulkan::cmd_set_viewport(const CmdSetViewportInfo &cmd_set_viewport_info, CommandBuffer command_buffer)
+{
+  VkCommandBuffer vk_command_buffer = reinterpret_cast<CommandBuffer_T*>(command_buffer)->vk_command_buffer;
+
+  const Viewport &viewport_info = cmd_set_viewport_info.viewport;
+  VkViewport viewport = {
+      .x = viewport_info.location[0],
+      .y = viewport_info.location[1],
+      .width = viewport_info.size[0],
+      .height = viewport_info.size[1],
+      .minDepth = 0.0F,
+      .maxDepth = 1.0F
+  };
+
+  const Scissor &scissor_info = cmd_set_viewport_info.scissor;
+  VkRect2D scissor = {
+      .offset = {scissor_info.offset[0], scissor_info.offset[1]},
+      .extent = {scissor_info.size[0], scissor_info.size[1]}
+  };
+
+  set_viewport(vk_command_buffer, viewport, scissor);
+  return 0;
+}
+
+int me::Vulkan::cmd_execute(CommandBuffer command_buffer, uint32_t secondary_count, CommandBuffer* secondaries)
+{
+  VkCommandBuffer vk_command_buffer = reinterpret_cast<CommandBuffer_T*>(command_buffer)->vk_command_buffer;
+
+  if (secondary_count == 0)
+    return 0;
+
+  VkCommandBuffer vk_secondary_command_buffers[secondary_count];
+  for (uint32_t i = 0; i < secondary_count; i++)
+    vk_secondary_command_buffers[i] = reinterpret_cast<CommandBuffer_T*>(secondaries[i])->vk_command_buffer;
+
+  vkCmdExecuteCommands(vk_command_buffer, secondary_count, vk_secondary_command_buffers);
   return 0;
 }
 
@@ -101,13 +268,14 @@ int me::Vulkan::cmd_bind_descriptors(const CmdBindDescriptorsInfo &cmd_bind_desc
 {
   VkCommandBuffer vk_command_buffer = reinterpret_cast<CommandBuffer_T*>(command_buffer)->vk_command_buffer;
   VkPipelineLayout vk_pipeline_layout = reinterpret_cast<Pipeline_T*>(cmd_bind_descriptors_info.pipeline)->vk_layout;
+  uint32_t first_set = reinterpret_cast<Pipeline_T*>(cmd_bind_descriptors_info.pipeline)->first_set;
 
   VkDescriptorSet vk_descriptor_sets[cmd_bind_descriptors_info.descriptor_count];
   for (uint32_t i = 0; i < cmd_bind_descriptors_info.descriptor_count; i++)
     vk_descriptor_sets[i] = reinterpret_cast<Descriptor_T*>(cmd_bind_descriptors_info.descriptors[i])->vk_descriptor_set;
 
   vkCmdBindDescriptorSets(vk_command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
-      vk_pipeline_layout, 0, cmd_bind_descriptors_info.descriptor_count, vk_descriptor_sets, 0, nullptr);
+      vk_pipeline_layout, first_set, cmd_bind_descriptors_info.descriptor_count, vk_descriptor_sets, 0, nullptr);
   return 0;
 }
 
@@ -115,23 +283,119 @@ int me::Vulkan::cmd_draw_meshes(const CmdDrawMeshesInfo &cmd_draw_meshes_info, C
 {
   VkCommandBuffer vk_command_buffer = reinterpret_cast<CommandBuffer_T*>(command_buffer)->vk_command_buffer;
   VkPipeline vk_pipeline = reinterpret_cast<Pipeline_T*>(cmd_draw_meshes_info.pipeline)->vk_pipeline;
+  VkPipelineLayout vk_pipeline_layout = reinterpret_cast<Pipeline_T*>(cmd_draw_meshes_info.pipeline)->vk_layout;
+  uint32_t pipeline_push_constant_size = reinterpret_cast<Pipeline_T*>(cmd_draw_meshes_info.pipeline)->push_constant_size;
+  uint32_t first_set = reinterpret_cast<Pipeline_T*>(cmd_draw_meshes_info.pipeline)->first_set;
+  memory::GeometryPool* geometry_pool = reinterpret_cast<Device_T*>(cmd_draw_meshes_info.device)->geometry_pool;
+
+  /* streaming in may move the pool, so it happens before recording and not here */
+  for (uint32_t i = 0; i < cmd_draw_meshes_info.mesh_count; i++)
+    check_resident(cmd_draw_meshes_info.meshes[i]);
+
+  /* all meshes live in the geometry pool, so the buffers are bound once */
+  const size_t vertex_buffer_count = 1;
+  VkBuffer vk_vertex_buffers[vertex_buffer_count] = {geometry_pool->get_vertex_buffer()};
+  VkDeviceSize vk_offsets[vertex_buffer_count] = {0};
+
+  vkCmdBindPipeline(vk_command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, vk_pipeline);
+  vkCmdBindVertexBuffers(vk_command_buffer, 0, vertex_buffer_count, vk_vertex_buffers, vk_offsets);
+  vkCmdBindIndexBuffer(vk_command_buffer, geometry_pool->get_index_buffer(), 0, VK_INDEX_TYPE_UINT32);
+
+  /* bindless pipelines find everything through indices, the table is bound once for all meshes */
+  if (first_set > 0)
+  {
+    VkDescriptorSet vk_bindless_descriptor_set = reinterpret_cast<Device_T*>(cmd_draw_meshes_info.device)->bindless_table->get_descriptor_set();
+    vkCmdBindDescriptorSets(vk_command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, vk_pipeline_layout,
+	0, 1, &vk_bindless_descriptor_set, 0, nullptr);
+  }
+
+  if (cmd_draw_meshes_info.push_constant_size > pipeline_push_constant_size)
+    throw exception("in 'cmd_draw_meshes()' CmdDrawMeshesInfo::push_constant_size is larger than the pipeline's. %u > \e[33m%u\e[0m",
+	cmd_draw_meshes_info.push_constant_size, pipeline_push_constant_size);
+
+  VkDescriptorSet vk_dynamic_descriptor_set = VK_NULL_HANDLE;
+  if (cmd_draw_meshes_info.dynamic_descriptor != nullptr)
+    vk_dynamic_descriptor_set = reinterpret_cast<Descriptor_T*>(cmd_draw_meshes_info.dynamic_descriptor)->vk_descriptor_set;
 
   for (uint32_t i = 0; i < cmd_draw_meshes_info.mesh_count; i++)
   {
     Mesh* mesh = cmd_draw_meshes_info.meshes[i];
-    VkBuffer vk_vertex_buffer = reinterpret_cast<Buffer_T*>(mesh->vertex_buffer)->vk_buffer;
-    VkBuffer vk_index_buffer = reinterpret_cast<Buffer_T*>(mesh->index_buffer)->vk_buffer;
 
-    /* get vertex buffers and offsets */
-    const size_t vertex_buffer_count = 1;
-    VkBuffer vk_vertex_buffers[vertex_buffer_count] = {vk_vertex_buffer};
-    VkDeviceSize vk_offsets[vertex_buffer_count] = {0};
+    /* per-draw data */
+    if (vk_dynamic_descriptor_set != VK_NULL_HANDLE)
+      vkCmdBindDescriptorSets(vk_command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, vk_pipeline_layout,
+	  first_set + cmd_draw_meshes_info.dynamic_set, 1, &vk_dynamic_descriptor_set, 1, &cmd_draw_meshes_info.dynamic_offsets[i]);
+
+    if (cmd_draw_meshes_info.push_constant_size > 0)
+      vkCmdPushConstants(vk_command_buffer, vk_pipeline_layout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0,
+	  cmd_draw_meshes_info.push_constant_size,
+	  static_cast<const char*>(cmd_draw_meshes_info.push_constants) + i * cmd_draw_meshes_info.push_constant_size);
+    vkCmdDrawIndexed(vk_command_buffer, mesh->index_count, 1, mesh->first_index, static_cast<int32_t>(mesh->vertex_offset), 0);
+  }
+  return 0;
+}
+
+int me::Vulkan::cmd_draw_list(const CmdDrawListInfo &cmd_draw_list_info, CommandBuffer command_buffer)
+{
+  VkCommandBuffer vk_command_buffer = reinterpret_cast<CommandBuffer_T*>(command_buffer)->vk_command_buffer;
+  memory::GeometryPool* geometry_pool = reinterpret_cast<Device_T*>(cmd_draw_list_info.device)->geometry_pool;
+
+  if (cmd_draw_list_info.draw_count == 0)
+    return 0;
+
+  /* recorded on worker threads, the meshes were made resident before */
+  for (uint32_t i = 0; i < cmd_draw_list_info.draw_count; i++)
+    check_resident(cmd_draw_list_info.draws[i].mesh);
+
+  const size_t vertex_buffer_count = 1;
+  VkBuffer vk_vertex_buffers[vertex_buffer_count] = {geometry_pool->get_vertex_buffer()};
+  VkDeviceSize vk_offsets[vertex_buffer_count] = {0};
+
+  vkCmdBindVertexBuffers(vk_command_buffer, 0, vertex_buffer_count, vk_vertex_buffers, vk_offsets);
+  vkCmdBindIndexBuffer(vk_command_buffer, geometry_pool->get_index_buffer(), 0, VK_INDEX_TYPE_UINT32);
 
-    vkCmdBindPipeline(vk_command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, vk_pipeline);
-    vkCmdBindVertexBuffers(vk_command_buffer, 0, vertex_buffer_count, vk_vertex_buffers, vk_offsets);
-    vkCmdBindIndexBuffer(vk_command_buffer, vk_index_buffer, 0, VK_INDEX_TYPE_UINT32);
+  /* instances of every draw are ranges of the same buffer, selected with 'firstInstance' */
+  if (cmd_draw_list_info.instance_buffer != nullptr)
+  {
+    VkBuffer vk_instance_buffer = reinterpret_cast<Buffer_T*>(cmd_draw_list_info.instance_buffer)->vk_buffer;
+    VkDeviceSize vk_instance_offset = 0;
+    vkCmdBindVertexBuffers(vk_command_buffer, cmd_draw_list_info.instance_binding, 1, &vk_instance_buffer, &vk_instance_offset);
+  }
 
-    vkCmdDrawIndexed(vk_command_buffer, static_cast<uint32_t>(mesh->indices.size()), 1, 0, 0, 0);
+  /* a new pipeline may have a different layout, so its descriptors are bound again */
+  const DrawItem* previous = nullptr;
+  for (uint32_t i = 0; i < cmd_draw_list_info.draw_count; i++)
+  {
+    const DrawItem &draw = cmd_draw_list_info.draws[i];
+    Pipeline_T* pipeline = reinterpret_cast<Pipeline_T*>(draw.pipeline);
+
+    /* the pipeline's build isn't ready and there is no fallback */
+    if (pipeline == nullptr)
+      continue;
+
+    bool pipeline_changed = previous == nullptr || draw.pipeline != previous->pipeline;
+    if (pipeline_changed)
+    {
+      vkCmdBindPipeline(vk_command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline->vk_pipeline);
+      if (pipeline->first_set > 0)
+      {
+	VkDescriptorSet vk_bindless_descriptor_set = reinterpret_cast<Device_T*>(cmd_draw_list_info.device)->bindless_table->get_descriptor_set();
+	vkCmdBindDescriptorSets(vk_command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline->vk_layout,
+	    0, 1, &vk_bindless_descriptor_set, 0, nullptr);
+      }
+    }
+
+    if (draw.descriptor != nullptr && (pipeline_changed || draw.descriptor != previous->descriptor))
+    {
+      VkDescriptorSet vk_descriptor_set = reinterpret_cast<Descriptor_T*>(draw.descriptor)->vk_descriptor_set;
+      vkCmdBindDescriptorSets(vk_command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline->vk_layout,
+	  pipeline->first_set + cmd_draw_list_info.descriptor_set, 1, &vk_descriptor_set, 0, nullptr);
+    }
+
+    uint32_t instance_count = draw.instance_count > 0 ? draw.instance_count : 1;
+    vkCmdDrawIndexed(vk_command_buffer, draw.mesh->index_count, instance_count, draw.mesh->first_index,
+	static_cast<int32_t>(draw.mesh->vertex_offset), draw.first_instance);
+    previous = &draw;
   }
   return 0;
 }
@@ -140,6 +404,9 @@ int me::Vulkan::cmd_draw_meshes(const CmdDrawMeshesInfo &cmd_draw_meshes_info, C
 int me::Vulkan::cleanup_command_buffers(Device device, CommandPool command_pool, uint32_t buffer_count, CommandBuffer* buffers)
 {
   VkDevice vk_device = reinterpret_cast<Device_T*>(device)->vk_device;
+
+  if (command_pool == nullptr)
+    throw exception("in 'cleanup_command_buffers()' frame command buffers are recycled with their frame");
   VkCommandPool vk_command_pool = reinterpret_cast<CommandPool_T*>(command_pool)->vk_command_pool;
 
   VkCommandBuffer vk_command_buffers[buffer_count];
@@ -153,11 +420,23 @@ int me::Vulkan::cleanup_command_buffers(Device device, CommandPool command_pool,
   return 0;
 }
 
+int me::Vulkan::reset_command_pool(Device device, CommandPool command_pool)
+{
+  VkDevice vk_device = reinterpret_cast<Device_T*>(device)->vk_device;
+  VkCommandPool vk_command_pool = reinterpret_cast<CommandPool_T*>(command_pool)->vk_command_pool;
+
+  VkResult result = vkResetCommandPool(vk_device, vk_command_pool, 0);
+  if (result != VK_SUCCESS)
+    throw exception("failed to reset command pool [%s]", util::get_result_string(result));
+  return 0;
+}
+
 
 int allocate_command_buffers(
     VkDevice 					device,
     VkAllocationCallbacks* 			allocation,
     VkCommandPool 				command_pool,
+    VkCommandBufferLevel 			level,
     uint32_t 					count,
     VkCommandBuffer*				command_buffers
     )
@@ -166,7 +445,7 @@ int allocate_command_buffers(
   command_buffer_allocate_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
   command_buffer_allocate_info.pNext = nullptr;
   command_buffer_allocate_info.commandPool = command_pool;
-  command_buffer_allocate_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+  command_buffer_allocate_info.level = level;
   command_buffer_allocate_info.commandBufferCount = count;
 
   VkResult result = vkAllocateCommandBuffers(device, &command_buffer_allocate_info, command_buffers);
@@ -174,3 +453,46 @@ int allocate_command_buffers(
     throw me::exception("failed to allocate command buffers [%s]", me::util::get_result_string(result));
   return 0;
 }
+
+int set_viewport(
+    VkCommandBuffer 				command_buffer,
+    const VkViewport 				&viewport,
+    const VkRect2D 				&scissor
+    )
+{
+  vkCmdSetViewport(command_buffer, 0, 1, &viewport);
+  vkCmdSetScissor(command_buffer, 0, 1, &scissor);
+  return 0;
+}
+
+int set_framebuffer_viewport(
+    VkCommandBuffer 				command_buffer,
+    VkExtent2D 					extent
+    )
+{
+  VkViewport viewport = {
+      .x = 0.0F,
+      .y = 0.0F,
+      .width = static_cast<float>(extent.width),
+      .height = static_cast<float>(extent.height),
+      .minDepth = 0.0F,
+      .maxDepth = 1.0F
+  };
+  VkRect2D scissor = {
+      .offset = {0, 0},
+      .extent = extent
+  };
+
+  set_viewport(command_buffer, viewport, scissor);
+  return 0;
+}
+
+int check_resident(
+    const me::Mesh* 				mesh
+    )
+{
+  if (!mesh->resident)
+    throw me::exception("mesh '%s' is drawn without being resident, call 'make_meshes_resident()' before recording its draws",
+	mesh->identifier.c_str());
+  return 0;
+}
@@ -0,0 +1,107 @@
+#include "CommandAllocator.hpp"
+#include "Types.hpp"
+#include "Util.hpp"
+
+me::command::FrameCommandAllocator::FrameCommandAllocator(allocator alloc, VkDevice device, VkAllocationCallbacks* allocation,
+    query::TimestampProfiler* timestamps, uint32_t queue_family, uint32_t frame_count, uint32_t thread_count)
+  : alloc(alloc), vk_device(device), vk_allocation(allocation), timestamps(timestamps),
+    frame_count(frame_count > 0 ? frame_count : 1), thread_count(thread_count > 0 ? thread_count : 1)
+{
+  VkCommandPoolCreateInfo command_pool_create_info = { };
+  command_pool_create_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+  command_pool_create_info.pNext = nullptr;
+  command_pool_create_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+  command_pool_create_info.queueFamilyIndex = queue_family;
+
+  pools.resize(this->frame_count * this->thread_count);
+  for (Pool &pool : pools)
+  {
+    VkResult result = vkCreateCommandPool(vk_device, &command_pool_create_info, vk_allocation, &pool.vk_command_pool);
+    if (result != VK_SUCCESS)
+      throw exception("failed to create frame command pool [%s]", util::get_result_string(result));
+    pool.primary_count = 0;
+    pool.secondary_count = 0;
+  }
+  frame_index = 0;
+}
+
+int me::command::FrameCommandAllocator::cleanup()
+{
+  /* destroying a pool frees its command buffers */
+  for (Pool &pool : pools)
+  {
+    vkDestroyCommandPool(vk_device, pool.vk_command_pool, vk_allocation);
+    for (CommandBuffer_T* command_buffer : pool.primaries)
+      alloc.deallocate(command_buffer);
+    for (CommandBuffer_T* command_buffer : pool.secondaries)
+      alloc.deallocate(command_buffer);
+  }
+  pools.resize(0);
+  return 0;
+}
+
+int me::command::FrameCommandAllocator::begin_frame(
+    uint32_t 						frame_index
+    )
+{
+  this->frame_index = frame_index % frame_count;
+
+  for (uint32_t i = 0; i < thread_count; i++)
+  {
+    Pool &pool = pools[this->frame_index * thread_count + i];
+    if (pool.primary_count == 0 && pool.secondary_count == 0)
+      continue;
+
+    VkResult result = vkResetCommandPool(vk_device, pool.vk_command_pool, 0);
+    if (result != VK_SUCCESS)
+      throw exception("failed to reset frame command pool [%s]", util::get_result_string(result));
+    pool.primary_count = 0;
+    pool.secondary_count = 0;
+  }
+  return 0;
+}
+
+int me::command::FrameCommandAllocator::allocate(
+    uint32_t 						thread_index,
+    bool 						secondary,
+    CommandBufferUsage 					usage,
+    uint32_t 						count,
+    CommandBuffer_T** 					command_buffers
+    )
+{
+  if (thread_index >= thread_count)
+    throw exception("frame command buffers allocated by thread %u but the device was created for %u threads", thread_index, thread_count);
+
+  Pool &pool = pools[frame_index * thread_count + thread_index];
+  vector<CommandBuffer_T*> &recycled = secondary ? pool.secondaries : pool.primaries;
+  uint32_t &used = secondary ? pool.secondary_count : pool.primary_count;
+
+  /* only allocate what the earlier frames haven't left behind */
+  uint32_t missing = used + count > recycled.size() ? used + count - recycled.size() : 0;
+  if (missing > 0)
+  {
+    VkCommandBufferAllocateInfo command_buffer_allocate_info = { };
+    command_buffer_allocate_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    command_buffer_allocate_info.pNext = nullptr;
+    command_buffer_allocate_info.commandPool = pool.vk_command_pool;
+    command_buffer_allocate_info.level = secondary ? VK_COMMAND_BUFFER_LEVEL_SECONDARY : VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    command_buffer_allocate_info.commandBufferCount = missing;
+
+    VkCommandBuffer vk_command_buffers[missing];
+    VkResult result = vkAllocateCommandBuffers(vk_device, &command_buffer_allocate_info, vk_command_buffers);
+    if (result != VK_SUCCESS)
+      throw exception("failed to allocate frame command buffers [%s]", util::get_result_string(result));
+
+    for (uint32_t i = 0; i < missing; i++)
+      recycled.push_back(alloc.allocate<CommandBuffer_T>(vk_command_buffers[i], usage, secondary, timestamps,
+	  query::TimestampProfiler::NO_REGION));
+  }
+
+  for (uint32_t i = 0; i < count; i++)
+  {
+    CommandBuffer_T* command_buffer = recycled[used++];
+    command_buffer->usage = usage;
+    command_buffers[i] = command_buffer;
+  }
+  return 0;
+}
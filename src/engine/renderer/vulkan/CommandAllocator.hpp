@@ -0,0 +1,81 @@
+#ifndef ME_VULKAN_COMMAND_ALLOCATOR_HPP
+  #define ME_VULKAN_COMMAND_ALLOCATOR_HPP
+
+#include "../Types.hpp"
+
+#include <lme/vector.hpp>
+#include <lme/memory.hpp>
+
+#include <vulkan/vulkan.h>
+
+namespace me {
+
+  struct CommandBuffer_T;
+
+}
+
+namespace me::query {
+
+  class TimestampProfiler;
+
+}
+
+namespace me::command {
+
+  /* one transient command pool per recording thread per frame in flight.
+   * a frame's pools are reset as a whole when the frame begins again and their
+   * command buffers are handed out again instead of being freed and reallocated.
+   * threads only touch their own pools, so different threads can allocate at the same time */
+  class FrameCommandAllocator {
+
+  protected:
+
+    struct Pool {
+      VkCommandPool vk_command_pool;
+      vector<CommandBuffer_T*> primaries;
+      uint32_t primary_count;
+      vector<CommandBuffer_T*> secondaries;
+      uint32_t secondary_count;
+    };
+
+    allocator alloc;
+    VkDevice vk_device;
+    VkAllocationCallbacks* vk_allocation;
+    query::TimestampProfiler* timestamps; /* given to the command buffers, nullptr to not profile them */
+
+    uint32_t frame_count;
+    uint32_t thread_count;
+    vector<Pool> pools; /* 'thread_count' pools per frame */
+    uint32_t frame_index;
+
+  public:
+
+    FrameCommandAllocator(allocator alloc, VkDevice device, VkAllocationCallbacks* allocation, query::TimestampProfiler* timestamps,
+	uint32_t queue_family, uint32_t frame_count, uint32_t thread_count);
+
+    int cleanup();
+
+    /* the frame must not be in flight anymore */
+    int begin_frame(
+	uint32_t 					frame_index
+	);
+
+    /* only one thread may allocate with a 'thread_index' at a time */
+    int allocate(
+	uint32_t 					thread_index,
+	bool 						secondary,
+	CommandBufferUsage 				usage,
+	uint32_t 					count,
+	CommandBuffer_T** 				command_buffers
+	);
+
+    uint32_t get_thread_count() const
+    {
+      return thread_count;
+    }
+
+  };
+
+}
+
+#endif
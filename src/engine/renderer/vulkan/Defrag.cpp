@@ -0,0 +1,290 @@
+#include "Defrag.hpp"
+#include "Types.hpp"
+#include "Util.hpp"
+
+me::memory::Defragmenter::Defragmenter(DeviceAllocator &device_allocator, Uploader &uploader, VkDevice device, VkAllocationCallbacks* allocation,
+    uint32_t frame_count)
+  : device_allocator(device_allocator), uploader(uploader), vk_device(device), vk_allocation(allocation),
+    frame_count(frame_count > 0 ? frame_count : 1)
+{
+  frame = 0;
+}
+
+int me::memory::Defragmenter::cleanup()
+{
+  destroy_retired(true);
+  return 0;
+}
+
+int me::memory::Defragmenter::add(
+    Buffer_T* 						buffer
+    )
+{
+  /* a move copies out of the buffer, without the usage it stays where it is */
+  if (!(buffer->vk_usage & VK_BUFFER_USAGE_TRANSFER_SRC_BIT))
+    return 0;
+
+  buffers.push_back(buffer);
+  return 0;
+}
+
+int me::memory::Defragmenter::remove(
+    Buffer_T* 						buffer
+    )
+{
+  for (size_t i = 0; i < buffers.size(); i++)
+  {
+    if (buffers[i] == buffer)
+    {
+      buffers[i] = buffers[buffers.size() - 1];
+      buffers.resize(buffers.size() - 1);
+      break;
+    }
+  }
+  return 0;
+}
+
+int me::memory::Defragmenter::add_descriptor(
+    Descriptor_T* 					descriptor
+    )
+{
+  descriptors.push_back(descriptor);
+  return 0;
+}
+
+int me::memory::Defragmenter::remove_descriptor(
+    Descriptor_T* 					descriptor
+    )
+{
+  for (size_t i = 0; i < descriptors.size(); i++)
+  {
+    if (descriptors[i] == descriptor)
+    {
+      descriptors[i] = descriptors[descriptors.size() - 1];
+      descriptors.resize(descriptors.size() - 1);
+      break;
+    }
+  }
+  return 0;
+}
+
+int me::memory::Defragmenter::remove_descriptor_allocator(
+    descriptor::DescriptorAllocator* 			allocator
+    )
+{
+  size_t index = 0;
+  while (index < descriptors.size())
+  {
+    if (descriptors[index]->allocator != allocator)
+    {
+      index++;
+      continue;
+    }
+
+    descriptors[index] = descriptors[descriptors.size() - 1];
+    descriptors.resize(descriptors.size() - 1);
+  }
+
+  /* destroying the pools frees these sets too */
+  index = 0;
+  while (index < retired_sets.size())
+  {
+    if (retired_sets[index].allocator != allocator)
+    {
+      index++;
+      continue;
+    }
+
+    retired_sets[index] = retired_sets[retired_sets.size() - 1];
+    retired_sets.resize(retired_sets.size() - 1);
+  }
+  return 0;
+}
+
+int me::memory::Defragmenter::step(
+    VkDeviceSize 					byte_budget,
+    uint32_t 						&moved_count
+    )
+{
+  frame++;
+  moved_count = 0;
+
+  /* frees the space of earlier moves, which may empty the block they came from */
+  destroy_retired(false);
+
+  Block* block = find_movable_block();
+  if (block == nullptr)
+    return 0;
+
+  VkDeviceSize moved_bytes = 0;
+  for (Buffer_T* buffer : buffers)
+  {
+    if (buffer->allocation.block != block)
+      continue;
+
+    if (moved_bytes + buffer->allocation.size > byte_budget)
+      break;
+
+    if (!move(buffer))
+      break;
+
+    moved_bytes += buffer->allocation.size;
+    moved_count++;
+  }
+  return 0;
+}
+
+me::memory::Block* me::memory::Defragmenter::find_movable_block()
+{
+  /* bytes of registered buffers per block */
+  vector<Block*> blocks;
+  vector<VkDeviceSize> movable_bytes;
+  for (Buffer_T* buffer : buffers)
+  {
+    Block* block = buffer->allocation.block;
+    if (block->dedicated)
+      continue;
+
+    size_t index = 0;
+    while (index < blocks.size() && blocks[index] != block)
+      index++;
+
+    if (index == blocks.size())
+    {
+      blocks.push_back(block);
+      movable_bytes.push_back(0);
+    }
+    movable_bytes[index] += buffer->allocation.size;
+  }
+
+  Block* sparse_block = nullptr;
+  for (size_t i = 0; i < blocks.size(); i++)
+  {
+    Block* block = blocks[i];
+
+    /* attachments, rings and mapped buffers can't be moved, the block would never empty */
+    if (movable_bytes[i] != block->used || block->used * 100 > block->size * MAX_OCCUPANCY)
+      continue;
+
+    /* the buffers can only go to another shared block of the same type */
+    if (device_allocator.get_shared_block_count(block->memory_type) <= 1)
+      continue;
+
+    if (sparse_block == nullptr || block->used * sparse_block->size < sparse_block->used * block->size)
+      sparse_block = block;
+  }
+  return sparse_block;
+}
+
+bool me::memory::Defragmenter::move(Buffer_T* buffer)
+{
+  VkBufferCreateInfo buffer_create_info = { };
+  buffer_create_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+  buffer_create_info.pNext = nullptr;
+  buffer_create_info.flags = 0;
+  buffer_create_info.size = buffer->size;
+  buffer_create_info.usage = buffer->vk_usage;
+  buffer_create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+  buffer_create_info.queueFamilyIndexCount = 0;
+  buffer_create_info.pQueueFamilyIndices = nullptr;
+
+  VkBuffer vk_buffer;
+  VkResult result = vkCreateBuffer(vk_device, &buffer_create_info, vk_allocation, &vk_buffer);
+  if (result != VK_SUCCESS)
+    throw exception("failed to create buffer [%s]", util::get_result_string(result));
+
+  VkMemoryRequirements memory_requirements;
+  vkGetBufferMemoryRequirements(vk_device, vk_buffer, &memory_requirements);
+
+  Allocation allocation;
+  if (memory_requirements.size > buffer->allocation.size ||
+      !device_allocator.reallocate(buffer->allocation, memory_requirements.memoryTypeBits, allocation))
+  {
+    vkDestroyBuffer(vk_device, vk_buffer, vk_allocation);
+    return false;
+  }
+
+  result = vkBindBufferMemory(vk_device, vk_buffer, allocation.block->vk_memory, allocation.offset);
+  if (result != VK_SUCCESS)
+    throw exception("failed to bind buffer memory [%s]", util::get_result_string(result));
+
+  uploader.copy(buffer->vk_buffer, 0, vk_buffer, 0, buffer->size);
+
+  /* frames recorded before this may still use the old buffer */
+  retired.push_back({buffer->vk_buffer, buffer->allocation, frame + frame_count});
+  buffer->vk_buffer = vk_buffer;
+  buffer->allocation = allocation;
+
+  rewrite_descriptors(buffer);
+  return true;
+}
+
+int me::memory::Defragmenter::rewrite_descriptors(Buffer_T* buffer)
+{
+  for (Descriptor_T* descriptor : descriptors)
+  {
+    if (descriptor->buffer != buffer)
+      continue;
+
+    /* frames in flight may have the old set bound, so it isn't written in place */
+    VkDescriptorSet vk_descriptor_set;
+    VkDescriptorPool vk_descriptor_pool;
+    descriptor->allocator->allocate(1, &descriptor->vk_descriptor_set_layout, &vk_descriptor_set, vk_descriptor_pool);
+
+    VkDescriptorBufferInfo vk_descriptor_buffer_info = { };
+    vk_descriptor_buffer_info.buffer = buffer->vk_buffer;
+    vk_descriptor_buffer_info.offset = descriptor->offset;
+    vk_descriptor_buffer_info.range = descriptor->range;
+
+    VkWriteDescriptorSet vk_write_descriptor_set = { };
+    vk_write_descriptor_set.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    vk_write_descriptor_set.pNext = nullptr;
+    vk_write_descriptor_set.dstSet = vk_descriptor_set;
+    vk_write_descriptor_set.dstBinding = 0;
+    vk_write_descriptor_set.dstArrayElement = 0;
+    vk_write_descriptor_set.descriptorCount = 1;
+    vk_write_descriptor_set.descriptorType = descriptor->vk_descriptor_type;
+    vk_write_descriptor_set.pImageInfo = nullptr;
+    vk_write_descriptor_set.pBufferInfo = &vk_descriptor_buffer_info;
+    vk_write_descriptor_set.pTexelBufferView = nullptr;
+
+    vkUpdateDescriptorSets(vk_device, 1, &vk_write_descriptor_set, 0, nullptr);
+
+    retired_sets.push_back({descriptor->vk_descriptor_set, descriptor->vk_descriptor_pool, descriptor->allocator, frame + frame_count});
+    descriptor->vk_descriptor_set = vk_descriptor_set;
+    descriptor->vk_descriptor_pool = vk_descriptor_pool;
+  }
+  return 0;
+}
+
+int me::memory::Defragmenter::destroy_retired(bool all)
+{
+  size_t index = 0;
+  while (index < retired.size())
+  {
+    if (!all && retired[index].frame > frame)
+    {
+      index++;
+      continue;
+    }
+
+    destroy_buffer(device_allocator, vk_device, retired[index].vk_buffer, retired[index].allocation);
+    retired[index] = retired[retired.size() - 1];
+    retired.resize(retired.size() - 1);
+  }
+
+  index = 0;
+  while (index < retired_sets.size())
+  {
+    if (!all && retired_sets[index].frame > frame)
+    {
+      index++;
+      continue;
+    }
+
+    vkFreeDescriptorSets(vk_device, retired_sets[index].vk_descriptor_pool, 1, &retired_sets[index].vk_descriptor_set);
+    retired_sets[index] = retired_sets[retired_sets.size() - 1];
+    retired_sets.resize(retired_sets.size() - 1);
+  }
+  return 0;
+}
@@ -0,0 +1,113 @@
+#ifndef ME_VULKAN_DEFRAG_HPP
+  #define ME_VULKAN_DEFRAG_HPP
+
+#include "Memory.hpp"
+#include "Upload.hpp"
+
+#include <lme/vector.hpp>
+
+#include <vulkan/vulkan.h>
+
+namespace me {
+
+  struct Buffer_T;
+  struct Descriptor_T;
+
+}
+
+namespace me::descriptor {
+
+  class DescriptorAllocator;
+
+}
+
+namespace me::memory {
+
+  /* moves device local buffers out of sparsely used blocks a few at a time,
+   * so the blocks become empty and are freed. only blocks that hold nothing but registered buffers
+   * are emptied, anything else in a block would keep it alive anyway.
+   * a moved buffer gets a new 'VkBuffer', the old one is destroyed once no frame in flight can use it anymore.
+   * registered descriptors of a moved buffer get a new set written with it, the old set is freed the same way */
+  class Defragmenter {
+
+  public:
+
+    static constexpr uint32_t MAX_OCCUPANCY = 50; /* percent, fuller blocks are left alone */
+
+  protected:
+
+    struct Retired {
+      VkBuffer vk_buffer;
+      Allocation allocation;
+      uint64_t frame; /* destroyed once this frame has been reached */
+    };
+
+    struct RetiredSet {
+      VkDescriptorSet vk_descriptor_set;
+      VkDescriptorPool vk_descriptor_pool;
+      descriptor::DescriptorAllocator* allocator;
+      uint64_t frame; /* freed once this frame has been reached */
+    };
+
+    DeviceAllocator &device_allocator;
+    Uploader &uploader;
+    VkDevice vk_device;
+    VkAllocationCallbacks* vk_allocation;
+
+    uint32_t frame_count;
+    uint64_t frame;
+
+    vector<Buffer_T*> buffers;
+    vector<Descriptor_T*> descriptors;
+    vector<Retired> retired;
+    vector<RetiredSet> retired_sets;
+
+  public:
+
+    Defragmenter(DeviceAllocator &device_allocator, Uploader &uploader, VkDevice device, VkAllocationCallbacks* allocation,
+	uint32_t frame_count);
+
+    int cleanup();
+
+    /* only registered buffers are moved, ones that can't be a copy source ('VK_BUFFER_USAGE_TRANSFER_SRC_BIT') are ignored */
+    int add(
+	Buffer_T* 					buffer
+	);
+
+    int remove(
+	Buffer_T* 					buffer
+	);
+
+    /* descriptors from a descriptor allocator, written with a single buffer */
+    int add_descriptor(
+	Descriptor_T* 					descriptor
+	);
+
+    int remove_descriptor(
+	Descriptor_T* 					descriptor
+	);
+
+    /* the allocator is destroyed with all of its sets */
+    int remove_descriptor_allocator(
+	descriptor::DescriptorAllocator* 		allocator
+	);
+
+    /* called once per frame, moves at most 'byte_budget' bytes out of the sparsest block.
+     * 'moved_count' buffers got a new 'VkBuffer', command buffers recorded with them before must be recorded again */
+    int step(
+	VkDeviceSize 					byte_budget,
+	uint32_t 					&moved_count
+	);
+
+  protected:
+
+    Block* find_movable_block();
+    bool move(Buffer_T* buffer);
+    int rewrite_descriptors(Buffer_T* buffer);
+    int destroy_retired(bool all);
+
+  };
+
+}
+
+#endif
@@ -0,0 +1,174 @@
+#include "Descriptor.hpp"
+#include "Types.hpp"
+#include "Util.hpp"
+
+#include <lme/math/math.hpp>
+
+me::descriptor::DescriptorAllocator::DescriptorAllocator(VkDevice device, VkAllocationCallbacks* allocation, uint32_t pool_size_count, const PoolSize* pool_sizes,
+    uint32_t sets_per_pool, VkDescriptorPoolCreateFlags flags)
+  : vk_device(device), vk_allocation(allocation), vk_flags(flags), sets_per_pool(sets_per_pool > 0 ? sets_per_pool : 1)
+{
+  for (uint32_t i = 0; i < pool_size_count; i++)
+    this->pool_sizes.push_back(pool_sizes[i]);
+  vk_current_pool = VK_NULL_HANDLE;
+}
+
+int me::descriptor::DescriptorAllocator::cleanup()
+{
+  for (VkDescriptorPool vk_pool : used_pools)
+    vkDestroyDescriptorPool(vk_device, vk_pool, vk_allocation);
+  for (VkDescriptorPool vk_pool : free_pools)
+    vkDestroyDescriptorPool(vk_device, vk_pool, vk_allocation);
+  used_pools.resize(0);
+  free_pools.resize(0);
+  vk_current_pool = VK_NULL_HANDLE;
+  return 0;
+}
+
+int me::descriptor::DescriptorAllocator::allocate(
+    uint32_t 						set_count,
+    const VkDescriptorSetLayout* 			set_layouts,
+    VkDescriptorSet* 					sets,
+    VkDescriptorPool 					&pool
+    )
+{
+  if (vk_current_pool == VK_NULL_HANDLE)
+    next_pool();
+
+  VkDescriptorSetAllocateInfo descriptor_set_allocate_info = { };
+  descriptor_set_allocate_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+  descriptor_set_allocate_info.pNext = nullptr;
+  descriptor_set_allocate_info.descriptorPool = vk_current_pool;
+  descriptor_set_allocate_info.descriptorSetCount = set_count;
+  descriptor_set_allocate_info.pSetLayouts = set_layouts;
+
+  VkResult result = vkAllocateDescriptorSets(vk_device, &descriptor_set_allocate_info, sets);
+
+  /* the pool is full, retry once with a fresh pool */
+  if (result == VK_ERROR_OUT_OF_POOL_MEMORY || result == VK_ERROR_FRAGMENTED_POOL)
+  {
+    next_pool();
+    descriptor_set_allocate_info.descriptorPool = vk_current_pool;
+    result = vkAllocateDescriptorSets(vk_device, &descriptor_set_allocate_info, sets);
+  }
+
+  if (result != VK_SUCCESS)
+    throw exception("failed to allocate descriptor sets [%s]", util::get_result_string(result));
+
+  pool = vk_current_pool;
+  return 0;
+}
+
+int me::descriptor::DescriptorAllocator::reset()
+{
+  for (VkDescriptorPool vk_pool : used_pools)
+  {
+    vkResetDescriptorPool(vk_device, vk_pool, 0);
+    free_pools.push_back(vk_pool);
+  }
+  used_pools.resize(0);
+  vk_current_pool = VK_NULL_HANDLE;
+  return 0;
+}
+
+int me::descriptor::DescriptorAllocator::next_pool()
+{
+  if (free_pools.size() > 0)
+  {
+    vk_current_pool = free_pools[free_pools.size() - 1];
+    free_pools.resize(free_pools.size() - 1);
+    used_pools.push_back(vk_current_pool);
+    return 0;
+  }
+
+  VkDescriptorPoolSize descriptor_pool_sizes[pool_sizes.size()];
+  for (size_t i = 0; i < pool_sizes.size(); i++)
+  {
+    descriptor_pool_sizes[i].type = pool_sizes[i].type;
+    descriptor_pool_sizes[i].descriptorCount = math::max(1U, (uint32_t) (pool_sizes[i].ratio * sets_per_pool));
+  }
+
+  VkDescriptorPoolCreateInfo descriptor_pool_create_info = { };
+  descriptor_pool_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+  descriptor_pool_create_info.pNext = nullptr;
+  descriptor_pool_create_info.flags = vk_flags;
+  descriptor_pool_create_info.maxSets = sets_per_pool;
+  descriptor_pool_create_info.poolSizeCount = pool_sizes.size();
+  descriptor_pool_create_info.pPoolSizes = descriptor_pool_sizes;
+
+  VkResult result = vkCreateDescriptorPool(vk_device, &descriptor_pool_create_info, vk_allocation, &vk_current_pool);
+  if (result != VK_SUCCESS)
+    throw exception("failed to create descriptor pool [%s]", util::get_result_string(result));
+  used_pools.push_back(vk_current_pool);
+
+  /* grow so the number of pools stays small */
+  sets_per_pool = math::min(sets_per_pool + sets_per_pool / 2, MAX_SETS_PER_POOL);
+  return 0;
+}
+
+
+me::descriptor::FrameDescriptorAllocator::FrameDescriptorAllocator(allocator alloc, VkDevice device, VkAllocationCallbacks* allocation,
+    uint32_t frame_count)
+  : alloc(alloc)
+{
+  frames.resize(frame_count > 0 ? frame_count : 1);
+  for (Frame &frame : frames)
+  {
+    frame.allocator = alloc.allocate<DescriptorAllocator>(device, allocation,
+	DescriptorAllocator::DEFAULT_POOL_SIZE_COUNT, DescriptorAllocator::DEFAULT_POOL_SIZES);
+    frame.descriptor_count = 0;
+  }
+  frame_index = 0;
+}
+
+int me::descriptor::FrameDescriptorAllocator::cleanup()
+{
+  for (Frame &frame : frames)
+  {
+    frame.allocator->cleanup();
+    alloc.deallocate(frame.allocator);
+    for (Descriptor_T* descriptor : frame.descriptors)
+      alloc.deallocate(descriptor);
+  }
+  frames.resize(0);
+  return 0;
+}
+
+int me::descriptor::FrameDescriptorAllocator::begin_frame(
+    uint32_t 						frame_index
+    )
+{
+  this->frame_index = frame_index % frames.size();
+
+  Frame &frame = frames[this->frame_index];
+  frame.allocator->reset();
+  frame.descriptor_count = 0;
+  return 0;
+}
+
+int me::descriptor::FrameDescriptorAllocator::allocate(
+    uint32_t 						set_count,
+    const VkDescriptorSetLayout* 			set_layouts,
+    Descriptor_T** 					descriptors
+    )
+{
+  Frame &frame = frames[frame_index];
+
+  VkDescriptorSet vk_descriptor_sets[set_count];
+  VkDescriptorPool vk_descriptor_pool;
+  frame.allocator->allocate(set_count, set_layouts, vk_descriptor_sets, vk_descriptor_pool);
+
+  for (uint32_t i = 0; i < set_count; i++)
+  {
+    if (frame.descriptor_count == frame.descriptors.size())
+      frame.descriptors.push_back(alloc.allocate<Descriptor_T>());
+
+    Descriptor_T* descriptor = frame.descriptors[frame.descriptor_count++];
+    descriptor->vk_descriptor_set = vk_descriptor_sets[i];
+    descriptor->vk_descriptor_pool = VK_NULL_HANDLE;
+    descriptor->allocator = nullptr;
+    descriptor->buffer = nullptr;
+    descriptors[i] = descriptor;
+  }
+  return 0;
+}
@@ -0,0 +1,120 @@
+#ifndef ME_VULKAN_DESCRIPTOR_HPP
+  #define ME_VULKAN_DESCRIPTOR_HPP
+
+#include <lme/vector.hpp>
+#include <lme/memory.hpp>
+
+#include <vulkan/vulkan.h>
+
+namespace me {
+
+  struct Descriptor_T;
+
+}
+
+namespace me::descriptor {
+
+  /* number of descriptors of a type per set in a pool */
+  struct PoolSize {
+    VkDescriptorType type;
+    float ratio;
+  };
+
+  /* allocates descriptor sets from a list of pools, a new pool is created when
+   * all of them are out of memory. each pool is larger than the one before */
+  class DescriptorAllocator {
+
+  public:
+
+    static constexpr uint32_t DEFAULT_SETS_PER_POOL = 64;
+    static constexpr uint32_t MAX_SETS_PER_POOL = 4096;
+
+    /* most sets in the engine are buffer descriptors */
+    static constexpr uint32_t DEFAULT_POOL_SIZE_COUNT = 9;
+    static constexpr PoolSize DEFAULT_POOL_SIZES[DEFAULT_POOL_SIZE_COUNT] = {
+      {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2.0F},
+      {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1.0F},
+      {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2.0F},
+      {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, 0.5F},
+      {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 2.0F},
+      {VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 1.0F},
+      {VK_DESCRIPTOR_TYPE_SAMPLER, 0.5F},
+      {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 0.5F},
+      {VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, 0.5F}
+    };
+
+  protected:
+
+    VkDevice vk_device;
+    VkAllocationCallbacks* vk_allocation;
+    VkDescriptorPoolCreateFlags vk_flags;
+
+    vector<PoolSize> pool_sizes;
+    uint32_t sets_per_pool;
+
+    VkDescriptorPool vk_current_pool;
+    vector<VkDescriptorPool> used_pools;
+    vector<VkDescriptorPool> free_pools; /* reset and empty */
+
+  public:
+
+    DescriptorAllocator(VkDevice device, VkAllocationCallbacks* allocation, uint32_t pool_size_count, const PoolSize* pool_sizes,
+	uint32_t sets_per_pool = DEFAULT_SETS_PER_POOL, VkDescriptorPoolCreateFlags flags = 0);
+
+    int cleanup();
+
+    /* 'pool' is the pool the sets came from, needed to free them */
+    int allocate(
+	uint32_t 					set_count,
+	const VkDescriptorSetLayout* 			set_layouts,
+	VkDescriptorSet* 				sets,
+	VkDescriptorPool 				&pool
+	);
+
+    /* frees every set of every pool */
+    int reset();
+
+  protected:
+
+    int next_pool();
+
+  };
+
+  /* one descriptor allocator per frame in flight, reset as a whole when its frame begins again.
+   * sets from it are only valid during the frame they were allocated in */
+  class FrameDescriptorAllocator {
+
+  protected:
+
+    struct Frame {
+      DescriptorAllocator* allocator;
+      vector<Descriptor_T*> descriptors; /* handles are reused between frames */
+      uint32_t descriptor_count;
+    };
+
+    allocator alloc;
+    vector<Frame> frames;
+    uint32_t frame_index;
+
+  public:
+
+    FrameDescriptorAllocator(allocator alloc, VkDevice device, VkAllocationCallbacks* allocation, uint32_t frame_count);
+
+    int cleanup();
+
+    /* the frame must not be in flight anymore */
+    int begin_frame(
+	uint32_t 					frame_index
+	);
+
+    int allocate(
+	uint32_t 					set_count,
+	const VkDescriptorSetLayout* 			set_layouts,
+	Descriptor_T** 					descriptors
+	);
+
+  };
+
+}
+
+#endif
@@ -4,6 +4,7 @@
 
 #include <lme/vector.hpp>
 #include <lme/algorithm.hpp>
+#include <lme/math/math.hpp>
 #include <vulkan/vulkan_core.h>
 
 /*
@@ -52,6 +53,7 @@ int me::Vulkan::create_device(const DeviceCreateInfo &device_create_info, Device
   Surface_T* surface = reinterpret_cast<Surface_T*>(device_create_info.surface);
   VkPhysicalDevice vk_physical_device = reinterpret_cast<PhysicalDevice_T*>(device_create_info.physical_devices[0])->vk_physical_device;
   VkPhysicalDeviceFeatures vk_physical_device_features = reinterpret_cast<PhysicalDevice_T*>(device_create_info.physical_devices[0])->vk_features;
+  VkPhysicalDeviceLimits vk_physical_device_limits = reinterpret_cast<PhysicalDevice_T*>(device_create_info.physical_devices[0])->vk_properties.limits;
 
   uint32_t queue_family_count;
   vkGetPhysicalDeviceQueueFamilyProperties(vk_physical_device, &queue_family_count, nullptr);
@@ -102,17 +104,78 @@ int me::Vulkan::create_device(const DeviceCreateInfo &device_create_info, Device
     device_queue_create_infos[i].pQueuePriorities = queue_priorities;
   } 
 
+  /* the required extensions are for presenting, a device without a surface only renders offscreen */
+  vector<const char*> device_extensions;
+  if (surface != nullptr)
+  {
+    for (const char* extension : required_device_extensions)
+      device_extensions.push_back(extension);
+  }
+
+  /* optional extensions */
+  uint32_t extension_count;
+  vkEnumerateDeviceExtensionProperties(vk_physical_device, nullptr, &extension_count, nullptr);
+  VkExtensionProperties extensions[extension_count];
+  vkEnumerateDeviceExtensionProperties(vk_physical_device, nullptr, &extension_count, extensions);
+
+  const char* memory_budget_extension = VK_EXT_MEMORY_BUDGET_EXTENSION_NAME;
+  bool memory_budget_supported = util::has_required_extensions({extension_count, extensions}, {1, &memory_budget_extension});
+  if (memory_budget_supported)
+    device_extensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+
+  /* descriptor indexing is optional, it enables the bindless table */
+  VkPhysicalDeviceVulkan12Features vk_supported_vulkan12_features = { };
+  vk_supported_vulkan12_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+  vk_supported_vulkan12_features.pNext = nullptr;
+
+  VkPhysicalDeviceFeatures2 vk_supported_features = { };
+  vk_supported_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+  vk_supported_features.pNext = &vk_supported_vulkan12_features;
+  vkGetPhysicalDeviceFeatures2(vk_physical_device, &vk_supported_features);
+
+  bool descriptor_indexing_supported = vk_supported_vulkan12_features.runtimeDescriptorArray &&
+    vk_supported_vulkan12_features.descriptorBindingPartiallyBound &&
+    vk_supported_vulkan12_features.descriptorBindingUpdateUnusedWhilePending &&
+    vk_supported_vulkan12_features.descriptorBindingStorageBufferUpdateAfterBind &&
+    vk_supported_vulkan12_features.descriptorBindingSampledImageUpdateAfterBind;
+
+  /* with an indirect draw count, culled objects don't leave empty draws behind */
+  bool draw_indirect_count_supported = vk_supported_vulkan12_features.drawIndirectCount;
+
+  /* timeline semaphores track uploads, there is no fallback without them */
+  if (!vk_supported_vulkan12_features.timelineSemaphore)
+    throw exception("failed to create device [timeline semaphores are not supported by the physical device]");
+
+  VkPhysicalDeviceVulkan12Features vk_physical_device_vulkan12_features = { };
+  vk_physical_device_vulkan12_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+  vk_physical_device_vulkan12_features.pNext = nullptr;
+  vk_physical_device_vulkan12_features.timelineSemaphore = VK_TRUE;
+  vk_physical_device_vulkan12_features.drawIndirectCount = draw_indirect_count_supported;
+
+  if (descriptor_indexing_supported)
+  {
+    vk_physical_device_vulkan12_features.runtimeDescriptorArray = VK_TRUE;
+    vk_physical_device_vulkan12_features.descriptorBindingPartiallyBound = VK_TRUE;
+    vk_physical_device_vulkan12_features.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+    vk_physical_device_vulkan12_features.descriptorBindingStorageBufferUpdateAfterBind = VK_TRUE;
+    vk_physical_device_vulkan12_features.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+    vk_physical_device_vulkan12_features.shaderStorageBufferArrayNonUniformIndexing =
+      vk_supported_vulkan12_features.shaderStorageBufferArrayNonUniformIndexing;
+    vk_physical_device_vulkan12_features.shaderSampledImageArrayNonUniformIndexing =
+      vk_supported_vulkan12_features.shaderSampledImageArrayNonUniformIndexing;
+  }
+
   /* === Creating a logical device === */
   VkDeviceCreateInfo vk_device_create_info = { };
   vk_device_create_info.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
-  vk_device_create_info.pNext = nullptr;
+  vk_device_create_info.pNext = &vk_physical_device_vulkan12_features;
   vk_device_create_info.flags = 0;
   vk_device_create_info.queueCreateInfoCount = unique_queue_family_count;
   vk_device_create_info.pQueueCreateInfos = device_queue_create_infos;
   vk_device_create_info.enabledLayerCount = required_device_layers.size();
   vk_device_create_info.ppEnabledLayerNames = required_device_layers.data();
-  vk_device_create_info.enabledExtensionCount = required_device_extensions.size();
-  vk_device_create_info.ppEnabledExtensionNames = required_device_extensions.data();
+  vk_device_create_info.enabledExtensionCount = device_extensions.size();
+  vk_device_create_info.ppEnabledExtensionNames = device_extensions.data();
   vk_device_create_info.pEnabledFeatures = &vk_physical_device_features;
 
   VkDevice vk_device;
@@ -120,13 +183,162 @@ int me::Vulkan::create_device(const DeviceCreateInfo &device_create_info, Device
   if (result != VK_SUCCESS)
     throw exception("failed to create device [%s]", util::get_result_string(result));
 
-  device = alloc.allocate<Device_T>(vk_device, compute_queue_index, graphics_queue_index, present_queue_index, transfer_queue_index);
+  memory::DeviceAllocator* memory_allocator = alloc.allocate<memory::DeviceAllocator>(alloc, vk_physical_device, vk_device, vk_allocation,
+      memory_budget_supported);
+
+  memory::StagingRing* staging_ring = alloc.allocate<memory::StagingRing>(*memory_allocator, vk_device, vk_allocation, device_create_info.frame_count);
+  staging_ring->initialize();
+
+  memory::Uploader* uploader = alloc.allocate<memory::Uploader>(vk_device, vk_allocation, *staging_ring, transfer_queue_index, graphics_queue_index);
+  uploader->initialize();
+
+  memory::GeometryPool* geometry_pool = alloc.allocate<memory::GeometryPool>(*memory_allocator, vk_device, sizeof(Vertex), sizeof(Index));
+  geometry_pool->initialize();
+
+  memory::ResidencyManager* residency = alloc.allocate<memory::ResidencyManager>(*memory_allocator, *geometry_pool, *uploader,
+      device_create_info.frame_count);
+
+  memory::Defragmenter* defragmenter = alloc.allocate<memory::Defragmenter>(*memory_allocator, *uploader, vk_device, vk_allocation,
+      device_create_info.frame_count);
+
+  /* frames are submitted to the graphics queue, its family decides if timestamps can be written at all */
+  query::TimestampProfiler* timestamps = nullptr;
+  if (device_create_info.profiler != nullptr)
+  {
+    uint32_t timestamp_valid_bits = queue_families[graphics_queue_index].timestampValidBits;
+    if (timestamp_valid_bits > 0)
+    {
+      timestamps = alloc.allocate<query::TimestampProfiler>(*device_create_info.profiler, vk_device, vk_allocation, graphics_queue_index,
+	  timestamp_valid_bits, vk_physical_device_limits.timestampPeriod, device_create_info.frame_count);
+      timestamps->initialize();
+    }else
+      logger.warn("the graphics queue doesn't support timestamps, gpu time is not profiled");
+  }
+
+  command::FrameCommandAllocator* frame_commands = alloc.allocate<command::FrameCommandAllocator>(alloc, vk_device, vk_allocation,
+      timestamps, graphics_queue_index, device_create_info.frame_count, device_create_info.thread_count);
+
+  descriptor::BindlessTable* bindless_table = nullptr;
+  if (descriptor_indexing_supported)
+  {
+    VkPhysicalDeviceVulkan12Properties vk_physical_device_vulkan12_properties = { };
+    vk_physical_device_vulkan12_properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_PROPERTIES;
+    vk_physical_device_vulkan12_properties.pNext = nullptr;
+
+    VkPhysicalDeviceProperties2 vk_physical_device_properties = { };
+    vk_physical_device_properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+    vk_physical_device_properties.pNext = &vk_physical_device_vulkan12_properties;
+    vkGetPhysicalDeviceProperties2(vk_physical_device, &vk_physical_device_properties);
+
+    uint32_t max_storage_buffers = math::min(vk_physical_device_vulkan12_properties.maxDescriptorSetUpdateAfterBindStorageBuffers,
+	vk_physical_device_vulkan12_properties.maxPerStageDescriptorUpdateAfterBindStorageBuffers);
+    uint32_t max_sampled_images = math::min(vk_physical_device_vulkan12_properties.maxDescriptorSetUpdateAfterBindSampledImages,
+	vk_physical_device_vulkan12_properties.maxPerStageDescriptorUpdateAfterBindSampledImages);
+
+    bindless_table = alloc.allocate<descriptor::BindlessTable>(vk_device, vk_allocation, device_create_info.frame_count,
+	max_storage_buffers, max_sampled_images);
+    bindless_table->initialize();
+  }
+
+  descriptor::FrameDescriptorAllocator* frame_descriptors = alloc.allocate<descriptor::FrameDescriptorAllocator>(alloc, vk_device, vk_allocation,
+      device_create_info.frame_count);
+
+  pipeline::PipelineCache* pipeline_cache = alloc.allocate<pipeline::PipelineCache>(vk_device, vk_allocation,
+      reinterpret_cast<PhysicalDevice_T*>(device_create_info.physical_devices[0])->vk_properties, device_create_info.pipeline_cache_path);
+  pipeline_cache->initialize();
+
+  pipeline::StateCache* state_cache = alloc.allocate<pipeline::StateCache>();
+
+  pipeline::PipelineCompiler* pipeline_compiler = alloc.allocate<pipeline::PipelineCompiler>(this, device_create_info.pipeline_thread_count);
+  pipeline_compiler->initialize();
+
+  device = alloc.allocate<Device_T>(vk_device, vk_physical_device_limits, compute_queue_index, graphics_queue_index, present_queue_index, transfer_queue_index,
+      memory_allocator, staging_ring, uploader, geometry_pool, residency, defragmenter, bindless_table, frame_descriptors,
+      frame_commands, pipeline_cache, pipeline_compiler, state_cache, timestamps,
+      static_cast<bool>(vk_physical_device_features.multiDrawIndirect), draw_indirect_count_supported);
   return 0;
 }
 
 int me::Vulkan::cleanup_device(Device device)
 {
   VkDevice vk_device = reinterpret_cast<Device_T*>(device)->vk_device;
+  memory::DeviceAllocator* memory_allocator = reinterpret_cast<Device_T*>(device)->memory_allocator;
+  memory::StagingRing* staging_ring = reinterpret_cast<Device_T*>(device)->staging_ring;
+  memory::Uploader* uploader = reinterpret_cast<Device_T*>(device)->uploader;
+  memory::GeometryPool* geometry_pool = reinterpret_cast<Device_T*>(device)->geometry_pool;
+  memory::ResidencyManager* residency = reinterpret_cast<Device_T*>(device)->residency;
+  memory::Defragmenter* defragmenter = reinterpret_cast<Device_T*>(device)->defragmenter;
+  descriptor::BindlessTable* bindless_table = reinterpret_cast<Device_T*>(device)->bindless_table;
+  descriptor::FrameDescriptorAllocator* frame_descriptors = reinterpret_cast<Device_T*>(device)->frame_descriptors;
+
+  command::FrameCommandAllocator* frame_commands = reinterpret_cast<Device_T*>(device)->frame_commands;
+  pipeline::PipelineCache* pipeline_cache = reinterpret_cast<Device_T*>(device)->pipeline_cache;
+  pipeline::PipelineCompiler* pipeline_compiler = reinterpret_cast<Device_T*>(device)->pipeline_compiler;
+  pipeline::StateCache* state_cache = reinterpret_cast<Device_T*>(device)->state_cache;
+  query::TimestampProfiler* timestamps = reinterpret_cast<Device_T*>(device)->timestamps;
+
+  /* queued builds still go into the cache */
+  pipeline_compiler->cleanup();
+  alloc.deallocate(pipeline_compiler);
+
+  pipeline::StateCache::Stats state_stats = state_cache->get_stats();
+  logger.info("shared %u of %u pipeline requests and %u of %u pipeline layout requests",
+      state_stats.hits[pipeline::STATE_KIND_PIPELINE],
+      state_stats.hits[pipeline::STATE_KIND_PIPELINE] + state_stats.misses[pipeline::STATE_KIND_PIPELINE],
+      state_stats.hits[pipeline::STATE_KIND_PIPELINE_LAYOUT],
+      state_stats.hits[pipeline::STATE_KIND_PIPELINE_LAYOUT] + state_stats.misses[pipeline::STATE_KIND_PIPELINE_LAYOUT]);
+
+  uint32_t state_object_count = state_cache->get_object_count();
+  if (state_object_count > 0)
+    logger.warn("%u pipeline state objects were never cleaned up", state_object_count);
+
+  state_cache->cleanup();
+  alloc.deallocate(state_cache);
+
+  /* cold starts compile every pipeline, warm starts should mostly hit the cache file */
+  pipeline::PipelineCache::Stats pipeline_stats = pipeline_cache->get_stats();
+  logger.info("created %u pipelines in %.3f ms (%s start)", pipeline_stats.pipeline_count,
+      static_cast<double>(pipeline_stats.creation_time) / 1000000.0, pipeline_stats.seeded ? "warm" : "cold");
+
+  if (!pipeline_cache->cleanup())
+    logger.warn("failed to save the pipeline cache to '%s', the next start compiles every pipeline again", pipeline_cache->get_path());
+  alloc.deallocate(pipeline_cache);
+  frame_commands->cleanup();
+  alloc.deallocate(frame_commands);
+
+  if (timestamps != nullptr)
+  {
+    timestamps->cleanup();
+    alloc.deallocate(timestamps);
+  }
+
+  frame_descriptors->cleanup();
+  alloc.deallocate(frame_descriptors);
+
+  if (bindless_table != nullptr)
+  {
+    bindless_table->cleanup();
+    alloc.deallocate(bindless_table);
+  }
+
+  alloc.deallocate(residency);
+
+  uploader->cleanup();
+  alloc.deallocate(uploader);
+
+  /* after the uploader, its copies may read the old buffers */
+  defragmenter->cleanup();
+  alloc.deallocate(defragmenter);
+
+  staging_ring->cleanup();
+  alloc.deallocate(staging_ring);
+
+  geometry_pool->cleanup();
+  alloc.deallocate(geometry_pool);
+
+  /* all buffers must be destroyed before this */
+  memory_allocator->cleanup();
+  alloc.deallocate(memory_allocator);
 
   vkDestroyDevice(vk_device, vk_allocation);
   return 0;
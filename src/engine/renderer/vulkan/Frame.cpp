@@ -37,7 +37,7 @@ int me::Vulkan::create_frames(const FrameCreateInfo &frame_create_info, uint32_t
     if (result != VK_SUCCESS)
       throw exception("failed to create fence [%s]", util::get_result_string(result));
 
-    frames[i] = alloc.allocate<Frame_T>(vk_image_available_semaphore, vk_render_finished_semaphore, vk_in_flight_fence);
+    frames[i] = alloc.allocate<Frame_T>(vk_image_available_semaphore, vk_render_finished_semaphore, vk_in_flight_fence, uint64_t(0));
   }
   return 0;
 }
@@ -7,11 +7,14 @@ int me::Vulkan::create_framebuffer(const FramebufferCreateInfo &framebuffer_info
 
   VkDevice vk_device = reinterpret_cast<Device_T*>(framebuffer_info.device)->vk_device;
   VkRenderPass vk_render_pass = reinterpret_cast<RenderPass_T*>(framebuffer_info.render_pass)->vk_render_pass;
-  VkImageView vk_image_view = reinterpret_cast<SwapchainImage_T*>(framebuffer_info.image)->vk_image_view;
 
-  uint32_t attachment_count = 1;
+  uint32_t swapchain_image_count = framebuffer_info.image != nullptr ? 1 : 0;
+  uint32_t attachment_count = swapchain_image_count + framebuffer_info.attachment_count;
   VkImageView attachments[attachment_count];
-  attachments[0] = vk_image_view;
+  if (swapchain_image_count > 0)
+    attachments[0] = reinterpret_cast<SwapchainImage_T*>(framebuffer_info.image)->vk_image_view;
+  for (uint32_t i = 0; i < framebuffer_info.attachment_count; i++)
+    attachments[swapchain_image_count + i] = reinterpret_cast<Attachment_T*>(framebuffer_info.attachments[i])->vk_image_view;
 
   VkFramebufferCreateInfo framebuffer_create_info = { };
   framebuffer_create_info.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
@@ -29,7 +32,7 @@ int me::Vulkan::create_framebuffer(const FramebufferCreateInfo &framebuffer_info
   if (result != VK_SUCCESS)
     throw exception("failed to create framebuffer [%s]", util::get_result_string(result));
 
-  framebuffer = alloc.allocate<Framebuffer_T>(vk_framebuffer);
+  framebuffer = alloc.allocate<Framebuffer_T>(vk_framebuffer, VkExtent2D{framebuffer_create_info.width, framebuffer_create_info.height});
   return 0;
 }
 
@@ -39,5 +42,6 @@ int me::Vulkan::cleanup_framebuffer(Device device, Framebuffer framebuffer)
   VkFramebuffer vk_framebuffer = reinterpret_cast<Framebuffer_T*>(framebuffer)->vk_framebuffer;
 
   vkDestroyFramebuffer(vk_device, vk_framebuffer, vk_allocation);
+  alloc.deallocate(reinterpret_cast<Framebuffer_T*>(framebuffer));
   return 0;
 }
@@ -0,0 +1,200 @@
+#include "Geometry.hpp"
+
+#include <lme/math/math.hpp>
+
+me::memory::RangeAllocator::RangeAllocator(uint32_t capacity)
+  : capacity(capacity), used(0)
+{
+  free_ranges.push_back({0, capacity});
+}
+
+bool me::memory::RangeAllocator::allocate(uint32_t count, uint32_t &offset)
+{
+  for (size_t i = 0; i < free_ranges.size(); i++)
+  {
+    Range &range = free_ranges[i];
+    if (range.count < count)
+      continue;
+
+    offset = range.offset;
+    range.offset += count;
+    range.count -= count;
+
+    /* remove the empty range, keeping the list sorted */
+    if (range.count == 0)
+    {
+      for (size_t j = i + 1; j < free_ranges.size(); j++)
+	free_ranges[j - 1] = free_ranges[j];
+      free_ranges.resize(free_ranges.size() - 1);
+    }
+
+    used += count;
+    return true;
+  }
+  return false;
+}
+
+void me::memory::RangeAllocator::free(uint32_t offset, uint32_t count)
+{
+  if (count == 0)
+    return;
+
+  used -= count;
+
+  size_t index = 0;
+  while (index < free_ranges.size() && free_ranges[index].offset < offset)
+    index++;
+
+  bool merge_previous = index > 0 && free_ranges[index - 1].offset + free_ranges[index - 1].count == offset;
+  bool merge_next = index < free_ranges.size() && offset + count == free_ranges[index].offset;
+
+  if (merge_previous && merge_next)
+  {
+    free_ranges[index - 1].count += count + free_ranges[index].count;
+    for (size_t j = index + 1; j < free_ranges.size(); j++)
+      free_ranges[j - 1] = free_ranges[j];
+    free_ranges.resize(free_ranges.size() - 1);
+  }else if (merge_previous)
+  {
+    free_ranges[index - 1].count += count;
+  }else if (merge_next)
+  {
+    free_ranges[index].offset = offset;
+    free_ranges[index].count += count;
+  }else
+  {
+    free_ranges.push_back({0, 0});
+    for (size_t j = free_ranges.size() - 1; j > index; j--)
+      free_ranges[j] = free_ranges[j - 1];
+    free_ranges[index] = {offset, count};
+  }
+}
+
+uint32_t me::memory::RangeAllocator::get_largest_free() const
+{
+  uint32_t largest = 0;
+  for (const Range &range : free_ranges)
+    largest = math::max(largest, range.count);
+  return largest;
+}
+
+void me::memory::RangeAllocator::reset(uint32_t capacity)
+{
+  this->capacity = capacity;
+  used = 0;
+  free_ranges.resize(0);
+  free_ranges.push_back({0, capacity});
+}
+
+
+me::memory::GeometryPool::GeometryPool(DeviceAllocator &device_allocator, VkDevice device, VkDeviceSize vertex_stride, VkDeviceSize index_stride,
+    uint32_t vertex_capacity, uint32_t index_capacity)
+  : device_allocator(device_allocator), vk_device(device), vertex_stride(vertex_stride), index_stride(index_stride),
+    vertex_ranges(vertex_capacity), index_ranges(index_capacity), generation(0)
+{
+}
+
+int me::memory::GeometryPool::initialize()
+{
+  create_buffers();
+  return 0;
+}
+
+int me::memory::GeometryPool::cleanup()
+{
+  release_retired(0, true);
+  destroy_buffer(device_allocator, vk_device, vk_vertex_buffer, vertex_allocation);
+  destroy_buffer(device_allocator, vk_device, vk_index_buffer, index_allocation);
+  return 0;
+}
+
+bool me::memory::GeometryPool::allocate(
+    uint32_t 						vertex_count,
+    uint32_t 						index_count,
+    uint32_t 						&vertex_offset,
+    uint32_t 						&first_index
+    )
+{
+  if (!vertex_ranges.allocate(vertex_count, vertex_offset))
+    return false;
+
+  if (!index_ranges.allocate(index_count, first_index))
+  {
+    vertex_ranges.free(vertex_offset, vertex_count);
+    return false;
+  }
+  return true;
+}
+
+void me::memory::GeometryPool::free(
+    uint32_t 						vertex_offset,
+    uint32_t 						vertex_count,
+    uint32_t 						first_index,
+    uint32_t 						index_count
+    )
+{
+  vertex_ranges.free(vertex_offset, vertex_count);
+  index_ranges.free(first_index, index_count);
+}
+
+int me::memory::GeometryPool::resize(
+    uint32_t 						vertex_capacity,
+    uint32_t 						index_capacity,
+    uint64_t 						release_frame,
+    VkBuffer 						&old_vertex_buffer,
+    VkBuffer 						&old_index_buffer
+    )
+{
+  retired.push_back({vk_vertex_buffer, vertex_allocation, vk_index_buffer, index_allocation, release_frame});
+  old_vertex_buffer = vk_vertex_buffer;
+  old_index_buffer = vk_index_buffer;
+
+  vertex_ranges.reset(vertex_capacity);
+  index_ranges.reset(index_capacity);
+  create_buffers();
+  generation++;
+  return 0;
+}
+
+int me::memory::GeometryPool::release_retired(
+    uint64_t 						frame,
+    bool 						all
+    )
+{
+  size_t index = 0;
+  while (index < retired.size())
+  {
+    if (!all && retired[index].frame > frame)
+    {
+      index++;
+      continue;
+    }
+
+    destroy_buffer(device_allocator, vk_device, retired[index].vk_vertex_buffer, retired[index].vertex_allocation);
+    destroy_buffer(device_allocator, vk_device, retired[index].vk_index_buffer, retired[index].index_allocation);
+    retired[index] = retired[retired.size() - 1];
+    retired.resize(retired.size() - 1);
+  }
+  return 0;
+}
+
+VkDeviceSize me::memory::GeometryPool::get_allocated_bytes() const
+{
+  VkDeviceSize bytes = vertex_allocation.size + index_allocation.size;
+  for (const Retired &buffers : retired)
+    bytes += buffers.vertex_allocation.size + buffers.index_allocation.size;
+  return bytes;
+}
+
+int me::memory::GeometryPool::create_buffers()
+{
+  /* dedicated, so the memory goes back to the heap when the pool shrinks instead of staying in a shared block */
+  create_buffer(device_allocator, vk_device, vertex_stride * vertex_ranges.get_capacity(),
+      VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_SHARING_MODE_EXCLUSIVE,
+      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, vk_vertex_buffer, vertex_allocation, true);
+
+  create_buffer(device_allocator, vk_device, index_stride * index_ranges.get_capacity(),
+      VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_SHARING_MODE_EXCLUSIVE,
+      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, vk_index_buffer, index_allocation, true);
+  return 0;
+}
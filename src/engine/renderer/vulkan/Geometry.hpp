@@ -0,0 +1,202 @@
+#ifndef ME_VULKAN_GEOMETRY_HPP
+  #define ME_VULKAN_GEOMETRY_HPP
+
+#include "Memory.hpp"
+
+#include <lme/vector.hpp>
+
+#include <vulkan/vulkan.h>
+
+namespace me::memory {
+
+  /* first fit allocator of element ranges, free ranges are kept sorted and merged */
+  class RangeAllocator {
+
+  protected:
+
+    struct Range {
+      uint32_t offset;
+      uint32_t count;
+    };
+
+    uint32_t capacity;
+    uint32_t used;
+    vector<Range> free_ranges;
+
+  public:
+
+    explicit RangeAllocator(uint32_t capacity);
+
+    bool allocate(uint32_t count, uint32_t &offset);
+    void free(uint32_t offset, uint32_t count);
+
+    /* forgets every allocation */
+    void reset(uint32_t capacity);
+
+    uint32_t get_capacity() const
+    {
+      return capacity;
+    }
+
+    uint32_t get_used() const
+    {
+      return used;
+    }
+
+    uint32_t get_largest_free() const;
+
+  };
+
+  /* one vertex buffer and one index buffer shared by all meshes of a device.
+   * meshes own ranges in them, so draws bind the buffers once and use
+   * 'vertexOffset' and 'firstIndex' to select the mesh.
+   * 'resize()' replaces both buffers, the old ones are kept until no frame in flight can read them.
+   * every range moves with them, the generation tells users that copied ranges to read them again */
+  class GeometryPool {
+
+  public:
+
+    static constexpr uint32_t MIN_VERTEX_CAPACITY = 64 * 1024;
+    static constexpr uint32_t MIN_INDEX_CAPACITY = 256 * 1024;
+
+  protected:
+
+    struct Retired {
+      VkBuffer vk_vertex_buffer;
+      Allocation vertex_allocation;
+      VkBuffer vk_index_buffer;
+      Allocation index_allocation;
+      uint64_t frame; /* destroyed once this frame has been reached */
+    };
+
+    DeviceAllocator &device_allocator;
+    VkDevice vk_device;
+
+    VkDeviceSize vertex_stride;
+    VkDeviceSize index_stride;
+
+    VkBuffer vk_vertex_buffer;
+    Allocation vertex_allocation;
+    VkBuffer vk_index_buffer;
+    Allocation index_allocation;
+
+    RangeAllocator vertex_ranges;
+    RangeAllocator index_ranges;
+
+    vector<Retired> retired;
+    uint64_t generation; /* incremented by 'resize()' */
+
+  public:
+
+    GeometryPool(DeviceAllocator &device_allocator, VkDevice device, VkDeviceSize vertex_stride, VkDeviceSize index_stride,
+	uint32_t vertex_capacity = MIN_VERTEX_CAPACITY, uint32_t index_capacity = MIN_INDEX_CAPACITY);
+
+    int initialize();
+    int cleanup();
+
+    /* returns false if the pool is full */
+    bool allocate(
+	uint32_t 					vertex_count,
+	uint32_t 					index_count,
+	uint32_t 					&vertex_offset,
+	uint32_t 					&first_index
+	);
+
+    void free(
+	uint32_t 					vertex_offset,
+	uint32_t 					vertex_count,
+	uint32_t 					first_index,
+	uint32_t 					index_count
+	);
+
+    /* creates empty buffers with the new capacities, the old buffers are returned so their ranges can be
+     * copied over and are destroyed by 'release_retired()' once 'release_frame' has been reached */
+    int resize(
+	uint32_t 					vertex_capacity,
+	uint32_t 					index_capacity,
+	uint64_t 					release_frame,
+	VkBuffer 					&old_vertex_buffer,
+	VkBuffer 					&old_index_buffer
+	);
+
+    /* destroys the retired buffers of frames before 'frame', or all of them */
+    int release_retired(
+	uint64_t 					frame,
+	bool 						all = false
+	);
+
+    uint64_t get_generation() const
+    {
+      return generation;
+    }
+
+    VkBuffer get_vertex_buffer() const
+    {
+      return vk_vertex_buffer;
+    }
+
+    VkBuffer get_index_buffer() const
+    {
+      return vk_index_buffer;
+    }
+
+    uint32_t get_vertex_capacity() const
+    {
+      return vertex_ranges.get_capacity();
+    }
+
+    uint32_t get_index_capacity() const
+    {
+      return index_ranges.get_capacity();
+    }
+
+    uint32_t get_vertex_used() const
+    {
+      return vertex_ranges.get_used();
+    }
+
+    uint32_t get_index_used() const
+    {
+      return index_ranges.get_used();
+    }
+
+    /* free space split into small ranges fits fewer meshes than its size suggests */
+    bool is_fragmented() const
+    {
+      return (vertex_ranges.get_capacity() - vertex_ranges.get_used()) > 2 * vertex_ranges.get_largest_free() ||
+	(index_ranges.get_capacity() - index_ranges.get_used()) > 2 * index_ranges.get_largest_free();
+    }
+
+    VkDeviceSize get_capacity_bytes(uint32_t vertex_capacity, uint32_t index_capacity) const
+    {
+      return vertex_capacity * vertex_stride + index_capacity * index_stride;
+    }
+
+    /* device memory of the current and the retired buffers */
+    VkDeviceSize get_allocated_bytes() const;
+
+    /* the heap the buffers are allocated from */
+    uint32_t get_heap_index() const
+    {
+      return device_allocator.get_memory_properties().memoryTypes[vertex_allocation.block->memory_type].heapIndex;
+    }
+
+    VkDeviceSize get_vertex_stride() const
+    {
+      return vertex_stride;
+    }
+
+    VkDeviceSize get_index_stride() const
+    {
+      return index_stride;
+    }
+
+  protected:
+
+    int create_buffers();
+
+  };
+
+}
+
+#endif
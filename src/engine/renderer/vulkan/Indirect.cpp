@@ -0,0 +1,420 @@
+#include "Vulkan.hpp"
+#include "Util.hpp"
+
+/* the layouts of the structs in res/cull.comp */
+struct CullObject {
+  float bounds[4];
+  uint32_t first_index;
+  uint32_t index_count;
+  int32_t vertex_offset;
+  uint32_t object_index;
+};
+
+struct CullConstants {
+  float frustum_planes[6][4];
+  uint32_t object_count;
+  uint32_t compact; /* visible commands are packed to the front and counted, otherwise culled ones get 0 instances */
+};
+
+static constexpr uint32_t CULL_GROUP_SIZE = 64;
+
+static int create_cull_pipeline(
+    VkDevice 					device,
+    VkAllocationCallbacks* 			allocation,
+    me::pipeline::PipelineCache* 		pipeline_cache,
+    const me::Shader* 				shader,
+    VkDescriptorSetLayout 			&descriptor_set_layout,
+    VkPipelineLayout 				&pipeline_layout,
+    VkPipeline 					&pipeline
+    );
+
+static bool is_compact(
+    const me::Device_T* 			device
+    );
+
+static CullObject* get_objects(
+    const me::Device_T* 			device,
+    const me::IndirectDrawList_T* 		list
+    );
+
+static int write_ranges(
+    const me::Device_T* 			device,
+    me::IndirectDrawList_T* 			list
+    );
+
+
+int me::Vulkan::create_indirect_draw_list(const IndirectDrawListCreateInfo &indirect_draw_list_create_info, IndirectDrawList &draw_list)
+{
+  VERIFY_CREATE_INFO(indirect_draw_list_create_info, STRUCTURE_TYPE_INDIRECT_DRAW_LIST_CREATE_INFO);
+
+  VkDevice vk_device = reinterpret_cast<Device_T*>(indirect_draw_list_create_info.device)->vk_device;
+  memory::DeviceAllocator* memory_allocator = reinterpret_cast<Device_T*>(indirect_draw_list_create_info.device)->memory_allocator;
+  VkDeviceSize vk_alignment = reinterpret_cast<Device_T*>(indirect_draw_list_create_info.device)->vk_limits.minStorageBufferOffsetAlignment;
+
+  if (indirect_draw_list_create_info.cull_shader == nullptr || indirect_draw_list_create_info.cull_shader->type != SHADER_TYPE_COMPUTE)
+    throw exception("in 'create_indirect_draw_list()' IndirectDrawListCreateInfo::cull_shader must be a 'SHADER_TYPE_COMPUTE' shader");
+
+  uint32_t frame_count = indirect_draw_list_create_info.frame_count > 0 ? indirect_draw_list_create_info.frame_count : 1;
+  uint32_t capacity = indirect_draw_list_create_info.capacity;
+  VkDeviceSize frame_size = (capacity * sizeof(CullObject) + vk_alignment - 1) / vk_alignment * vk_alignment;
+
+  /* the host writes the objects every frame, coherent memory avoids a flush per write */
+  VkBuffer vk_object_buffer;
+  memory::Allocation object_allocation;
+  memory::create_buffer(*memory_allocator, vk_device, frame_size * frame_count,
+      VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_SHARING_MODE_EXCLUSIVE,
+      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, vk_object_buffer, object_allocation);
+
+  void* objects;
+  memory_allocator->map(object_allocation, objects);
+
+  /* commands and count stay on the device, they are only copied out to check the cull. the previous frame has finished reading them
+   * when the next cull writes them, since frames are submitted to the same queue and 'cmd_cull_indirect' waits for indirect reads */
+  VkBuffer vk_command_buffer;
+  memory::Allocation command_allocation;
+  memory::create_buffer(*memory_allocator, vk_device, capacity * sizeof(VkDrawIndexedIndirectCommand),
+      VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_SHARING_MODE_EXCLUSIVE,
+      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, vk_command_buffer, command_allocation);
+
+  VkBuffer vk_count_buffer;
+  memory::Allocation count_allocation;
+  memory::create_buffer(*memory_allocator, vk_device, sizeof(uint32_t),
+      VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+      VK_SHARING_MODE_EXCLUSIVE,
+      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, vk_count_buffer, count_allocation);
+
+  VkDescriptorSetLayout vk_descriptor_set_layout;
+  VkPipelineLayout vk_layout;
+  VkPipeline vk_pipeline;
+  create_cull_pipeline(vk_device, vk_allocation, reinterpret_cast<Device_T*>(indirect_draw_list_create_info.device)->pipeline_cache,
+      indirect_draw_list_create_info.cull_shader, vk_descriptor_set_layout, vk_layout, vk_pipeline);
+
+  /* one set per frame, only the object range differs between them */
+  VkDescriptorPoolSize descriptor_pool_size = { };
+  descriptor_pool_size.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+  descriptor_pool_size.descriptorCount = 3 * frame_count;
+
+  VkDescriptorPoolCreateInfo descriptor_pool_create_info = { };
+  descriptor_pool_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+  descriptor_pool_create_info.pNext = nullptr;
+  descriptor_pool_create_info.flags = 0;
+  descriptor_pool_create_info.maxSets = frame_count;
+  descriptor_pool_create_info.poolSizeCount = 1;
+  descriptor_pool_create_info.pPoolSizes = &descriptor_pool_size;
+
+  VkDescriptorPool vk_descriptor_pool;
+  VkResult result = vkCreateDescriptorPool(vk_device, &descriptor_pool_create_info, vk_allocation, &vk_descriptor_pool);
+  if (result != VK_SUCCESS)
+    throw exception("failed to create indirect draw list descriptor pool [%s]", util::get_result_string(result));
+
+  VkDescriptorSetLayout vk_descriptor_set_layouts[frame_count];
+  for (uint32_t i = 0; i < frame_count; i++)
+    vk_descriptor_set_layouts[i] = vk_descriptor_set_layout;
+
+  VkDescriptorSetAllocateInfo descriptor_set_allocate_info = { };
+  descriptor_set_allocate_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+  descriptor_set_allocate_info.pNext = nullptr;
+  descriptor_set_allocate_info.descriptorPool = vk_descriptor_pool;
+  descriptor_set_allocate_info.descriptorSetCount = frame_count;
+  descriptor_set_allocate_info.pSetLayouts = vk_descriptor_set_layouts;
+
+  vector<VkDescriptorSet> vk_descriptor_sets;
+  vk_descriptor_sets.resize(frame_count);
+  result = vkAllocateDescriptorSets(vk_device, &descriptor_set_allocate_info, vk_descriptor_sets.data());
+  if (result != VK_SUCCESS)
+    throw exception("failed to allocate indirect draw list descriptor sets [%s]", util::get_result_string(result));
+
+  for (uint32_t i = 0; i < frame_count; i++)
+  {
+    VkDescriptorBufferInfo descriptor_buffer_infos[3];
+    descriptor_buffer_infos[0] = {vk_object_buffer, i * frame_size, capacity * sizeof(CullObject)};
+    descriptor_buffer_infos[1] = {vk_command_buffer, 0, VK_WHOLE_SIZE};
+    descriptor_buffer_infos[2] = {vk_count_buffer, 0, VK_WHOLE_SIZE};
+
+    VkWriteDescriptorSet write_descriptor_set = { };
+    write_descriptor_set.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write_descriptor_set.pNext = nullptr;
+    write_descriptor_set.dstSet = vk_descriptor_sets[i];
+    write_descriptor_set.dstBinding = 0;
+    write_descriptor_set.dstArrayElement = 0;
+    write_descriptor_set.descriptorCount = 3;
+    write_descriptor_set.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    write_descriptor_set.pImageInfo = nullptr;
+    write_descriptor_set.pBufferInfo = descriptor_buffer_infos;
+    write_descriptor_set.pTexelBufferView = nullptr;
+
+    vkUpdateDescriptorSets(vk_device, 1, &write_descriptor_set, 0, nullptr);
+  }
+
+  draw_list = alloc.allocate<IndirectDrawList_T>(vk_object_buffer, object_allocation, static_cast<char*>(objects),
+      vk_command_buffer, command_allocation, vk_count_buffer, count_allocation,
+      vk_descriptor_set_layout, vk_descriptor_pool, vk_descriptor_sets, vk_layout, vk_pipeline,
+      capacity, frame_count, 0U, 0U, vector<Mesh*>(), static_cast<uint64_t>(0));
+  return 0;
+}
+
+int me::Vulkan::indirect_draw_list_write(const IndirectDrawListWriteInfo &indirect_draw_list_write_info, IndirectDrawList draw_list)
+{
+  IndirectDrawList_T* list = reinterpret_cast<IndirectDrawList_T*>(draw_list);
+  Device_T* device = reinterpret_cast<Device_T*>(indirect_draw_list_write_info.device);
+
+  if (indirect_draw_list_write_info.object_count > list->capacity)
+    throw exception("in 'indirect_draw_list_write()' IndirectDrawListWriteInfo::object_count is larger than the capacity. \e[31m%u\e[0m > %u",
+	indirect_draw_list_write_info.object_count, list->capacity);
+
+  /* the draw commands are built on the device from the geometry ranges, so they must be valid before the cull runs */
+  device->residency->make_resident(indirect_draw_list_write_info.object_count, indirect_draw_list_write_info.meshes);
+
+  list->frame_index = indirect_draw_list_write_info.frame_index % list->frame_count;
+  list->object_count = indirect_draw_list_write_info.object_count;
+
+  CullObject* objects = get_objects(device, list);
+  list->meshes.resize(list->object_count);
+  for (uint32_t i = 0; i < list->object_count; i++)
+  {
+    const math::vec4f &bounds = indirect_draw_list_write_info.bounds[i];
+
+    objects[i].bounds[0] = bounds[0];
+    objects[i].bounds[1] = bounds[1];
+    objects[i].bounds[2] = bounds[2];
+    objects[i].bounds[3] = bounds[3];
+    objects[i].object_index = i;
+    list->meshes[i] = indirect_draw_list_write_info.meshes[i];
+  }
+  write_ranges(device, list);
+  return 0;
+}
+
+int me::Vulkan::cmd_cull_indirect(const CmdCullIndirectInfo &cmd_cull_indirect_info, CommandBuffer command_buffer)
+{
+  VkCommandBuffer vk_command_buffer = reinterpret_cast<CommandBuffer_T*>(command_buffer)->vk_command_buffer;
+  IndirectDrawList_T* list = reinterpret_cast<IndirectDrawList_T*>(cmd_cull_indirect_info.draw_list);
+  Device_T* device = reinterpret_cast<Device_T*>(cmd_cull_indirect_info.device);
+  bool compact = is_compact(device);
+
+  /* streaming or 'defragment' may have moved the geometry pool since the write, the objects are read when the cull runs */
+  if (list->geometry_generation != device->geometry_pool->get_generation())
+    write_ranges(device, list);
+
+  /* the draws of the previous frame read the commands and the count, which are written again below */
+  VkMemoryBarrier memory_barrier = { };
+  memory_barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+  memory_barrier.pNext = nullptr;
+  memory_barrier.srcAccessMask = 0;
+  memory_barrier.dstAccessMask = 0;
+  vkCmdPipelineBarrier(vk_command_buffer, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+      VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &memory_barrier, 0, nullptr, 0, nullptr);
+
+  vkCmdFillBuffer(vk_command_buffer, list->vk_count_buffer, 0, sizeof(uint32_t), 0);
+
+  memory_barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  memory_barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+  vkCmdPipelineBarrier(vk_command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+      0, 1, &memory_barrier, 0, nullptr, 0, nullptr);
+
+  CullConstants cull_constants;
+  for (uint32_t i = 0; i < 6; i++)
+  {
+    for (uint32_t j = 0; j < 4; j++)
+      cull_constants.frustum_planes[i][j] = cmd_cull_indirect_info.frustum_planes[i][j];
+  }
+  cull_constants.object_count = list->object_count;
+  cull_constants.compact = compact ? 1 : 0;
+
+  vkCmdBindPipeline(vk_command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, list->vk_pipeline);
+  vkCmdBindDescriptorSets(vk_command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, list->vk_layout,
+      0, 1, &list->vk_descriptor_sets[list->frame_index], 0, nullptr);
+  vkCmdPushConstants(vk_command_buffer, list->vk_layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(CullConstants), &cull_constants);
+
+  if (list->object_count > 0)
+    vkCmdDispatch(vk_command_buffer, (list->object_count + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE, 1, 1);
+
+  memory_barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+  memory_barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+  vkCmdPipelineBarrier(vk_command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+      0, 1, &memory_barrier, 0, nullptr, 0, nullptr);
+  return 0;
+}
+
+int me::Vulkan::cmd_draw_indirect(const CmdDrawIndirectInfo &cmd_draw_indirect_info, CommandBuffer command_buffer)
+{
+  VkCommandBuffer vk_command_buffer = reinterpret_cast<CommandBuffer_T*>(command_buffer)->vk_command_buffer;
+  VkPipeline vk_pipeline = reinterpret_cast<Pipeline_T*>(cmd_draw_indirect_info.pipeline)->vk_pipeline;
+  VkPipelineLayout vk_pipeline_layout = reinterpret_cast<Pipeline_T*>(cmd_draw_indirect_info.pipeline)->vk_layout;
+  uint32_t first_set = reinterpret_cast<Pipeline_T*>(cmd_draw_indirect_info.pipeline)->first_set;
+  Device_T* device = reinterpret_cast<Device_T*>(cmd_draw_indirect_info.device);
+  IndirectDrawList_T* list = reinterpret_cast<IndirectDrawList_T*>(cmd_draw_indirect_info.draw_list);
+
+  const size_t vertex_buffer_count = 1;
+  VkBuffer vk_vertex_buffers[vertex_buffer_count] = {device->geometry_pool->get_vertex_buffer()};
+  VkDeviceSize vk_offsets[vertex_buffer_count] = {0};
+
+  vkCmdBindPipeline(vk_command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, vk_pipeline);
+  vkCmdBindVertexBuffers(vk_command_buffer, 0, vertex_buffer_count, vk_vertex_buffers, vk_offsets);
+  vkCmdBindIndexBuffer(vk_command_buffer, device->geometry_pool->get_index_buffer(), 0, VK_INDEX_TYPE_UINT32);
+
+  if (first_set > 0)
+  {
+    VkDescriptorSet vk_bindless_descriptor_set = device->bindless_table->get_descriptor_set();
+    vkCmdBindDescriptorSets(vk_command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, vk_pipeline_layout,
+	0, 1, &vk_bindless_descriptor_set, 0, nullptr);
+  }
+
+  if (list->object_count == 0)
+    return 0;
+
+  /* without a draw count every object has a command, culled ones draw 0 instances */
+  const uint32_t stride = sizeof(VkDrawIndexedIndirectCommand);
+  if (is_compact(device))
+  {
+    vkCmdDrawIndexedIndirectCount(vk_command_buffer, list->vk_command_buffer, 0, list->vk_count_buffer, 0, list->object_count, stride);
+  }else if (device->multi_draw_indirect)
+  {
+    vkCmdDrawIndexedIndirect(vk_command_buffer, list->vk_command_buffer, 0, list->object_count, stride);
+  }else
+  {
+    for (uint32_t i = 0; i < list->object_count; i++)
+      vkCmdDrawIndexedIndirect(vk_command_buffer, list->vk_command_buffer, i * stride, 1, stride);
+  }
+  return 0;
+}
+
+int me::Vulkan::cleanup_indirect_draw_list(Device device, IndirectDrawList draw_list)
+{
+  VkDevice vk_device = reinterpret_cast<Device_T*>(device)->vk_device;
+  memory::DeviceAllocator* memory_allocator = reinterpret_cast<Device_T*>(device)->memory_allocator;
+  IndirectDrawList_T* list = reinterpret_cast<IndirectDrawList_T*>(draw_list);
+
+  vkDestroyPipeline(vk_device, list->vk_pipeline, vk_allocation);
+  vkDestroyPipelineLayout(vk_device, list->vk_layout, vk_allocation);
+  vkDestroyDescriptorPool(vk_device, list->vk_descriptor_pool, vk_allocation);
+  vkDestroyDescriptorSetLayout(vk_device, list->vk_descriptor_set_layout, vk_allocation);
+
+  memory::destroy_buffer(*memory_allocator, vk_device, list->vk_object_buffer, list->object_allocation);
+  memory::destroy_buffer(*memory_allocator, vk_device, list->vk_command_buffer, list->command_allocation);
+  memory::destroy_buffer(*memory_allocator, vk_device, list->vk_count_buffer, list->count_allocation);
+  alloc.deallocate(list);
+  return 0;
+}
+
+
+int create_cull_pipeline(
+    VkDevice 					device,
+    VkAllocationCallbacks* 			allocation,
+    me::pipeline::PipelineCache* 		pipeline_cache,
+    const me::Shader* 				shader,
+    VkDescriptorSetLayout 			&descriptor_set_layout,
+    VkPipelineLayout 				&pipeline_layout,
+    VkPipeline 					&pipeline
+    )
+{
+  /* objects, commands and count */
+  VkDescriptorSetLayoutBinding descriptor_set_layout_bindings[3];
+  for (uint32_t i = 0; i < 3; i++)
+  {
+    descriptor_set_layout_bindings[i].binding = i;
+    descriptor_set_layout_bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    descriptor_set_layout_bindings[i].descriptorCount = 1;
+    descriptor_set_layout_bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    descriptor_set_layout_bindings[i].pImmutableSamplers = nullptr;
+  }
+
+  VkDescriptorSetLayoutCreateInfo descriptor_set_layout_create_info = { };
+  descriptor_set_layout_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+  descriptor_set_layout_create_info.pNext = nullptr;
+  descriptor_set_layout_create_info.flags = 0;
+  descriptor_set_layout_create_info.bindingCount = 3;
+  descriptor_set_layout_create_info.pBindings = descriptor_set_layout_bindings;
+
+  VkResult result = vkCreateDescriptorSetLayout(device, &descriptor_set_layout_create_info, allocation, &descriptor_set_layout);
+  if (result != VK_SUCCESS)
+    throw me::exception("failed to create cull descriptor set layout [%s]", me::util::get_result_string(result));
+
+  VkPushConstantRange push_constant_range = { };
+  push_constant_range.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+  push_constant_range.offset = 0;
+  push_constant_range.size = sizeof(CullConstants);
+
+  VkPipelineLayoutCreateInfo pipeline_layout_create_info = { };
+  pipeline_layout_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+  pipeline_layout_create_info.pNext = nullptr;
+  pipeline_layout_create_info.flags = 0;
+  pipeline_layout_create_info.setLayoutCount = 1;
+  pipeline_layout_create_info.pSetLayouts = &descriptor_set_layout;
+  pipeline_layout_create_info.pushConstantRangeCount = 1;
+  pipeline_layout_create_info.pPushConstantRanges = &push_constant_range;
+
+  result = vkCreatePipelineLayout(device, &pipeline_layout_create_info, allocation, &pipeline_layout);
+  if (result != VK_SUCCESS)
+    throw me::exception("failed to create cull pipeline layout [%s]", me::util::get_result_string(result));
+
+  VkShaderModuleCreateInfo shader_module_create_info = { };
+  shader_module_create_info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+  shader_module_create_info.pNext = nullptr;
+  shader_module_create_info.flags = 0;
+  shader_module_create_info.codeSize = shader->data.size;
+  shader_module_create_info.pCode = reinterpret_cast<const uint32_t*>(shader->data.code);
+
+  VkShaderModule shader_module;
+  result = vkCreateShaderModule(device, &shader_module_create_info, allocation, &shader_module);
+  if (result != VK_SUCCESS)
+    throw me::exception("failed to create shader module [%s]", me::util::get_result_string(result));
+
+  VkComputePipelineCreateInfo compute_pipeline_create_info = { };
+  compute_pipeline_create_info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+  compute_pipeline_create_info.pNext = nullptr;
+  compute_pipeline_create_info.flags = 0;
+  compute_pipeline_create_info.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+  compute_pipeline_create_info.stage.pNext = nullptr;
+  compute_pipeline_create_info.stage.flags = 0;
+  compute_pipeline_create_info.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+  compute_pipeline_create_info.stage.module = shader_module;
+  compute_pipeline_create_info.stage.pName = shader->config.entry_point;
+  compute_pipeline_create_info.stage.pSpecializationInfo = nullptr;
+  compute_pipeline_create_info.layout = pipeline_layout;
+  compute_pipeline_create_info.basePipelineHandle = VK_NULL_HANDLE;
+  compute_pipeline_create_info.basePipelineIndex = -1;
+
+  uint64_t start_time = me::pipeline::PipelineCache::get_time();
+  result = vkCreateComputePipelines(device, pipeline_cache->get_pipeline_cache(), 1, &compute_pipeline_create_info, allocation, &pipeline);
+  pipeline_cache->record_creation(start_time);
+  vkDestroyShaderModule(device, shader_module, allocation);
+  if (result != VK_SUCCESS)
+    throw me::exception("failed to create cull pipeline [%s]", me::util::get_result_string(result));
+  return 0;
+}
+
+bool is_compact(
+    const me::Device_T* 			device
+    )
+{
+  /* a draw count above 1 needs multi draw indirect */
+  return device->draw_indirect_count && device->multi_draw_indirect;
+}
+
+CullObject* get_objects(
+    const me::Device_T* 			device,
+    const me::IndirectDrawList_T* 		list
+    )
+{
+  VkDeviceSize vk_alignment = device->vk_limits.minStorageBufferOffsetAlignment;
+  VkDeviceSize frame_size = (list->capacity * sizeof(CullObject) + vk_alignment - 1) / vk_alignment * vk_alignment;
+  return reinterpret_cast<CullObject*>(list->objects + list->frame_index * frame_size);
+}
+
+int write_ranges(
+    const me::Device_T* 			device,
+    me::IndirectDrawList_T* 			list
+    )
+{
+  CullObject* objects = get_objects(device, list);
+  for (uint32_t i = 0; i < list->object_count; i++)
+  {
+    const me::Mesh* mesh = list->meshes[i];
+    objects[i].first_index = mesh->first_index;
+    objects[i].index_count = mesh->index_count;
+    objects[i].vertex_offset = static_cast<int32_t>(mesh->vertex_offset);
+  }
+  list->geometry_generation = device->geometry_pool->get_generation();
+  return 0;
+}
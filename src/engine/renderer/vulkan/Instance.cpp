@@ -46,6 +46,7 @@ int me::Vulkan::setup_instance(const EngineInitInfo &engine_init_info)
   application_info.applicationVersion = engine_init_info.engine_info->application_info.version;
   application_info.pEngineName = ME_ENGINE_NAME;
   application_info.engineVersion = VK_MAKE_VERSION(ME_ENGINE_VERSION_MAJOR, ME_ENGINE_VERSION_MINOR, ME_ENGINE_VERSION_PATCH);
+  application_info.apiVersion = VK_API_VERSION_1_2;
 
   VkInstanceCreateInfo instance_create_info = { };
   instance_create_info.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
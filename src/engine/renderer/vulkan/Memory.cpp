@@ -1,6 +1,9 @@
 #include "Vulkan.hpp"
 #include "Util.hpp"
 #include "Memory.hpp"
+#include "Staging.hpp"
+
+#include <lme/math/math.hpp>
 
 int me::Vulkan::create_descriptor_pool(const DescriptorPoolCreateInfo &descriptor_pool_create_info, DescriptorPool &descriptor_pool)
 {
@@ -8,25 +11,22 @@ int me::Vulkan::create_descriptor_pool(const DescriptorPoolCreateInfo &descripto
 
   VkDevice vk_device = reinterpret_cast<Device_T*>(descriptor_pool_create_info.device)->vk_device;
 
-  uint32_t pool_size_count = 1;
-  VkDescriptorPoolSize vk_descriptor_pool_sizes[pool_size_count];
-  vk_descriptor_pool_sizes[0].type = util::get_vulkan_descriptor_type(descriptor_pool_create_info.descriptor_type);
-  vk_descriptor_pool_sizes[0].descriptorCount = descriptor_pool_create_info.descriptor_count;
-
-  VkDescriptorPoolCreateInfo vk_descriptor_pool_create_info = {};
-  vk_descriptor_pool_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-  vk_descriptor_pool_create_info.pNext = nullptr;
-  vk_descriptor_pool_create_info.flags = 0;
-  vk_descriptor_pool_create_info.maxSets = descriptor_pool_create_info.descriptor_count;
-  vk_descriptor_pool_create_info.poolSizeCount = pool_size_count;
-  vk_descriptor_pool_create_info.pPoolSizes = vk_descriptor_pool_sizes;
-
-  VkDescriptorPool vk_descriptor_pool;
-  VkResult result = vkCreateDescriptorPool(vk_device, &vk_descriptor_pool_create_info, vk_allocation, &vk_descriptor_pool);
-  if (result != VK_SUCCESS)
-    throw exception("failed to create descriptor pool [%s]", util::get_result_string(result));
+  /* 'DESCRIPTOR_TYPE_NONE' makes pools with a mix of every type */
+  uint32_t pool_size_count = descriptor::DescriptorAllocator::DEFAULT_POOL_SIZE_COUNT;
+  const descriptor::PoolSize* pool_sizes = descriptor::DescriptorAllocator::DEFAULT_POOL_SIZES;
+  descriptor::PoolSize single_pool_size;
+  if (descriptor_pool_create_info.descriptor_type != DESCRIPTOR_TYPE_NONE)
+  {
+    single_pool_size = {util::get_vulkan_descriptor_type(descriptor_pool_create_info.descriptor_type), 1.0F};
+    pool_size_count = 1;
+    pool_sizes = &single_pool_size;
+  }
 
-  descriptor_pool = alloc.allocate<DescriptorPool_T>(vk_descriptor_pool, descriptor_pool_create_info.descriptor_type);
+  /* the first pool fits 'descriptor_count' sets, more pools are added when it runs out */
+  descriptor::DescriptorAllocator* descriptor_allocator = alloc.allocate<descriptor::DescriptorAllocator>(vk_device, vk_allocation,
+      pool_size_count, pool_sizes, descriptor_pool_create_info.descriptor_count, VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT);
+
+  descriptor_pool = alloc.allocate<DescriptorPool_T>(descriptor_allocator, descriptor_pool_create_info.descriptor_type);
   return 0;
 }
 
@@ -43,6 +43,11 @@ int me::Vulkan::create_command_pool(const CommandPoolCreateInfo &command_pool_cr
   vk_command_pool_create_info.flags = 0;
   vk_command_pool_create_info.queueFamilyIndex = queue_index;
 
+  if (command_pool_create_info.transient)
+    vk_command_pool_create_info.flags |= VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+  if (command_pool_create_info.resettable)
+    vk_command_pool_create_info.flags |= VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+
   VkCommandPool vk_command_pool;
   VkResult result = vkCreateCommandPool(vk_device, &vk_command_pool_create_info, vk_allocation, &vk_command_pool);
   if (result != VK_SUCCESS)
@@ -56,8 +61,8 @@ int me::Vulkan::create_buffer(const BufferCreateInfo &buffer_create_info, Buffer
 {
   VERIFY_CREATE_INFO(buffer_create_info, STRUCTURE_TYPE_BUFFER_CREATE_INFO);
 
-  VkPhysicalDevice vk_physical_device = reinterpret_cast<PhysicalDevice_T*>(buffer_create_info.physical_device)->vk_physical_device;
   VkDevice vk_device = reinterpret_cast<Device_T*>(buffer_create_info.device)->vk_device;
+  memory::DeviceAllocator* memory_allocator = reinterpret_cast<Device_T*>(buffer_create_info.device)->memory_allocator;
 
   VkBufferUsageFlags vk_buffer_usage = VK_BUFFER_USAGE_FLAG_BITS_MAX_ENUM;
   VkMemoryPropertyFlags vk_memory_property = VK_MEMORY_PROPERTY_FLAG_BITS_MAX_ENUM;
@@ -72,32 +77,44 @@ int me::Vulkan::create_buffer(const BufferCreateInfo &buffer_create_info, Buffer
 
   if (buffer_create_info.write_method == BUFFER_WRITE_METHOD_STANDARD)
   {
+    /* coherency is not required, writes are flushed */
     vk_buffer_usage |= VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-    vk_memory_property = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    vk_memory_property = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
   }else if (buffer_create_info.write_method == BUFFER_WRITE_METHOD_STAGING)
   {
-    vk_buffer_usage |= VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    /* the source of the copy when 'defragment' moves the buffer */
+    vk_buffer_usage |= VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
     vk_memory_property = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
   }
 
   VkDeviceSize vk_buffer_size = buffer_create_info.size;
   VkBuffer vk_buffer;
-  VkDeviceMemory vk_buffer_memory;
-  me::memory::create_buffer(vk_physical_device, vk_device, vk_buffer_size,
+  memory::Allocation buffer_allocation;
+  me::memory::create_buffer(*memory_allocator, vk_device, vk_buffer_size,
       vk_buffer_usage, VK_SHARING_MODE_EXCLUSIVE,
-      vk_memory_property, vk_buffer, vk_buffer_memory);
+      vk_memory_property, vk_buffer, buffer_allocation);
+
+  /* host visible buffers stay mapped for their lifetime */
+  void* data = nullptr;
+  if (buffer_create_info.write_method == BUFFER_WRITE_METHOD_STANDARD)
+    memory_allocator->map(buffer_allocation, data);
 
-  buffer = alloc.allocate<Buffer_T>(vk_buffer, vk_buffer_memory,
-      buffer_create_info.usage, buffer_create_info.write_method, buffer_create_info.size);
+  Buffer_T* created_buffer = alloc.allocate<Buffer_T>(vk_buffer, vk_buffer_usage, buffer_allocation,
+      buffer_create_info.usage, buffer_create_info.write_method, buffer_create_info.size, data);
+
+  /* device local buffers can be moved by 'defragment', mapped ones would invalidate their pointer */
+  if (buffer_create_info.write_method == BUFFER_WRITE_METHOD_STAGING)
+    reinterpret_cast<Device_T*>(buffer_create_info.device)->defragmenter->add(created_buffer);
+
+  buffer = created_buffer;
   return 0;
 }
 
 int me::Vulkan::buffer_write(const BufferWriteInfo &buffer_write_info, Buffer buffer)
 {
-  VkPhysicalDevice vk_physical_device = reinterpret_cast<PhysicalDevice_T*>(buffer_write_info.physical_device)->vk_physical_device;
-  VkDevice vk_device = reinterpret_cast<Device_T*>(buffer_write_info.device)->vk_device;
+  memory::DeviceAllocator* memory_allocator = reinterpret_cast<Device_T*>(buffer_write_info.device)->memory_allocator;
   VkBuffer vk_buffer = reinterpret_cast<Buffer_T*>(buffer)->vk_buffer;
-  VkDeviceMemory vk_buffer_memory = reinterpret_cast<Buffer_T*>(buffer)->vk_memory;
+  const memory::Allocation &buffer_allocation = reinterpret_cast<Buffer_T*>(buffer)->allocation;
   BufferWriteMethod buffer_write_method = reinterpret_cast<Buffer_T*>(buffer)->write_method;
   size_t buffer_size = reinterpret_cast<Buffer_T*>(buffer)->size;
 
@@ -109,37 +126,187 @@ int me::Vulkan::buffer_write(const BufferWriteInfo &buffer_write_info, Buffer bu
 
   if (buffer_write_method == BUFFER_WRITE_METHOD_STANDARD)
   {
-    me::memory::map_buffer_memory(vk_device, vk_buffer_size, buffer_write_info.bytes, vk_buffer_memory);
+    me::memory::write_buffer_memory(*memory_allocator, vk_buffer_size, buffer_write_info.bytes, buffer_allocation);
   }else if (buffer_write_method == BUFFER_WRITE_METHOD_STAGING)
   {
-    VkQueue vk_queue = reinterpret_cast<Queue_T*>(buffer_write_info.transfer_queue)->vk_queue;
-    VkCommandPool vk_command_pool = reinterpret_cast<CommandPool_T*>(buffer_write_info.transfer_command_pool)->vk_command_pool;
+    /* recorded now, submitted on the next 'transfer_flush' or 'frame_render' */
+    memory::Uploader* uploader = reinterpret_cast<Device_T*>(buffer_write_info.device)->uploader;
+    uploader->upload(vk_buffer, 0, buffer_write_info.bytes, vk_buffer_size);
+  }
+  return 0;
+}
+
+int me::Vulkan::buffer_flush(Device device, Buffer buffer, size_t offset, size_t size)
+{
+  memory::DeviceAllocator* memory_allocator = reinterpret_cast<Device_T*>(device)->memory_allocator;
+  const memory::Allocation &buffer_allocation = reinterpret_cast<Buffer_T*>(buffer)->allocation;
+
+  memory_allocator->flush(buffer_allocation, offset, size);
+  return 0;
+}
+
+int me::Vulkan::transfer_flush(Device device, TransferTicket &ticket)
+{
+  memory::Uploader* uploader = reinterpret_cast<Device_T*>(device)->uploader;
+
+  uploader->flush(ticket);
+  return 0;
+}
+
+int me::Vulkan::transfer_wait(Device device, TransferTicket ticket)
+{
+  memory::Uploader* uploader = reinterpret_cast<Device_T*>(device)->uploader;
+
+  uploader->wait(ticket);
+  return 0;
+}
+
+int me::Vulkan::transfer_is_complete(Device device, TransferTicket ticket, bool &complete)
+{
+  memory::Uploader* uploader = reinterpret_cast<Device_T*>(device)->uploader;
+
+  complete = uploader->is_complete(ticket);
+  return 0;
+}
+
+int me::Vulkan::get_buffer_data(Buffer buffer, void* &data)
+{
+  data = reinterpret_cast<Buffer_T*>(buffer)->data;
+  if (data == nullptr)
+    throw exception("buffer is not host visible, use 'BUFFER_WRITE_METHOD_STANDARD'");
+  return 0;
+}
+
+int me::Vulkan::cleanup_buffer(Device device, Buffer buffer)
+{
+  VkDevice vk_device = reinterpret_cast<Device_T*>(device)->vk_device;
+  memory::DeviceAllocator* memory_allocator = reinterpret_cast<Device_T*>(device)->memory_allocator;
+  VkBuffer vk_buffer = reinterpret_cast<Buffer_T*>(buffer)->vk_buffer;
+  const memory::Allocation &buffer_allocation = reinterpret_cast<Buffer_T*>(buffer)->allocation;
+  memory::Defragmenter* defragmenter = reinterpret_cast<Device_T*>(device)->defragmenter;
+
+  if (reinterpret_cast<Buffer_T*>(buffer)->write_method == BUFFER_WRITE_METHOD_STAGING)
+    defragmenter->remove(reinterpret_cast<Buffer_T*>(buffer));
+
+  me::memory::destroy_buffer(*memory_allocator, vk_device, vk_buffer, buffer_allocation);
+  alloc.deallocate(reinterpret_cast<Buffer_T*>(buffer));
+  return 0;
+}
+
+int me::Vulkan::defragment(Device device, size_t byte_budget, uint32_t &moved_count)
+{
+  memory::Defragmenter* defragmenter = reinterpret_cast<Device_T*>(device)->defragmenter;
+  memory::ResidencyManager* residency = reinterpret_cast<Device_T*>(device)->residency;
+
+  /* the geometry pool holds most of the device memory, it is packed in one move and spends the whole budget */
+  if (residency->compact(byte_budget))
+    byte_budget = 0;
+
+  defragmenter->step(byte_budget, moved_count);
+  return 0;
+}
+
+int me::Vulkan::create_uniform_ring(const UniformRingCreateInfo &uniform_ring_create_info, UniformRing &uniform_ring)
+{
+  VERIFY_CREATE_INFO(uniform_ring_create_info, STRUCTURE_TYPE_UNIFORM_RING_CREATE_INFO);
+
+  VkDevice vk_device = reinterpret_cast<Device_T*>(uniform_ring_create_info.device)->vk_device;
+  memory::DeviceAllocator* memory_allocator = reinterpret_cast<Device_T*>(uniform_ring_create_info.device)->memory_allocator;
+  VkDeviceSize vk_alignment = reinterpret_cast<Device_T*>(uniform_ring_create_info.device)->vk_limits.minUniformBufferOffsetAlignment;
+
+  uint32_t frame_count = uniform_ring_create_info.frame_count > 0 ? uniform_ring_create_info.frame_count : 1;
+  VkDeviceSize frame_size = (uniform_ring_create_info.frame_size + vk_alignment - 1) / vk_alignment * vk_alignment;
+  VkDeviceSize vk_buffer_size = frame_size * frame_count;
+
+  /* written every frame, coherent memory avoids a flush per push */
+  VkBuffer vk_buffer;
+  memory::Allocation buffer_allocation;
+  me::memory::create_buffer(*memory_allocator, vk_device, vk_buffer_size,
+      VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_SHARING_MODE_EXCLUSIVE,
+      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, vk_buffer, buffer_allocation);
 
-    VkBuffer vk_staging_buffer;
-    VkDeviceMemory vk_staging_buffer_memory;
-    me::memory::create_buffer(vk_physical_device, vk_device, vk_buffer_size,
-        VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_SHARING_MODE_EXCLUSIVE, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-        vk_staging_buffer, vk_staging_buffer_memory);
+  void* data;
+  memory_allocator->map(buffer_allocation, data);
+
+  Buffer_T* buffer = alloc.allocate<Buffer_T>(vk_buffer, VkBufferUsageFlags(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT), buffer_allocation,
+      BUFFER_USAGE_UNIFORM_BUFFER, BUFFER_WRITE_METHOD_STANDARD, vk_buffer_size, data);
+
+  uniform_ring = alloc.allocate<UniformRing_T>(buffer, static_cast<char*>(data), vk_alignment, frame_size, frame_count, 0U, VkDeviceSize(0));
+  return 0;
+}
 
-    /* copy data to staging buffer */
-    me::memory::map_buffer_memory(vk_device, vk_buffer_size, buffer_write_info.bytes, vk_staging_buffer_memory);
+int me::Vulkan::uniform_ring_begin_frame(UniformRing uniform_ring, uint32_t frame_index)
+{
+  UniformRing_T* ring = reinterpret_cast<UniformRing_T*>(uniform_ring);
 
-    /* copy buffer */
-    me::memory::copy_buffer(vk_device, vk_command_pool, vk_queue, vk_buffer_size, vk_staging_buffer, vk_buffer);
+  ring->frame_index = frame_index % ring->frame_count;
+  ring->used = 0;
+  return 0;
+}
+
+int me::Vulkan::uniform_ring_push(UniformRing uniform_ring, const void* data, size_t size, uint32_t &offset)
+{
+  UniformRing_T* ring = reinterpret_cast<UniformRing_T*>(uniform_ring);
+
+  if (ring->used + size > ring->frame_size)
+    throw exception("uniform ring frame is full. \e[31m%lu\e[0m > %lu",
+	ring->used + size, ring->frame_size);
+
+  VkDeviceSize position = ring->frame_index * ring->frame_size + ring->used;
+  memcpy(ring->data + position, data, size);
+
+  offset = static_cast<uint32_t>(position);
+  ring->used = (ring->used + size + ring->alignment - 1) / ring->alignment * ring->alignment;
+  return 0;
+}
 
-    /* destroy and free */
-    vkDestroyBuffer(vk_device, vk_staging_buffer, vk_allocation);
-    vkFreeMemory(vk_device, vk_staging_buffer_memory, vk_allocation);
+int me::Vulkan::get_memory_budget(Device device, uint32_t &heap_count, MemoryHeapBudget* budgets)
+{
+  memory::DeviceAllocator* memory_allocator = reinterpret_cast<Device_T*>(device)->memory_allocator;
+
+  heap_count = memory_allocator->get_heap_count();
+  if (!budgets)
+    return 0;
+
+  memory::HeapBudget heap_budgets[VK_MAX_MEMORY_HEAPS];
+  memory_allocator->get_heap_budgets(heap_budgets);
+
+  for (uint32_t i = 0; i < heap_count; i++)
+  {
+    budgets[i].size = heap_budgets[i].size;
+    budgets[i].budget = heap_budgets[i].budget;
+    budgets[i].usage = heap_budgets[i].usage;
+    budgets[i].allocated = heap_budgets[i].allocated;
+    budgets[i].used = heap_budgets[i].used;
+    budgets[i].device_local = heap_budgets[i].device_local;
   }
   return 0;
 }
 
+int me::Vulkan::get_uniform_ring_buffer(UniformRing uniform_ring, Buffer &buffer)
+{
+  buffer = reinterpret_cast<UniformRing_T*>(uniform_ring)->buffer;
+  return 0;
+}
+
+int me::Vulkan::cleanup_uniform_ring(Device device, UniformRing uniform_ring)
+{
+  UniformRing_T* ring = reinterpret_cast<UniformRing_T*>(uniform_ring);
+
+  cleanup_buffer(device, ring->buffer);
+  alloc.deallocate(ring);
+  return 0;
+}
+
 int me::Vulkan::cleanup_descriptor_pool(Device device, DescriptorPool descriptor_pool)
 {
-  VkDevice vk_device = reinterpret_cast<Device_T*>(device)->vk_device;
-  VkDescriptorPool vk_descriptor_pool = reinterpret_cast<DescriptorPool_T*>(descriptor_pool)->vk_descriptor_pool;
+  descriptor::DescriptorAllocator* descriptor_allocator = reinterpret_cast<DescriptorPool_T*>(descriptor_pool)->allocator;
+  memory::Defragmenter* defragmenter = reinterpret_cast<Device_T*>(device)->defragmenter;
 
-  vkDestroyDescriptorPool(vk_device, vk_descriptor_pool, vk_allocation);
+  defragmenter->remove_descriptor_allocator(descriptor_allocator);
+  descriptor_allocator->cleanup();
+  alloc.deallocate(descriptor_allocator);
+  alloc.deallocate(descriptor_pool);
   return 0;
 }
 
@@ -153,15 +320,384 @@ int me::Vulkan::cleanup_command_pool(Device device, CommandPool command_pool)
 }
 
 
+me::memory::DeviceAllocator::DeviceAllocator(allocator alloc, VkPhysicalDevice physical_device, VkDevice device, VkAllocationCallbacks* allocation,
+    bool memory_budget_supported)
+  : alloc(alloc), vk_physical_device(physical_device), vk_device(device), vk_allocation(allocation),
+    memory_budget_supported(memory_budget_supported)
+{
+  vkGetPhysicalDeviceMemoryProperties(vk_physical_device, &vk_memory_properties);
+
+  VkPhysicalDeviceProperties physical_device_properties;
+  vkGetPhysicalDeviceProperties(vk_physical_device, &physical_device_properties);
+  non_coherent_atom_size = physical_device_properties.limits.nonCoherentAtomSize;
+
+  /* use smaller blocks on small heaps so a single block can't take most of the heap */
+  for (uint32_t i = 0; i < vk_memory_properties.memoryTypeCount; i++)
+  {
+    VkDeviceSize heap_size = vk_memory_properties.memoryHeaps[vk_memory_properties.memoryTypes[i].heapIndex].size;
+    VkDeviceSize block_size = DEFAULT_BLOCK_SIZE;
+    while (block_size > MIN_ALLOCATION_SIZE * 4096 && block_size > heap_size / 8)
+      block_size >>= 1;
+    block_sizes[i] = block_size;
+  }
+
+  for (uint32_t i = 0; i < VK_MAX_MEMORY_HEAPS; i++)
+  {
+    heap_allocated[i] = 0;
+    heap_used[i] = 0;
+  }
+}
+
+int me::memory::DeviceAllocator::allocate(
+    const VkMemoryRequirements 				&memory_requirements,
+    VkMemoryPropertyFlags 				memory_property_flags,
+    Allocation 						&allocation,
+    bool 						dedicated
+    )
+{
+  uint32_t memory_type = UINT32_MAX;
+  for (uint32_t i = 0; i < vk_memory_properties.memoryTypeCount; i++)
+  {
+    if (memory_requirements.memoryTypeBits & (1 << i) &&
+	(vk_memory_properties.memoryTypes[i].propertyFlags & memory_property_flags) == memory_property_flags)
+    {
+      memory_type = i;
+      break;
+    }
+  }
+
+  if (memory_type == UINT32_MAX)
+    throw exception("failed to find suitable memory type");
+
+  /* buddy nodes are aligned to their own size, so rounding up to the alignment is enough */
+  VkDeviceSize size = math::max(memory_requirements.size, memory_requirements.alignment);
+  uint32_t order = 0;
+  while ((MIN_ALLOCATION_SIZE << order) < size)
+    order++;
+
+  /* too large for a block, give it its own memory */
+  if (dedicated || (MIN_ALLOCATION_SIZE << order) > block_sizes[memory_type])
+  {
+    Block* block;
+    allocate_block(memory_type, memory_requirements.size, true, block);
+    block->used = memory_requirements.size;
+    blocks[memory_type].push_back(block);
+    heap_used[vk_memory_properties.memoryTypes[memory_type].heapIndex] += memory_requirements.size;
+
+    allocation = {block, 0, memory_requirements.size, 0};
+    return 0;
+  }
+
+  for (Block* block : blocks[memory_type])
+  {
+    if (!block->dedicated && allocate_from_block(block, order, allocation))
+      return 0;
+  }
+
+  Block* block;
+  allocate_block(memory_type, block_sizes[memory_type], false, block);
+  blocks[memory_type].push_back(block);
+
+  if (!allocate_from_block(block, order, allocation))
+    throw exception("failed to sub-allocate %lu bytes from a new memory block", size);
+  return 0;
+}
+
+int me::memory::DeviceAllocator::free(
+    const Allocation 					&allocation
+    )
+{
+  Block* block = allocation.block;
+  vector<Block*> &type_blocks = blocks[block->memory_type];
+  heap_used[vk_memory_properties.memoryTypes[block->memory_type].heapIndex] -= allocation.size;
+
+  if (!block->dedicated)
+  {
+    /* merge with the buddy as long as it's free */
+    uint32_t node = (uint32_t) (allocation.offset / MIN_ALLOCATION_SIZE);
+    uint32_t order = allocation.order;
+    while (order < block->max_order)
+    {
+      uint32_t buddy = node ^ (1 << order);
+      vector<uint32_t> &free_list = block->free_lists[order];
+
+      size_t index = SIZE_MAX;
+      for (size_t i = 0; i < free_list.size(); i++)
+      {
+	if (free_list[i] == buddy)
+	{
+	  index = i;
+	  break;
+	}
+      }
+
+      if (index == SIZE_MAX)
+	break;
+
+      free_list[index] = free_list[free_list.size() - 1];
+      free_list.resize(free_list.size() - 1);
+      node = math::min(node, buddy);
+      order++;
+    }
+    block->free_lists[order].push_back(node);
+    block->used -= allocation.size;
+
+    /* keep one empty block per memory type around to avoid allocation churn */
+    if (block->used > 0)
+      return 0;
+
+    uint32_t shared_block_count = 0;
+    for (Block* type_block : type_blocks)
+    {
+      if (!type_block->dedicated)
+	shared_block_count++;
+    }
+
+    if (shared_block_count <= 1)
+      return 0;
+  }
+
+  for (size_t i = 0; i < type_blocks.size(); i++)
+  {
+    if (type_blocks[i] == block)
+    {
+      type_blocks[i] = type_blocks[type_blocks.size() - 1];
+      type_blocks.resize(type_blocks.size() - 1);
+      break;
+    }
+  }
+  free_block(block);
+  return 0;
+}
+
+int me::memory::DeviceAllocator::cleanup()
+{
+  for (uint32_t i = 0; i < vk_memory_properties.memoryTypeCount; i++)
+  {
+    for (Block* block : blocks[i])
+      free_block(block);
+    blocks[i].resize(0);
+  }
+  return 0;
+}
+
+uint32_t me::memory::DeviceAllocator::get_shared_block_count(
+    uint32_t 						memory_type
+    ) const
+{
+  uint32_t shared_block_count = 0;
+  for (Block* block : blocks[memory_type])
+  {
+    if (!block->dedicated)
+      shared_block_count++;
+  }
+  return shared_block_count;
+}
+
+bool me::memory::DeviceAllocator::reallocate(
+    const Allocation 					&allocation,
+    uint32_t 						memory_type_bits,
+    Allocation 						&new_allocation
+    )
+{
+  uint32_t memory_type = allocation.block->memory_type;
+  if (allocation.block->dedicated || !(memory_type_bits & (1 << memory_type)))
+    return false;
+
+  /* fill the fullest blocks first so the sparse ones empty out */
+  vector<Block*> candidates;
+  for (Block* block : blocks[memory_type])
+  {
+    if (block != allocation.block && !block->dedicated && block->size - block->used >= allocation.size)
+      candidates.push_back(block);
+  }
+
+  while (candidates.size() > 0)
+  {
+    size_t fullest = 0;
+    for (size_t i = 1; i < candidates.size(); i++)
+    {
+      if (candidates[i]->used > candidates[fullest]->used)
+	fullest = i;
+    }
+
+    if (allocate_from_block(candidates[fullest], allocation.order, new_allocation))
+      return true;
+
+    candidates[fullest] = candidates[candidates.size() - 1];
+    candidates.resize(candidates.size() - 1);
+  }
+  return false;
+}
+
+int me::memory::DeviceAllocator::map(
+    const Allocation 					&allocation,
+    void* 						&data
+    )
+{
+  Block* block = allocation.block;
+  if (block->mapped == nullptr)
+  {
+    void* block_data;
+    VkResult result = vkMapMemory(vk_device, block->vk_memory, 0, VK_WHOLE_SIZE, 0, &block_data);
+    if (result != VK_SUCCESS)
+      throw exception("failed to map memory [%s]", util::get_result_string(result));
+    block->mapped = static_cast<char*>(block_data);
+  }
+
+  data = block->mapped + allocation.offset;
+  return 0;
+}
+
+int me::memory::DeviceAllocator::flush(
+    const Allocation 					&allocation,
+    VkDeviceSize 					offset,
+    VkDeviceSize 					size
+    )
+{
+  if (is_coherent(allocation))
+    return 0;
+
+  /* the range has to be aligned to 'nonCoherentAtomSize' */
+  VkDeviceSize begin = allocation.offset + offset;
+  VkDeviceSize end = begin + size;
+  begin = begin / non_coherent_atom_size * non_coherent_atom_size;
+  end = (end + non_coherent_atom_size - 1) / non_coherent_atom_size * non_coherent_atom_size;
+
+  VkMappedMemoryRange memory_range = { };
+  memory_range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+  memory_range.pNext = nullptr;
+  memory_range.memory = allocation.block->vk_memory;
+  memory_range.offset = begin;
+  memory_range.size = end >= allocation.block->size ? VK_WHOLE_SIZE : end - begin;
+
+  VkResult result = vkFlushMappedMemoryRanges(vk_device, 1, &memory_range);
+  if (result != VK_SUCCESS)
+    throw exception("failed to flush mapped memory [%s]", util::get_result_string(result));
+  return 0;
+}
+
+int me::memory::DeviceAllocator::get_heap_budgets(
+    HeapBudget* 					budgets
+    )
+{
+  VkPhysicalDeviceMemoryBudgetPropertiesEXT memory_budget_properties = { };
+  memory_budget_properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+  memory_budget_properties.pNext = nullptr;
+
+  if (memory_budget_supported)
+  {
+    VkPhysicalDeviceMemoryProperties2 memory_properties = { };
+    memory_properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+    memory_properties.pNext = &memory_budget_properties;
+    vkGetPhysicalDeviceMemoryProperties2(vk_physical_device, &memory_properties);
+  }
+
+  for (uint32_t i = 0; i < vk_memory_properties.memoryHeapCount; i++)
+  {
+    const VkMemoryHeap &heap = vk_memory_properties.memoryHeaps[i];
+    HeapBudget &budget = budgets[i];
+    budget.size = heap.size;
+    budget.allocated = heap_allocated[i];
+    budget.used = heap_used[i];
+    budget.device_local = heap.flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT;
+
+    if (memory_budget_supported)
+    {
+      budget.budget = memory_budget_properties.heapBudget[i];
+      budget.usage = memory_budget_properties.heapUsage[i];
+    }else
+    {
+      /* leave room for other processes and the driver */
+      budget.budget = heap.size / 10 * 8;
+      budget.usage = heap_allocated[i];
+    }
+  }
+  return 0;
+}
+
+int me::memory::DeviceAllocator::allocate_block(uint32_t memory_type, VkDeviceSize size, bool dedicated, Block* &block)
+{
+  VkMemoryAllocateInfo memory_allocate_info = { };
+  memory_allocate_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+  memory_allocate_info.pNext = nullptr;
+  memory_allocate_info.allocationSize = size;
+  memory_allocate_info.memoryTypeIndex = memory_type;
+
+  VkDeviceMemory vk_memory;
+  VkResult result = vkAllocateMemory(vk_device, &memory_allocate_info, vk_allocation, &vk_memory);
+  if (result != VK_SUCCESS)
+    throw exception("failed to allocate memory block(%lu) [%s]", size, util::get_result_string(result));
+
+  heap_allocated[vk_memory_properties.memoryTypes[memory_type].heapIndex] += size;
+
+  block = alloc.allocate<Block>();
+  block->vk_memory = vk_memory;
+  block->size = size;
+  block->memory_type = memory_type;
+  block->dedicated = dedicated;
+  block->used = 0;
+  block->mapped = nullptr;
+  block->max_order = 0;
+
+  if (!dedicated)
+  {
+    while ((MIN_ALLOCATION_SIZE << block->max_order) < size)
+      block->max_order++;
+    block->free_lists[block->max_order].push_back(0);
+  }
+  return 0;
+}
+
+int me::memory::DeviceAllocator::free_block(Block* block)
+{
+  heap_allocated[vk_memory_properties.memoryTypes[block->memory_type].heapIndex] -= block->size;
+  if (block->mapped != nullptr)
+    vkUnmapMemory(vk_device, block->vk_memory);
+  vkFreeMemory(vk_device, block->vk_memory, vk_allocation);
+  alloc.deallocate(block);
+  return 0;
+}
+
+bool me::memory::DeviceAllocator::allocate_from_block(Block* block, uint32_t order, Allocation &allocation)
+{
+  /* find the smallest free node that fits */
+  uint32_t node_order = order;
+  while (node_order <= block->max_order && block->free_lists[node_order].size() == 0)
+    node_order++;
+
+  if (node_order > block->max_order)
+    return false;
+
+  vector<uint32_t> &free_list = block->free_lists[node_order];
+  uint32_t node = free_list[free_list.size() - 1];
+  free_list.resize(free_list.size() - 1);
+
+  /* split it down to the requested order, the upper halves become free buddies */
+  while (node_order > order)
+  {
+    node_order--;
+    block->free_lists[node_order].push_back(node + (1 << node_order));
+  }
+
+  VkDeviceSize size = MIN_ALLOCATION_SIZE << order;
+  block->used += size;
+  heap_used[vk_memory_properties.memoryTypes[block->memory_type].heapIndex] += size;
+  allocation = {block, node * MIN_ALLOCATION_SIZE, size, order};
+  return true;
+}
+
+
 int me::memory::create_buffer(
-    VkPhysicalDevice 					physical_device,
+    DeviceAllocator 					&device_allocator,
     VkDevice 						device,
     VkDeviceSize 					buffer_size,
     VkBufferUsageFlags 					buffer_usage_flags,
     VkSharingMode 					sharing_mode,
     VkMemoryPropertyFlags 				memory_property_flags,
     VkBuffer 						&buffer,
-    VkDeviceMemory 					&buffer_memory
+    Allocation 						&buffer_allocation,
+    bool 						dedicated
     )
 {
   VkBufferCreateInfo buffer_create_info = { };
@@ -174,28 +710,30 @@ int me::memory::create_buffer(
   buffer_create_info.queueFamilyIndexCount = 0;
   buffer_create_info.pQueueFamilyIndices = nullptr;
 
-  VkResult result = vkCreateBuffer(device, &buffer_create_info, nullptr, &buffer);
+  VkResult result = vkCreateBuffer(device, &buffer_create_info, device_allocator.get_allocation_callbacks(), &buffer);
   if (result != VK_SUCCESS)
     throw exception("failed to create vertex buffer [%s]", util::get_result_string(result));
 
   VkMemoryRequirements memory_requirements;
   vkGetBufferMemoryRequirements(device, buffer, &memory_requirements);
 
-  uint32_t memory_type;
-  get_memory_type(physical_device, memory_requirements.memoryTypeBits, memory_property_flags, memory_type);
-
-  VkMemoryAllocateInfo buffer_memory_allocate_info = { };
-  buffer_memory_allocate_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-  buffer_memory_allocate_info.pNext = nullptr;
-  buffer_memory_allocate_info.allocationSize = memory_requirements.size;
-  buffer_memory_allocate_info.memoryTypeIndex = memory_type;
+  device_allocator.allocate(memory_requirements, memory_property_flags, buffer_allocation, dedicated);
 
-  result = vkAllocateMemory(device, &buffer_memory_allocate_info, nullptr, &buffer_memory);
+  result = vkBindBufferMemory(device, buffer, buffer_allocation.block->vk_memory, buffer_allocation.offset);
   if (result != VK_SUCCESS)
-    throw exception("failed to allocate memory with mesh vertices(%lu) [%s]", buffer_size, result);
+    throw exception("failed to bind buffer memory [%s]", util::get_result_string(result));
+  return 0;
+}
 
-  /* param[3]: offset */
-  vkBindBufferMemory(device, buffer, buffer_memory, 0);
+int me::memory::destroy_buffer(
+    DeviceAllocator 					&device_allocator,
+    VkDevice 						device,
+    VkBuffer 						buffer,
+    const Allocation 					&buffer_allocation
+    )
+{
+  vkDestroyBuffer(device, buffer, device_allocator.get_allocation_callbacks());
+  device_allocator.free(buffer_allocation);
   return 0;
 }
 
@@ -205,7 +743,9 @@ int me::memory::copy_buffer(
     VkQueue 						queue,
     VkDeviceSize 					buffer_size,
     VkBuffer 						source_buffer,
-    VkBuffer 						destination_buffer
+    VkDeviceSize 					source_offset,
+    VkBuffer 						destination_buffer,
+    VkFence 						fence
     )
 {
   VkCommandBufferAllocateInfo command_buffer_allocate_info = { };
@@ -228,7 +768,7 @@ int me::memory::copy_buffer(
   vkBeginCommandBuffer(command_buffer, &command_buffer_begin_info);
 
   VkBufferCopy buffer_copy_region = { };
-  buffer_copy_region.srcOffset = 0;
+  buffer_copy_region.srcOffset = source_offset;
   buffer_copy_region.dstOffset = 0;
   buffer_copy_region.size = buffer_size;
 
@@ -249,28 +789,28 @@ int me::memory::copy_buffer(
   submit_infos[0].signalSemaphoreCount = 0;
   submit_infos[0].pSignalSemaphores = nullptr;
 
-  vkQueueSubmit(queue, submit_info_count, submit_infos, VK_NULL_HANDLE);
-  vkQueueWaitIdle(queue);
+  vkQueueSubmit(queue, submit_info_count, submit_infos, fence);
+  if (fence != VK_NULL_HANDLE)
+    vkWaitForFences(device, 1, &fence, VK_TRUE, UINT64_MAX);
+  else
+    vkQueueWaitIdle(queue);
 
   vkFreeCommandBuffers(device, command_pool, 1, &command_buffer);
   return 0;
 }
 
-int me::memory::map_buffer_memory(
-    VkDevice 						device,
+int me::memory::write_buffer_memory(
+    DeviceAllocator 					&device_allocator,
     VkDeviceSize 					buffer_size,
     void* 						buffer_data,
-    VkDeviceMemory 					device_memory
+    const Allocation 					&buffer_allocation
     )
 {
   void* data;
-  VkResult result = vkMapMemory(device, device_memory, 0, buffer_size, 0, &data);
-  if (result != VK_SUCCESS)
-    throw exception("failed to map memory [%s]", util::get_result_string(result));
+  device_allocator.map(buffer_allocation, data);
 
-  /* TODO: use flush instead */
   memcpy(data, buffer_data, (size_t) buffer_size);
-  vkUnmapMemory(device, device_memory);
+  device_allocator.flush(buffer_allocation, 0, buffer_size);
   return 0;
 }
 
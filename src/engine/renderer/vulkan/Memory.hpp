@@ -1,19 +1,172 @@
 #ifndef ME_VULKAN_MEMORY_HPP
   #define ME_VULKAN_MEMORY_HPP
 
+#include <lme/vector.hpp>
+#include <lme/memory.hpp>
+
 #include <vulkan/vulkan.h>
 
 namespace me::memory {
 
+  /* one 'vkAllocateMemory' allocation that is split into sub-ranges with a buddy allocator */
+  struct Block {
+    VkDeviceMemory vk_memory;
+    VkDeviceSize size;
+    uint32_t memory_type;
+    uint32_t max_order;
+    bool dedicated;
+    VkDeviceSize used;
+    char* mapped; /* whole block, mapped on first use and kept until the block is freed */
+    vector<uint32_t> free_lists[32]; /* free node offsets (in 'MIN_ALLOCATION_SIZE' units) per order */
+  };
+
+  struct Allocation {
+    Block* block;
+    VkDeviceSize offset;
+    VkDeviceSize size;
+    uint32_t order;
+  };
+
+  struct HeapBudget {
+    VkDeviceSize size;
+    VkDeviceSize budget; /* how much the process can use before it should expect problems */
+    VkDeviceSize usage; /* usage of the whole process, 'allocated' without 'VK_EXT_memory_budget' */
+    VkDeviceSize allocated; /* bytes in blocks of this allocator */
+    VkDeviceSize used; /* bytes in allocations handed out by this allocator */
+    bool device_local;
+  };
+
+  class DeviceAllocator {
+
+  public:
+
+    static constexpr VkDeviceSize MIN_ALLOCATION_SIZE = 256;
+    static constexpr VkDeviceSize DEFAULT_BLOCK_SIZE = 64 * 1024 * 1024;
+
+  protected:
+
+    allocator alloc;
+
+    VkPhysicalDevice vk_physical_device;
+    VkDevice vk_device;
+    VkAllocationCallbacks* vk_allocation;
+    VkPhysicalDeviceMemoryProperties vk_memory_properties;
+    VkDeviceSize non_coherent_atom_size;
+    bool memory_budget_supported;
+
+    VkDeviceSize block_sizes[VK_MAX_MEMORY_TYPES];
+    vector<Block*> blocks[VK_MAX_MEMORY_TYPES];
+
+    VkDeviceSize heap_allocated[VK_MAX_MEMORY_HEAPS];
+    VkDeviceSize heap_used[VK_MAX_MEMORY_HEAPS];
+
+  public:
+
+    DeviceAllocator(allocator alloc, VkPhysicalDevice physical_device, VkDevice device, VkAllocationCallbacks* allocation,
+	bool memory_budget_supported);
+
+    int allocate(
+	const VkMemoryRequirements 			&memory_requirements,
+	VkMemoryPropertyFlags 				memory_property_flags,
+	Allocation 					&allocation,
+	bool 						dedicated = false
+	);
+
+    int free(
+	const Allocation 				&allocation
+	);
+
+    int cleanup();
+
+    /* blocks of the memory type that allocations share, without dedicated ones */
+    uint32_t get_shared_block_count(
+	uint32_t 					memory_type
+	) const;
+
+    /* places an allocation of the same size in the fullest other shared block that has room,
+     * never allocates a new block. returns false if no other block fits it */
+    bool reallocate(
+	const Allocation 				&allocation,
+	uint32_t 					memory_type_bits,
+	Allocation 					&new_allocation
+	);
+
+    /* persistent pointer to the allocation, only valid for host visible memory */
+    int map(
+	const Allocation 				&allocation,
+	void* 						&data
+	);
+
+    /* makes host writes visible to the device, does nothing for host coherent memory */
+    int flush(
+	const Allocation 				&allocation,
+	VkDeviceSize 					offset,
+	VkDeviceSize 					size
+	);
+
+    bool is_coherent(const Allocation &allocation) const
+    {
+      return vk_memory_properties.memoryTypes[allocation.block->memory_type].propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    }
+
+    /* buffers of the allocator's memory are created and destroyed with the same callbacks */
+    VkAllocationCallbacks* get_allocation_callbacks() const
+    {
+      return vk_allocation;
+    }
+
+    const VkPhysicalDeviceMemoryProperties& get_memory_properties() const
+    {
+      return vk_memory_properties;
+    }
+
+    bool has_memory_type(uint32_t memory_type_bits, VkMemoryPropertyFlags memory_property_flags) const
+    {
+      for (uint32_t i = 0; i < vk_memory_properties.memoryTypeCount; i++)
+      {
+	if (memory_type_bits & (1 << i) && (vk_memory_properties.memoryTypes[i].propertyFlags & memory_property_flags) == memory_property_flags)
+	  return true;
+      }
+      return false;
+    }
+
+    uint32_t get_heap_count() const
+    {
+      return vk_memory_properties.memoryHeapCount;
+    }
+
+    /* queries 'VK_EXT_memory_budget' if the device supports it,
+     * otherwise the budget is a fixed part of the heap size and the usage is what this allocator has allocated */
+    int get_heap_budgets(
+	HeapBudget* 					budgets
+	);
+
+  protected:
+
+    int allocate_block(uint32_t memory_type, VkDeviceSize size, bool dedicated, Block* &block);
+    int free_block(Block* block);
+
+    bool allocate_from_block(Block* block, uint32_t order, Allocation &allocation);
+
+  };
+
   int create_buffer(
-      VkPhysicalDevice 					physical_device,
+      DeviceAllocator 					&device_allocator,
       VkDevice 						device,
       VkDeviceSize 					buffer_size,
       VkBufferUsageFlags 				buffer_usage_flags,
       VkSharingMode 					sharing_mode,
       VkMemoryPropertyFlags 				memory_property_flags,
       VkBuffer 						&buffer,
-      VkDeviceMemory 					&buffer_memory
+      Allocation 					&buffer_allocation,
+      bool 						dedicated = false /* own 'VkDeviceMemory' instead of a range in a shared block */
+      );
+
+  int destroy_buffer(
+      DeviceAllocator 					&device_allocator,
+      VkDevice 						device,
+      VkBuffer 						buffer,
+      const Allocation 					&buffer_allocation
       );
 
   int copy_buffer(
@@ -22,14 +175,17 @@ namespace me::memory {
       VkQueue 						queue,
       VkDeviceSize 					buffer_size,
       VkBuffer 						source_buffer,
-      VkBuffer 						destination_buffer
+      VkDeviceSize 					source_offset,
+      VkBuffer 						destination_buffer,
+      VkFence 						fence /* optional, waits for the fence instead of the whole queue */
       );
 
-  int map_buffer_memory(
-      VkDevice 						device,
+  /* copies into the persistently mapped allocation and flushes it */
+  int write_buffer_memory(
+      DeviceAllocator 					&device_allocator,
       VkDeviceSize 					buffer_size,
       void* 						buffer_data,
-      VkDeviceMemory 					device_memory
+      const Allocation 					&buffer_allocation
       );
 
   int get_memory_type(
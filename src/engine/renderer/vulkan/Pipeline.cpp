@@ -26,15 +26,16 @@ static int create_pipeline_layout(
     VkDevice 								device,
     VkAllocationCallbacks*						allocation,
     const me::array_proxy<VkDescriptorSetLayout>			&descriptor_set_layouts,
+    uint32_t 								push_constant_size,
     VkPipelineLayout 							&pipeline_layout
     );
 
-static int create_viewports(
-    const me::array_proxy<me::Viewport>					&viewport_infos,
-    const me::array_proxy<me::Scissor>					&scissor_infos,
-    VkViewport*								viewports,
-    VkRect2D*								scissors,
-    VkPipelineViewportStateCreateInfo 					&pipeline_viewport_state_create_info
+static int create_viewport_state(
+    uint32_t 								viewport_count,
+    uint32_t 								scissor_count,
+    const me::array_proxy<VkDynamicState> 				&dynamic_states,
+    VkPipelineViewportStateCreateInfo 					&pipeline_viewport_state_create_info,
+    VkPipelineDynamicStateCreateInfo 					&pipeline_dynamic_state_create_info
     );
 
 static int create_rasterizer(
@@ -48,10 +49,15 @@ static int create_multisampling(
     );
 
 static int create_color_blend(
+    uint32_t 								attachment_count,
     VkPipelineColorBlendAttachmentState* 				pipeline_color_blend_attachment_states,
     VkPipelineColorBlendStateCreateInfo 				&vk_pipeline_color_blend_state_create_info
     );
 
+static int create_depth_stencil(
+    VkPipelineDepthStencilStateCreateInfo 				&pipeline_depth_stencil_state_create_info
+    );
+
 static int create_shader_module(
     VkDevice 								device,
     VkAllocationCallbacks*						allocation,
@@ -60,6 +66,46 @@ static int create_shader_module(
     VkPipelineShaderStageCreateInfo 					&pipeline_shader_stage_create_info
     );
 
+static int build_pipeline_key(
+    const me::PipelineCreateInfo 					&pipeline_create_info,
+    uint64_t 								render_pass_compatibility,
+    me::vector<char> 							&key
+    );
+
+static int acquire_descriptor_set_layout(
+    VkDevice 								device,
+    VkAllocationCallbacks* 						allocation,
+    me::pipeline::StateCache 						&state_cache,
+    me::DescriptorType 							descriptor_type,
+    VkDescriptorSetLayout 						&descriptor_set_layout
+    );
+
+static int acquire_pipeline_layout(
+    VkDevice 								device,
+    VkAllocationCallbacks* 						allocation,
+    me::pipeline::StateCache 						&state_cache,
+    const me::array_proxy<VkDescriptorSetLayout> 			&descriptor_set_layouts,
+    uint32_t 								push_constant_size,
+    VkPipelineLayout 							&pipeline_layout
+    );
+
+/* drops references to shared layouts, a 'VK_NULL_HANDLE' pipeline layout is skipped */
+static int release_layouts(
+    VkDevice 								device,
+    VkAllocationCallbacks* 						allocation,
+    me::pipeline::StateCache 						&state_cache,
+    VkPipelineLayout 							pipeline_layout,
+    const me::vector<VkDescriptorSetLayout> 				&descriptor_set_layouts
+    );
+
+/* drops the pipeline's references to its layouts and destroys the 'VkPipeline', not the 'Pipeline_T' */
+static int release_pipeline(
+    VkDevice 								device,
+    VkAllocationCallbacks* 						allocation,
+    me::pipeline::StateCache 						&state_cache,
+    const me::Pipeline_T* 						pipeline
+    );
+
 
 int me::Vulkan::create_pipeline(const PipelineCreateInfo &pipeline_create_info, Pipeline &pipeline)
 {
@@ -67,6 +113,17 @@ int me::Vulkan::create_pipeline(const PipelineCreateInfo &pipeline_create_info,
 
   VkDevice vk_device = reinterpret_cast<Device_T*>(pipeline_create_info.device)->vk_device;
   VkRenderPass vk_render_pass = reinterpret_cast<RenderPass_T*>(pipeline_create_info.render_pass)->vk_render_pass;
+  uint32_t color_attachment_count = reinterpret_cast<RenderPass_T*>(pipeline_create_info.render_pass)->color_attachment_count;
+  bool depth_attachment = reinterpret_cast<RenderPass_T*>(pipeline_create_info.render_pass)->depth_attachment != UINT32_MAX;
+  uint64_t render_pass_compatibility = reinterpret_cast<RenderPass_T*>(pipeline_create_info.render_pass)->compatibility_hash;
+  pipeline::StateCache* state_cache = reinterpret_cast<Device_T*>(pipeline_create_info.device)->state_cache;
+
+  /* identical requests share one pipeline */
+  vector<char> pipeline_key;
+  build_pipeline_key(pipeline_create_info, render_pass_compatibility, pipeline_key);
+  pipeline = state_cache->acquire(pipeline::STATE_KIND_PIPELINE, pipeline_key);
+  if (pipeline != nullptr)
+    return 0;
 
   ShaderCreateInfo &shader_create_info = *pipeline_create_info.shader_create_info;
   RasterizerCreateInfo &rasterizer_create_info = *pipeline_create_info.rasterizer_create_info;
@@ -85,85 +142,206 @@ int me::Vulkan::create_pipeline(const PipelineCreateInfo &pipeline_create_info,
   VkPipelineInputAssemblyStateCreateInfo pipeline_input_assembly_state_create_info;
   create_input_assembly(shader_create_info.topology, pipeline_input_assembly_state_create_info);
 
-  /* uniform buffer object */
-  uint32_t descriptor_set_layout_binding_count = 1;
-  VkDescriptorSetLayoutBinding descriptor_set_layout_bindings[descriptor_set_layout_binding_count];
-  descriptor_set_layout_bindings[0].binding = 0;
-  descriptor_set_layout_bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-  descriptor_set_layout_bindings[0].descriptorCount = 1;
-  descriptor_set_layout_bindings[0].stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
-  descriptor_set_layout_bindings[0].pImmutableSamplers = nullptr;
-
-  /* creating descriptor set layouts */
-  VkDescriptorSetLayout vk_descriptor_set_layout;
-  create_descriptor_set_layout(vk_device, vk_allocation,
-      {descriptor_set_layout_binding_count, descriptor_set_layout_bindings}, vk_descriptor_set_layout);
-
-  /* creating pipeline layout */
-  VkPipelineLayout vk_layout;
-  create_pipeline_layout(vk_device, vk_allocation,
-      {1, &vk_descriptor_set_layout}, vk_layout);
-
-  /* creating viewports and scissors */
-  VkViewport viewports[pipeline_create_info.viewport_count];
-  VkRect2D scissors[pipeline_create_info.scissor_count];
-  VkPipelineViewportStateCreateInfo pipeline_viewport_state_create_info;
-  create_viewports(
-      {pipeline_create_info.viewport_count, pipeline_create_info.viewports},
-      {pipeline_create_info.scissor_count, pipeline_create_info.scissors},
-      viewports, scissors, pipeline_viewport_state_create_info);
-
-  /* creating rasterizer */
-  VkPipelineRasterizationStateCreateInfo pipeline_rasterization_state_create_info;
-  create_rasterizer(rasterizer_create_info, pipeline_rasterization_state_create_info);
-
-  /* creating multisampling */
-  VkPipelineMultisampleStateCreateInfo pipeline_multisample_state_create_info;
-  create_multisampling(multisampling_create_info, pipeline_multisample_state_create_info);
-
-  /* creating color blend */
-  VkPipelineColorBlendAttachmentState pipeline_color_blend_attachment_states[1];
-  VkPipelineColorBlendStateCreateInfo pipeline_color_blend_state_create_info;
-  create_color_blend(pipeline_color_blend_attachment_states, pipeline_color_blend_state_create_info);
-
-
-  /* creating shader modules */
+  /* one binding per descriptor set, a single uniform buffer object by default */
+  DescriptorType default_descriptor_set = DESCRIPTOR_TYPE_UNIFORM;
+  uint32_t descriptor_set_count = pipeline_create_info.descriptor_set_count;
+  DescriptorType* descriptor_sets = pipeline_create_info.descriptor_sets;
+  if (descriptor_set_count == 0)
+  {
+    descriptor_set_count = 1;
+    descriptor_sets = &default_descriptor_set;
+  }
+
+  /* what is acquired below is released again if a later step throws, a failed build on the compiler's thread must not leak it */
+  vector<VkDescriptorSetLayout> vk_descriptor_set_layouts;
+  VkPipelineLayout vk_layout = VK_NULL_HANDLE;
   VkShaderModule shader_modules[shader_create_info.shader_count];
-  VkPipelineShaderStageCreateInfo pipeline_shader_stage_create_infos[shader_create_info.shader_count];
+  uint32_t shader_module_count = 0;
+  VkPipeline vk_pipeline = VK_NULL_HANDLE;
+  Pipeline_T* created_pipeline = nullptr;
+  try
+  {
+    /* getting descriptor set layouts, shared with every pipeline that has a set of the same type */
+    for (uint32_t i = 0; i < descriptor_set_count; i++)
+    {
+      VkDescriptorSetLayout vk_descriptor_set_layout;
+      acquire_descriptor_set_layout(vk_device, vk_allocation, *state_cache, descriptor_sets[i], vk_descriptor_set_layout);
+      vk_descriptor_set_layouts.push_back(vk_descriptor_set_layout);
+    }
+
+    /* the bindless table is set 0 and isn't owned by the pipeline */
+    uint32_t first_set = 0;
+    vector<VkDescriptorSetLayout> vk_layout_set_layouts;
+    if (pipeline_create_info.bindless)
+    {
+      descriptor::BindlessTable* bindless_table = reinterpret_cast<Device_T*>(pipeline_create_info.device)->bindless_table;
+      if (bindless_table == nullptr)
+	throw exception("in 'create_pipeline()' bindless pipelines need descriptor indexing, which the device doesn't support");
+
+      vk_layout_set_layouts.push_back(bindless_table->get_descriptor_set_layout());
+      first_set = 1;
+    }
+    for (VkDescriptorSetLayout vk_descriptor_set_layout : vk_descriptor_set_layouts)
+      vk_layout_set_layouts.push_back(vk_descriptor_set_layout);
+
+    /* getting pipeline layout */
+    acquire_pipeline_layout(vk_device, vk_allocation, *state_cache,
+	{(uint32_t) vk_layout_set_layouts.size(), vk_layout_set_layouts.data()}, pipeline_create_info.push_constant_size, vk_layout);
+
+    /* creating viewports and scissors, they are dynamic so the pipeline survives a resized swapchain */
+    static constexpr uint32_t dynamic_state_count = 2;
+    VkDynamicState dynamic_states[dynamic_state_count] = {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
+    VkPipelineViewportStateCreateInfo pipeline_viewport_state_create_info;
+    VkPipelineDynamicStateCreateInfo pipeline_dynamic_state_create_info;
+    create_viewport_state(pipeline_create_info.viewport_count, pipeline_create_info.scissor_count,
+	{dynamic_state_count, dynamic_states}, pipeline_viewport_state_create_info, pipeline_dynamic_state_create_info);
+
+    /* creating rasterizer */
+    VkPipelineRasterizationStateCreateInfo pipeline_rasterization_state_create_info;
+    create_rasterizer(rasterizer_create_info, pipeline_rasterization_state_create_info);
+
+    /* creating multisampling */
+    VkPipelineMultisampleStateCreateInfo pipeline_multisample_state_create_info;
+    create_multisampling(multisampling_create_info, pipeline_multisample_state_create_info);
+
+    /* creating color blend */
+    VkPipelineColorBlendAttachmentState pipeline_color_blend_attachment_states[color_attachment_count];
+    VkPipelineColorBlendStateCreateInfo pipeline_color_blend_state_create_info;
+    create_color_blend(color_attachment_count, pipeline_color_blend_attachment_states, pipeline_color_blend_state_create_info);
+
+    /* creating depth stencil, only if the render pass has a depth attachment */
+    VkPipelineDepthStencilStateCreateInfo pipeline_depth_stencil_state_create_info;
+    if (depth_attachment)
+      create_depth_stencil(pipeline_depth_stencil_state_create_info);
+
+
+    /* creating shader modules */
+    VkPipelineShaderStageCreateInfo pipeline_shader_stage_create_infos[shader_create_info.shader_count];
+    for (; shader_module_count < shader_create_info.shader_count; shader_module_count++)
+      create_shader_module(vk_device, vk_allocation, shader_create_info.shaders[shader_module_count], shader_modules[shader_module_count],
+	pipeline_shader_stage_create_infos[shader_module_count]);
+
+
+    /* === Creating graphics pipeline === */
+    VkGraphicsPipelineCreateInfo graphics_pipeline_create_info = { };
+    graphics_pipeline_create_info.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+    graphics_pipeline_create_info.pNext = nullptr;
+    graphics_pipeline_create_info.flags = 0;
+    graphics_pipeline_create_info.stageCount = shader_create_info.shader_count;
+    graphics_pipeline_create_info.pStages = pipeline_shader_stage_create_infos;
+    graphics_pipeline_create_info.pVertexInputState = &pipeline_vertex_input_state_create_info;
+    graphics_pipeline_create_info.pInputAssemblyState = &pipeline_input_assembly_state_create_info;
+    graphics_pipeline_create_info.pViewportState = &pipeline_viewport_state_create_info;
+    graphics_pipeline_create_info.pRasterizationState = &pipeline_rasterization_state_create_info;
+    graphics_pipeline_create_info.pMultisampleState = &pipeline_multisample_state_create_info;
+    graphics_pipeline_create_info.pDepthStencilState = depth_attachment ? &pipeline_depth_stencil_state_create_info : nullptr;
+    graphics_pipeline_create_info.pColorBlendState = &pipeline_color_blend_state_create_info;
+    graphics_pipeline_create_info.pDynamicState = &pipeline_dynamic_state_create_info;
+    graphics_pipeline_create_info.layout = vk_layout;
+    graphics_pipeline_create_info.renderPass = vk_render_pass;
+    graphics_pipeline_create_info.subpass = 0;
+    graphics_pipeline_create_info.basePipelineHandle = VK_NULL_HANDLE;
+    graphics_pipeline_create_info.basePipelineIndex = -1;
+
+    pipeline::PipelineCache* pipeline_cache = reinterpret_cast<Device_T*>(pipeline_create_info.device)->pipeline_cache;
+    uint64_t start_time = pipeline::PipelineCache::get_time();
+
+    VkResult result = vkCreateGraphicsPipelines(vk_device, pipeline_cache->get_pipeline_cache(), 1, &graphics_pipeline_create_info, vk_allocation,
+	&vk_pipeline);
+    pipeline_cache->record_creation(start_time);
+    if (result != VK_SUCCESS)
+      throw exception("failed to create graphics piplines [%s]", util::get_result_string(result));
+
+    for (; shader_module_count > 0; shader_module_count--)
+      vkDestroyShaderModule(vk_device, shader_modules[shader_module_count - 1], vk_allocation);
+
+    created_pipeline = alloc.allocate<Pipeline_T>(vk_pipeline, vk_layout, vk_descriptor_set_layouts,
+	pipeline_create_info.push_constant_size, first_set);
+
+    /* another thread created the same pipeline in the meantime */
+    pipeline = state_cache->insert(pipeline::STATE_KIND_PIPELINE, pipeline_key, created_pipeline);
+    if (pipeline != created_pipeline)
+    {
+      release_pipeline(vk_device, vk_allocation, *state_cache, created_pipeline);
+      alloc.deallocate(created_pipeline);
+    }
+  }catch (...)
+  {
+    for (uint32_t i = 0; i < shader_module_count; i++)
+      vkDestroyShaderModule(vk_device, shader_modules[i], vk_allocation);
+
+    if (created_pipeline != nullptr)
+    {
+      release_pipeline(vk_device, vk_allocation, *state_cache, created_pipeline);
+      alloc.deallocate(created_pipeline);
+    }else
+    {
+      release_layouts(vk_device, vk_allocation, *state_cache, vk_layout, vk_descriptor_set_layouts);
+      if (vk_pipeline != VK_NULL_HANDLE)
+	vkDestroyPipeline(vk_device, vk_pipeline, vk_allocation);
+    }
+    throw;
+  }
+  return 0;
+}
+
+int me::Vulkan::create_pipeline_async(const PipelineCreateInfo &pipeline_create_info, PipelineBuild &build)
+{
+  VERIFY_CREATE_INFO(pipeline_create_info, STRUCTURE_TYPE_PIPELINE_CREATE_INFO);
+
+  pipeline::PipelineCompiler* pipeline_compiler = reinterpret_cast<Device_T*>(pipeline_create_info.device)->pipeline_compiler;
+  const ShaderCreateInfo &shader_create_info = *pipeline_create_info.shader_create_info;
+
+  PipelineBuild_T* pipeline_build = alloc.allocate<PipelineBuild_T>();
+
+  /* copying the create info, the arrays are copied first so the pointers to them stay valid */
+  for (uint32_t i = 0; i < pipeline_create_info.viewport_count; i++)
+    pipeline_build->viewports.push_back(pipeline_create_info.viewports[i]);
+  for (uint32_t i = 0; i < pipeline_create_info.scissor_count; i++)
+    pipeline_build->scissors.push_back(pipeline_create_info.scissors[i]);
+  for (uint32_t i = 0; i < shader_create_info.vertex_binding_count; i++)
+    pipeline_build->vertex_bindings.push_back(shader_create_info.vertex_bindings[i]);
+  for (uint32_t i = 0; i < shader_create_info.vertex_attribute_count; i++)
+    pipeline_build->vertex_attributes.push_back(shader_create_info.vertex_attributes[i]);
+  for (uint32_t i = 0; i < pipeline_create_info.descriptor_set_count; i++)
+    pipeline_build->descriptor_sets.push_back(pipeline_create_info.descriptor_sets[i]);
+
+  /* the shaders are copied with their code, the caller may free it as soon as this returns */
+  size_t shader_code_size = 0;
   for (uint32_t i = 0; i < shader_create_info.shader_count; i++)
-    create_shader_module(vk_device, vk_allocation, shader_create_info.shaders[i], shader_modules[i], pipeline_shader_stage_create_infos[i]);
-
-
-  /* === Creating graphics pipeline === */
-  VkGraphicsPipelineCreateInfo graphics_pipeline_create_info = { };
-  graphics_pipeline_create_info.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-  graphics_pipeline_create_info.pNext = nullptr;
-  graphics_pipeline_create_info.flags = 0;
-  graphics_pipeline_create_info.stageCount = shader_create_info.shader_count;
-  graphics_pipeline_create_info.pStages = pipeline_shader_stage_create_infos;
-  graphics_pipeline_create_info.pVertexInputState = &pipeline_vertex_input_state_create_info;
-  graphics_pipeline_create_info.pInputAssemblyState = &pipeline_input_assembly_state_create_info;
-  graphics_pipeline_create_info.pViewportState = &pipeline_viewport_state_create_info;
-  graphics_pipeline_create_info.pRasterizationState = &pipeline_rasterization_state_create_info;
-  graphics_pipeline_create_info.pMultisampleState = &pipeline_multisample_state_create_info;
-  graphics_pipeline_create_info.pDepthStencilState = nullptr;
-  graphics_pipeline_create_info.pColorBlendState = &pipeline_color_blend_state_create_info;
-  graphics_pipeline_create_info.pDynamicState = nullptr;
-  graphics_pipeline_create_info.layout = vk_layout;
-  graphics_pipeline_create_info.renderPass = vk_render_pass;
-  graphics_pipeline_create_info.subpass = 0;
-  graphics_pipeline_create_info.basePipelineHandle = VK_NULL_HANDLE;
-  graphics_pipeline_create_info.basePipelineIndex = -1;
-
-  VkPipeline vk_pipeline;
-  VkResult result = vkCreateGraphicsPipelines(vk_device, VK_NULL_HANDLE, 1, &graphics_pipeline_create_info, vk_allocation, &vk_pipeline);
-  if (result != VK_SUCCESS)
-    throw exception("failed to create graphics piplines [%s]", util::get_result_string(result));
+    shader_code_size += shader_create_info.shaders[i]->data.size + strlen(shader_create_info.shaders[i]->config.entry_point) + 1;
+  pipeline_build->shader_code.resize(shader_code_size);
 
+  char* shader_code = pipeline_build->shader_code.data();
   for (uint32_t i = 0; i < shader_create_info.shader_count; i++)
-    vkDestroyShaderModule(vk_device, shader_modules[i], vk_allocation);
+  {
+    const Shader* shader = shader_create_info.shaders[i];
+    size_t entry_point_size = strlen(shader->config.entry_point) + 1;
+    memcpy(shader_code, shader->data.code, shader->data.size);
+    memcpy(shader_code + shader->data.size, shader->config.entry_point, entry_point_size);
+    pipeline_build->shaders.push_back(alloc.allocate<Shader>(shader->type, ShaderData{shader->data.size, shader_code},
+	  ShaderConfig{shader_code + shader->data.size}));
+    shader_code += shader->data.size + entry_point_size;
+  }
 
-  pipeline = alloc.allocate<Pipeline_T>(vk_pipeline, vk_layout, vk_descriptor_set_layout);
+  pipeline_build->shader_create_info = shader_create_info;
+  pipeline_build->shader_create_info.vertex_bindings = pipeline_build->vertex_bindings.data();
+  pipeline_build->shader_create_info.vertex_attributes = pipeline_build->vertex_attributes.data();
+  pipeline_build->shader_create_info.shaders = pipeline_build->shaders.data();
+  pipeline_build->rasterizer_create_info = *pipeline_create_info.rasterizer_create_info;
+  pipeline_build->multisampling_create_info = *pipeline_create_info.multisampling_create_info;
+
+  pipeline_build->pipeline_create_info = pipeline_create_info;
+  pipeline_build->pipeline_create_info.viewports = pipeline_build->viewports.data();
+  pipeline_build->pipeline_create_info.scissors = pipeline_build->scissors.data();
+  pipeline_build->pipeline_create_info.rasterizer_create_info = &pipeline_build->rasterizer_create_info;
+  pipeline_build->pipeline_create_info.multisampling_create_info = &pipeline_build->multisampling_create_info;
+  pipeline_build->pipeline_create_info.shader_create_info = &pipeline_build->shader_create_info;
+  pipeline_build->pipeline_create_info.descriptor_sets = pipeline_build->descriptor_sets.data();
+  pipeline_build->pipeline = nullptr;
+
+  pipeline_compiler->submit(pipeline_build);
+  build = pipeline_build;
   return 0;
 }
 
@@ -197,13 +375,14 @@ int me::Vulkan::create_descriptors(const DescriptorCreateInfo &descriptor_create
   VERIFY_CREATE_INFO(descriptor_create_info, STRUCTURE_TYPE_DESCRIPTOR_CREATE_INFO);
 
   VkDevice vk_device = reinterpret_cast<Device_T*>(descriptor_create_info.device)->vk_device;
-  VkDescriptorPool vk_descriptor_pool = reinterpret_cast<DescriptorPool_T*>(descriptor_create_info.descriptor_pool)->vk_descriptor_pool;
-  DescriptorType descriptor_pool_type = reinterpret_cast<DescriptorPool_T*>(descriptor_create_info.descriptor_pool)->type;
-  VkDescriptorSetLayout vk_descriptor_set_layout = reinterpret_cast<Pipeline_T*>(descriptor_create_info.pipeline)->vk_descriptor_set_layout;
+  memory::Defragmenter* defragmenter = reinterpret_cast<Device_T*>(descriptor_create_info.device)->defragmenter;
+  const vector<VkDescriptorSetLayout> &vk_pipeline_set_layouts = reinterpret_cast<Pipeline_T*>(descriptor_create_info.pipeline)->vk_descriptor_set_layouts;
+
+  if (descriptor_create_info.set >= vk_pipeline_set_layouts.size())
+    throw exception("in 'create_descriptors()' DescriptorCreateInfo::set is out of range. %u >= \e[33m%lu\e[0m",
+	descriptor_create_info.set, vk_pipeline_set_layouts.size());
 
-  if (descriptor_create_info.descriptor_type != descriptor_pool_type)
-    throw exception("in 'create_descriptors()' DescriptorCreateInfo::descriptor_type must be the same as DescriptorPool::descriptor_type. %s != \e[33m%s\e[0m",
-	descriptor_type_name(descriptor_create_info.descriptor_type), descriptor_type_name(descriptor_pool_type));
+  VkDescriptorSetLayout vk_descriptor_set_layout = vk_pipeline_set_layouts[descriptor_create_info.set];
 
   if (descriptor_create_info.buffer_count != descriptor_count)
     throw exception("in 'create_descriptors()' DescriptorCreateInfo::buffer_count must be the same as 'descriptor_count'. %u != \e[33m%u\e[0m",	
@@ -213,17 +392,31 @@ int me::Vulkan::create_descriptors(const DescriptorCreateInfo &descriptor_create
   for (uint32_t i = 0; i < descriptor_count; i++)
     vk_descriptor_set_layouts[i] = vk_descriptor_set_layout;
 
-  VkDescriptorSetAllocateInfo vk_descriptor_set_allocate_info = { };
-  vk_descriptor_set_allocate_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-  vk_descriptor_set_allocate_info.pNext = nullptr;
-  vk_descriptor_set_allocate_info.descriptorPool = vk_descriptor_pool;
-  vk_descriptor_set_allocate_info.descriptorSetCount = descriptor_count;
-  vk_descriptor_set_allocate_info.pSetLayouts = vk_descriptor_set_layouts;
-
-  VkDescriptorSet vk_descriptor_sets[descriptor_count];
-  VkResult result = vkAllocateDescriptorSets(vk_device, &vk_descriptor_set_allocate_info, vk_descriptor_sets);
-  if (result != VK_SUCCESS)
-    throw exception("failed to allocate descriptor sets [%s]", util::get_result_string(result));
+  /* without a pool the sets come from the current frame and are freed when the frame index comes around again */
+  Descriptor_T* vk_descriptors[descriptor_count];
+  if (descriptor_create_info.descriptor_pool == nullptr)
+  {
+    descriptor::FrameDescriptorAllocator* frame_descriptors = reinterpret_cast<Device_T*>(descriptor_create_info.device)->frame_descriptors;
+    frame_descriptors->allocate(descriptor_count, vk_descriptor_set_layouts, vk_descriptors);
+  }else
+  {
+    descriptor::DescriptorAllocator* descriptor_allocator = reinterpret_cast<DescriptorPool_T*>(descriptor_create_info.descriptor_pool)->allocator;
+    DescriptorType descriptor_pool_type = reinterpret_cast<DescriptorPool_T*>(descriptor_create_info.descriptor_pool)->type;
+
+    if (descriptor_pool_type != DESCRIPTOR_TYPE_NONE && descriptor_create_info.descriptor_type != descriptor_pool_type)
+      throw exception("in 'create_descriptors()' DescriptorCreateInfo::descriptor_type must be the same as DescriptorPool::descriptor_type. %s != \e[33m%s\e[0m",
+	  descriptor_type_name(descriptor_create_info.descriptor_type), descriptor_type_name(descriptor_pool_type));
+
+    VkDescriptorSet vk_descriptor_sets[descriptor_count];
+    VkDescriptorPool vk_descriptor_pool;
+    descriptor_allocator->allocate(descriptor_count, vk_descriptor_set_layouts, vk_descriptor_sets, vk_descriptor_pool);
+
+    VkDescriptorType vk_descriptor_type = util::get_vulkan_descriptor_type(descriptor_create_info.descriptor_type);
+    for (uint32_t i = 0; i < descriptor_count; i++)
+      vk_descriptors[i] = alloc.allocate<Descriptor_T>(vk_descriptor_sets[i], vk_descriptor_pool, descriptor_allocator,
+	  vk_descriptor_set_layout, vk_descriptor_type, reinterpret_cast<Buffer_T*>(descriptor_create_info.buffers[i]),
+	  descriptor_create_info.offset, descriptor_create_info.range);
+  }
 
   for (uint32_t i = 0; i < descriptor_count; i++)
   {
@@ -237,7 +430,7 @@ int me::Vulkan::create_descriptors(const DescriptorCreateInfo &descriptor_create
     VkWriteDescriptorSet vk_write_descriptor_set = { };
     vk_write_descriptor_set.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
     vk_write_descriptor_set.pNext = nullptr;
-    vk_write_descriptor_set.dstSet = vk_descriptor_sets[i];
+    vk_write_descriptor_set.dstSet = vk_descriptors[i]->vk_descriptor_set;
     vk_write_descriptor_set.dstBinding = 0;
     vk_write_descriptor_set.dstArrayElement = 0;
     vk_write_descriptor_set.descriptorCount = 1;
@@ -248,37 +441,97 @@ int me::Vulkan::create_descriptors(const DescriptorCreateInfo &descriptor_create
 
     vkUpdateDescriptorSets(vk_device, 1, &vk_write_descriptor_set, 0, nullptr);
 
-    descriptors[i] = alloc.allocate<Descriptor_T>(vk_descriptor_sets[i]);
+    /* the defragmenter writes the set again when it moves the buffer */
+    if (vk_descriptors[i]->allocator != nullptr)
+      defragmenter->add_descriptor(vk_descriptors[i]);
+
+    descriptors[i] = vk_descriptors[i];
   }
   return 0;
 }
 
+int me::Vulkan::bindless_add_buffer(Device device, Buffer buffer, uint32_t &index)
+{
+  descriptor::BindlessTable* bindless_table = reinterpret_cast<Device_T*>(device)->bindless_table;
+  memory::Defragmenter* defragmenter = reinterpret_cast<Device_T*>(device)->defragmenter;
+  VkBuffer vk_buffer = reinterpret_cast<Buffer_T*>(buffer)->vk_buffer;
+  VkBufferUsageFlags vk_buffer_usage = reinterpret_cast<Buffer_T*>(buffer)->vk_usage;
+
+  if (bindless_table == nullptr)
+    throw exception("in 'bindless_add_buffer()' the device doesn't support descriptor indexing");
+
+  if (!(vk_buffer_usage & VK_BUFFER_USAGE_STORAGE_BUFFER_BIT))
+    throw exception("in 'bindless_add_buffer()' the buffer wasn't created with 'BUFFER_USAGE_STORAGE'");
+
+  /* the table is read by frames in flight and its indices are kept by the caller, so the buffer is never moved again */
+  defragmenter->remove(reinterpret_cast<Buffer_T*>(buffer));
+
+  bindless_table->add_buffer(vk_buffer, 0, VK_WHOLE_SIZE, index);
+  return 0;
+}
+
+int me::Vulkan::bindless_remove_buffer(Device device, uint32_t index)
+{
+  descriptor::BindlessTable* bindless_table = reinterpret_cast<Device_T*>(device)->bindless_table;
+
+  bindless_table->remove_buffer(index);
+  return 0;
+}
+
 int me::Vulkan::cleanup_pipeline(Device device, Pipeline pipeline)
 {
   VkDevice vk_device = reinterpret_cast<Device_T*>(device)->vk_device;
-  VkDescriptorSetLayout vk_descriptor_set_layout = reinterpret_cast<Pipeline_T*>(pipeline)->vk_descriptor_set_layout;
-  VkPipelineLayout vk_pipeline_layout = reinterpret_cast<Pipeline_T*>(pipeline)->vk_layout;
-  VkPipeline vk_pipeline = reinterpret_cast<Pipeline_T*>(pipeline)->vk_pipeline;
+  pipeline::StateCache* state_cache = reinterpret_cast<Device_T*>(device)->state_cache;
+
+  /* other users of the same pipeline keep it alive */
+  if (!state_cache->release(pipeline::STATE_KIND_PIPELINE, pipeline))
+    return 0;
 
-  vkDestroyDescriptorSetLayout(vk_device, vk_descriptor_set_layout, vk_allocation);
-  vkDestroyPipelineLayout(vk_device, vk_pipeline_layout, vk_allocation);
-  vkDestroyPipeline(vk_device, vk_pipeline, vk_allocation);
+  release_pipeline(vk_device, vk_allocation, *state_cache, reinterpret_cast<Pipeline_T*>(pipeline));
+  alloc.deallocate(reinterpret_cast<Pipeline_T*>(pipeline));
+  return 0;
+}
+
+int me::Vulkan::cleanup_pipeline_build(Device device, PipelineBuild build)
+{
+  pipeline::PipelineCompiler* pipeline_compiler = reinterpret_cast<Device_T*>(device)->pipeline_compiler;
+
+  /* the compiler still writes to a pending build */
+  PipelineBuild_T* pipeline_build = reinterpret_cast<PipelineBuild_T*>(build);
+  pipeline_compiler->wait(pipeline_build);
+  for (Shader* shader : pipeline_build->shaders)
+    alloc.deallocate(shader);
+  alloc.deallocate(pipeline_build);
+  return 0;
+}
+
+int me::Vulkan::get_pipeline_build(PipelineBuild build, Pipeline fallback, PipelineBuildStatus &status, Pipeline &pipeline)
+{
+  PipelineBuild_T* pipeline_build = reinterpret_cast<PipelineBuild_T*>(build);
+  pipeline::PipelineCompiler* pipeline_compiler =
+    reinterpret_cast<Device_T*>(pipeline_build->pipeline_create_info.device)->pipeline_compiler;
+
+  status = pipeline_compiler->get_status(pipeline_build);
+  pipeline = status == PIPELINE_BUILD_STATUS_READY ? pipeline_build->pipeline : fallback;
   return 0;
 }
 
 int me::Vulkan::cleanup_descriptors(Device device, DescriptorPool descriptor_pool, uint32_t descriptor_count, Descriptor* descriptors)
 {
   VkDevice vk_device = reinterpret_cast<Device_T*>(device)->vk_device;
-  VkDescriptorPool vk_descriptor_pool = reinterpret_cast<DescriptorPool_T*>(descriptor_pool)->vk_descriptor_pool;
+  memory::Defragmenter* defragmenter = reinterpret_cast<Device_T*>(device)->defragmenter;
 
-  VkDescriptorSet vk_descriptor_sets[descriptor_count];
+  /* a set goes back to the pool of the allocator it came from */
   for (uint32_t i = 0; i < descriptor_count; i++)
   {
-    VkDescriptorSet vk_descriptor_set = reinterpret_cast<Descriptor_T*>(descriptors[i])->vk_descriptor_set;
-    vk_descriptor_sets[i] = vk_descriptor_set;
-  }
+    Descriptor_T* descriptor = reinterpret_cast<Descriptor_T*>(descriptors[i]);
+    if (descriptor->vk_descriptor_pool == VK_NULL_HANDLE)
+      throw exception("in 'cleanup_descriptors()' per-frame descriptors are freed with their frame");
 
-  vkFreeDescriptorSets(vk_device, vk_descriptor_pool, descriptor_count, vk_descriptor_sets);
+    defragmenter->remove_descriptor(descriptor);
+    vkFreeDescriptorSets(vk_device, descriptor->vk_descriptor_pool, 1, &descriptor->vk_descriptor_set);
+    alloc.deallocate(descriptor);
+  }
   return 0;
 }
 
@@ -296,7 +549,7 @@ int create_vertex_input(
     const me::ShaderBinding &binding_info = binding_infos[i];
     vertex_input_binding_descriptions[i].binding = binding_info.binding;
     vertex_input_binding_descriptions[i].stride = binding_info.stride;
-    vertex_input_binding_descriptions[i].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+    vertex_input_binding_descriptions[i].inputRate = binding_info.per_instance ? VK_VERTEX_INPUT_RATE_INSTANCE : VK_VERTEX_INPUT_RATE_VERTEX;
   }
 
   for (uint32_t i = 0; i < attribute_infos.size(); i++)
@@ -360,17 +613,23 @@ int create_pipeline_layout(
     VkDevice 								device,
     VkAllocationCallbacks* 						allocation,
     const me::array_proxy<VkDescriptorSetLayout>			&descriptor_set_layouts,
+    uint32_t 								push_constant_size,
     VkPipelineLayout 							&pipeline_layout
     )
 {
+  VkPushConstantRange push_constant_range = { };
+  push_constant_range.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+  push_constant_range.offset = 0;
+  push_constant_range.size = push_constant_size;
+
   VkPipelineLayoutCreateInfo pipeline_layout_create_info = { };
   pipeline_layout_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
   pipeline_layout_create_info.pNext = nullptr;
   pipeline_layout_create_info.flags = 0;
   pipeline_layout_create_info.setLayoutCount = descriptor_set_layouts.size();
   pipeline_layout_create_info.pSetLayouts = descriptor_set_layouts.data();
-  pipeline_layout_create_info.pushConstantRangeCount = 0;
-  pipeline_layout_create_info.pPushConstantRanges = nullptr;
+  pipeline_layout_create_info.pushConstantRangeCount = push_constant_size > 0 ? 1 : 0;
+  pipeline_layout_create_info.pPushConstantRanges = &push_constant_range;
  
   VkResult result = vkCreatePipelineLayout(device, &pipeline_layout_create_info, allocation, &pipeline_layout);
   if (result != VK_SUCCESS)
@@ -378,40 +637,195 @@ int create_pipeline_layout(
   return 0;
 }
 
-int create_viewports(
-    const me::array_proxy<me::Viewport>					&viewport_infos,
-    const me::array_proxy<me::Scissor>					&scissor_infos,
-    VkViewport*								viewports,
-    VkRect2D*								scissors,
-    VkPipelineViewportStateCreateInfo 					&pipeline_viewport_state_create_info
+int build_pipeline_key(
+    const me::PipelineCreateInfo 					&pipeline_create_info,
+    uint64_t 								render_pass_compatibility,
+    me::vector<char> 							&key
     )
 {
-  for (uint32_t i = 0; i < viewport_infos.size(); i++)
+  typedef me::pipeline::StateCache StateCache;
+
+  /* only what ends up in the 'VkGraphicsPipelineCreateInfo', in a fixed layout without padding.
+   * the render pass only matters up to compatibility, the shaders by their code, not their address */
+  const me::ShaderCreateInfo &shader_create_info = *pipeline_create_info.shader_create_info;
+  StateCache::append_key(key, render_pass_compatibility);
+
+  StateCache::append_key(key, shader_create_info.shader_count);
+  for (uint32_t i = 0; i < shader_create_info.shader_count; i++)
   {
-    const me::Viewport &viewport_info = viewport_infos[i];
-    viewports[i] = {
-        .x = viewport_info.location[0],
-        .y = viewport_info.location[1],
-        .width = viewport_info.size[0],
-        .height = viewport_info.size[1],
-        .minDepth = 0.0F,
-	.maxDepth = 1.0F
-    };
+    const me::Shader* shader = shader_create_info.shaders[i];
+    StateCache::append_key(key, shader->type);
+    StateCache::append_key(key, shader->data.size);
+    StateCache::append_key(key, StateCache::hash(shader->data.code, shader->data.size));
+    for (const char* c = shader->config.entry_point; *c != '\0'; c++)
+      key.push_back(*c);
+    key.push_back('\0');
+  }
 
-    const me::Scissor &scissor_info = scissor_infos[i];
-    scissors[i] = {
-        .offset = {scissor_info.offset[0], scissor_info.offset[1]},
-        .extent = {scissor_info.size[0], scissor_info.size[1]}
-    };
+  StateCache::append_key(key, shader_create_info.vertex_binding_count);
+  for (uint32_t i = 0; i < shader_create_info.vertex_binding_count; i++)
+  {
+    StateCache::append_key(key, shader_create_info.vertex_bindings[i].binding);
+    StateCache::append_key(key, shader_create_info.vertex_bindings[i].stride);
+    StateCache::append_key(key, static_cast<uint8_t>(shader_create_info.vertex_bindings[i].per_instance));
+  }
+  StateCache::append_key(key, shader_create_info.vertex_attribute_count);
+  for (uint32_t i = 0; i < shader_create_info.vertex_attribute_count; i++)
+  {
+    StateCache::append_key(key, shader_create_info.vertex_attributes[i].binding);
+    StateCache::append_key(key, shader_create_info.vertex_attributes[i].location);
+    StateCache::append_key(key, shader_create_info.vertex_attributes[i].offset);
+    StateCache::append_key(key, shader_create_info.vertex_attributes[i].format);
+  }
+  StateCache::append_key(key, shader_create_info.topology);
+
+  /* viewports and scissors are dynamic, pipelines for different sizes are the same */
+  StateCache::append_key(key, pipeline_create_info.viewport_count);
+  StateCache::append_key(key, pipeline_create_info.scissor_count);
+
+  StateCache::append_key(key, pipeline_create_info.rasterizer_create_info->polygon_mode);
+  StateCache::append_key(key, pipeline_create_info.rasterizer_create_info->front_face);
+  StateCache::append_key(key, pipeline_create_info.rasterizer_create_info->cull_mode);
+  StateCache::append_key(key, pipeline_create_info.multisampling_create_info->samples);
+
+  /* no sets is the same as the default single uniform set */
+  if (pipeline_create_info.descriptor_set_count == 0)
+  {
+    StateCache::append_key(key, 1U);
+    StateCache::append_key(key, me::DESCRIPTOR_TYPE_UNIFORM);
+  }else
+  {
+    StateCache::append_key(key, pipeline_create_info.descriptor_set_count);
+    for (uint32_t i = 0; i < pipeline_create_info.descriptor_set_count; i++)
+      StateCache::append_key(key, pipeline_create_info.descriptor_sets[i]);
+  }
+  StateCache::append_key(key, pipeline_create_info.push_constant_size);
+  StateCache::append_key(key, static_cast<uint8_t>(pipeline_create_info.bindless));
+  return 0;
+}
+
+int acquire_descriptor_set_layout(
+    VkDevice 								device,
+    VkAllocationCallbacks* 						allocation,
+    me::pipeline::StateCache 						&state_cache,
+    me::DescriptorType 							descriptor_type,
+    VkDescriptorSetLayout 						&descriptor_set_layout
+    )
+{
+  me::vector<char> key;
+  me::pipeline::StateCache::append_key(key, descriptor_type);
+
+  void* shared = state_cache.acquire(me::pipeline::STATE_KIND_DESCRIPTOR_SET_LAYOUT, key);
+  if (shared != nullptr)
+  {
+    descriptor_set_layout = reinterpret_cast<VkDescriptorSetLayout>(shared);
+    return 0;
+  }
+
+  VkDescriptorSetLayoutBinding descriptor_set_layout_binding = { };
+  descriptor_set_layout_binding.binding = 0;
+  descriptor_set_layout_binding.descriptorType = me::util::get_vulkan_descriptor_type(descriptor_type);
+  descriptor_set_layout_binding.descriptorCount = 1;
+  descriptor_set_layout_binding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+  descriptor_set_layout_binding.pImmutableSamplers = nullptr;
+
+  VkDescriptorSetLayout created_descriptor_set_layout;
+  create_descriptor_set_layout(device, allocation, {1, &descriptor_set_layout_binding}, created_descriptor_set_layout);
+
+  shared = state_cache.insert(me::pipeline::STATE_KIND_DESCRIPTOR_SET_LAYOUT, key, reinterpret_cast<void*>(created_descriptor_set_layout));
+  descriptor_set_layout = reinterpret_cast<VkDescriptorSetLayout>(shared);
+  if (descriptor_set_layout != created_descriptor_set_layout)
+    vkDestroyDescriptorSetLayout(device, created_descriptor_set_layout, allocation);
+  return 0;
+}
+
+int acquire_pipeline_layout(
+    VkDevice 								device,
+    VkAllocationCallbacks* 						allocation,
+    me::pipeline::StateCache 						&state_cache,
+    const me::array_proxy<VkDescriptorSetLayout> 			&descriptor_set_layouts,
+    uint32_t 								push_constant_size,
+    VkPipelineLayout 							&pipeline_layout
+    )
+{
+  /* the set layouts are shared too, so their handles identify them */
+  me::vector<char> key;
+  me::pipeline::StateCache::append_key(key, descriptor_set_layouts.size());
+  for (uint32_t i = 0; i < descriptor_set_layouts.size(); i++)
+    me::pipeline::StateCache::append_key(key, descriptor_set_layouts[i]);
+  me::pipeline::StateCache::append_key(key, push_constant_size);
+
+  void* shared = state_cache.acquire(me::pipeline::STATE_KIND_PIPELINE_LAYOUT, key);
+  if (shared != nullptr)
+  {
+    pipeline_layout = reinterpret_cast<VkPipelineLayout>(shared);
+    return 0;
   }
 
+  VkPipelineLayout created_pipeline_layout;
+  create_pipeline_layout(device, allocation, descriptor_set_layouts, push_constant_size, created_pipeline_layout);
+
+  shared = state_cache.insert(me::pipeline::STATE_KIND_PIPELINE_LAYOUT, key, reinterpret_cast<void*>(created_pipeline_layout));
+  pipeline_layout = reinterpret_cast<VkPipelineLayout>(shared);
+  if (pipeline_layout != created_pipeline_layout)
+    vkDestroyPipelineLayout(device, created_pipeline_layout, allocation);
+  return 0;
+}
+
+int release_pipeline(
+    VkDevice 								device,
+    VkAllocationCallbacks* 						allocation,
+    me::pipeline::StateCache 						&state_cache,
+    const me::Pipeline_T* 						pipeline
+    )
+{
+  release_layouts(device, allocation, state_cache, pipeline->vk_layout, pipeline->vk_descriptor_set_layouts);
+  vkDestroyPipeline(device, pipeline->vk_pipeline, allocation);
+  return 0;
+}
+
+int release_layouts(
+    VkDevice 								device,
+    VkAllocationCallbacks* 						allocation,
+    me::pipeline::StateCache 						&state_cache,
+    VkPipelineLayout 							pipeline_layout,
+    const me::vector<VkDescriptorSetLayout> 				&descriptor_set_layouts
+    )
+{
+  if (pipeline_layout != VK_NULL_HANDLE &&
+      state_cache.release(me::pipeline::STATE_KIND_PIPELINE_LAYOUT, reinterpret_cast<void*>(pipeline_layout)))
+    vkDestroyPipelineLayout(device, pipeline_layout, allocation);
+
+  for (VkDescriptorSetLayout descriptor_set_layout : descriptor_set_layouts)
+  {
+    if (state_cache.release(me::pipeline::STATE_KIND_DESCRIPTOR_SET_LAYOUT, reinterpret_cast<void*>(descriptor_set_layout)))
+      vkDestroyDescriptorSetLayout(device, descriptor_set_layout, allocation);
+  }
+  return 0;
+}
+
+int create_viewport_state(
+    uint32_t 								viewport_count,
+    uint32_t 								scissor_count,
+    const me::array_proxy<VkDynamicState> 				&dynamic_states,
+    VkPipelineViewportStateCreateInfo 					&pipeline_viewport_state_create_info,
+    VkPipelineDynamicStateCreateInfo 					&pipeline_dynamic_state_create_info
+    )
+{
+  /* only the counts are baked in, the rectangles are set when recording */
   pipeline_viewport_state_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
   pipeline_viewport_state_create_info.pNext = nullptr;
   pipeline_viewport_state_create_info.flags = 0;
-  pipeline_viewport_state_create_info.viewportCount = viewport_infos.size();
-  pipeline_viewport_state_create_info.pViewports = viewports;
-  pipeline_viewport_state_create_info.scissorCount = scissor_infos.size();
-  pipeline_viewport_state_create_info.pScissors = scissors;
+  pipeline_viewport_state_create_info.viewportCount = viewport_count > 0 ? viewport_count : 1;
+  pipeline_viewport_state_create_info.pViewports = nullptr;
+  pipeline_viewport_state_create_info.scissorCount = scissor_count > 0 ? scissor_count : 1;
+  pipeline_viewport_state_create_info.pScissors = nullptr;
+
+  pipeline_dynamic_state_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+  pipeline_dynamic_state_create_info.pNext = nullptr;
+  pipeline_dynamic_state_create_info.flags = 0;
+  pipeline_dynamic_state_create_info.dynamicStateCount = dynamic_states.size();
+  pipeline_dynamic_state_create_info.pDynamicStates = dynamic_states.data();
   return 0;
 }
 
@@ -490,27 +904,31 @@ int create_multisampling(
 }
 
 int create_color_blend(
+    uint32_t 								attachment_count,
     VkPipelineColorBlendAttachmentState* 				pipeline_color_blend_attachment_states,
     VkPipelineColorBlendStateCreateInfo 				&pipeline_color_blend_state_create_info
     )
 {
-  pipeline_color_blend_attachment_states[0] = {
-    VK_FALSE,
-    VK_BLEND_FACTOR_ONE,
-    VK_BLEND_FACTOR_ZERO,
-    VK_BLEND_OP_ADD,
-    VK_BLEND_FACTOR_ONE,
-    VK_BLEND_FACTOR_ZERO,
-    VK_BLEND_OP_ADD,
-    VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT
-  };
+  for (uint32_t i = 0; i < attachment_count; i++)
+  {
+    pipeline_color_blend_attachment_states[i] = {
+      VK_FALSE,
+      VK_BLEND_FACTOR_ONE,
+      VK_BLEND_FACTOR_ZERO,
+      VK_BLEND_OP_ADD,
+      VK_BLEND_FACTOR_ONE,
+      VK_BLEND_FACTOR_ZERO,
+      VK_BLEND_OP_ADD,
+      VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT
+    };
+  }
 
   pipeline_color_blend_state_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
   pipeline_color_blend_state_create_info.pNext = nullptr;
   pipeline_color_blend_state_create_info.flags = 0;
   pipeline_color_blend_state_create_info.logicOpEnable = VK_FALSE;
   pipeline_color_blend_state_create_info.logicOp = VK_LOGIC_OP_COPY;
-  pipeline_color_blend_state_create_info.attachmentCount = 1;
+  pipeline_color_blend_state_create_info.attachmentCount = attachment_count;
   pipeline_color_blend_state_create_info.pAttachments = pipeline_color_blend_attachment_states;
   pipeline_color_blend_state_create_info.blendConstants[0] = 0.0F;
   pipeline_color_blend_state_create_info.blendConstants[1] = 0.0F;
@@ -519,6 +937,25 @@ int create_color_blend(
   return 0;
 }
 
+int create_depth_stencil(
+    VkPipelineDepthStencilStateCreateInfo 				&pipeline_depth_stencil_state_create_info
+    )
+{
+  pipeline_depth_stencil_state_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+  pipeline_depth_stencil_state_create_info.pNext = nullptr;
+  pipeline_depth_stencil_state_create_info.flags = 0;
+  pipeline_depth_stencil_state_create_info.depthTestEnable = VK_TRUE;
+  pipeline_depth_stencil_state_create_info.depthWriteEnable = VK_TRUE;
+  pipeline_depth_stencil_state_create_info.depthCompareOp = VK_COMPARE_OP_LESS;
+  pipeline_depth_stencil_state_create_info.depthBoundsTestEnable = VK_FALSE;
+  pipeline_depth_stencil_state_create_info.stencilTestEnable = VK_FALSE;
+  pipeline_depth_stencil_state_create_info.front = { };
+  pipeline_depth_stencil_state_create_info.back = { };
+  pipeline_depth_stencil_state_create_info.minDepthBounds = 0.0F;
+  pipeline_depth_stencil_state_create_info.maxDepthBounds = 1.0F;
+  return 0;
+}
+
 int create_shader_module(
     VkDevice 								device,
     VkAllocationCallbacks* 						allocation,
@@ -544,6 +981,7 @@ int create_shader_module(
     case me::SHADER_TYPE_VERTEX: shader_stage_flag_bits = VK_SHADER_STAGE_VERTEX_BIT; break;
     case me::SHADER_TYPE_FRAGMENT: shader_stage_flag_bits = VK_SHADER_STAGE_FRAGMENT_BIT; break;
     case me::SHADER_TYPE_GEOMETRY: shader_stage_flag_bits = VK_SHADER_STAGE_GEOMETRY_BIT; break;
+    case me::SHADER_TYPE_COMPUTE: shader_stage_flag_bits = VK_SHADER_STAGE_COMPUTE_BIT; break;
   }
 
   pipeline_shader_stage_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
@@ -0,0 +1,151 @@
+#include "PipelineCache.hpp"
+#include "Util.hpp"
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+me::pipeline::PipelineCache::PipelineCache(VkDevice device, VkAllocationCallbacks* allocation, const VkPhysicalDeviceProperties &properties,
+    const char* path)
+  : vk_device(device), vk_allocation(allocation), vk_properties(properties), path(path)
+{
+  vk_pipeline_cache = VK_NULL_HANDLE;
+  stats = { };
+}
+
+int me::pipeline::PipelineCache::initialize()
+{
+  char* data = nullptr;
+  size_t size = 0;
+  if (path != nullptr)
+    read_file(data, size);
+
+  /* an incompatible file is ignored and replaced on cleanup */
+  stats.seeded = data != nullptr && is_compatible(data, size);
+
+  VkPipelineCacheCreateInfo pipeline_cache_create_info = { };
+  pipeline_cache_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+  pipeline_cache_create_info.pNext = nullptr;
+  pipeline_cache_create_info.flags = 0;
+  pipeline_cache_create_info.initialDataSize = stats.seeded ? size : 0;
+  pipeline_cache_create_info.pInitialData = stats.seeded ? data : nullptr;
+
+  VkResult result = vkCreatePipelineCache(vk_device, &pipeline_cache_create_info, vk_allocation, &vk_pipeline_cache);
+  delete[] data;
+  if (result != VK_SUCCESS)
+    throw exception("failed to create pipeline cache [%s]", util::get_result_string(result));
+  return 0;
+}
+
+bool me::pipeline::PipelineCache::cleanup()
+{
+  /* a cache that isn't saved only makes the next start cold, so nothing here stops the device from being destroyed */
+  bool saved = true;
+  if (path != nullptr)
+  {
+    size_t size;
+    VkResult result = vkGetPipelineCacheData(vk_device, vk_pipeline_cache, &size, nullptr);
+    if (result == VK_SUCCESS)
+    {
+      char* data = new char[size];
+      result = vkGetPipelineCacheData(vk_device, vk_pipeline_cache, &size, data);
+      saved = result == VK_SUCCESS && write_file(data, size);
+      delete[] data;
+    }else
+      saved = false;
+  }
+
+  vkDestroyPipelineCache(vk_device, vk_pipeline_cache, vk_allocation);
+  pthread_mutex_destroy(&mutex);
+  return saved;
+}
+
+int me::pipeline::PipelineCache::record_creation(
+    uint64_t 						start_time
+    )
+{
+  uint64_t duration = get_time() - start_time;
+
+  pthread_mutex_lock(&mutex);
+  stats.pipeline_count++;
+  stats.creation_time += duration;
+  pthread_mutex_unlock(&mutex);
+  return 0;
+}
+
+me::pipeline::PipelineCache::Stats me::pipeline::PipelineCache::get_stats()
+{
+  pthread_mutex_lock(&mutex);
+  Stats current_stats = stats;
+  pthread_mutex_unlock(&mutex);
+  return current_stats;
+}
+
+uint64_t me::pipeline::PipelineCache::get_time()
+{
+  timespec time;
+  clock_gettime(CLOCK_MONOTONIC, &time);
+  return static_cast<uint64_t>(time.tv_sec) * 1000000000ULL + static_cast<uint64_t>(time.tv_nsec);
+}
+
+bool me::pipeline::PipelineCache::is_compatible(const char* data, size_t size) const
+{
+  VkPipelineCacheHeaderVersionOne header;
+  if (size < sizeof(header))
+    return false;
+
+  memcpy(&header, data, sizeof(header));
+  return header.headerSize >= sizeof(header) && header.headerSize <= size &&
+    header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+    header.vendorID == vk_properties.vendorID &&
+    header.deviceID == vk_properties.deviceID &&
+    memcmp(header.pipelineCacheUUID, vk_properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
+
+int me::pipeline::PipelineCache::read_file(char* &data, size_t &size)
+{
+  /* no file on the first run */
+  FILE* file = fopen(path, "rb");
+  if (file == nullptr)
+    return 0;
+
+  fseek(file, 0, SEEK_END);
+  long length = ftell(file);
+  fseek(file, 0, SEEK_SET);
+
+  if (length > 0)
+  {
+    data = new char[length];
+    size = fread(data, 1, length, file);
+    if (size != static_cast<size_t>(length))
+    {
+      delete[] data;
+      data = nullptr;
+      size = 0;
+    }
+  }
+  fclose(file);
+  return 0;
+}
+
+bool me::pipeline::PipelineCache::write_file(const char* data, size_t size)
+{
+  /* written next to the old file and renamed, so a crash while writing never leaves half a cache behind */
+  size_t path_length = strlen(path);
+  char temporary_path[path_length + 5];
+  memcpy(temporary_path, path, path_length);
+  memcpy(temporary_path + path_length, ".tmp", 5);
+
+  FILE* file = fopen(temporary_path, "wb");
+  if (file == nullptr)
+    return false;
+
+  size_t written = fwrite(data, 1, size, file);
+  bool closed = fclose(file) == 0;
+  if (written != size || !closed || rename(temporary_path, path) != 0)
+  {
+    remove(temporary_path);
+    return false;
+  }
+  return true;
+}
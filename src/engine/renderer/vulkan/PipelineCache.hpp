@@ -0,0 +1,80 @@
+#ifndef ME_VULKAN_PIPELINE_CACHE_HPP
+  #define ME_VULKAN_PIPELINE_CACHE_HPP
+
+#include "../Types.hpp"
+
+#include <vulkan/vulkan.h>
+
+#include <pthread.h>
+
+namespace me::pipeline {
+
+  /* one 'VkPipelineCache' per device that every pipeline is created with.
+   * it is seeded from a file written by an earlier run if the file's header matches the
+   * physical device, so warm starts don't compile the same SPIR-V again, and written back on cleanup */
+  class PipelineCache {
+
+  public:
+
+    struct Stats {
+      bool seeded; /* the cache started with data from the file */
+      uint32_t pipeline_count;
+      uint64_t creation_time; /* nanoseconds spent creating pipelines */
+    };
+
+  protected:
+
+    VkDevice vk_device;
+    VkAllocationCallbacks* vk_allocation;
+    VkPhysicalDeviceProperties vk_properties;
+    const char* path; /* nullptr to keep the cache in memory only */
+
+    VkPipelineCache vk_pipeline_cache;
+
+    pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER; /* stats are recorded by every thread creating pipelines */
+    Stats stats;
+
+  public:
+
+    PipelineCache(VkDevice device, VkAllocationCallbacks* allocation, const VkPhysicalDeviceProperties &properties, const char* path);
+
+    int initialize();
+
+    /* writes the cache to the file, then destroys it. saving is best effort,
+     * returns false if the file couldn't be written and was left as it was */
+    bool cleanup();
+
+    /* time from before the pipeline was created to now, from 'get_time()' */
+    int record_creation(
+	uint64_t 					start_time
+	);
+
+    Stats get_stats();
+
+    VkPipelineCache get_pipeline_cache() const
+    {
+      return vk_pipeline_cache;
+    }
+
+    const char* get_path() const
+    {
+      return path;
+    }
+
+    /* monotonic nanoseconds */
+    static uint64_t get_time();
+
+  protected:
+
+    /* false if the data was written by another driver or device, the driver would reject or misuse it */
+    bool is_compatible(const char* data, size_t size) const;
+
+    int read_file(char* &data, size_t &size);
+    /* false if the file couldn't be replaced, the temporary file is removed */
+    bool write_file(const char* data, size_t size);
+
+  };
+
+}
+
+#endif
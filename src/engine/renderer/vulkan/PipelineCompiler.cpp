@@ -0,0 +1,115 @@
+#include "PipelineCompiler.hpp"
+#include "Types.hpp"
+
+#include "../Renderer.hpp"
+
+me::pipeline::PipelineCompiler::PipelineCompiler(RendererModule* renderer, uint32_t thread_count)
+  : renderer(renderer), thread_count(thread_count < 1 ? 1 : (thread_count > MAX_THREADS ? MAX_THREADS : thread_count))
+{
+  first_build = nullptr;
+  last_build = nullptr;
+  stopping = false;
+}
+
+int me::pipeline::PipelineCompiler::initialize()
+{
+  pthread_mutex_init(&mutex, nullptr);
+  pthread_cond_init(&queue_cond, nullptr);
+  pthread_cond_init(&done_cond, nullptr);
+
+  for (uint32_t i = 0; i < thread_count; i++)
+    pthread_create(&threads[i], nullptr, thread_main, this);
+  return 0;
+}
+
+int me::pipeline::PipelineCompiler::cleanup()
+{
+  pthread_mutex_lock(&mutex);
+  stopping = true;
+  pthread_cond_broadcast(&queue_cond);
+  pthread_mutex_unlock(&mutex);
+
+  for (uint32_t i = 0; i < thread_count; i++)
+    pthread_join(threads[i], nullptr);
+
+  pthread_cond_destroy(&done_cond);
+  pthread_cond_destroy(&queue_cond);
+  pthread_mutex_destroy(&mutex);
+  return 0;
+}
+
+int me::pipeline::PipelineCompiler::submit(
+    PipelineBuild_T* 					build
+    )
+{
+  pthread_mutex_lock(&mutex);
+  build->status = PIPELINE_BUILD_STATUS_PENDING;
+  build->next_build = nullptr;
+  if (last_build != nullptr)
+    last_build->next_build = build;
+  else
+    first_build = build;
+  last_build = build;
+  pthread_cond_signal(&queue_cond);
+  pthread_mutex_unlock(&mutex);
+  return 0;
+}
+
+me::PipelineBuildStatus me::pipeline::PipelineCompiler::get_status(
+    const PipelineBuild_T* 				build
+    )
+{
+  pthread_mutex_lock(&mutex);
+  PipelineBuildStatus status = build->status;
+  pthread_mutex_unlock(&mutex);
+  return status;
+}
+
+int me::pipeline::PipelineCompiler::wait(
+    const PipelineBuild_T* 				build
+    )
+{
+  pthread_mutex_lock(&mutex);
+  while (build->status == PIPELINE_BUILD_STATUS_PENDING)
+    pthread_cond_wait(&done_cond, &mutex);
+  pthread_mutex_unlock(&mutex);
+  return 0;
+}
+
+void* me::pipeline::PipelineCompiler::thread_main(void* ptr)
+{
+  PipelineCompiler* compiler = static_cast<PipelineCompiler*>(ptr);
+
+  pthread_mutex_lock(&compiler->mutex);
+  for (;;)
+  {
+    while (!compiler->stopping && compiler->first_build == nullptr)
+      pthread_cond_wait(&compiler->queue_cond, &compiler->mutex);
+    if (compiler->first_build == nullptr)
+      break;
+
+    PipelineBuild_T* build = compiler->first_build;
+    compiler->first_build = build->next_build;
+    if (compiler->first_build == nullptr)
+      compiler->last_build = nullptr;
+    pthread_mutex_unlock(&compiler->mutex);
+
+    /* a failed build must not take the thread down, the owner sees 'PIPELINE_BUILD_STATUS_FAILED' instead */
+    Pipeline pipeline = nullptr;
+    PipelineBuildStatus status = PIPELINE_BUILD_STATUS_READY;
+    try
+    {
+      compiler->renderer->create_pipeline(build->pipeline_create_info, pipeline);
+    }catch (...)
+    {
+      status = PIPELINE_BUILD_STATUS_FAILED;
+    }
+
+    pthread_mutex_lock(&compiler->mutex);
+    build->pipeline = pipeline;
+    build->status = status;
+    pthread_cond_broadcast(&compiler->done_cond);
+  }
+  pthread_mutex_unlock(&compiler->mutex);
+  return nullptr;
+}
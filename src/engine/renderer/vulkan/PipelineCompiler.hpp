@@ -0,0 +1,70 @@
+#ifndef ME_VULKAN_PIPELINE_COMPILER_HPP
+  #define ME_VULKAN_PIPELINE_COMPILER_HPP
+
+#include "../Types.hpp"
+
+#include <pthread.h>
+
+namespace me {
+
+  class RendererModule;
+
+  struct PipelineBuild_T;
+
+}
+
+namespace me::pipeline {
+
+  /* background threads that create the pipelines of 'create_pipeline_async' in the order they were submitted.
+   * the render thread only takes the lock to queue a build or look at its status, never while a pipeline compiles */
+  class PipelineCompiler {
+
+  public:
+
+    static constexpr uint32_t MAX_THREADS = 8;
+
+  protected:
+
+    RendererModule* renderer;
+    uint32_t thread_count;
+    pthread_t threads[MAX_THREADS];
+
+    pthread_mutex_t mutex;
+    pthread_cond_t queue_cond;
+    pthread_cond_t done_cond;
+
+    PipelineBuild_T* first_build; /* queued builds, linked through 'PipelineBuild_T::next_build' */
+    PipelineBuild_T* last_build;
+    bool stopping;
+
+  public:
+
+    PipelineCompiler(RendererModule* renderer, uint32_t thread_count);
+
+    int initialize();
+
+    /* builds that are still queued are compiled before the threads stop */
+    int cleanup();
+
+    /* the build must stay alive until it isn't 'PIPELINE_BUILD_STATUS_PENDING' anymore */
+    int submit(
+	PipelineBuild_T* 				build
+	);
+
+    PipelineBuildStatus get_status(
+	const PipelineBuild_T* 				build
+	);
+
+    int wait(
+	const PipelineBuild_T* 				build
+	);
+
+  protected:
+
+    static void* thread_main(void* ptr);
+
+  };
+
+}
+
+#endif
@@ -24,6 +24,9 @@ int me::Vulkan::create_queue(const QueueCreateInfo &queue_create_info, Queue &qu
   else if (queue_create_info.queue_type == QUEUE_TRANSFER_TYPE)
     vk_queue_index = transfer_queue_index;
 
+  if (vk_queue_index == UINT32_MAX)
+    throw exception("in 'create_queue()' the device has no queue of that type, devices without a surface have no present queue");
+
   vkGetDeviceQueue(vk_device, vk_queue_index, 0, &vk_queue);
   queue = alloc.allocate<Queue_T>(vk_queue, vk_queue_index);
   return 0;
@@ -0,0 +1,203 @@
+#include "Vulkan.hpp"
+#include "Util.hpp"
+
+static bool is_slot_complete(
+    VkDevice 					device,
+    const me::ReadbackRing_T::Slot 		&slot
+    );
+
+
+int me::Vulkan::create_readback_ring(const ReadbackRingCreateInfo &readback_ring_create_info, ReadbackRing &readback_ring)
+{
+  VERIFY_CREATE_INFO(readback_ring_create_info, STRUCTURE_TYPE_READBACK_RING_CREATE_INFO);
+
+  VkDevice vk_device = reinterpret_cast<Device_T*>(readback_ring_create_info.device)->vk_device;
+  memory::DeviceAllocator* memory_allocator = reinterpret_cast<Device_T*>(readback_ring_create_info.device)->memory_allocator;
+
+  VkFormat vk_format = util::get_vulkan_format(readback_ring_create_info.format);
+  uint32_t texel_size = util::get_vulkan_format_size(vk_format);
+  if (texel_size == 0)
+    throw exception("in 'create_readback_ring()' the format can't be read back");
+
+  /* the host reads every byte, cached memory is much faster to read where there is one */
+  VkMemoryPropertyFlags vk_memory_property_flags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+  if (memory_allocator->has_memory_type(UINT32_MAX, vk_memory_property_flags | VK_MEMORY_PROPERTY_HOST_CACHED_BIT))
+    vk_memory_property_flags |= VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+
+  ReadbackRing_T* ring = alloc.allocate<ReadbackRing_T>();
+  ring->vk_device = vk_device;
+  ring->vk_format = vk_format;
+  ring->vk_extent = {readback_ring_create_info.size[0], readback_ring_create_info.size[1]};
+  ring->slot_size = static_cast<VkDeviceSize>(texel_size) * ring->vk_extent.width * ring->vk_extent.height;
+  ring->first = 0;
+  ring->count = 0;
+  ring->dropped_count = 0;
+
+  ring->slots.resize(readback_ring_create_info.slot_count > 0 ? readback_ring_create_info.slot_count : 1);
+  for (ReadbackRing_T::Slot &slot : ring->slots)
+  {
+    memory::create_buffer(*memory_allocator, vk_device, ring->slot_size,
+	VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_SHARING_MODE_EXCLUSIVE, vk_memory_property_flags, slot.vk_buffer, slot.allocation);
+    memory_allocator->map(slot.allocation, slot.data);
+    slot.frame = nullptr;
+    slot.submit_count = 0;
+    slot.tag = 0;
+  }
+
+  readback_ring = ring;
+  return 0;
+}
+
+int me::Vulkan::cleanup_readback_ring(Device device, ReadbackRing readback_ring)
+{
+  VkDevice vk_device = reinterpret_cast<Device_T*>(device)->vk_device;
+  memory::DeviceAllocator* memory_allocator = reinterpret_cast<Device_T*>(device)->memory_allocator;
+  ReadbackRing_T* ring = reinterpret_cast<ReadbackRing_T*>(readback_ring);
+
+  /* a copy that was recorded but never submitted has nothing to wait for */
+  for (uint32_t i = 0; i < ring->count; i++)
+  {
+    ReadbackRing_T::Slot &slot = ring->slots[(ring->first + i) % ring->slots.size()];
+    if (slot.frame->submit_count > slot.submit_count)
+      vkWaitForFences(vk_device, 1, &slot.frame->vk_in_flight_fence, VK_TRUE, UINT64_MAX);
+  }
+
+  for (ReadbackRing_T::Slot &slot : ring->slots)
+    memory::destroy_buffer(*memory_allocator, vk_device, slot.vk_buffer, slot.allocation);
+  alloc.deallocate(ring);
+  return 0;
+}
+
+int me::Vulkan::readback_ring_acquire(ReadbackRing readback_ring, Readback &readback, bool &available)
+{
+  ReadbackRing_T* ring = reinterpret_cast<ReadbackRing_T*>(readback_ring);
+
+  available = ring->count > 0 && is_slot_complete(ring->vk_device, ring->slots[ring->first]);
+  if (!available)
+    return 0;
+
+  const ReadbackRing_T::Slot &slot = ring->slots[ring->first];
+  readback.data = slot.data;
+  readback.size = ring->slot_size;
+  readback.extent = {ring->vk_extent.width, ring->vk_extent.height};
+  readback.tag = slot.tag;
+  readback.dropped_count = ring->dropped_count;
+  ring->dropped_count = 0;
+  return 0;
+}
+
+int me::Vulkan::readback_ring_release(ReadbackRing readback_ring)
+{
+  ReadbackRing_T* ring = reinterpret_cast<ReadbackRing_T*>(readback_ring);
+
+  if (ring->count == 0)
+    throw exception("in 'readback_ring_release()' the ring has no copy to release");
+
+  ring->slots[ring->first].frame = nullptr;
+  ring->first = (ring->first + 1) % ring->slots.size();
+  ring->count--;
+  return 0;
+}
+
+int me::Vulkan::cmd_readback(const CmdReadbackInfo &cmd_readback_info, CommandBuffer command_buffer)
+{
+  VkCommandBuffer vk_command_buffer = reinterpret_cast<CommandBuffer_T*>(command_buffer)->vk_command_buffer;
+  ReadbackRing_T* ring = reinterpret_cast<ReadbackRing_T*>(cmd_readback_info.readback_ring);
+  Attachment_T* attachment = reinterpret_cast<Attachment_T*>(cmd_readback_info.attachment);
+  Frame_T* frame = reinterpret_cast<Frame_T*>(cmd_readback_info.frame);
+
+  if (attachment->transient)
+    throw exception("in 'cmd_readback()' 'Attachment[%p]' is transient, its contents never leave the render pass", cmd_readback_info.attachment);
+  if (attachment->vk_format != ring->vk_format || attachment->vk_samples != VK_SAMPLE_COUNT_1_BIT)
+    throw exception("in 'cmd_readback()' 'Attachment[%p]' must have the format of the ring and a single sample", cmd_readback_info.attachment);
+
+  if (ring->count == ring->slots.size())
+  {
+    ring->dropped_count++;
+    return 0;
+  }
+
+  ReadbackRing_T::Slot &slot = ring->slots[(ring->first + ring->count) % ring->slots.size()];
+  slot.frame = frame;
+  slot.submit_count = frame->submit_count;
+  slot.tag = cmd_readback_info.tag;
+  ring->count++;
+
+  /* attachments are left in these layouts by 'create_render_pass' */
+  bool depth = attachment->attachment_type == ATTACHMENT_TYPE_DEPTH;
+  VkImageLayout vk_layout = depth ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+  VkPipelineStageFlags vk_attachment_stages = depth ? VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT
+    : VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+  VkAccessFlags vk_attachment_access = depth ? VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT
+    : VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_SHADER_READ_BIT;
+
+  VkImageMemoryBarrier image_memory_barrier = { };
+  image_memory_barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+  image_memory_barrier.pNext = nullptr;
+  image_memory_barrier.srcAccessMask = vk_attachment_access;
+  image_memory_barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+  image_memory_barrier.oldLayout = vk_layout;
+  image_memory_barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+  image_memory_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  image_memory_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  image_memory_barrier.image = attachment->vk_image;
+  image_memory_barrier.subresourceRange.aspectMask = depth ? VK_IMAGE_ASPECT_DEPTH_BIT : VK_IMAGE_ASPECT_COLOR_BIT;
+  image_memory_barrier.subresourceRange.baseMipLevel = 0;
+  image_memory_barrier.subresourceRange.levelCount = 1;
+  image_memory_barrier.subresourceRange.baseArrayLayer = 0;
+  image_memory_barrier.subresourceRange.layerCount = 1;
+  vkCmdPipelineBarrier(vk_command_buffer, vk_attachment_stages, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+      0, nullptr, 0, nullptr, 1, &image_memory_barrier);
+
+  VkBufferImageCopy buffer_image_copy = { };
+  buffer_image_copy.bufferOffset = 0;
+  buffer_image_copy.bufferRowLength = 0;
+  buffer_image_copy.bufferImageHeight = 0;
+  buffer_image_copy.imageSubresource.aspectMask = image_memory_barrier.subresourceRange.aspectMask;
+  buffer_image_copy.imageSubresource.mipLevel = 0;
+  buffer_image_copy.imageSubresource.baseArrayLayer = 0;
+  buffer_image_copy.imageSubresource.layerCount = 1;
+  buffer_image_copy.imageOffset = {0, 0, 0};
+  buffer_image_copy.imageExtent = {ring->vk_extent.width, ring->vk_extent.height, 1};
+  vkCmdCopyImageToBuffer(vk_command_buffer, attachment->vk_image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, slot.vk_buffer, 1, &buffer_image_copy);
+
+  /* the next render pass writing the attachment waits for the copy */
+  image_memory_barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+  image_memory_barrier.dstAccessMask = vk_attachment_access;
+  image_memory_barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+  image_memory_barrier.newLayout = vk_layout;
+
+  VkBufferMemoryBarrier buffer_memory_barrier = { };
+  buffer_memory_barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+  buffer_memory_barrier.pNext = nullptr;
+  buffer_memory_barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  buffer_memory_barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+  buffer_memory_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  buffer_memory_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  buffer_memory_barrier.buffer = slot.vk_buffer;
+  buffer_memory_barrier.offset = 0;
+  buffer_memory_barrier.size = VK_WHOLE_SIZE;
+
+  vkCmdPipelineBarrier(vk_command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, vk_attachment_stages, 0,
+      0, nullptr, 0, nullptr, 1, &image_memory_barrier);
+  vkCmdPipelineBarrier(vk_command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0,
+      0, nullptr, 1, &buffer_memory_barrier, 0, nullptr);
+  return 0;
+}
+
+
+bool is_slot_complete(
+    VkDevice 					device,
+    const me::ReadbackRing_T::Slot 		&slot
+    )
+{
+  /* until the frame is submitted its fence still belongs to an older submit.
+   * after that a signaled fence means this submit or a later one has finished, queues finish submits in order */
+  if (slot.frame->submit_count <= slot.submit_count)
+    return false;
+
+  VkResult result = vkGetFenceStatus(device, slot.frame->vk_in_flight_fence);
+  if (result != VK_SUCCESS && result != VK_NOT_READY)
+    throw me::exception("failed to get readback fence status [%s]", me::util::get_result_string(result));
+  return result == VK_SUCCESS;
+}
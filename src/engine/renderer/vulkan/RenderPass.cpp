@@ -6,35 +6,132 @@ int me::Vulkan::create_render_pass(const RenderPassCreateInfo &render_pass_creat
   VERIFY_CREATE_INFO(render_pass_create_info, STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO);
 
   VkDevice vk_device = reinterpret_cast<Device_T*>(render_pass_create_info.device)->vk_device;
-  VkFormat vk_image_format = reinterpret_cast<Swapchain_T*>(render_pass_create_info.swapchain)->vk_image_format;
-  
+
+  /* attachment 0 is the swapchain image, the others follow in the order they are given.
+   * offscreen render passes have no swapchain image, they render into the attachments only */
+  uint32_t swapchain_image_count = render_pass_create_info.swapchain != nullptr ? 1 : 0;
+  uint32_t attachment_description_count = swapchain_image_count + render_pass_create_info.attachment_count;
+  if (attachment_description_count == 0)
+    throw exception("in 'create_render_pass()' an offscreen render pass needs at least one attachment");
+
+  VkAttachmentDescription attachment_descriptions[attachment_description_count];
+  if (swapchain_image_count > 0)
+  {
+    attachment_descriptions[0].flags = 0;
+    attachment_descriptions[0].format = reinterpret_cast<Swapchain_T*>(render_pass_create_info.swapchain)->vk_image_format;
+    attachment_descriptions[0].samples = VK_SAMPLE_COUNT_1_BIT;
+    attachment_descriptions[0].loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    attachment_descriptions[0].storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+    attachment_descriptions[0].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    attachment_descriptions[0].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    attachment_descriptions[0].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    attachment_descriptions[0].finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+  }
+
+  uint32_t color_attachment_reference_count = 0;
+  VkAttachmentReference color_attachment_references[attachment_description_count];
+  VkAttachmentReference resolve_attachment_references[attachment_description_count];
+  VkAttachmentReference depth_attachment_reference;
+  uint32_t depth_attachment = UINT32_MAX;
+  VkSampleCountFlagBits vk_samples = VK_SAMPLE_COUNT_1_BIT;
+  bool aliased = false;
+
+  for (uint32_t i = 0; i < render_pass_create_info.attachment_count; i++)
+  {
+    Attachment_T* attachment = reinterpret_cast<Attachment_T*>(render_pass_create_info.attachments[i]);
+    uint32_t index = swapchain_image_count + i;
+
+    if (i > 0 && attachment->vk_samples != vk_samples)
+      throw exception("in 'create_render_pass()' all attachments must have the same sample count");
+    vk_samples = attachment->vk_samples;
+
+    if (render_pass_create_info.pass_index < attachment->first_pass || render_pass_create_info.pass_index > attachment->last_pass)
+      throw exception("in 'create_render_pass()' attachment %u isn't used by pass %u, it is used by passes %u to \e[33m%u\e[0m",
+	  i, render_pass_create_info.pass_index, attachment->first_pass, attachment->last_pass);
+    aliased |= attachment->memory->reference_count > 1;
+
+    /* the contents of transient attachments never leave the render pass, so they are never stored */
+    attachment_descriptions[index].flags = 0;
+    attachment_descriptions[index].format = attachment->vk_format;
+    attachment_descriptions[index].samples = attachment->vk_samples;
+    attachment_descriptions[index].loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    attachment_descriptions[index].storeOp = attachment->transient ? VK_ATTACHMENT_STORE_OP_DONT_CARE : VK_ATTACHMENT_STORE_OP_STORE;
+    attachment_descriptions[index].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    attachment_descriptions[index].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    attachment_descriptions[index].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    if (attachment->attachment_type == ATTACHMENT_TYPE_DEPTH)
+    {
+      if (depth_attachment != UINT32_MAX)
+	throw exception("in 'create_render_pass()' only one attachment can be 'ATTACHMENT_TYPE_DEPTH'");
+
+      attachment_descriptions[index].finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+      depth_attachment_reference.attachment = index;
+      depth_attachment_reference.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+      depth_attachment = index;
+    }else
+    {
+      attachment_descriptions[index].finalLayout = attachment->transient ? VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+      color_attachment_references[swapchain_image_count + color_attachment_reference_count].attachment = index;
+      color_attachment_references[swapchain_image_count + color_attachment_reference_count].layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+      color_attachment_reference_count++;
+    }
+  }
+
+  /* with multisampled attachments the swapchain image is the resolve target of the first color attachment */
+  bool resolve = vk_samples != VK_SAMPLE_COUNT_1_BIT;
+  if (resolve)
+  {
+    if (swapchain_image_count == 0)
+      throw exception("in 'create_render_pass()' multisampled attachments need a swapchain image to resolve into");
+    if (color_attachment_reference_count == 0)
+      throw exception("in 'create_render_pass()' multisampled attachments need a color attachment to resolve into the swapchain image");
+
+    for (uint32_t i = 0; i < color_attachment_reference_count; i++)
+    {
+      color_attachment_references[i] = color_attachment_references[i + 1];
+      resolve_attachment_references[i].attachment = VK_ATTACHMENT_UNUSED;
+      resolve_attachment_references[i].layout = VK_IMAGE_LAYOUT_UNDEFINED;
+    }
+    resolve_attachment_references[0].attachment = 0;
+    resolve_attachment_references[0].layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    attachment_descriptions[0].loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+  }else if (swapchain_image_count > 0)
+  {
+    color_attachment_references[0].attachment = 0;
+    color_attachment_references[0].layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    color_attachment_reference_count++;
+  }
+
+  VkPipelineStageFlags vk_stage_mask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+  VkAccessFlags vk_access_mask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+  if (depth_attachment != UINT32_MAX)
+  {
+    vk_stage_mask |= VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+    vk_access_mask |= VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+  }
+
+  /* aliased attachments are written by an earlier pass of the frame, so the wait covers their writes too.
+   * the memory may have been a color attachment there and a depth attachment here or the other way around */
+  VkPipelineStageFlags vk_src_stage_mask = vk_stage_mask;
+  VkAccessFlags vk_src_access_mask = vk_access_mask;
+  if (aliased)
+  {
+    vk_src_stage_mask |= VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+    vk_src_access_mask |= VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+  }
+
   uint32_t subpass_dependency_count = 1;
   VkSubpassDependency subpass_dependencies[subpass_dependency_count];
   subpass_dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
   subpass_dependencies[0].dstSubpass = 0;
-  subpass_dependencies[0].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-  subpass_dependencies[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-  subpass_dependencies[0].srcAccessMask = 0;
-  subpass_dependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+  subpass_dependencies[0].srcStageMask = vk_src_stage_mask;
+  subpass_dependencies[0].dstStageMask = vk_stage_mask;
+  subpass_dependencies[0].srcAccessMask = render_pass_create_info.attachment_count > 0 ? vk_src_access_mask : 0;
+  /* offscreen attachments are copied by 'cmd_readback' after the pass, its barrier orders the copy before the next pass */
+  subpass_dependencies[0].dstAccessMask = vk_access_mask;
   subpass_dependencies[0].dependencyFlags = 0;
 
-  uint32_t color_attachment_description_count = 1;
-  VkAttachmentDescription color_attachment_descriptions[color_attachment_description_count];
-  color_attachment_descriptions[0].flags = 0;
-  color_attachment_descriptions[0].format = vk_image_format;
-  color_attachment_descriptions[0].samples = VK_SAMPLE_COUNT_1_BIT;
-  color_attachment_descriptions[0].loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-  color_attachment_descriptions[0].storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-  color_attachment_descriptions[0].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-  color_attachment_descriptions[0].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-  color_attachment_descriptions[0].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-  color_attachment_descriptions[0].finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
-
-  uint32_t color_attachment_reference_count = 1;
-  VkAttachmentReference color_attachment_references[color_attachment_reference_count];
-  color_attachment_references[0].attachment = 0;
-  color_attachment_references[0].layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-
   uint32_t subpass_description_count = 1;
   VkSubpassDescription vk_subpass_descriptions[subpass_description_count];
   vk_subpass_descriptions[0].flags = 0;
@@ -43,8 +140,8 @@ int me::Vulkan::create_render_pass(const RenderPassCreateInfo &render_pass_creat
   vk_subpass_descriptions[0].pInputAttachments = nullptr;
   vk_subpass_descriptions[0].colorAttachmentCount = color_attachment_reference_count;
   vk_subpass_descriptions[0].pColorAttachments = color_attachment_references;
-  vk_subpass_descriptions[0].pResolveAttachments = nullptr;
-  vk_subpass_descriptions[0].pDepthStencilAttachment = nullptr;
+  vk_subpass_descriptions[0].pResolveAttachments = resolve ? resolve_attachment_references : nullptr;
+  vk_subpass_descriptions[0].pDepthStencilAttachment = depth_attachment != UINT32_MAX ? &depth_attachment_reference : nullptr;
   vk_subpass_descriptions[0].preserveAttachmentCount = 0;
   vk_subpass_descriptions[0].pPreserveAttachments = nullptr;
 
@@ -52,8 +149,8 @@ int me::Vulkan::create_render_pass(const RenderPassCreateInfo &render_pass_creat
   vk_render_pass_create_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
   vk_render_pass_create_info.pNext = nullptr;
   vk_render_pass_create_info.flags = 0;
-  vk_render_pass_create_info.attachmentCount = color_attachment_description_count;
-  vk_render_pass_create_info.pAttachments = color_attachment_descriptions;
+  vk_render_pass_create_info.attachmentCount = attachment_description_count;
+  vk_render_pass_create_info.pAttachments = attachment_descriptions;
   vk_render_pass_create_info.subpassCount = subpass_description_count;
   vk_render_pass_create_info.pSubpasses = vk_subpass_descriptions;
   vk_render_pass_create_info.dependencyCount = subpass_dependency_count;
@@ -64,7 +161,24 @@ int me::Vulkan::create_render_pass(const RenderPassCreateInfo &render_pass_creat
   if (result != VK_SUCCESS)
     throw exception("failed to create render pass [%s]", util::get_result_string(result));
 
-  render_pass = alloc.allocate<RenderPass_T>(vk_render_pass);
+  /* pipelines can be used with every compatible render pass, which only depends on the formats,
+   * sample counts and references of the attachments, not on load, store or layouts */
+  vector<char> compatibility_key;
+  for (uint32_t i = 0; i < attachment_description_count; i++)
+  {
+    pipeline::StateCache::append_key(compatibility_key, attachment_descriptions[i].format);
+    pipeline::StateCache::append_key(compatibility_key, attachment_descriptions[i].samples);
+  }
+  for (uint32_t i = 0; i < color_attachment_reference_count; i++)
+  {
+    pipeline::StateCache::append_key(compatibility_key, color_attachment_references[i].attachment);
+    pipeline::StateCache::append_key(compatibility_key, resolve ? resolve_attachment_references[i].attachment : VK_ATTACHMENT_UNUSED);
+  }
+  pipeline::StateCache::append_key(compatibility_key, depth_attachment);
+  uint64_t compatibility_hash = pipeline::StateCache::hash(compatibility_key.data(), compatibility_key.size());
+
+  render_pass = alloc.allocate<RenderPass_T>(vk_render_pass, attachment_description_count, color_attachment_reference_count, depth_attachment,
+      compatibility_hash);
   return 0;
 }
 
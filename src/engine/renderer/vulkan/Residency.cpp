@@ -0,0 +1,342 @@
+#include "Residency.hpp"
+#include "Util.hpp"
+
+#include "../../scene/Mesh.hpp"
+
+#include <lme/math/math.hpp>
+
+me::memory::ResidencyManager::ResidencyManager(DeviceAllocator &device_allocator, GeometryPool &geometry_pool, Uploader &uploader,
+    uint32_t frame_count)
+  : device_allocator(device_allocator), geometry_pool(geometry_pool), uploader(uploader), frame_count(frame_count > 0 ? frame_count : 1)
+{
+  frame = frame_count;
+  budget_limit = 0;
+  resident_bytes = 0;
+  update_budget();
+}
+
+int me::memory::ResidencyManager::add(
+    Mesh* 						mesh
+    )
+{
+  mesh->resident = false;
+  mesh->last_used_frame = 0;
+  mesh->residency_index = meshes.size();
+  meshes.push_back(mesh);
+  return 0;
+}
+
+int me::memory::ResidencyManager::remove(
+    Mesh* 						mesh
+    )
+{
+  if (mesh->resident)
+  {
+    /* a frame in flight may still draw it */
+    if (mesh->last_used_frame + frame_count > frame)
+    {
+      pending_frees.push_back({mesh->vertex_offset, mesh->vertex_count, mesh->first_index, mesh->index_count,
+	mesh->last_used_frame + frame_count});
+      resident_bytes -= get_mesh_size(mesh);
+      mesh->resident = false;
+    }else
+      evict(mesh);
+  }
+
+  /* swap with the last mesh */
+  Mesh* last = meshes[meshes.size() - 1];
+  meshes[mesh->residency_index] = last;
+  last->residency_index = mesh->residency_index;
+  meshes.resize(meshes.size() - 1);
+  return 0;
+}
+
+int me::memory::ResidencyManager::make_resident(
+    uint32_t 						mesh_count,
+    Mesh** 						meshes
+    )
+{
+  stream_in(mesh_count, meshes);
+  return 0;
+}
+
+int me::memory::ResidencyManager::prefetch(
+    uint32_t 						mesh_count,
+    Mesh** 						meshes
+    )
+{
+  VkDeviceSize bytes = resident_bytes;
+  uint32_t count = 0;
+  while (count < mesh_count)
+  {
+    const Mesh* mesh = meshes[count];
+    VkDeviceSize mesh_size = mesh->vertices.size() * geometry_pool.get_vertex_stride() + mesh->indices.size() * geometry_pool.get_index_stride();
+    if (!mesh->resident && bytes + mesh_size > budget)
+      break;
+
+    if (!mesh->resident)
+      bytes += mesh_size;
+    count++;
+  }
+
+  stream_in(count, meshes);
+  return 0;
+}
+
+int me::memory::ResidencyManager::stream_in(uint32_t mesh_count, Mesh** meshes)
+{
+  vector<Uploader::UploadInfo> vertex_uploads;
+  vector<Uploader::UploadInfo> index_uploads;
+
+  for (uint32_t i = 0; i < mesh_count; i++)
+  {
+    Mesh* mesh = meshes[i];
+    mesh->last_used_frame = frame;
+    if (mesh->resident)
+      continue;
+
+    mesh->vertex_count = mesh->vertices.size();
+    mesh->index_count = mesh->indices.size();
+    VkDeviceSize mesh_size = get_mesh_size(mesh);
+
+    /* evict until the mesh fits in the budget, if the rest is in use it goes over it for now */
+    while (resident_bytes + mesh_size > budget)
+    {
+      if (!evict_oldest())
+	break;
+    }
+
+    /* a full pool grows while the budget allows it, otherwise more meshes are evicted */
+    while (!geometry_pool.allocate(mesh->vertex_count, mesh->index_count, mesh->vertex_offset, mesh->first_index))
+    {
+      /* they are for the current buffers, so they are recorded before the pool moves */
+      record_uploads(vertex_uploads, index_uploads);
+
+      if (!grow(mesh->vertex_count, mesh->index_count) && !evict_oldest())
+	throw exception("geometry pool is full. mesh '%s' with %u vertices and %u indices doesn't fit in the residency budget of %lu bytes",
+	    mesh->identifier.c_str(), mesh->vertex_count, mesh->index_count, budget);
+    }
+
+    mesh->resident = true;
+    resident_bytes += mesh_size;
+
+    if (mesh->vertex_count > 0)
+      vertex_uploads.push_back({geometry_pool.get_vertex_buffer(), mesh->vertex_offset * geometry_pool.get_vertex_stride(),
+	mesh->vertices.data(), mesh->vertex_count * geometry_pool.get_vertex_stride()});
+    if (mesh->index_count > 0)
+      index_uploads.push_back({geometry_pool.get_index_buffer(), mesh->first_index * geometry_pool.get_index_stride(),
+	mesh->indices.data(), mesh->index_count * geometry_pool.get_index_stride()});
+  }
+
+  record_uploads(vertex_uploads, index_uploads);
+  return 0;
+}
+
+int me::memory::ResidencyManager::record_uploads(vector<Uploader::UploadInfo> &vertex_uploads, vector<Uploader::UploadInfo> &index_uploads)
+{
+  /* vertex uploads first and index uploads after, so each becomes one multi-region copy */
+  for (const Uploader::UploadInfo &upload : index_uploads)
+    vertex_uploads.push_back(upload);
+
+  if (vertex_uploads.size() > 0)
+    uploader.upload_batch(vertex_uploads.size(), vertex_uploads.data());
+
+  vertex_uploads.resize(0);
+  index_uploads.resize(0);
+  return 0;
+}
+
+int me::memory::ResidencyManager::begin_frame()
+{
+  frame++;
+
+  /* the frames that could still read them have finished */
+  size_t index = 0;
+  while (index < pending_frees.size())
+  {
+    const PendingFree &pending_free = pending_frees[index];
+    if (pending_free.frame > frame)
+    {
+      index++;
+      continue;
+    }
+
+    geometry_pool.free(pending_free.vertex_offset, pending_free.vertex_count, pending_free.first_index, pending_free.index_count);
+    pending_frees[index] = pending_frees[pending_frees.size() - 1];
+    pending_frees.resize(pending_frees.size() - 1);
+  }
+  geometry_pool.release_retired(frame);
+
+  update_budget();
+
+  /* over the budget, meshes are evicted until the rest fits in half of it, so the pool can shrink and doesn't grow again right away */
+  if (geometry_pool.get_capacity_bytes(geometry_pool.get_vertex_capacity(), geometry_pool.get_index_capacity()) > budget)
+  {
+    while (resident_bytes > budget / 2)
+    {
+      if (!evict_oldest())
+	break;
+    }
+  }
+
+  shrink();
+  return 0;
+}
+
+bool me::memory::ResidencyManager::compact(
+    VkDeviceSize 					byte_budget
+    )
+{
+  if (resident_bytes == 0 || resident_bytes > byte_budget || !geometry_pool.is_fragmented())
+    return false;
+
+  relocate(geometry_pool.get_vertex_capacity(), geometry_pool.get_index_capacity());
+  return true;
+}
+
+int me::memory::ResidencyManager::set_budget(
+    VkDeviceSize 					bytes
+    )
+{
+  budget_limit = bytes;
+  update_budget();
+  return 0;
+}
+
+int me::memory::ResidencyManager::update_budget()
+{
+  HeapBudget heap_budgets[device_allocator.get_heap_count()];
+  device_allocator.get_heap_budgets(heap_budgets);
+  const HeapBudget &heap_budget = heap_budgets[geometry_pool.get_heap_index()];
+
+  /* the pool may use what the rest of the process leaves of the heap's budget */
+  VkDeviceSize pool_bytes = geometry_pool.get_allocated_bytes();
+  VkDeviceSize other_bytes = heap_budget.usage > pool_bytes ? heap_budget.usage - pool_bytes : 0;
+  budget = heap_budget.budget > other_bytes ? heap_budget.budget - other_bytes : 0;
+
+  if (budget_limit > 0)
+    budget = math::min(budget, budget_limit);
+  return 0;
+}
+
+VkDeviceSize me::memory::ResidencyManager::get_mesh_size(const Mesh* mesh) const
+{
+  return mesh->vertex_count * geometry_pool.get_vertex_stride() + mesh->index_count * geometry_pool.get_index_stride();
+}
+
+bool me::memory::ResidencyManager::evict_oldest()
+{
+  Mesh* oldest = nullptr;
+  for (Mesh* mesh : meshes)
+  {
+    /* may still be read by a frame in flight */
+    if (!mesh->resident || mesh->last_used_frame + frame_count > frame)
+      continue;
+
+    if (oldest == nullptr || mesh->last_used_frame < oldest->last_used_frame)
+      oldest = mesh;
+  }
+
+  if (oldest == nullptr)
+    return false;
+
+  evict(oldest);
+  return true;
+}
+
+int me::memory::ResidencyManager::evict(Mesh* mesh)
+{
+  geometry_pool.free(mesh->vertex_offset, mesh->vertex_count, mesh->first_index, mesh->index_count);
+  resident_bytes -= get_mesh_size(mesh);
+  mesh->resident = false;
+  return 0;
+}
+
+bool me::memory::ResidencyManager::grow(uint32_t vertex_count, uint32_t index_count)
+{
+  /* relocating packs the meshes, so a fragmented pool may already be large enough */
+  uint64_t vertex_needed = static_cast<uint64_t>(geometry_pool.get_vertex_used()) + vertex_count;
+  uint64_t index_needed = static_cast<uint64_t>(geometry_pool.get_index_used()) + index_count;
+
+  uint64_t vertex_capacity = geometry_pool.get_vertex_capacity();
+  while (vertex_capacity < vertex_needed)
+    vertex_capacity *= 2;
+
+  uint64_t index_capacity = geometry_pool.get_index_capacity();
+  while (index_capacity < index_needed)
+    index_capacity *= 2;
+
+  if (vertex_capacity > UINT32_MAX || index_capacity > UINT32_MAX ||
+      geometry_pool.get_capacity_bytes(vertex_capacity, index_capacity) > budget)
+    return false;
+
+  relocate(static_cast<uint32_t>(vertex_capacity), static_cast<uint32_t>(index_capacity));
+  return true;
+}
+
+int me::memory::ResidencyManager::shrink()
+{
+  uint32_t vertex_capacity = geometry_pool.get_vertex_capacity();
+  uint32_t index_capacity = geometry_pool.get_index_capacity();
+  uint32_t vertex_used = geometry_pool.get_vertex_used();
+  uint32_t index_used = geometry_pool.get_index_used();
+
+  /* halves while a quarter is used, so the pool is still half empty afterwards */
+  while (vertex_capacity / 2 >= GeometryPool::MIN_VERTEX_CAPACITY && vertex_used <= vertex_capacity / 4)
+    vertex_capacity /= 2;
+  while (index_capacity / 2 >= GeometryPool::MIN_INDEX_CAPACITY && index_used <= index_capacity / 4)
+    index_capacity /= 2;
+
+  /* over the budget it shrinks as far as the resident meshes allow */
+  while (geometry_pool.get_capacity_bytes(vertex_capacity, index_capacity) > budget)
+  {
+    if (vertex_capacity / 2 >= GeometryPool::MIN_VERTEX_CAPACITY && vertex_used <= vertex_capacity / 2)
+      vertex_capacity /= 2;
+    else if (index_capacity / 2 >= GeometryPool::MIN_INDEX_CAPACITY && index_used <= index_capacity / 2)
+      index_capacity /= 2;
+    else
+      break;
+  }
+
+  if (vertex_capacity != geometry_pool.get_vertex_capacity() || index_capacity != geometry_pool.get_index_capacity())
+    relocate(vertex_capacity, index_capacity);
+  return 0;
+}
+
+int me::memory::ResidencyManager::relocate(uint32_t vertex_capacity, uint32_t index_capacity)
+{
+  VkDeviceSize vertex_stride = geometry_pool.get_vertex_stride();
+  VkDeviceSize index_stride = geometry_pool.get_index_stride();
+
+  /* frames recorded before this still draw from the old buffers */
+  VkBuffer old_vertex_buffer, old_index_buffer;
+  geometry_pool.resize(vertex_capacity, index_capacity, frame + frame_count, old_vertex_buffer, old_index_buffer);
+
+  /* the ranges of removed meshes stay behind in the old buffers */
+  pending_frees.resize(0);
+
+  vector<VkBufferCopy> vertex_copies;
+  vector<VkBufferCopy> index_copies;
+  for (Mesh* mesh : meshes)
+  {
+    if (!mesh->resident)
+      continue;
+
+    uint32_t vertex_offset, first_index;
+    if (!geometry_pool.allocate(mesh->vertex_count, mesh->index_count, vertex_offset, first_index))
+      throw exception("failed to relocate mesh '%s' into a geometry pool of %u vertices and %u indices",
+	  mesh->identifier.c_str(), vertex_capacity, index_capacity);
+
+    if (mesh->vertex_count > 0)
+      vertex_copies.push_back({mesh->vertex_offset * vertex_stride, vertex_offset * vertex_stride, mesh->vertex_count * vertex_stride});
+    if (mesh->index_count > 0)
+      index_copies.push_back({mesh->first_index * index_stride, first_index * index_stride, mesh->index_count * index_stride});
+
+    mesh->vertex_offset = vertex_offset;
+    mesh->first_index = first_index;
+  }
+
+  uploader.copy_regions(old_vertex_buffer, geometry_pool.get_vertex_buffer(), vertex_copies.size(), vertex_copies.data());
+  uploader.copy_regions(old_index_buffer, geometry_pool.get_index_buffer(), index_copies.size(), index_copies.data());
+  return 0;
+}
@@ -0,0 +1,130 @@
+#ifndef ME_VULKAN_RESIDENCY_HPP
+  #define ME_VULKAN_RESIDENCY_HPP
+
+#include "Geometry.hpp"
+#include "Upload.hpp"
+
+#include <lme/vector.hpp>
+
+#include <vulkan/vulkan.h>
+
+namespace me {
+
+  class Mesh;
+
+}
+
+namespace me::memory {
+
+  /* keeps the geometry of recently drawn meshes in the geometry pool.
+   * meshes are streamed in from their host copy before they are drawn and the
+   * least recently used ones are evicted when the budget is full.
+   * the pool grows while the budget allows it and shrinks again when evictions leave it mostly empty,
+   * so evicting gives device memory back to the heap.
+   * a mesh drawn in one of the last 'frame_count' frames is never evicted and its ranges are never reused.
+   * like the uploader it records into, it is only used from the thread that prepares the frames */
+  class ResidencyManager {
+
+  protected:
+
+    /* ranges of a removed mesh that a frame in flight may still read */
+    struct PendingFree {
+      uint32_t vertex_offset;
+      uint32_t vertex_count;
+      uint32_t first_index;
+      uint32_t index_count;
+      uint64_t frame; /* freed once this frame has been reached */
+    };
+
+    DeviceAllocator &device_allocator;
+    GeometryPool &geometry_pool;
+    Uploader &uploader;
+
+    uint32_t frame_count;
+    uint64_t frame;
+
+    VkDeviceSize budget; /* what the heap's budget leaves for the pool, capped by 'budget_limit' */
+    VkDeviceSize budget_limit; /* 0 without a limit */
+    VkDeviceSize resident_bytes;
+
+    vector<Mesh*> meshes;
+    vector<PendingFree> pending_frees;
+
+  public:
+
+    ResidencyManager(DeviceAllocator &device_allocator, GeometryPool &geometry_pool, Uploader &uploader, uint32_t frame_count);
+
+    /* registers the mesh without streaming it in */
+    int add(
+	Mesh* 						mesh
+	);
+
+    /* forgets the mesh, its ranges are reused once no frame in flight can draw it */
+    int remove(
+	Mesh* 						mesh
+	);
+
+    /* marks the meshes as used this frame and records uploads for the ones that aren't resident,
+     * the uploads are submitted on the next 'Uploader::flush' or 'Uploader::acquire'.
+     * must be called before the draws of the meshes are recorded */
+    int make_resident(
+	uint32_t 					mesh_count,
+	Mesh** 						meshes
+	);
+
+    /* like 'make_resident()' for the first meshes that fit in the budget without evicting anything,
+     * the others stay evicted until they are made resident */
+    int prefetch(
+	uint32_t 					mesh_count,
+	Mesh** 						meshes
+	);
+
+    /* releases what the finished frames used, updates the budget from the heap
+     * and evicts and shrinks until the pool fits in it */
+    int begin_frame();
+
+    /* packs the resident meshes into new buffers of the same size when the pool's free space is fragmented
+     * and the copy fits in 'byte_budget'. returns true if the pool moved */
+    bool compact(
+	VkDeviceSize 					byte_budget
+	);
+
+    /* caps the budget below what the heap allows, 0 removes the cap */
+    int set_budget(
+	VkDeviceSize 					bytes
+	);
+
+    VkDeviceSize get_budget() const
+    {
+      return budget;
+    }
+
+    VkDeviceSize get_resident_bytes() const
+    {
+      return resident_bytes;
+    }
+
+  protected:
+
+    int update_budget();
+    int stream_in(uint32_t mesh_count, Mesh** meshes);
+    int record_uploads(vector<Uploader::UploadInfo> &vertex_uploads, vector<Uploader::UploadInfo> &index_uploads);
+
+    VkDeviceSize get_mesh_size(const Mesh* mesh) const;
+
+    /* evicts the least recently used mesh, returns false if every resident mesh is still in use */
+    bool evict_oldest();
+    int evict(Mesh* mesh);
+
+    /* moves the pool into buffers that fit 'vertex_count' and 'index_count' more elements,
+     * returns false if they wouldn't fit in the budget */
+    bool grow(uint32_t vertex_count, uint32_t index_count);
+    int shrink();
+    /* copies the resident meshes into new buffers of the pool, packed from the start */
+    int relocate(uint32_t vertex_capacity, uint32_t index_capacity);
+
+  };
+
+}
+
+#endif
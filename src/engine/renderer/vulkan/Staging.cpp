@@ -0,0 +1,155 @@
+#include "Staging.hpp"
+#include "Util.hpp"
+
+me::memory::StagingRing::StagingRing(DeviceAllocator &device_allocator, VkDevice device, VkAllocationCallbacks* allocation, uint32_t frame_count)
+  : device_allocator(device_allocator), vk_device(device), vk_allocation(allocation)
+{
+  vk_buffer = VK_NULL_HANDLE;
+  mapped = nullptr;
+  size = FRAME_SIZE * (frame_count > 0 ? frame_count : 1);
+  write_position = 0;
+  read_position = 0;
+  submit_first = 0;
+  submit_count = 0;
+}
+
+int me::memory::StagingRing::initialize()
+{
+  create_buffer(device_allocator, vk_device, size,
+      VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_SHARING_MODE_EXCLUSIVE, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+      vk_buffer, allocation, true);
+
+  void* data;
+  device_allocator.map(allocation, data);
+  mapped = static_cast<char*>(data);
+
+  VkFenceCreateInfo fence_create_info = { };
+  fence_create_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+  fence_create_info.pNext = nullptr;
+  fence_create_info.flags = 0;
+
+  for (uint32_t i = 0; i < MAX_SUBMITS; i++)
+  {
+    VkResult result = vkCreateFence(vk_device, &fence_create_info, vk_allocation, &submits[i].vk_fence);
+    if (result != VK_SUCCESS)
+      throw exception("failed to create staging fence [%s]", util::get_result_string(result));
+    submits[i].end = 0;
+    submits[i].submitted = false;
+  }
+  return 0;
+}
+
+int me::memory::StagingRing::cleanup()
+{
+  /* a fence that was never submitted would never signal */
+  while (submit_count > 0 && submits[submit_first].submitted)
+    wait_oldest();
+
+  for (uint32_t i = 0; i < MAX_SUBMITS; i++)
+    vkDestroyFence(vk_device, submits[i].vk_fence, vk_allocation);
+
+  destroy_buffer(device_allocator, vk_device, vk_buffer, allocation);
+  return 0;
+}
+
+bool me::memory::StagingRing::reserve(
+    VkDeviceSize 					byte_count,
+    VkDeviceSize 					alignment,
+    VkDeviceSize 					&offset,
+    void* 						&data
+    )
+{
+  if (byte_count > size)
+    return false;
+
+  VkDeviceSize position = (write_position + alignment - 1) / alignment * alignment;
+
+  /* don't let a reservation wrap around the end of the buffer */
+  if (position % size + byte_count > size)
+    position += size - position % size;
+
+  reclaim();
+  while (position + byte_count - read_position > size)
+  {
+    /* everything in use is reserved but not submitted yet */
+    if (submit_count == 0 || !submits[submit_first].submitted)
+      return false;
+    wait_oldest();
+  }
+
+  write_position = position + byte_count;
+  offset = position % size;
+  data = mapped + offset;
+  return true;
+}
+
+int me::memory::StagingRing::submit(
+    VkFence 						&fence
+    )
+{
+  /* the last fence was handed out but never submitted, it still is unsignaled and covers the new space too */
+  if (submit_count > 0)
+  {
+    Submit &last = submits[(submit_first + submit_count - 1) % MAX_SUBMITS];
+    if (!last.submitted)
+    {
+      last.end = write_position;
+      fence = last.vk_fence;
+      return 0;
+    }
+  }
+
+  if (submit_count == MAX_SUBMITS)
+    wait_oldest();
+
+  Submit &submit = submits[(submit_first + submit_count) % MAX_SUBMITS];
+  VkResult result = vkResetFences(vk_device, 1, &submit.vk_fence);
+  if (result != VK_SUCCESS)
+    throw exception("failed to reset staging fence [%s]", util::get_result_string(result));
+  submit.end = write_position;
+  submit.submitted = false;
+  submit_count++;
+
+  fence = submit.vk_fence;
+  return 0;
+}
+
+int me::memory::StagingRing::mark_submitted()
+{
+  if (submit_count == 0)
+    throw exception("no staging submit to mark as submitted");
+
+  submits[(submit_first + submit_count - 1) % MAX_SUBMITS].submitted = true;
+  return 0;
+}
+
+int me::memory::StagingRing::reclaim()
+{
+  while (submit_count > 0)
+  {
+    Submit &submit = submits[submit_first];
+    if (!submit.submitted || vkGetFenceStatus(vk_device, submit.vk_fence) != VK_SUCCESS)
+      break;
+
+    read_position = submit.end;
+    submit_first = (submit_first + 1) % MAX_SUBMITS;
+    submit_count--;
+  }
+  return 0;
+}
+
+int me::memory::StagingRing::wait_oldest()
+{
+  Submit &submit = submits[submit_first];
+  if (!submit.submitted)
+    throw exception("staging fence was never submitted");
+
+  VkResult result = vkWaitForFences(vk_device, 1, &submit.vk_fence, VK_TRUE, UINT64_MAX);
+  if (result != VK_SUCCESS)
+    throw exception("failed to wait for staging fence [%s]", util::get_result_string(result));
+
+  read_position = submit.end;
+  submit_first = (submit_first + 1) % MAX_SUBMITS;
+  submit_count--;
+  return 0;
+}
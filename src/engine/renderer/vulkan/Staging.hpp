@@ -0,0 +1,88 @@
+#ifndef ME_VULKAN_STAGING_HPP
+  #define ME_VULKAN_STAGING_HPP
+
+#include "Memory.hpp"
+
+#include <vulkan/vulkan.h>
+
+namespace me::memory {
+
+  /* persistently mapped host visible buffer that uploads are written into at increasing offsets.
+   * every submit that reads from the ring takes a fence from 'submit()' and reports the queue submit
+   * with 'mark_submitted()', space before that submit is reclaimed once its fence has signaled */
+  class StagingRing {
+
+  public:
+
+    static constexpr VkDeviceSize FRAME_SIZE = 16 * 1024 * 1024;
+    static constexpr uint32_t MAX_SUBMITS = 64;
+
+  protected:
+
+    struct Submit {
+      VkFence vk_fence;
+      VkDeviceSize end;
+      bool submitted; /* false until the fence has been handed to a queue submit */
+    };
+
+    DeviceAllocator &device_allocator;
+    VkDevice vk_device;
+    VkAllocationCallbacks* vk_allocation;
+
+    VkBuffer vk_buffer;
+    Allocation allocation;
+    char* mapped;
+    VkDeviceSize size;
+
+    /* positions grow forever, the offset in the buffer is 'position % size' */
+    VkDeviceSize write_position;
+    VkDeviceSize read_position;
+
+    Submit submits[MAX_SUBMITS];
+    uint32_t submit_first;
+    uint32_t submit_count;
+
+  public:
+
+    StagingRing(DeviceAllocator &device_allocator, VkDevice device, VkAllocationCallbacks* allocation, uint32_t frame_count);
+
+    int initialize();
+    int cleanup();
+
+    /* reserves 'byte_count' bytes, waits for older submits if the ring is full.
+     * returns false if the ring can never fit 'byte_count' bytes */
+    bool reserve(
+	VkDeviceSize 					byte_count,
+	VkDeviceSize 					alignment,
+	VkDeviceSize 					&offset,
+	void* 						&data
+	);
+
+    /* returns the fence the next submit must signal,
+     * everything reserved before this call stays in use until the fence has signaled.
+     * until 'mark_submitted()' is called the fence is never waited for, calling 'submit()'
+     * again hands out the same fence and extends it over the newer reservations */
+    int submit(
+	VkFence 					&fence
+	);
+
+    /* the fence from the last 'submit()' has been passed to a queue submit */
+    int mark_submitted();
+
+    /* frees the space of all submits that have completed */
+    int reclaim();
+
+    VkBuffer get_buffer() const
+    {
+      return vk_buffer;
+    }
+
+  protected:
+
+    int wait_oldest();
+
+  };
+
+}
+
+#endif
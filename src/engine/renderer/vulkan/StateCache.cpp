@@ -0,0 +1,130 @@
+#include "StateCache.hpp"
+#include <string.h>
+
+me::pipeline::StateCache::StateCache()
+{
+  stats = { };
+}
+
+int me::pipeline::StateCache::cleanup()
+{
+  for (uint32_t i = 0; i < STATE_KIND_COUNT; i++)
+  {
+    for (Entry &entry : entries[i])
+      delete[] entry.key;
+    entries[i].resize(0);
+  }
+  pthread_mutex_destroy(&mutex);
+  return 0;
+}
+
+void* me::pipeline::StateCache::acquire(
+    StateKind 						kind,
+    const vector<char> 					&key
+    )
+{
+  uint64_t key_hash = hash(key.data(), key.size());
+
+  pthread_mutex_lock(&mutex);
+  Entry* entry = find(kind, key_hash, key);
+  void* object = nullptr;
+  if (entry != nullptr)
+  {
+    entry->references++;
+    object = entry->object;
+    stats.hits[kind]++;
+  }else
+    stats.misses[kind]++;
+  pthread_mutex_unlock(&mutex);
+  return object;
+}
+
+void* me::pipeline::StateCache::insert(
+    StateKind 						kind,
+    const vector<char> 					&key,
+    void* 						object
+    )
+{
+  uint64_t key_hash = hash(key.data(), key.size());
+
+  pthread_mutex_lock(&mutex);
+  Entry* entry = find(kind, key_hash, key);
+  if (entry != nullptr)
+  {
+    entry->references++;
+    object = entry->object;
+  }else
+  {
+    char* entry_key = new char[key.size()];
+    memcpy(entry_key, key.data(), key.size());
+    entries[kind].push_back({key_hash, entry_key, key.size(), object, 1});
+  }
+  pthread_mutex_unlock(&mutex);
+  return object;
+}
+
+bool me::pipeline::StateCache::release(
+    StateKind 						kind,
+    void* 						object
+    )
+{
+  bool last = false;
+
+  pthread_mutex_lock(&mutex);
+  vector<Entry> &kind_entries = entries[kind];
+  for (size_t i = 0; i < kind_entries.size(); i++)
+  {
+    if (kind_entries[i].object != object)
+      continue;
+
+    if (--kind_entries[i].references == 0)
+    {
+      delete[] kind_entries[i].key;
+      kind_entries[i] = kind_entries[kind_entries.size() - 1];
+      kind_entries.resize(kind_entries.size() - 1);
+      last = true;
+    }
+    break;
+  }
+  pthread_mutex_unlock(&mutex);
+  return last;
+}
+
+uint32_t me::pipeline::StateCache::get_object_count()
+{
+  pthread_mutex_lock(&mutex);
+  uint32_t object_count = 0;
+  for (uint32_t i = 0; i < STATE_KIND_COUNT; i++)
+    object_count += entries[i].size();
+  pthread_mutex_unlock(&mutex);
+  return object_count;
+}
+
+me::pipeline::StateCache::Stats me::pipeline::StateCache::get_stats()
+{
+  pthread_mutex_lock(&mutex);
+  Stats current_stats = stats;
+  pthread_mutex_unlock(&mutex);
+  return current_stats;
+}
+
+uint64_t me::pipeline::StateCache::hash(const char* data, size_t size)
+{
+  uint64_t value = 0xCBF29CE484222325ULL;
+  for (size_t i = 0; i < size; i++)
+  {
+    value ^= static_cast<uint8_t>(data[i]);
+    value *= 0x100000001B3ULL;
+  }
+  return value;
+}
+
+me::pipeline::StateCache::Entry* me::pipeline::StateCache::find(StateKind kind, uint64_t key_hash, const vector<char> &key)
+{
+  for (Entry &entry : entries[kind])
+  {
+    if (entry.hash == key_hash && entry.key_size == key.size() && memcmp(entry.key, key.data(), key.size()) == 0)
+      return &entry;
+  }
+  return nullptr;
+}
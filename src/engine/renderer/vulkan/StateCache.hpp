@@ -0,0 +1,98 @@
+#ifndef ME_VULKAN_STATE_CACHE_HPP
+  #define ME_VULKAN_STATE_CACHE_HPP
+
+#include "../Types.hpp"
+
+#include <lme/vector.hpp>
+
+#include <pthread.h>
+
+namespace me::pipeline {
+
+  enum StateKind {
+    STATE_KIND_DESCRIPTOR_SET_LAYOUT,
+    STATE_KIND_PIPELINE_LAYOUT,
+    STATE_KIND_PIPELINE,
+    STATE_KIND_COUNT
+  };
+
+  /* reference counted pipeline state, keyed by the bytes of a normalized create info.
+   * identical requests share one object, it is only destroyed when the last user releases it.
+   * the lock is only held for lookups, so pipelines can be created on several threads */
+  class StateCache {
+
+  public:
+
+    struct Stats {
+      uint32_t hits[STATE_KIND_COUNT];
+      uint32_t misses[STATE_KIND_COUNT];
+    };
+
+  protected:
+
+    struct Entry {
+      uint64_t hash;
+      char* key;
+      size_t key_size;
+      void* object;
+      uint32_t references;
+    };
+
+    pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+    vector<Entry> entries[STATE_KIND_COUNT]; /* few objects of every kind, scanned by hash */
+    Stats stats;
+
+  public:
+
+    StateCache();
+
+    /* forgets the entries, objects that weren't released are leaked */
+    int cleanup();
+
+    /* a new reference to the object with the key, nullptr if there is none yet */
+    void* acquire(
+	StateKind 					kind,
+	const vector<char> 				&key
+	);
+
+    /* adds an object created after 'acquire' missed. if another thread added one with the same key
+     * in the meantime, a reference to that one is returned and the caller destroys its own */
+    void* insert(
+	StateKind 					kind,
+	const vector<char> 				&key,
+	void* 						object
+	);
+
+    /* true if that was the last reference, the caller destroys the object then */
+    bool release(
+	StateKind 					kind,
+	void* 						object
+	);
+
+    /* objects of every kind that are still referenced */
+    uint32_t get_object_count();
+
+    Stats get_stats();
+
+    /* appends the bytes of a key field */
+    template<typename T>
+    static int append_key(vector<char> &key, const T &value)
+    {
+      const char* bytes = reinterpret_cast<const char*>(&value);
+      for (size_t i = 0; i < sizeof(T); i++)
+	key.push_back(bytes[i]);
+      return 0;
+    }
+
+    /* FNV-1a */
+    static uint64_t hash(const char* data, size_t size);
+
+  protected:
+
+    Entry* find(StateKind kind, uint64_t key_hash, const vector<char> &key);
+
+  };
+
+}
+
+#endif
@@ -2,7 +2,6 @@
 #include "Util.hpp"
 
 #include <lme/algorithm.hpp>
-#include <lme/math/math.hpp>
 
 static int get_format(
     const VkFormat 						color_format,
@@ -11,11 +10,6 @@ static int get_format(
     VkSurfaceFormatKHR 						&surface_format
     );
 
-static int get_extent(
-    const VkSurfaceCapabilitiesKHR 				&surface_capabilities,
-    VkExtent2D 							&image_extent
-    );
-
 
 int me::Vulkan::create_surface(const SurfaceCreateInfo &surface_create_info, Surface &surface)
 {
@@ -50,12 +44,12 @@ int me::Vulkan::create_surface(const SurfaceCreateInfo &surface_create_info, Sur
 
   VkExtent2D vk_extent;
   surface_create_info.surface_module->get_framebuffer_size(vk_extent.width, vk_extent.height);
-  get_extent(vk_surface_capabilities, vk_extent);
+  util::get_surface_extent(vk_surface_capabilities, vk_extent);
 
   VkSurfaceFormatKHR vk_surface_format;
   get_format(VK_FORMAT_B8G8R8A8_UNORM, VK_COLOR_SPACE_SRGB_NONLINEAR_KHR, {surface_format_count, surface_formats}, vk_surface_format);
 
-  surface = alloc.allocate<Surface_T>(vk_surface, vk_surface_capabilities, vk_surface_format, vk_present_mode, vk_extent);
+  surface = alloc.allocate<Surface_T>(vk_physical_device, surface_create_info.surface_module, vk_surface, vk_surface_capabilities, vk_surface_format, vk_present_mode, vk_extent);
   return 0;
 }
 
@@ -94,21 +88,3 @@ int get_format(
     surface_format = surface_formats[0];
   return 0;
 }
-
-int get_extent(
-    const VkSurfaceCapabilitiesKHR 				&surface_capabilities,
-    VkExtent2D 							&image_extent
-    )
-{
-  if (surface_capabilities.currentExtent.width != UINT32_MAX)
-    image_extent = surface_capabilities.currentExtent;
-
-  /* if extent.width/height is more than max image width/height; set the extent.width/height to max image width/height */
-  image_extent.width = me::math::min(image_extent.width, surface_capabilities.maxImageExtent.width);
-  image_extent.height = me::math::min(image_extent.height, surface_capabilities.maxImageExtent.height);
-
-  /* if extent.width/height is less than min image width/height; set the extent.width/height to min image width/height */
-  image_extent.width = me::math::max(image_extent.width, surface_capabilities.minImageExtent.width);
-  image_extent.height = me::math::max(image_extent.height, surface_capabilities.minImageExtent.height);
-  return 0;
-}
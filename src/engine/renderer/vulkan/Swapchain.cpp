@@ -15,11 +15,25 @@ int me::Vulkan::create_swapchain(const SwapchainCreateInfo &swapchain_create_inf
   VERIFY_CREATE_INFO(swapchain_create_info, STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO);
 
   VkDevice vk_device = reinterpret_cast<Device_T*>(swapchain_create_info.device)->vk_device;
-  VkSurfaceKHR vk_surface = reinterpret_cast<Surface_T*>(swapchain_create_info.surface)->vk_surface;
-  VkSurfaceCapabilitiesKHR vk_surface_capabilities = reinterpret_cast<Surface_T*>(swapchain_create_info.surface)->vk_capabilities;
-  VkSurfaceFormatKHR vk_surface_format = reinterpret_cast<Surface_T*>(swapchain_create_info.surface)->vk_format;
-  VkPresentModeKHR vk_present_mode = reinterpret_cast<Surface_T*>(swapchain_create_info.surface)->vk_present_mode;
-  VkExtent2D vk_surface_extent = reinterpret_cast<Surface_T*>(swapchain_create_info.surface)->vk_extent;
+  Surface_T* surface = reinterpret_cast<Surface_T*>(swapchain_create_info.surface);
+  VkSurfaceKHR vk_surface = surface->vk_surface;
+  VkSurfaceFormatKHR vk_surface_format = surface->vk_format;
+  VkPresentModeKHR vk_present_mode = surface->vk_present_mode;
+
+  VkSwapchainKHR vk_old_swapchain = VK_NULL_HANDLE;
+  if (swapchain_create_info.old_swapchain != nullptr)
+    vk_old_swapchain = reinterpret_cast<Swapchain_T*>(swapchain_create_info.old_swapchain)->vk_swapchain;
+
+  /* the window may have been resized since the surface or the last swapchain was created */
+  VkResult result = vkGetPhysicalDeviceSurfaceCapabilitiesKHR(surface->vk_physical_device, vk_surface, &surface->vk_capabilities);
+  if (result != VK_SUCCESS)
+    throw exception("failed to get surface capabilities [%s]", util::get_result_string(result));
+
+  surface->surface_module->get_framebuffer_size(surface->vk_extent.width, surface->vk_extent.height);
+  util::get_surface_extent(surface->vk_capabilities, surface->vk_extent);
+
+  VkSurfaceCapabilitiesKHR vk_surface_capabilities = surface->vk_capabilities;
+  VkExtent2D vk_surface_extent = surface->vk_extent;
 
   VkFormat vk_image_format = vk_surface_format.format;
   VkColorSpaceKHR vk_image_color_space = vk_surface_format.colorSpace;
@@ -51,10 +65,10 @@ int me::Vulkan::create_swapchain(const SwapchainCreateInfo &swapchain_create_inf
   vk_swapchain_create_info.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
   vk_swapchain_create_info.presentMode = present_mode;
   vk_swapchain_create_info.clipped = VK_TRUE;
-  vk_swapchain_create_info.oldSwapchain = VK_NULL_HANDLE; /* TODO */
+  vk_swapchain_create_info.oldSwapchain = vk_old_swapchain; /* lets the driver reuse its resources, frames of the old one can still be presented */
 
   VkSwapchainKHR vk_swapchain;
-  VkResult result = vkCreateSwapchainKHR(vk_device, &vk_swapchain_create_info, vk_allocation, &vk_swapchain);
+  result = vkCreateSwapchainKHR(vk_device, &vk_swapchain_create_info, vk_allocation, &vk_swapchain);
   if (result != VK_SUCCESS)
     throw exception("failed to create swapchain [%s]", util::get_result_string(result));
 
@@ -96,12 +110,21 @@ int me::Vulkan::get_swapchain_image_count(Device device, Swapchain swapchain, ui
   return 0;
 }
 
+int me::Vulkan::get_swapchain_extent(Swapchain swapchain, math::vec2u &extent)
+{
+  VkExtent2D vk_image_extent = reinterpret_cast<Swapchain_T*>(swapchain)->vk_image_extent;
+
+  extent = {vk_image_extent.width, vk_image_extent.height};
+  return 0;
+}
+
 int me::Vulkan::cleanup_swapchain(Device device, Swapchain swapchain)
 {
   VkDevice vk_device = reinterpret_cast<Device_T*>(device)->vk_device;
   VkSwapchainKHR vk_swapchain = reinterpret_cast<Swapchain_T*>(swapchain)->vk_swapchain;
 
   vkDestroySwapchainKHR(vk_device, vk_swapchain, vk_allocation);
+  alloc.deallocate(reinterpret_cast<Swapchain_T*>(swapchain));
   return 0;
 }
 
@@ -113,6 +136,7 @@ int me::Vulkan::cleanup_swapchain_images(Device device, uint32_t image_count, Sw
   {
     VkImageView vk_image_view = reinterpret_cast<SwapchainImage_T*>(images[i])->vk_image_view;
     vkDestroyImageView(vk_device, vk_image_view, vk_allocation);
+    alloc.deallocate(reinterpret_cast<SwapchainImage_T*>(images[i]));
   }
   return 0;
 }
@@ -0,0 +1,191 @@
+#include "Timestamp.hpp"
+#include "Util.hpp"
+
+me::query::TimestampProfiler::TimestampProfiler(Profiler &profiler, VkDevice device, VkAllocationCallbacks* allocation, uint32_t queue_family,
+    uint32_t timestamp_valid_bits, float timestamp_period, uint32_t frame_count)
+  : profiler(profiler), vk_device(device), vk_allocation(allocation), queue_family(queue_family), timestamp_period(timestamp_period)
+{
+  timestamp_mask = timestamp_valid_bits >= 64 ? UINT64_MAX : (1ULL << timestamp_valid_bits) - 1;
+  vk_command_pool = VK_NULL_HANDLE;
+  frames.resize(frame_count > 0 ? frame_count : 1);
+  frame_index = 0;
+}
+
+int me::query::TimestampProfiler::initialize()
+{
+  VkCommandPoolCreateInfo command_pool_create_info = { };
+  command_pool_create_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+  command_pool_create_info.pNext = nullptr;
+  command_pool_create_info.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+  command_pool_create_info.queueFamilyIndex = queue_family;
+
+  VkResult result = vkCreateCommandPool(vk_device, &command_pool_create_info, vk_allocation, &vk_command_pool);
+  if (result != VK_SUCCESS)
+    throw exception("failed to create timestamp command pool [%s]", util::get_result_string(result));
+
+  VkQueryPoolCreateInfo query_pool_create_info = { };
+  query_pool_create_info.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+  query_pool_create_info.pNext = nullptr;
+  query_pool_create_info.flags = 0;
+  query_pool_create_info.queryType = VK_QUERY_TYPE_TIMESTAMP;
+  query_pool_create_info.queryCount = MAX_REGIONS * 2;
+  query_pool_create_info.pipelineStatistics = 0;
+
+  VkCommandBufferAllocateInfo command_buffer_allocate_info = { };
+  command_buffer_allocate_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+  command_buffer_allocate_info.pNext = nullptr;
+  command_buffer_allocate_info.commandPool = vk_command_pool;
+  command_buffer_allocate_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+  command_buffer_allocate_info.commandBufferCount = 1;
+
+  for (FrameQueries &frame : frames)
+  {
+    result = vkCreateQueryPool(vk_device, &query_pool_create_info, vk_allocation, &frame.vk_query_pool);
+    if (result != VK_SUCCESS)
+      throw exception("failed to create timestamp query pool [%s]", util::get_result_string(result));
+
+    result = vkAllocateCommandBuffers(vk_device, &command_buffer_allocate_info, &frame.vk_reset_command_buffer);
+    if (result != VK_SUCCESS)
+      throw exception("failed to allocate timestamp reset command buffer [%s]", util::get_result_string(result));
+
+    frame.labels.resize(MAX_REGIONS);
+    frame.region_count = 0;
+    frame.profiler_frame = 0;
+    frame.submit_time = 0;
+    frame.submitted = false;
+  }
+  return 0;
+}
+
+int me::query::TimestampProfiler::cleanup()
+{
+  /* the last frames are not read back, the device may not have finished them */
+  for (FrameQueries &frame : frames)
+    vkDestroyQueryPool(vk_device, frame.vk_query_pool, vk_allocation);
+  vkDestroyCommandPool(vk_device, vk_command_pool, vk_allocation);
+  frames.resize(0);
+  pthread_mutex_destroy(&mutex);
+  return 0;
+}
+
+int me::query::TimestampProfiler::begin_frame(
+    uint32_t 						frame_index
+    )
+{
+  pthread_mutex_lock(&mutex);
+  this->frame_index = frame_index % frames.size();
+  FrameQueries &frame = frames[this->frame_index];
+  pthread_mutex_unlock(&mutex);
+
+  /* a frame that was prepared but never submitted has nothing to read */
+  if (frame.submitted)
+    resolve(frame);
+
+  frame.region_count = 0;
+  frame.profiler_frame = profiler.get_frame();
+  frame.submitted = false;
+
+  /* 'vkCmdResetQueryPool' is core 1.0, resetting from the host needs 'hostQueryReset' */
+  VkCommandBufferBeginInfo command_buffer_begin_info = { };
+  command_buffer_begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+  command_buffer_begin_info.pNext = nullptr;
+  command_buffer_begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+  command_buffer_begin_info.pInheritanceInfo = nullptr;
+
+  VkResult result = vkBeginCommandBuffer(frame.vk_reset_command_buffer, &command_buffer_begin_info);
+  if (result != VK_SUCCESS)
+    throw exception("failed to begin timestamp reset command buffer [%s]", util::get_result_string(result));
+
+  vkCmdResetQueryPool(frame.vk_reset_command_buffer, frame.vk_query_pool, 0, MAX_REGIONS * 2);
+
+  result = vkEndCommandBuffer(frame.vk_reset_command_buffer);
+  if (result != VK_SUCCESS)
+    throw exception("failed to end timestamp reset command buffer [%s]", util::get_result_string(result));
+  return 0;
+}
+
+VkCommandBuffer me::query::TimestampProfiler::submit_frame()
+{
+  pthread_mutex_lock(&mutex);
+  FrameQueries &frame = frames[frame_index];
+  frame.submitted = true;
+  frame.submit_time = Profiler::get_time();
+  pthread_mutex_unlock(&mutex);
+  return frame.vk_reset_command_buffer;
+}
+
+int me::query::TimestampProfiler::begin_region(
+    const char* 					label,
+    VkCommandBuffer 					command_buffer,
+    uint32_t 						&region
+    )
+{
+  pthread_mutex_lock(&mutex);
+  FrameQueries &frame = frames[frame_index];
+  region = frame.region_count < MAX_REGIONS ? frame.region_count++ : NO_REGION;
+  if (region != NO_REGION)
+    frame.labels[region] = label;
+  VkQueryPool vk_query_pool = frame.vk_query_pool;
+  pthread_mutex_unlock(&mutex);
+
+  if (region != NO_REGION)
+    vkCmdWriteTimestamp(command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, vk_query_pool, region * 2);
+  return 0;
+}
+
+int me::query::TimestampProfiler::end_region(
+    uint32_t 						region,
+    VkCommandBuffer 					command_buffer
+    )
+{
+  if (region == NO_REGION)
+    return 0;
+
+  pthread_mutex_lock(&mutex);
+  VkQueryPool vk_query_pool = frames[frame_index].vk_query_pool;
+  pthread_mutex_unlock(&mutex);
+
+  vkCmdWriteTimestamp(command_buffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, vk_query_pool, region * 2 + 1);
+  return 0;
+}
+
+int me::query::TimestampProfiler::resolve(FrameQueries &frame)
+{
+  uint32_t query_count = frame.region_count * 2;
+  if (query_count == 0)
+    return 0;
+
+  /* a value and its availability per query, without waiting.
+   * a region that was never ended stays unavailable and is skipped */
+  uint64_t results[query_count * 2];
+  VkResult result = vkGetQueryPoolResults(vk_device, frame.vk_query_pool, 0, query_count, sizeof(results), results,
+      2 * sizeof(uint64_t), VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+  if (result != VK_SUCCESS && result != VK_NOT_READY)
+    throw exception("failed to get timestamp query results [%s]", util::get_result_string(result));
+
+  /* gpu ticks have no relation to the cpu clock, the first timestamp of the frame is placed at its submission */
+  bool found_first = false;
+  uint64_t first_tick = 0;
+  for (uint32_t i = 0; i < frame.region_count; i++)
+  {
+    uint64_t tick = results[i * 4] & timestamp_mask;
+    if (results[i * 4 + 1] != 0 && (!found_first || tick < first_tick))
+    {
+      first_tick = tick;
+      found_first = true;
+    }
+  }
+
+  for (uint32_t i = 0; i < frame.region_count; i++)
+  {
+    if (results[i * 4 + 1] == 0 || results[i * 4 + 3] == 0)
+      continue;
+
+    uint64_t begin_tick = results[i * 4] & timestamp_mask;
+    uint64_t end_tick = results[i * 4 + 2] & timestamp_mask;
+    uint64_t start = frame.submit_time + static_cast<uint64_t>(static_cast<double>((begin_tick - first_tick) & timestamp_mask) * timestamp_period);
+    uint64_t duration = static_cast<uint64_t>(static_cast<double>((end_tick - begin_tick) & timestamp_mask) * timestamp_period);
+    profiler.record({frame.labels[i], PROFILE_SOURCE_GPU, frame.profiler_frame, start, start + duration});
+  }
+  return 0;
+}
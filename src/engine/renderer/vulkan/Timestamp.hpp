@@ -0,0 +1,86 @@
+#ifndef ME_VULKAN_TIMESTAMP_HPP
+  #define ME_VULKAN_TIMESTAMP_HPP
+
+#include "../Types.hpp"
+#include "../../util/Profiler.hpp"
+
+#include <lme/vector.hpp>
+
+#include <vulkan/vulkan.h>
+
+#include <pthread.h>
+
+namespace me::query {
+
+  /* a timestamp query pool per frame in flight, every region is a pair of queries.
+   * a frame's queries are read back when the frame begins again, its fence has signaled by then,
+   * so reading never waits for the gpu. the results go to the profiler as 'PROFILE_SOURCE_GPU' events */
+  class TimestampProfiler {
+
+  public:
+
+    static constexpr uint32_t MAX_REGIONS = 256; /* per frame, regions after this are not timed */
+    static constexpr uint32_t NO_REGION = UINT32_MAX;
+
+  protected:
+
+    struct FrameQueries {
+      VkQueryPool vk_query_pool;
+      VkCommandBuffer vk_reset_command_buffer;
+      vector<const char*> labels; /* of each region */
+      uint32_t region_count;
+      uint64_t profiler_frame;
+      uint64_t submit_time; /* cpu time the frame was submitted at */
+      bool submitted;
+    };
+
+    Profiler &profiler;
+    VkDevice vk_device;
+    VkAllocationCallbacks* vk_allocation;
+    uint32_t queue_family;
+    float timestamp_period; /* nanoseconds per tick */
+    uint64_t timestamp_mask; /* of the valid bits */
+
+    VkCommandPool vk_command_pool;
+    vector<FrameQueries> frames;
+    uint32_t frame_index;
+
+    pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER; /* regions are opened by every thread recording the frame */
+
+  public:
+
+    TimestampProfiler(Profiler &profiler, VkDevice device, VkAllocationCallbacks* allocation, uint32_t queue_family,
+	uint32_t timestamp_valid_bits, float timestamp_period, uint32_t frame_count);
+
+    int initialize();
+    int cleanup();
+
+    /* the frame must not be in flight anymore, the regions it had the last time are read back */
+    int begin_frame(
+	uint32_t 					frame_index
+	);
+
+    /* resets the frame's queries, submitted before the command buffers of the frame */
+    VkCommandBuffer submit_frame();
+
+    /* 'region' is 'NO_REGION' if the frame has no queries left */
+    int begin_region(
+	const char* 					label,
+	VkCommandBuffer 				command_buffer,
+	uint32_t 					&region
+	);
+
+    int end_region(
+	uint32_t 					region,
+	VkCommandBuffer 				command_buffer
+	);
+
+  protected:
+
+    int resolve(FrameQueries &frame);
+
+  };
+
+}
+
+#endif
@@ -3,6 +3,20 @@
 
 #include "../Types.hpp"
 
+#include "Memory.hpp"
+#include "Staging.hpp"
+#include "Upload.hpp"
+#include "Geometry.hpp"
+#include "Residency.hpp"
+#include "Defrag.hpp"
+#include "Bindless.hpp"
+#include "Descriptor.hpp"
+#include "CommandAllocator.hpp"
+#include "PipelineCache.hpp"
+#include "PipelineCompiler.hpp"
+#include "StateCache.hpp"
+#include "Timestamp.hpp"
+
 #include <vulkan/vulkan.h>
 
 #include <lme/vector.hpp>
@@ -16,19 +30,37 @@ namespace me {
   };
 
   struct Surface_T {
+    VkPhysicalDevice vk_physical_device;
+    SurfaceModule* surface_module;
     VkSurfaceKHR vk_surface;
     VkSurfaceCapabilitiesKHR vk_capabilities;
     VkSurfaceFormatKHR vk_format;
     VkPresentModeKHR vk_present_mode;
-    VkExtent2D vk_extent;
+    VkExtent2D vk_extent; /* of the last swapchain */
   };
 
   struct Device_T {
     VkDevice vk_device;
+    VkPhysicalDeviceLimits vk_limits;
     uint32_t compute_queue_index;
     uint32_t graphics_queue_index;
     uint32_t present_queue_index;
     uint32_t transfer_queue_index;
+    memory::DeviceAllocator* memory_allocator;
+    memory::StagingRing* staging_ring;
+    memory::Uploader* uploader;
+    memory::GeometryPool* geometry_pool;
+    memory::ResidencyManager* residency;
+    memory::Defragmenter* defragmenter;
+    descriptor::BindlessTable* bindless_table; /* nullptr without descriptor indexing */
+    descriptor::FrameDescriptorAllocator* frame_descriptors;
+    command::FrameCommandAllocator* frame_commands;
+    pipeline::PipelineCache* pipeline_cache;
+    pipeline::PipelineCompiler* pipeline_compiler;
+    pipeline::StateCache* state_cache;
+    query::TimestampProfiler* timestamps; /* nullptr without a profiler or timestamp support */
+    bool multi_draw_indirect; /* more than one draw per indirect call */
+    bool draw_indirect_count; /* the draw count of indirect calls can come from a buffer */
   };
 
   struct Queue_T {
@@ -53,37 +85,74 @@ namespace me {
     VkSemaphore vk_image_available_semaphore;
     VkSemaphore vk_render_finished_semaphore;
     VkFence vk_in_flight_fence;
+    uint64_t submit_count; /* submits signaling the fence, tells readbacks if the fence is for their submit yet */
   };
 
   struct Buffer_T {
     VkBuffer vk_buffer;
-    VkDeviceMemory vk_memory;
+    VkBufferUsageFlags vk_usage;
+    memory::Allocation allocation;
     BufferUsage usage;
     BufferWriteMethod write_method;
     size_t size;
+    void* data; /* persistently mapped, nullptr if not host visible */
   };
 
   struct RenderPass_T {
     VkRenderPass vk_render_pass;
+    uint32_t attachment_count; /* with the swapchain image of non-offscreen render passes */
+    uint32_t color_attachment_count;
+    uint32_t depth_attachment; /* index of the depth attachment, UINT32_MAX if there is none */
+    uint64_t compatibility_hash; /* the same for compatible render passes */
   };
 
   struct Pipeline_T {
     VkPipeline vk_pipeline;
     VkPipelineLayout vk_layout;
-    VkDescriptorSetLayout vk_descriptor_set_layout;
+    vector<VkDescriptorSetLayout> vk_descriptor_set_layouts; /* shared through the device's state cache, like the layout and the pipeline */
+    uint32_t push_constant_size;
+    uint32_t first_set; /* 1 if set 0 is the device's bindless table */
+  };
+
+  /* owns a copy of everything the create info points to, the caller's may be gone before the build starts */
+  struct PipelineBuild_T {
+    PipelineCreateInfo pipeline_create_info;
+    ShaderCreateInfo shader_create_info;
+    RasterizerCreateInfo rasterizer_create_info;
+    MultisamplingCreateInfo multisampling_create_info;
+    vector<Viewport> viewports;
+    vector<Scissor> scissors;
+    vector<ShaderBinding> vertex_bindings;
+    vector<ShaderAttribute> vertex_attributes;
+    vector<char> shader_code; /* the code and entry point of every shader, one after another */
+    vector<Shader*> shaders; /* copies pointing into 'shader_code', freed with the build */
+    vector<DescriptorType> descriptor_sets;
+    PipelineBuildStatus status; /* written by the compiler under its lock */
+    Pipeline pipeline;
+    PipelineBuild_T* next_build; /* in the compiler's queue */
   };
 
   struct Framebuffer_T {
     VkFramebuffer vk_framebuffer;
+    VkExtent2D vk_extent;
   };
 
   struct DescriptorPool_T {
-    VkDescriptorPool vk_descriptor_pool;
+    descriptor::DescriptorAllocator* allocator;
     DescriptorType type;
   };
 
   struct Descriptor_T {
     VkDescriptorSet vk_descriptor_set;
+    VkDescriptorPool vk_descriptor_pool; /* VK_NULL_HANDLE for per-frame descriptors */
+    /* what the set was written with, so it can be written again when the defragmenter moves the buffer.
+     * not kept for per-frame descriptors, they don't outlive the buffers they were written with */
+    descriptor::DescriptorAllocator* allocator;
+    VkDescriptorSetLayout vk_descriptor_set_layout;
+    VkDescriptorType vk_descriptor_type;
+    Buffer_T* buffer;
+    VkDeviceSize offset;
+    VkDeviceSize range;
   };
 
   struct CommandPool_T {
@@ -93,6 +162,81 @@ namespace me {
   struct CommandBuffer_T {
     VkCommandBuffer vk_command_buffer;
     CommandBufferUsage usage;
+    bool secondary;
+    query::TimestampProfiler* timestamps; /* nullptr if the command buffer isn't from the frame pools */
+    uint32_t render_pass_region;
+  };
+
+  /* memory shared by attachments created together, freed with the last of them */
+  struct AttachmentMemory_T {
+    memory::Allocation allocation;
+    uint32_t reference_count;
+  };
+
+  struct Attachment_T {
+    VkImage vk_image;
+    VkImageView vk_image_view;
+    VkFormat vk_format;
+    VkSampleCountFlagBits vk_samples;
+    AttachmentType attachment_type;
+    bool transient;
+    uint32_t first_pass;
+    uint32_t last_pass;
+    AttachmentMemory_T* memory; /* aliased if 'reference_count' is greater than 1 */
+  };
+
+  /* per-frame object data written by the host, read by the cull pipeline,
+   * which writes the draw commands and their count on the device */
+  struct IndirectDrawList_T {
+    VkBuffer vk_object_buffer;
+    memory::Allocation object_allocation;
+    char* objects; /* mapped, 'capacity' objects per frame */
+    VkBuffer vk_command_buffer;
+    memory::Allocation command_allocation;
+    VkBuffer vk_count_buffer;
+    memory::Allocation count_allocation;
+    VkDescriptorSetLayout vk_descriptor_set_layout;
+    VkDescriptorPool vk_descriptor_pool;
+    vector<VkDescriptorSet> vk_descriptor_sets; /* one per frame */
+    VkPipelineLayout vk_layout;
+    VkPipeline vk_pipeline;
+    uint32_t capacity;
+    uint32_t frame_count;
+    uint32_t frame_index; /* of the last write */
+    uint32_t object_count; /* of the last write */
+    vector<Mesh*> meshes; /* of the last write, their ranges are written again if the geometry pool moved them */
+    uint64_t geometry_generation; /* of the geometry pool when the ranges were written */
+  };
+
+  /* slots are used in order, 'first' is the oldest copy that hasn't been released */
+  struct ReadbackRing_T {
+    struct Slot {
+      VkBuffer vk_buffer;
+      memory::Allocation allocation;
+      void* data; /* mapped */
+      Frame_T* frame; /* whose fence signals the copy */
+      uint64_t submit_count; /* of the frame when the copy was recorded, the copy is in the next submit */
+      uint64_t tag;
+    };
+
+    VkDevice vk_device;
+    VkFormat vk_format;
+    VkExtent2D vk_extent;
+    VkDeviceSize slot_size;
+    vector<Slot> slots;
+    uint32_t first;
+    uint32_t count;
+    uint32_t dropped_count;
+  };
+
+  struct UniformRing_T {
+    Buffer_T* buffer;
+    char* data;
+    VkDeviceSize alignment;
+    VkDeviceSize frame_size;
+    uint32_t frame_count;
+    uint32_t frame_index;
+    VkDeviceSize used; /* bytes used in the current frame */
   };
 
 }
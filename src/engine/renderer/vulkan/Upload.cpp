@@ -0,0 +1,548 @@
+#include "Upload.hpp"
+#include "Util.hpp"
+
+#include <lme/math/math.hpp>
+
+#include <string.h>
+
+static int create_timeline_semaphore(
+    VkDevice 						device,
+    VkAllocationCallbacks* 				allocation,
+    VkSemaphore 					&semaphore
+    );
+
+static int create_command_pool(
+    VkDevice 						device,
+    VkAllocationCallbacks* 				allocation,
+    uint32_t 						queue_family,
+    VkCommandPool 					&command_pool
+    );
+
+
+me::memory::Uploader::Uploader(VkDevice device, VkAllocationCallbacks* allocation, StagingRing &staging_ring,
+    uint32_t transfer_queue_family, uint32_t graphics_queue_family)
+  : vk_device(device), vk_allocation(allocation), staging_ring(staging_ring),
+    transfer_queue_family(transfer_queue_family), graphics_queue_family(graphics_queue_family)
+{
+  transfer_value = 0;
+  acquire_value = 0;
+  acquired_value = 0;
+  vk_recording = VK_NULL_HANDLE;
+}
+
+int me::memory::Uploader::initialize()
+{
+  vkGetDeviceQueue(vk_device, transfer_queue_family, 0, &vk_transfer_queue);
+
+  create_command_pool(vk_device, vk_allocation, transfer_queue_family, vk_transfer_command_pool);
+  create_command_pool(vk_device, vk_allocation, graphics_queue_family, vk_graphics_command_pool);
+
+  create_timeline_semaphore(vk_device, vk_allocation, vk_transfer_semaphore);
+  create_timeline_semaphore(vk_device, vk_allocation, vk_acquire_semaphore);
+  return 0;
+}
+
+int me::memory::Uploader::cleanup()
+{
+  /* nothing may still be reading the staging ring or using the command buffers */
+  if (vk_recording != VK_NULL_HANDLE)
+  {
+    uint64_t ticket;
+    flush(ticket);
+  }
+
+  VkSemaphore semaphores[2] = {vk_transfer_semaphore, vk_acquire_semaphore};
+  uint64_t values[2] = {transfer_value, acquire_value};
+
+  VkSemaphoreWaitInfo semaphore_wait_info = { };
+  semaphore_wait_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+  semaphore_wait_info.pNext = nullptr;
+  semaphore_wait_info.flags = 0;
+  semaphore_wait_info.semaphoreCount = 2;
+  semaphore_wait_info.pSemaphores = semaphores;
+  semaphore_wait_info.pValues = values;
+  vkWaitSemaphores(vk_device, &semaphore_wait_info, UINT64_MAX);
+
+  vkDestroyCommandPool(vk_device, vk_transfer_command_pool, vk_allocation);
+  vkDestroyCommandPool(vk_device, vk_graphics_command_pool, vk_allocation);
+  vkDestroySemaphore(vk_device, vk_transfer_semaphore, vk_allocation);
+  vkDestroySemaphore(vk_device, vk_acquire_semaphore, vk_allocation);
+  return 0;
+}
+
+int me::memory::Uploader::upload(
+    VkBuffer 						buffer,
+    VkDeviceSize 					offset,
+    const void* 					data,
+    VkDeviceSize 					size
+    )
+{
+  /* uploads larger than a frame of the staging ring are split */
+  VkDeviceSize written = 0;
+  while (written < size)
+  {
+    VkDeviceSize chunk_size = math::min(size - written, StagingRing::FRAME_SIZE);
+
+    VkDeviceSize staging_offset;
+    char* staging_data;
+    reserve_staging(chunk_size, staging_offset, staging_data);
+
+    memcpy(staging_data, static_cast<const char*>(data) + written, (size_t) chunk_size);
+
+    VkBufferCopy buffer_copy_region = { };
+    buffer_copy_region.srcOffset = staging_offset;
+    buffer_copy_region.dstOffset = offset + written;
+    buffer_copy_region.size = chunk_size;
+    vkCmdCopyBuffer(vk_recording, staging_ring.get_buffer(), buffer, 1, &buffer_copy_region);
+
+    written += chunk_size;
+  }
+
+  recording_regions.push_back({buffer, offset, size});
+  return 0;
+}
+
+int me::memory::Uploader::upload_batch(
+    uint32_t 						upload_count,
+    const UploadInfo* 					uploads
+    )
+{
+  vector<VkBufferCopy> buffer_copy_regions;
+
+  uint32_t first = 0;
+  while (first < upload_count)
+  {
+    if (uploads[first].size > StagingRing::FRAME_SIZE)
+    {
+      upload(uploads[first].buffer, uploads[first].offset, uploads[first].data, uploads[first].size);
+      first++;
+      continue;
+    }
+
+    /* pack as many uploads as fit in one reservation */
+    VkDeviceSize batch_size = 0;
+    uint32_t last = first;
+    while (last < upload_count)
+    {
+      VkDeviceSize upload_offset = (batch_size + STAGING_ALIGNMENT - 1) / STAGING_ALIGNMENT * STAGING_ALIGNMENT;
+      if (upload_offset + uploads[last].size > StagingRing::FRAME_SIZE)
+	break;
+      batch_size = upload_offset + uploads[last].size;
+      last++;
+    }
+
+    VkDeviceSize staging_offset;
+    char* staging_data;
+    reserve_staging(batch_size, staging_offset, staging_data);
+
+    buffer_copy_regions.resize(last - first);
+    VkDeviceSize upload_offset = 0;
+    for (uint32_t i = first; i < last; i++)
+    {
+      upload_offset = (upload_offset + STAGING_ALIGNMENT - 1) / STAGING_ALIGNMENT * STAGING_ALIGNMENT;
+      memcpy(staging_data + upload_offset, uploads[i].data, (size_t) uploads[i].size);
+
+      VkBufferCopy &buffer_copy_region = buffer_copy_regions[i - first];
+      buffer_copy_region.srcOffset = staging_offset + upload_offset;
+      buffer_copy_region.dstOffset = uploads[i].offset;
+      buffer_copy_region.size = uploads[i].size;
+
+      recording_regions.push_back({uploads[i].buffer, uploads[i].offset, uploads[i].size});
+      upload_offset += uploads[i].size;
+    }
+
+    /* one copy command per run of uploads to the same buffer */
+    uint32_t run_first = first;
+    for (uint32_t i = first + 1; i <= last; i++)
+    {
+      if (i == last || uploads[i].buffer != uploads[run_first].buffer)
+      {
+	vkCmdCopyBuffer(vk_recording, staging_ring.get_buffer(), uploads[run_first].buffer,
+	    i - run_first, &buffer_copy_regions[run_first - first]);
+	run_first = i;
+      }
+    }
+
+    first = last;
+  }
+  return 0;
+}
+
+int me::memory::Uploader::copy(
+    VkBuffer 						src,
+    VkDeviceSize 					src_offset,
+    VkBuffer 						dst,
+    VkDeviceSize 					dst_offset,
+    VkDeviceSize 					size
+    )
+{
+  VkBufferCopy buffer_copy_region = { };
+  buffer_copy_region.srcOffset = src_offset;
+  buffer_copy_region.dstOffset = dst_offset;
+  buffer_copy_region.size = size;
+
+  /* the source may have been written by an upload in the same command buffer, 'copy_regions' waits for it */
+  copy_regions(src, dst, 1, &buffer_copy_region);
+  return 0;
+}
+
+int me::memory::Uploader::copy_regions(
+    VkBuffer 						src,
+    VkBuffer 						dst,
+    uint32_t 						region_count,
+    const VkBufferCopy* 				regions
+    )
+{
+  if (region_count == 0)
+    return 0;
+
+  /* the graphics queue records them after acquiring the uploads, which already makes them visible */
+  if (transfer_queue_family != graphics_queue_family)
+  {
+    for (uint32_t i = 0; i < region_count; i++)
+      graphics_copies.push_back({src, dst, regions[i]});
+    return 0;
+  }
+
+  if (vk_recording == VK_NULL_HANDLE)
+    begin_recording();
+
+  /* uploads recorded before in the same command buffer may write the source */
+  VkDeviceSize src_begin = regions[0].srcOffset;
+  VkDeviceSize src_end = regions[0].srcOffset + regions[0].size;
+  for (uint32_t i = 1; i < region_count; i++)
+  {
+    src_begin = math::min(src_begin, regions[i].srcOffset);
+    src_end = math::max(src_end, regions[i].srcOffset + regions[i].size);
+  }
+
+  VkBufferMemoryBarrier buffer_memory_barrier = { };
+  buffer_memory_barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+  buffer_memory_barrier.pNext = nullptr;
+  buffer_memory_barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  buffer_memory_barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+  buffer_memory_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  buffer_memory_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  buffer_memory_barrier.buffer = src;
+  buffer_memory_barrier.offset = src_begin;
+  buffer_memory_barrier.size = src_end - src_begin;
+  vkCmdPipelineBarrier(vk_recording, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+      0, nullptr, 1, &buffer_memory_barrier, 0, nullptr);
+
+  vkCmdCopyBuffer(vk_recording, src, dst, region_count, regions);
+  for (uint32_t i = 0; i < region_count; i++)
+    recording_regions.push_back({dst, regions[i].dstOffset, regions[i].size});
+  return 0;
+}
+
+int me::memory::Uploader::flush(
+    uint64_t 						&ticket
+    )
+{
+  if (vk_recording == VK_NULL_HANDLE)
+  {
+    ticket = transfer_value;
+    return 0;
+  }
+
+  if (transfer_queue_family != graphics_queue_family)
+    record_ownership_barriers(vk_recording, recording_regions, true);
+
+  VkResult result = vkEndCommandBuffer(vk_recording);
+  if (result != VK_SUCCESS)
+    throw exception("failed to end upload command buffer [%s]", util::get_result_string(result));
+
+  transfer_value++;
+  for (CommandBuffer &command_buffer : transfer_command_buffers)
+  {
+    if (command_buffer.vk_command_buffer == vk_recording)
+      command_buffer.value = transfer_value;
+  }
+
+  /* the staging ring reclaims its space by the fence */
+  VkFence vk_fence;
+  staging_ring.submit(vk_fence);
+
+  VkTimelineSemaphoreSubmitInfo timeline_semaphore_submit_info = { };
+  timeline_semaphore_submit_info.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+  timeline_semaphore_submit_info.pNext = nullptr;
+  timeline_semaphore_submit_info.waitSemaphoreValueCount = 0;
+  timeline_semaphore_submit_info.pWaitSemaphoreValues = nullptr;
+  timeline_semaphore_submit_info.signalSemaphoreValueCount = 1;
+  timeline_semaphore_submit_info.pSignalSemaphoreValues = &transfer_value;
+
+  VkSubmitInfo submit_info = { };
+  submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+  submit_info.pNext = &timeline_semaphore_submit_info;
+  submit_info.waitSemaphoreCount = 0;
+  submit_info.pWaitSemaphores = nullptr;
+  submit_info.pWaitDstStageMask = nullptr;
+  submit_info.commandBufferCount = 1;
+  submit_info.pCommandBuffers = &vk_recording;
+  submit_info.signalSemaphoreCount = 1;
+  submit_info.pSignalSemaphores = &vk_transfer_semaphore;
+
+  result = vkQueueSubmit(vk_transfer_queue, 1, &submit_info, vk_fence);
+  if (result != VK_SUCCESS)
+    throw exception("failed to submit uploads [%s]", util::get_result_string(result));
+  staging_ring.mark_submitted();
+
+  for (const Region &region : recording_regions)
+    released_regions.push_back(region);
+  recording_regions.resize(0);
+  vk_recording = VK_NULL_HANDLE;
+
+  ticket = transfer_value;
+  return 0;
+}
+
+int me::memory::Uploader::acquire(
+    VkQueue 						graphics_queue
+    )
+{
+  uint64_t ticket;
+  flush(ticket);
+
+  if (acquired_value == transfer_value && graphics_copies.size() == 0)
+    return 0;
+
+  VkCommandBuffer vk_command_buffer = VK_NULL_HANDLE;
+  if ((transfer_queue_family != graphics_queue_family && released_regions.size() > 0) || graphics_copies.size() > 0)
+  {
+    size_t index;
+    get_command_buffer(vk_graphics_command_pool, vk_acquire_semaphore, graphics_command_buffers, index);
+    vk_command_buffer = graphics_command_buffers[index].vk_command_buffer;
+    graphics_command_buffers[index].value = acquire_value + 1;
+
+    if (transfer_queue_family != graphics_queue_family && released_regions.size() > 0)
+      record_ownership_barriers(vk_command_buffer, released_regions, false);
+
+    if (graphics_copies.size() > 0)
+    {
+      for (const Copy &copy : graphics_copies)
+	vkCmdCopyBuffer(vk_command_buffer, copy.src_buffer, copy.dst_buffer, 1, &copy.region);
+      graphics_copies.resize(0);
+
+      /* later submits on this queue read the copies */
+      VkMemoryBarrier memory_barrier = { };
+      memory_barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+      memory_barrier.pNext = nullptr;
+      memory_barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+      memory_barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+      vkCmdPipelineBarrier(vk_command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0,
+	  1, &memory_barrier, 0, nullptr, 0, nullptr);
+    }
+
+    VkResult result = vkEndCommandBuffer(vk_command_buffer);
+    if (result != VK_SUCCESS)
+      throw exception("failed to end acquire command buffer [%s]", util::get_result_string(result));
+  }
+  released_regions.resize(0);
+
+  acquire_value++;
+
+  VkTimelineSemaphoreSubmitInfo timeline_semaphore_submit_info = { };
+  timeline_semaphore_submit_info.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+  timeline_semaphore_submit_info.pNext = nullptr;
+  timeline_semaphore_submit_info.waitSemaphoreValueCount = 1;
+  timeline_semaphore_submit_info.pWaitSemaphoreValues = &transfer_value;
+  timeline_semaphore_submit_info.signalSemaphoreValueCount = 1;
+  timeline_semaphore_submit_info.pSignalSemaphoreValues = &acquire_value;
+
+  /* later submits on the graphics queue are ordered after this one */
+  VkPipelineStageFlags wait_stage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+
+  VkSubmitInfo submit_info = { };
+  submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+  submit_info.pNext = &timeline_semaphore_submit_info;
+  submit_info.waitSemaphoreCount = 1;
+  submit_info.pWaitSemaphores = &vk_transfer_semaphore;
+  submit_info.pWaitDstStageMask = &wait_stage;
+  submit_info.commandBufferCount = vk_command_buffer != VK_NULL_HANDLE ? 1 : 0;
+  submit_info.pCommandBuffers = &vk_command_buffer;
+  submit_info.signalSemaphoreCount = 1;
+  submit_info.pSignalSemaphores = &vk_acquire_semaphore;
+
+  VkResult result = vkQueueSubmit(graphics_queue, 1, &submit_info, VK_NULL_HANDLE);
+  if (result != VK_SUCCESS)
+    throw exception("failed to submit upload acquire [%s]", util::get_result_string(result));
+
+  acquired_value = transfer_value;
+  return 0;
+}
+
+int me::memory::Uploader::wait(
+    uint64_t 						ticket
+    )
+{
+  VkSemaphoreWaitInfo semaphore_wait_info = { };
+  semaphore_wait_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+  semaphore_wait_info.pNext = nullptr;
+  semaphore_wait_info.flags = 0;
+  semaphore_wait_info.semaphoreCount = 1;
+  semaphore_wait_info.pSemaphores = &vk_transfer_semaphore;
+  semaphore_wait_info.pValues = &ticket;
+
+  VkResult result = vkWaitSemaphores(vk_device, &semaphore_wait_info, UINT64_MAX);
+  if (result != VK_SUCCESS)
+    throw exception("failed to wait for upload [%s]", util::get_result_string(result));
+  return 0;
+}
+
+bool me::memory::Uploader::is_complete(
+    uint64_t 						ticket
+    )
+{
+  uint64_t value;
+  VkResult result = vkGetSemaphoreCounterValue(vk_device, vk_transfer_semaphore, &value);
+  if (result != VK_SUCCESS)
+    throw exception("failed to get upload semaphore value [%s]", util::get_result_string(result));
+  return value >= ticket;
+}
+
+int me::memory::Uploader::reserve_staging(VkDeviceSize size, VkDeviceSize &offset, char* &data)
+{
+  if (vk_recording == VK_NULL_HANDLE)
+    begin_recording();
+
+  void* staging_data;
+  if (!staging_ring.reserve(size, STAGING_ALIGNMENT, offset, staging_data))
+  {
+    /* the ring is full of recorded uploads, submit them so their space can be reclaimed */
+    uint64_t ticket;
+    flush(ticket);
+
+    if (!staging_ring.reserve(size, STAGING_ALIGNMENT, offset, staging_data))
+      throw exception("failed to reserve %lu bytes of staging memory", size);
+    begin_recording();
+  }
+
+  data = static_cast<char*>(staging_data);
+  return 0;
+}
+
+int me::memory::Uploader::begin_recording()
+{
+  size_t index;
+  get_command_buffer(vk_transfer_command_pool, vk_transfer_semaphore, transfer_command_buffers, index);
+  vk_recording = transfer_command_buffers[index].vk_command_buffer;
+  return 0;
+}
+
+int me::memory::Uploader::get_command_buffer(VkCommandPool command_pool, VkSemaphore semaphore, vector<CommandBuffer> &command_buffers, size_t &index)
+{
+  uint64_t completed_value;
+  VkResult result = vkGetSemaphoreCounterValue(vk_device, semaphore, &completed_value);
+  if (result != VK_SUCCESS)
+    throw exception("failed to get upload semaphore value [%s]", util::get_result_string(result));
+
+  index = SIZE_MAX;
+  for (size_t i = 0; i < command_buffers.size(); i++)
+  {
+    if (command_buffers[i].value <= completed_value)
+    {
+      index = i;
+      break;
+    }
+  }
+
+  if (index == SIZE_MAX)
+  {
+    VkCommandBufferAllocateInfo command_buffer_allocate_info = { };
+    command_buffer_allocate_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    command_buffer_allocate_info.pNext = nullptr;
+    command_buffer_allocate_info.commandPool = command_pool;
+    command_buffer_allocate_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    command_buffer_allocate_info.commandBufferCount = 1;
+
+    VkCommandBuffer vk_command_buffer;
+    result = vkAllocateCommandBuffers(vk_device, &command_buffer_allocate_info, &vk_command_buffer);
+    if (result != VK_SUCCESS)
+      throw exception("failed to allocate upload command buffer [%s]", util::get_result_string(result));
+
+    index = command_buffers.size();
+    command_buffers.push_back({vk_command_buffer, 0});
+  }
+
+  /* marks it as in use until the submit sets the real value */
+  command_buffers[index].value = UINT64_MAX;
+
+  VkCommandBufferBeginInfo command_buffer_begin_info = { };
+  command_buffer_begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+  command_buffer_begin_info.pNext = nullptr;
+  command_buffer_begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+  command_buffer_begin_info.pInheritanceInfo = nullptr;
+
+  /* begin implicitly resets the command buffer */
+  result = vkBeginCommandBuffer(command_buffers[index].vk_command_buffer, &command_buffer_begin_info);
+  if (result != VK_SUCCESS)
+    throw exception("failed to begin upload command buffer [%s]", util::get_result_string(result));
+  return 0;
+}
+
+int me::memory::Uploader::record_ownership_barriers(VkCommandBuffer command_buffer, const vector<Region> &regions, bool release)
+{
+  /* a batch can release thousands of regions, too many for the stack */
+  buffer_memory_barriers.resize(regions.size());
+  for (size_t i = 0; i < regions.size(); i++)
+  {
+    buffer_memory_barriers[i].sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    buffer_memory_barriers[i].pNext = nullptr;
+    buffer_memory_barriers[i].srcAccessMask = release ? VK_ACCESS_TRANSFER_WRITE_BIT : 0;
+    buffer_memory_barriers[i].dstAccessMask = release ? 0 : VK_ACCESS_MEMORY_READ_BIT;
+    buffer_memory_barriers[i].srcQueueFamilyIndex = transfer_queue_family;
+    buffer_memory_barriers[i].dstQueueFamilyIndex = graphics_queue_family;
+    buffer_memory_barriers[i].buffer = regions[i].vk_buffer;
+    buffer_memory_barriers[i].offset = regions[i].offset;
+    buffer_memory_barriers[i].size = regions[i].size;
+  }
+
+  VkPipelineStageFlags source_stage = release ? VK_PIPELINE_STAGE_TRANSFER_BIT : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+  VkPipelineStageFlags destination_stage = release ? VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT : VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+  vkCmdPipelineBarrier(command_buffer, source_stage, destination_stage, 0,
+      0, nullptr, buffer_memory_barriers.size(), buffer_memory_barriers.data(), 0, nullptr);
+  return 0;
+}
+
+
+int create_timeline_semaphore(
+    VkDevice 						device,
+    VkAllocationCallbacks* 				allocation,
+    VkSemaphore 					&semaphore
+    )
+{
+  VkSemaphoreTypeCreateInfo semaphore_type_create_info = { };
+  semaphore_type_create_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+  semaphore_type_create_info.pNext = nullptr;
+  semaphore_type_create_info.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+  semaphore_type_create_info.initialValue = 0;
+
+  VkSemaphoreCreateInfo semaphore_create_info = { };
+  semaphore_create_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+  semaphore_create_info.pNext = &semaphore_type_create_info;
+  semaphore_create_info.flags = 0;
+
+  VkResult result = vkCreateSemaphore(device, &semaphore_create_info, allocation, &semaphore);
+  if (result != VK_SUCCESS)
+    throw me::exception("failed to create timeline semaphore [%s]", me::util::get_result_string(result));
+  return 0;
+}
+
+int create_command_pool(
+    VkDevice 						device,
+    VkAllocationCallbacks* 				allocation,
+    uint32_t 						queue_family,
+    VkCommandPool 					&command_pool
+    )
+{
+  VkCommandPoolCreateInfo command_pool_create_info = { };
+  command_pool_create_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+  command_pool_create_info.pNext = nullptr;
+  command_pool_create_info.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+  command_pool_create_info.queueFamilyIndex = queue_family;
+
+  VkResult result = vkCreateCommandPool(device, &command_pool_create_info, allocation, &command_pool);
+  if (result != VK_SUCCESS)
+    throw me::exception("failed to create upload command pool [%s]", me::util::get_result_string(result));
+  return 0;
+}
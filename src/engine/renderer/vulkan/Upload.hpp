@@ -0,0 +1,146 @@
+#ifndef ME_VULKAN_UPLOAD_HPP
+  #define ME_VULKAN_UPLOAD_HPP
+
+#include "Staging.hpp"
+
+#include <lme/vector.hpp>
+
+#include <vulkan/vulkan.h>
+
+namespace me::memory {
+
+  /* records buffer uploads into transfer queue command buffers and submits them without waiting.
+   * every submit signals the next value of a timeline semaphore, the value is the ticket of the submit.
+   * before the graphics queue uses uploaded buffers, 'acquire()' makes it wait for the uploads
+   * and takes ownership of the buffers if the transfer queue is from another family */
+  class Uploader {
+
+  public:
+
+    static constexpr VkDeviceSize STAGING_ALIGNMENT = 16;
+
+    struct UploadInfo {
+      VkBuffer buffer;
+      VkDeviceSize offset;
+      const void* data;
+      VkDeviceSize size;
+    };
+
+  protected:
+
+    struct Region {
+      VkBuffer vk_buffer;
+      VkDeviceSize offset;
+      VkDeviceSize size;
+    };
+
+    struct Copy {
+      VkBuffer src_buffer;
+      VkBuffer dst_buffer;
+      VkBufferCopy region;
+    };
+
+    struct CommandBuffer {
+      VkCommandBuffer vk_command_buffer;
+      uint64_t value; /* reusable once the semaphore it was submitted with has reached this */
+    };
+
+    VkDevice vk_device;
+    VkAllocationCallbacks* vk_allocation;
+    StagingRing &staging_ring;
+
+    uint32_t transfer_queue_family;
+    uint32_t graphics_queue_family;
+
+    VkQueue vk_transfer_queue;
+    VkCommandPool vk_transfer_command_pool;
+    VkCommandPool vk_graphics_command_pool;
+
+    VkSemaphore vk_transfer_semaphore;
+    uint64_t transfer_value; /* value of the last transfer submit */
+    VkSemaphore vk_acquire_semaphore;
+    uint64_t acquire_value; /* value of the last acquire submit */
+    uint64_t acquired_value; /* last transfer value the graphics queue has waited for */
+
+    VkCommandBuffer vk_recording;
+    vector<Region> recording_regions; /* written by the command buffer being recorded */
+    vector<Region> released_regions; /* submitted but not acquired by the graphics queue yet */
+    vector<Copy> graphics_copies; /* recorded by the next 'acquire()' */
+    vector<VkBufferMemoryBarrier> buffer_memory_barriers; /* scratch of 'record_ownership_barriers()', kept between batches */
+
+    vector<CommandBuffer> transfer_command_buffers;
+    vector<CommandBuffer> graphics_command_buffers;
+
+  public:
+
+    Uploader(VkDevice device, VkAllocationCallbacks* allocation, StagingRing &staging_ring,
+	uint32_t transfer_queue_family, uint32_t graphics_queue_family);
+
+    int initialize();
+    int cleanup();
+
+    /* copies 'data' to the staging ring and records a copy to 'buffer', nothing is submitted */
+    int upload(
+	VkBuffer 					buffer,
+	VkDeviceSize 					offset,
+	const void* 					data,
+	VkDeviceSize 					size
+	);
+
+    /* packs the uploads into as few staging reservations as possible,
+     * consecutive uploads to the same buffer are recorded as one multi-region copy */
+    int upload_batch(
+	uint32_t 					upload_count,
+	const UploadInfo* 				uploads
+	);
+
+    /* copies between device buffers. with a single queue family the copy is recorded like an upload,
+     * otherwise it is recorded on the graphics queue by the next 'acquire()' so the source
+     * doesn't need an ownership transfer. either way it completes before the next frame reads 'dst' */
+    int copy(
+	VkBuffer 					src,
+	VkDeviceSize 					src_offset,
+	VkBuffer 					dst,
+	VkDeviceSize 					dst_offset,
+	VkDeviceSize 					size
+	);
+
+    /* like 'copy()' for many regions between the same two buffers, recorded as one copy command.
+     * earlier uploads to the source ranges are made visible to it first */
+    int copy_regions(
+	VkBuffer 					src,
+	VkBuffer 					dst,
+	uint32_t 					region_count,
+	const VkBufferCopy* 				regions
+	);
+
+    /* submits the recorded uploads, 'ticket' is reached once they have completed */
+    int flush(
+	uint64_t 					&ticket
+	);
+
+    /* flushes and makes 'graphics_queue' wait for every upload submitted so far */
+    int acquire(
+	VkQueue 					graphics_queue
+	);
+
+    int wait(
+	uint64_t 					ticket
+	);
+
+    bool is_complete(
+	uint64_t 					ticket
+	);
+
+  protected:
+
+    int reserve_staging(VkDeviceSize size, VkDeviceSize &offset, char* &data);
+    int begin_recording();
+    int get_command_buffer(VkCommandPool command_pool, VkSemaphore semaphore, vector<CommandBuffer> &command_buffers, size_t &index);
+    int record_ownership_barriers(VkCommandBuffer command_buffer, const vector<Region> &regions, bool release);
+
+  };
+
+}
+
+#endif
@@ -1,5 +1,7 @@
 #include "Util.hpp"
 
+#include <lme/math/math.hpp>
+
 #include <string.h>
 
 bool me::util::has_required_extensions(
@@ -48,6 +50,24 @@ bool me::util::has_required_layers(
   return true;
 }
 
+int me::util::get_surface_extent(
+    const VkSurfaceCapabilitiesKHR 			&surface_capabilities,
+    VkExtent2D 						&image_extent
+    )
+{
+  if (surface_capabilities.currentExtent.width != UINT32_MAX)
+    image_extent = surface_capabilities.currentExtent;
+
+  /* if extent.width/height is more than max image width/height; set the extent.width/height to max image width/height */
+  image_extent.width = math::min(image_extent.width, surface_capabilities.maxImageExtent.width);
+  image_extent.height = math::min(image_extent.height, surface_capabilities.maxImageExtent.height);
+
+  /* if extent.width/height is less than min image width/height; set the extent.width/height to min image width/height */
+  image_extent.width = math::max(image_extent.width, surface_capabilities.minImageExtent.width);
+  image_extent.height = math::max(image_extent.height, surface_capabilities.minImageExtent.height);
+  return 0;
+}
+
 #define ENUMSTR(i, e) if (e == i) return #e;
 
 const char* me::util::get_result_string(
@@ -155,11 +175,42 @@ VkFormat me::util::get_vulkan_format(
       return VK_FORMAT_R32G32B32_SFLOAT;
     case FORMAT_VECTOR4_32FLOAT:
       return VK_FORMAT_R32G32B32A32_SFLOAT;
+    case FORMAT_VECTOR4_8UNORM:
+      return VK_FORMAT_R8G8B8A8_UNORM;
+    case FORMAT_VECTOR4_16FLOAT:
+      return VK_FORMAT_R16G16B16A16_SFLOAT;
+    case FORMAT_DEPTH_32FLOAT:
+      return VK_FORMAT_D32_SFLOAT;
     default:
       return VK_FORMAT_MAX_ENUM;
   }
 }
 
+uint32_t me::util::get_vulkan_format_size(
+    VkFormat format
+    )
+{
+  switch (format)
+  {
+    case VK_FORMAT_R32_SFLOAT:
+      return 4;
+    case VK_FORMAT_R32G32_SFLOAT:
+      return 8;
+    case VK_FORMAT_R32G32B32_SFLOAT:
+      return 12;
+    case VK_FORMAT_R32G32B32A32_SFLOAT:
+      return 16;
+    case VK_FORMAT_R8G8B8A8_UNORM:
+      return 4;
+    case VK_FORMAT_R16G16B16A16_SFLOAT:
+      return 8;
+    case VK_FORMAT_D32_SFLOAT:
+      return 4;
+    default:
+      return 0;
+  }
+}
+
 VkDescriptorType me::util::get_vulkan_descriptor_type(
     DescriptorType descriptor_type
     )
@@ -168,7 +219,34 @@ VkDescriptorType me::util::get_vulkan_descriptor_type(
   {
     case DESCRIPTOR_TYPE_UNIFORM:
       return VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    case DESCRIPTOR_TYPE_UNIFORM_DYNAMIC:
+      return VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
     default:
       return VK_DESCRIPTOR_TYPE_MAX_ENUM;
   }
 }
+
+VkSampleCountFlagBits me::util::get_vulkan_sample_count(
+    SampleCount sample_count
+    )
+{
+  switch (sample_count)
+  {
+    case SAMPLE_COUNT_1:
+      return VK_SAMPLE_COUNT_1_BIT;
+    case SAMPLE_COUNT_2:
+      return VK_SAMPLE_COUNT_2_BIT;
+    case SAMPLE_COUNT_4:
+      return VK_SAMPLE_COUNT_4_BIT;
+    case SAMPLE_COUNT_8:
+      return VK_SAMPLE_COUNT_8_BIT;
+    case SAMPLE_COUNT_16:
+      return VK_SAMPLE_COUNT_16_BIT;
+    case SAMPLE_COUNT_32:
+      return VK_SAMPLE_COUNT_32_BIT;
+    case SAMPLE_COUNT_64:
+      return VK_SAMPLE_COUNT_64_BIT;
+    default:
+      return VK_SAMPLE_COUNT_1_BIT;
+  }
+}
@@ -19,6 +19,12 @@ namespace me::util {
       const array_proxy<const char*>			&required_layers
       );
 
+  /* the current extent of the surface, or the framebuffer size clamped to what the surface supports */
+  int get_surface_extent(
+      const VkSurfaceCapabilitiesKHR 			&surface_capabilities,
+      VkExtent2D 					&image_extent
+      );
+
   const char* get_result_string(
       VkResult 						result
       );
@@ -35,10 +41,19 @@ namespace me::util {
       Format format
       );
 
+  /* bytes per texel of the formats 'get_vulkan_format' returns, 0 for others */
+  uint32_t get_vulkan_format_size(
+      VkFormat format
+      );
+
   VkDescriptorType get_vulkan_descriptor_type(
       DescriptorType descriptor_type
       );
 
+  VkSampleCountFlagBits get_vulkan_sample_count(
+      SampleCount sample_count
+      );
+
 }
 
 #endif
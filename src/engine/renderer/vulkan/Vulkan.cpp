@@ -54,20 +54,43 @@ int me::Vulkan::tick(const ModuleInfo module_info)
 int me::Vulkan::frame_prepare(const FramePrepareInfo &frame_prepare_info, FramePrepared &frame_prepared)
 {
   VkDevice vk_device = reinterpret_cast<Device_T*>(frame_prepare_info.device)->vk_device;
-  VkSwapchainKHR vk_swapchain = reinterpret_cast<Swapchain_T*>(frame_prepare_info.swapchain)->vk_swapchain;
   VkSemaphore &vk_frame_image_available_semaphore = reinterpret_cast<Frame_T*>(frame_prepare_info.frame)->vk_image_available_semaphore;
   VkFence &vk_frame_in_flight_fence = reinterpret_cast<Frame_T*>(frame_prepare_info.frame)->vk_in_flight_fence;
+  memory::ResidencyManager* residency = reinterpret_cast<Device_T*>(frame_prepare_info.device)->residency;
+  descriptor::BindlessTable* bindless_table = reinterpret_cast<Device_T*>(frame_prepare_info.device)->bindless_table;
+  descriptor::FrameDescriptorAllocator* frame_descriptors = reinterpret_cast<Device_T*>(frame_prepare_info.device)->frame_descriptors;
+  command::FrameCommandAllocator* frame_commands = reinterpret_cast<Device_T*>(frame_prepare_info.device)->frame_commands;
+  query::TimestampProfiler* timestamps = reinterpret_cast<Device_T*>(frame_prepare_info.device)->timestamps;
 
   vkWaitForFences(vk_device, 1, &vk_frame_in_flight_fence, VK_TRUE, UINT64_MAX);
+  residency->begin_frame();
+  if (bindless_table != nullptr)
+    bindless_table->begin_frame();
+  frame_descriptors->begin_frame(frame_prepare_info.frame_index);
+  frame_commands->begin_frame(frame_prepare_info.frame_index);
+  if (timestamps != nullptr)
+    timestamps->begin_frame(frame_prepare_info.frame_index);
+
+  /* offscreen frames render into attachments that are always there */
+  if (frame_prepare_info.swapchain == nullptr)
+  {
+    frame_prepared = 0;
+    return 0;
+  }
+
+  VkSwapchainKHR vk_swapchain = reinterpret_cast<Swapchain_T*>(frame_prepare_info.swapchain)->vk_swapchain;
 
   uint32_t image_index;
   VkResult result = vkAcquireNextImageKHR(vk_device, vk_swapchain, UINT64_MAX,
       vk_frame_image_available_semaphore, VK_NULL_HANDLE, &image_index);
 
+  /* no image was acquired, the frame is skipped and the swapchain recreated.
+   * a suboptimal swapchain still has an image, it is refreshed after presenting */
   uint8_t flags = 0;
   if (result == VK_ERROR_OUT_OF_DATE_KHR)
   {
     flags |= FRAME_SWAPCHAIN_REFRESH_FLAG;
+    image_index = 0;
   }else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR)
     throw exception("failed to acquire next image [%s]", util::get_result_string(result));
 
@@ -79,35 +102,48 @@ int me::Vulkan::frame_render(const FrameRenderInfo &frame_render_info, FrameRend
 {
   VkDevice vk_device = reinterpret_cast<Device_T*>(frame_render_info.device)->vk_device;
   VkQueue vk_queue = reinterpret_cast<Queue_T*>(frame_render_info.queue)->vk_queue;
-  VkFence &vk_image_in_flight_fence = reinterpret_cast<SwapchainImage_T*>(frame_render_info.image)->vk_in_flight_fence;
   VkSemaphore &vk_frame_image_available_semaphore = reinterpret_cast<Frame_T*>(frame_render_info.frame)->vk_image_available_semaphore;
   VkSemaphore &vk_frame_render_finished_semaphore = reinterpret_cast<Frame_T*>(frame_render_info.frame)->vk_render_finished_semaphore;
   VkFence &vk_frame_in_flight_fence = reinterpret_cast<Frame_T*>(frame_render_info.frame)->vk_in_flight_fence;
+  uint64_t &frame_submit_count = reinterpret_cast<Frame_T*>(frame_render_info.frame)->submit_count;
+  memory::Uploader* uploader = reinterpret_cast<Device_T*>(frame_render_info.device)->uploader;
+  query::TimestampProfiler* timestamps = reinterpret_cast<Device_T*>(frame_render_info.device)->timestamps;
 
-  if (vk_image_in_flight_fence != VK_NULL_HANDLE)
-    vkWaitForFences(vk_device, 1, &vk_image_in_flight_fence, VK_TRUE, UINT64_MAX);
-  vk_image_in_flight_fence = vk_frame_in_flight_fence;
+  /* submit pending uploads and make the frame wait for them */
+  uploader->acquire(vk_queue);
+
+  /* offscreen frames have no image to wait for and nothing waits for them to present */
+  bool offscreen = frame_render_info.image == nullptr;
+  if (!offscreen)
+  {
+    VkFence &vk_image_in_flight_fence = reinterpret_cast<SwapchainImage_T*>(frame_render_info.image)->vk_in_flight_fence;
+    if (vk_image_in_flight_fence != VK_NULL_HANDLE)
+      vkWaitForFences(vk_device, 1, &vk_image_in_flight_fence, VK_TRUE, UINT64_MAX);
+    vk_image_in_flight_fence = vk_frame_in_flight_fence;
+  }
 
   // refresh_uniform_buffers(render_info);
 
   /* create wait semaphores */
-  static uint32_t wait_semaphore_count = 1;
-  VkSemaphore wait_semaphores[wait_semaphore_count];
+  uint32_t wait_semaphore_count = offscreen ? 0 : 1;
+  VkSemaphore wait_semaphores[1];
   wait_semaphores[0] = vk_frame_image_available_semaphore;
 
   /* create wait stages */
-  static uint32_t wait_stage_count = 1;
-  VkPipelineStageFlags wait_stages[wait_stage_count];
+  VkPipelineStageFlags wait_stages[1];
   wait_stages[0] = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
 
-  /* get command buffers */
-  VkCommandBuffer command_buffers[frame_render_info.command_buffer_count];
+  /* get command buffers, the frame's timestamp queries are reset before any of them writes one */
+  uint32_t command_buffer_count = 0;
+  VkCommandBuffer command_buffers[frame_render_info.command_buffer_count + 1];
+  if (timestamps != nullptr)
+    command_buffers[command_buffer_count++] = timestamps->submit_frame();
   for (uint32_t i = 0; i < frame_render_info.command_buffer_count; i++)
-    command_buffers[i] = reinterpret_cast<CommandBuffer_T*>(frame_render_info.command_buffers[i])->vk_command_buffer;
+    command_buffers[command_buffer_count++] = reinterpret_cast<CommandBuffer_T*>(frame_render_info.command_buffers[i])->vk_command_buffer;
 
-  /* get signal semaphores */
-  static constexpr uint32_t signal_semaphore_count = 1;
-  VkSemaphore signal_semaphores[signal_semaphore_count];
+  /* get signal semaphores, a binary semaphore that nothing waits for could never be signaled again */
+  uint32_t signal_semaphore_count = offscreen ? 0 : 1;
+  VkSemaphore signal_semaphores[1];
   signal_semaphores[0] = vk_frame_render_finished_semaphore;
 
   /* create submit infos */
@@ -118,16 +154,18 @@ int me::Vulkan::frame_render(const FrameRenderInfo &frame_render_info, FrameRend
   submit_infos[0].waitSemaphoreCount = wait_semaphore_count;
   submit_infos[0].pWaitSemaphores = wait_semaphores;
   submit_infos[0].pWaitDstStageMask = wait_stages;
-  submit_infos[0].commandBufferCount = frame_render_info.command_buffer_count;
+  submit_infos[0].commandBufferCount = command_buffer_count;
   submit_infos[0].pCommandBuffers = command_buffers;
   submit_infos[0].signalSemaphoreCount = signal_semaphore_count;
   submit_infos[0].pSignalSemaphores = signal_semaphores;
 
-  vkResetFences(vk_device, 1, &vk_image_in_flight_fence);
+  /* the image's fence is the frame's fence now */
+  vkResetFences(vk_device, 1, &vk_frame_in_flight_fence);
 
-  VkResult result = vkQueueSubmit(vk_queue, submit_info_count, submit_infos, vk_image_in_flight_fence);
+  VkResult result = vkQueueSubmit(vk_queue, submit_info_count, submit_infos, vk_frame_in_flight_fence);
   if (result != VK_SUCCESS)
     throw exception("failed to queue submit [%s]", util::get_result_string(result));
+  frame_submit_count++;
 
   uint8_t flags = 0;
   frame_rendered = flags;
@@ -161,9 +199,9 @@ int me::Vulkan::frame_present(const FramePresentInfo &frame_present_info, FrameP
 
   uint8_t flags = 0;
   VkResult result = vkQueuePresentKHR(vk_queue, &present_info);
-  if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || flags & FRAME_SWAPCHAIN_REFRESH_FLAG)
+  if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR)
   {
-    flags &= ~FRAME_SWAPCHAIN_REFRESH_FLAG;
+    flags |= FRAME_SWAPCHAIN_REFRESH_FLAG;
   }else if (result != VK_SUCCESS)
     throw exception("failed to queue present [%s]", util::get_result_string(result));
 
@@ -180,45 +218,47 @@ int me::Vulkan::frame_prepared_get_image_index(FramePrepared frame_prepared, uin
 
 int me::Vulkan::setup_mesh(const SetupMeshInfo &setup_mesh_info, Mesh* mesh)
 {
-  size_t vertex_buffer_size = mesh->vertices.size() * sizeof(Vertex);
-  size_t index_buffer_size = mesh->indices.size() * sizeof(Index);
-
-  BufferCreateInfo vertex_buffer_create_info = {};
-  vertex_buffer_create_info.type = STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-  vertex_buffer_create_info.next = nullptr;
-  vertex_buffer_create_info.physical_device = setup_mesh_info.physical_device;
-  vertex_buffer_create_info.device = setup_mesh_info.device;
-  vertex_buffer_create_info.usage = BUFFER_USAGE_VERTEX_BUFFER;
-  vertex_buffer_create_info.write_method = BUFFER_WRITE_METHOD_STAGING;
-  vertex_buffer_create_info.size = vertex_buffer_size;
-  create_buffer(vertex_buffer_create_info, mesh->vertex_buffer);
-
-  BufferCreateInfo index_buffer_create_info = {};
-  index_buffer_create_info.type = STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-  index_buffer_create_info.next = nullptr;
-  index_buffer_create_info.physical_device = setup_mesh_info.physical_device;
-  index_buffer_create_info.device = setup_mesh_info.device;
-  index_buffer_create_info.usage = BUFFER_USAGE_INDEX_BUFFER;
-  index_buffer_create_info.write_method = BUFFER_WRITE_METHOD_STAGING;
-  index_buffer_create_info.size = index_buffer_size;
-  create_buffer(index_buffer_create_info, mesh->index_buffer);
-
-  BufferWriteInfo vertex_buffer_wrtie_info = {};
-  vertex_buffer_wrtie_info.physical_device = setup_mesh_info.physical_device;
-  vertex_buffer_wrtie_info.device = setup_mesh_info.device;
-  vertex_buffer_wrtie_info.transfer_queue = setup_mesh_info.transfer_queue;
-  vertex_buffer_wrtie_info.transfer_command_pool = setup_mesh_info.transfer_command_pool;
-  vertex_buffer_wrtie_info.byte_count = vertex_buffer_size;
-  vertex_buffer_wrtie_info.bytes = mesh->vertices.data();
-  buffer_write(vertex_buffer_wrtie_info, mesh->vertex_buffer);
-
-  BufferWriteInfo index_buffer_wrtie_info = {};
-  index_buffer_wrtie_info.physical_device = setup_mesh_info.physical_device;
-  index_buffer_wrtie_info.device = setup_mesh_info.device;
-  index_buffer_wrtie_info.transfer_queue = setup_mesh_info.transfer_queue;
-  index_buffer_wrtie_info.transfer_command_pool = setup_mesh_info.transfer_command_pool;
-  index_buffer_wrtie_info.byte_count = index_buffer_size;
-  index_buffer_wrtie_info.bytes = mesh->indices.data();
-  buffer_write(index_buffer_wrtie_info, mesh->index_buffer);
+  return setup_meshes(setup_mesh_info, 1, &mesh);
+}
+
+int me::Vulkan::setup_meshes(const SetupMeshInfo &setup_mesh_info, uint32_t mesh_count, Mesh** meshes)
+{
+  memory::Uploader* uploader = reinterpret_cast<Device_T*>(setup_mesh_info.device)->uploader;
+  memory::ResidencyManager* residency = reinterpret_cast<Device_T*>(setup_mesh_info.device)->residency;
+
+  for (uint32_t i = 0; i < mesh_count; i++)
+    residency->add(meshes[i]);
+
+  /* one staging pass and one submit for all meshes that fit in the budget */
+  residency->prefetch(mesh_count, meshes);
+
+  TransferTicket ticket;
+  uploader->flush(ticket);
+  return 0;
+}
+
+int me::Vulkan::cleanup_mesh(Device device, Mesh* mesh)
+{
+  memory::ResidencyManager* residency = reinterpret_cast<Device_T*>(device)->residency;
+
+  residency->remove(mesh);
+  mesh->vertex_count = 0;
+  mesh->index_count = 0;
+  return 0;
+}
+
+int me::Vulkan::make_meshes_resident(Device device, uint32_t mesh_count, Mesh** meshes)
+{
+  memory::ResidencyManager* residency = reinterpret_cast<Device_T*>(device)->residency;
+
+  residency->make_resident(mesh_count, meshes);
+  return 0;
+}
+
+int me::Vulkan::set_residency_budget(Device device, size_t bytes)
+{
+  memory::ResidencyManager* residency = reinterpret_cast<Device_T*>(device)->residency;
+
+  residency->set_budget(bytes);
   return 0;
 }
@@ -55,11 +55,16 @@ namespace me {
     int create_buffer(const BufferCreateInfo &buffer_create_info, Buffer &buffer) override;
     int create_render_pass(const RenderPassCreateInfo &render_pass_create_info, RenderPass &render_pass) override;
     int create_pipeline(const PipelineCreateInfo &pipeline_create_info, Pipeline &pipeline) override;
+    int create_pipeline_async(const PipelineCreateInfo &pipeline_create_info, PipelineBuild &build) override;
     int create_framebuffer(const FramebufferCreateInfo &framebuffer_create_info, Framebuffer &framebuffer) override;
     int create_descriptor_pool(const DescriptorPoolCreateInfo &descriptor_pool_create_info, DescriptorPool &descriptor_pool) override;
     int create_descriptors(const DescriptorCreateInfo &descriptor_create_info, uint32_t descriptor_count, Descriptor* descriptors) override;
     int create_command_pool(const CommandPoolCreateInfo &command_pool_create_info, CommandPool &command_pool) override;
     int create_command_buffers(const CommandBufferCreateInfo &command_buffer_create_info, uint32_t buffer_count, CommandBuffer* buffers) override;
+    int create_uniform_ring(const UniformRingCreateInfo &uniform_ring_create_info, UniformRing &uniform_ring) override;
+    int create_attachments(const AttachmentCreateInfo &attachment_create_info, uint32_t attachment_count, Attachment* attachments) override;
+    int create_indirect_draw_list(const IndirectDrawListCreateInfo &indirect_draw_list_create_info, IndirectDrawList &draw_list) override;
+    int create_readback_ring(const ReadbackRingCreateInfo &readback_ring_create_info, ReadbackRing &readback_ring) override;
 
     int cleanup_surface(Surface surface) override;
     int cleanup_device(Device device) override;
@@ -68,20 +73,54 @@ namespace me {
     int cleanup_frames(Device device, uint32_t frame_count, Frame* frames) override;
     int cleanup_render_pass(Device device, RenderPass render_pass) override;
     int cleanup_pipeline(Device device, Pipeline pipeline) override;
+    int cleanup_pipeline_build(Device device, PipelineBuild build) override;
     int cleanup_framebuffer(Device device, Framebuffer framebuffer) override;
+    int cleanup_buffer(Device device, Buffer buffer) override;
     int cleanup_descriptor_pool(Device device, DescriptorPool descriptor_pool) override;
     int cleanup_descriptors(Device device, DescriptorPool descriptor_pool, uint32_t descriptor_count, Descriptor* descriptors) override;
     int cleanup_command_pool(Device device, CommandPool command_pool) override;
     int cleanup_command_buffers(Device device, CommandPool command_pool, uint32_t buffer_count, CommandBuffer* buffers) override;
+    int reset_command_pool(Device device, CommandPool command_pool) override;
+    int cleanup_uniform_ring(Device device, UniformRing uniform_ring) override;
+    int cleanup_attachments(Device device, uint32_t attachment_count, Attachment* attachments) override;
+    int cleanup_indirect_draw_list(Device device, IndirectDrawList draw_list) override;
+    int cleanup_readback_ring(Device device, ReadbackRing readback_ring) override;
 
     int buffer_write(const BufferWriteInfo &buffer_write_info, Buffer buffer) override;
+    int buffer_flush(Device device, Buffer buffer, size_t offset, size_t size) override;
+
+    int transfer_flush(Device device, TransferTicket &ticket) override;
+    int transfer_wait(Device device, TransferTicket ticket) override;
+    int transfer_is_complete(Device device, TransferTicket ticket, bool &complete) override;
+
+    int defragment(Device device, size_t byte_budget, uint32_t &moved_count) override;
+
+    int bindless_add_buffer(Device device, Buffer buffer, uint32_t &index) override;
+    int bindless_remove_buffer(Device device, uint32_t index) override;
+
+    int uniform_ring_begin_frame(UniformRing uniform_ring, uint32_t frame_index) override;
+    int uniform_ring_push(UniformRing uniform_ring, const void* data, size_t size, uint32_t &offset) override;
+
+    int indirect_draw_list_write(const IndirectDrawListWriteInfo &indirect_draw_list_write_info, IndirectDrawList draw_list) override;
+
+    int readback_ring_acquire(ReadbackRing readback_ring, Readback &readback, bool &available) override;
+    int readback_ring_release(ReadbackRing readback_ring) override;
 
     int cmd_record_start(CommandBuffer command_buffer) override;
     int cmd_record_stop(CommandBuffer command_buffer) override;
+    int cmd_record_secondary_start(const CmdRecordSecondaryInfo &cmd_record_secondary_info, CommandBuffer command_buffer) override;
+    int cmd_execute(CommandBuffer command_buffer, uint32_t secondary_count, CommandBuffer* secondaries) override;
     int cmd_begin_render_pass(const CmdBeginRenderPassInfo &cmd_begin_render_pass_info, CommandBuffer command_buffer) override;
     int cmd_end_render_pass(CommandBuffer command_buffer) override;
+    int cmd_set_viewport(const CmdSetViewportInfo &cmd_set_viewport_info, CommandBuffer command_buffer) override;
     int cmd_bind_descriptors(const CmdBindDescriptorsInfo &cmd_bind_descriptors_info, CommandBuffer command_buffer) override;
     int cmd_draw_meshes(const CmdDrawMeshesInfo &cmd_draw_meshes_info, CommandBuffer command_buffer) override;
+    int cmd_draw_list(const CmdDrawListInfo &cmd_draw_list_info, CommandBuffer command_buffer) override;
+    int cmd_cull_indirect(const CmdCullIndirectInfo &cmd_cull_indirect_info, CommandBuffer command_buffer) override;
+    int cmd_draw_indirect(const CmdDrawIndirectInfo &cmd_draw_indirect_info, CommandBuffer command_buffer) override;
+    int cmd_begin_profile_region(const char* label, CommandBuffer command_buffer, ProfileRegion &region) override;
+    int cmd_end_profile_region(ProfileRegion region, CommandBuffer command_buffer) override;
+    int cmd_readback(const CmdReadbackInfo &cmd_readback_info, CommandBuffer command_buffer) override;
 
     int frame_prepare(const FramePrepareInfo &frame_prepare_info, FramePresented &frame_prepared) override;
     int frame_render(const FrameRenderInfo &frame_render_info, FrameRendered &frame_rendered) override;
@@ -89,10 +128,19 @@ namespace me {
 
     int get_physical_device_properties(PhysicalDevice physical_device, PhysicalDeviceProperties &physical_device_properties) override;
     int get_swapchain_image_count(Device device, Swapchain swapchain, uint32_t &image_count) override;
+    int get_swapchain_extent(Swapchain swapchain, math::vec2u &extent) override;
+    int get_buffer_data(Buffer buffer, void* &data) override;
+    int get_memory_budget(Device device, uint32_t &heap_count, MemoryHeapBudget* budgets) override;
+    int get_uniform_ring_buffer(UniformRing uniform_ring, Buffer &buffer) override;
+    int get_pipeline_build(PipelineBuild build, Pipeline fallback, PipelineBuildStatus &status, Pipeline &pipeline) override;
 
     int frame_prepared_get_image_index(FramePrepared frame_prepared, uint32_t &image_index) override;
 
     int setup_mesh(const SetupMeshInfo &setup_mesh_info, Mesh* mesh) override;
+    int setup_meshes(const SetupMeshInfo &setup_mesh_info, uint32_t mesh_count, Mesh** meshes) override;
+    int cleanup_mesh(Device device, Mesh* mesh) override;
+    int make_meshes_resident(Device device, uint32_t mesh_count, Mesh** meshes) override;
+    int set_residency_budget(Device device, size_t bytes) override;
 
   protected:
 
@@ -2,8 +2,8 @@
   #define ME_MATERIAL_HPP
 
 #include "../resources/Image.hpp"
+#include "../util/Symbol.hpp"
 
-#include <lme/string.hpp>
 #include <lme/math/vector.hpp>
 
 namespace me {
@@ -32,7 +32,7 @@ namespace me {
 
   public:
 
-    string identifier;
+    Symbol identifier;
     MaterialColor diffuse;
     MaterialColor emission;
 
@@ -3,15 +3,17 @@
 
 #include "Material.hpp"
 #include "../renderer/Types.hpp"
+#include "../util/Symbol.hpp"
+#include "../memory/ArenaVector.hpp"
 
 #include <lme/math/vector.hpp>
 #include <lme/vector.hpp>
-#include <lme/string.hpp>
 
 namespace me {
 
   enum MeshFlag {
-    MESH_VISIBLE_FLAG = 1
+    MESH_VISIBLE_FLAG = 1,
+    MESH_ARENA_FLAG = 1 << 1 /* the item and its mesh are in an arena and freed with it, never deleted */
   };
 
 
@@ -31,12 +33,26 @@ namespace me {
 
   public:
 
-    string identifier;
-    vector<Vertex> vertices;
-    vector<Index> indices;
+    Symbol identifier;
+    ArenaVector<Vertex> vertices;
+    ArenaVector<Index> indices;
 
-    Buffer vertex_buffer;
-    Buffer index_buffer;
+    /* ranges in the device's geometry pool, set by 'RendererModule::setup_mesh' */
+    uint32_t vertex_offset;
+    uint32_t vertex_count;
+    uint32_t first_index;
+    uint32_t index_count;
+
+    /* the ranges are only valid while resident, evicted meshes are streamed in again when drawn */
+    bool resident;
+    uint64_t last_used_frame;
+    uint32_t residency_index;
+
+    /* the geometry goes into the arena the mesh is allocated from, or on the heap without one */
+    explicit Mesh(Arena* arena = nullptr)
+      : vertices(arena), indices(arena)
+    {
+    }
 
   };
 
@@ -45,7 +61,7 @@ namespace me {
 
   public:
 
-    string identifier;
+    Symbol identifier;
     Mesh* mesh;
     Material* material;
     math::vec3f position, rotation, scale;
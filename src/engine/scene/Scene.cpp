@@ -0,0 +1,13 @@
+#include "Scene.hpp"
+
+me::Scene::~Scene()
+{
+  /* items in the arena go with it */
+  for (MeshItem* mesh_item : meshes)
+  {
+    if (mesh_item->flags & MESH_ARENA_FLAG)
+      continue;
+    delete mesh_item->mesh;
+    delete mesh_item;
+  }
+}
@@ -3,6 +3,7 @@
 
 #include "Mesh.hpp"
 #include "Camera.hpp"
+#include "../memory/Arena.hpp"
 
 namespace me {
 
@@ -10,9 +11,21 @@ namespace me {
 
   public:
 
+    static constexpr size_t DEFAULT_ARENA_SIZE = 1024ul * 1024 * 1024;
+
+    /* backing storage for scene objects and loader scratch data */
+    Arena arena;
+
     vector<Material*> materials;
     vector<MeshItem*> meshes;
     vector<Camera*> cameras;
+
+    explicit Scene(size_t arena_size = DEFAULT_ARENA_SIZE, uint32_t arena_flags = 0)
+      : arena(arena_size, arena_flags)
+    {
+    }
+
+    ~Scene();
   
   };
 
@@ -24,7 +24,7 @@ int me::WindowSurface::initialize(const ModuleInfo module_info)
   user_callbacks.init_surface(config);
 
   glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
-  glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
+  glfwWindowHint(GLFW_RESIZABLE, GLFW_TRUE);
   glfw_window = glfwCreateWindow(config.width, config.height, config.title, nullptr, nullptr);
   glfwSetWindowUserPointer(glfw_window, this);
   glfwSetFramebufferSizeCallback(glfw_window, glfw_framebuffer_size_callback);
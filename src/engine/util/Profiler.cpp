@@ -0,0 +1,112 @@
+#include "Profiler.hpp"
+
+#include <string.h>
+#include <time.h>
+
+me::Profiler::Profiler(uint32_t timeline_capacity)
+{
+  pthread_mutex_init(&mutex, nullptr);
+
+  timeline.resize(timeline_capacity > 0 ? timeline_capacity : 1);
+  timeline_next = 0;
+  timeline_count = 0;
+  frame = 0;
+}
+
+me::Profiler::~Profiler()
+{
+  pthread_mutex_destroy(&mutex);
+}
+
+int me::Profiler::begin_frame()
+{
+  pthread_mutex_lock(&mutex);
+  frame++;
+  pthread_mutex_unlock(&mutex);
+  return 0;
+}
+
+int me::Profiler::record(const ProfileEvent &event)
+{
+  uint64_t time = event.end > event.start ? event.end - event.start : 0;
+
+  pthread_mutex_lock(&mutex);
+  timeline[timeline_next] = event;
+  timeline_next = (timeline_next + 1) % timeline.size();
+  if (timeline_count < timeline.size())
+    timeline_count++;
+
+  ProfileStats &label_stats = get_label_stats(event.label, event.source);
+  if (label_stats.count == 0 || time < label_stats.min_time)
+    label_stats.min_time = time;
+  if (time > label_stats.max_time)
+    label_stats.max_time = time;
+  label_stats.count++;
+  label_stats.total_time += time;
+  label_stats.last_time = time;
+  pthread_mutex_unlock(&mutex);
+  return 0;
+}
+
+int me::Profiler::get_timeline(vector<ProfileEvent> &events)
+{
+  pthread_mutex_lock(&mutex);
+  /* gpu events are recorded frames after their cpu events, the timeline is in recording order */
+  size_t first = (timeline_next + timeline.size() - timeline_count) % timeline.size();
+  events.resize(timeline_count);
+  for (size_t i = 0; i < timeline_count; i++)
+    events[i] = timeline[(first + i) % timeline.size()];
+  pthread_mutex_unlock(&mutex);
+  return 0;
+}
+
+int me::Profiler::get_stats(vector<ProfileStats> &stats)
+{
+  pthread_mutex_lock(&mutex);
+  stats.resize(this->stats.size());
+  for (size_t i = 0; i < this->stats.size(); i++)
+    stats[i] = this->stats[i];
+  pthread_mutex_unlock(&mutex);
+  return 0;
+}
+
+uint64_t me::Profiler::get_frame()
+{
+  pthread_mutex_lock(&mutex);
+  uint64_t current_frame = frame;
+  pthread_mutex_unlock(&mutex);
+  return current_frame;
+}
+
+uint64_t me::Profiler::get_time()
+{
+  timespec time;
+  clock_gettime(CLOCK_MONOTONIC, &time);
+  return static_cast<uint64_t>(time.tv_sec) * 1000000000ULL + static_cast<uint64_t>(time.tv_nsec);
+}
+
+me::ProfileStats& me::Profiler::get_label_stats(const char* label, ProfileSource source)
+{
+  /* a handful of labels, a linear search is enough */
+  for (ProfileStats &label_stats : stats)
+  {
+    if (label_stats.source == source && (label_stats.label == label || strcmp(label_stats.label, label) == 0))
+      return label_stats;
+  }
+  stats.push_back({label, source, 0, 0, 0, 0, 0});
+  return stats[stats.size() - 1];
+}
+
+me::ProfileScope::ProfileScope(Profiler* profiler, const char* label)
+  : profiler(profiler), label(label)
+{
+  start = profiler != nullptr ? Profiler::get_time() : 0;
+}
+
+me::ProfileScope::~ProfileScope()
+{
+  if (profiler == nullptr)
+    return;
+
+  profiler->record({label, PROFILE_SOURCE_CPU, profiler->get_frame(), start, Profiler::get_time()});
+}
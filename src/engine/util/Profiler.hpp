@@ -0,0 +1,104 @@
+#ifndef ME_PROFILER_HPP
+  #define ME_PROFILER_HPP
+
+#include <lme/vector.hpp>
+
+#include <pthread.h>
+#include <stdint.h>
+
+namespace me {
+
+  enum ProfileSource {
+    PROFILE_SOURCE_CPU,
+    PROFILE_SOURCE_GPU
+  };
+
+  /* times are nanoseconds of 'Profiler::get_time()', gpu events are placed on the same clock */
+  struct ProfileEvent {
+    const char* label;
+    ProfileSource source;
+    uint64_t frame;
+    uint64_t start;
+    uint64_t end;
+  };
+
+  /* per label and source */
+  struct ProfileStats {
+    const char* label;
+    ProfileSource source;
+    uint64_t count;
+    uint64_t total_time;
+    uint64_t min_time;
+    uint64_t max_time;
+    uint64_t last_time;
+  };
+
+  /* collects timed regions of the cpu and the gpu into one timeline and keeps stats per label.
+   * the timeline is a ring of the latest events, the stats cover every event since the start.
+   * labels are compared by content and must stay valid as long as the profiler, like string literals.
+   * any thread can record */
+  class Profiler {
+
+  protected:
+
+    pthread_mutex_t mutex;
+
+    vector<ProfileEvent> timeline;
+    size_t timeline_next;
+    size_t timeline_count;
+
+    vector<ProfileStats> stats;
+    uint64_t frame;
+
+  public:
+
+    explicit Profiler(uint32_t timeline_capacity = 4096);
+    ~Profiler();
+
+    /* events recorded by 'ProfileScope' belong to the current frame afterwards */
+    int begin_frame();
+
+    int record(
+	const ProfileEvent 				&event
+	);
+
+    /* the oldest event first */
+    int get_timeline(
+	vector<ProfileEvent> 				&events
+	);
+
+    int get_stats(
+	vector<ProfileStats> 				&stats
+	);
+
+    uint64_t get_frame();
+
+    /* monotonic nanoseconds */
+    static uint64_t get_time();
+
+  protected:
+
+    ProfileStats& get_label_stats(const char* label, ProfileSource source);
+
+  };
+
+  /* records the cpu time from its construction to its destruction */
+  class ProfileScope {
+
+  protected:
+
+    Profiler* profiler;
+    const char* label;
+    uint64_t start;
+
+  public:
+
+    /* nothing is recorded without a profiler */
+    ProfileScope(Profiler* profiler, const char* label);
+    ~ProfileScope();
+
+  };
+
+}
+
+#endif
@@ -0,0 +1,184 @@
+#include "Symbol.hpp"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* entries are stored in fixed pages so a 'const char*' handed out by 'Symbol::c_str()'
+ * never moves when the table grows */
+static constexpr uint32_t ENTRY_PAGE_SHIFT = 12;
+static constexpr uint32_t ENTRY_PAGE_SIZE = 1 << ENTRY_PAGE_SHIFT;
+static constexpr uint32_t ENTRY_PAGE_COUNT = 1024;
+static constexpr size_t STRING_CHUNK_SIZE = 64 * 1024;
+
+struct SymbolEntry {
+  const char* str;
+  uint32_t len;
+  uint32_t hash;
+};
+
+static pthread_mutex_t symbol_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static SymbolEntry* entry_pages[ENTRY_PAGE_COUNT];
+static uint32_t entry_count = 0;
+
+/* open addressing table of symbol ids, 0 marks an empty slot */
+static uint32_t* slots = nullptr;
+static uint32_t slot_count = 0;
+
+static char* string_chunk = nullptr;
+static size_t string_chunk_used = STRING_CHUNK_SIZE;
+
+static uint32_t hash_string(const char* str, size_t len)
+{
+  /* FNV-1a */
+  uint32_t hash = 2166136261U;
+  for (size_t i = 0; i < len; i++)
+  {
+    hash ^= (uint8_t) str[i];
+    hash *= 16777619U;
+  }
+  return hash;
+}
+
+static SymbolEntry& get_entry(uint32_t id)
+{
+  return entry_pages[id >> ENTRY_PAGE_SHIFT][id & (ENTRY_PAGE_SIZE - 1)];
+}
+
+static const char* store_string(const char* str, size_t len)
+{
+  char* dest;
+  if (len + 1 > STRING_CHUNK_SIZE)
+  {
+    dest = (char*) malloc(len + 1);
+  }else
+  {
+    if (string_chunk_used + len + 1 > STRING_CHUNK_SIZE)
+    {
+      string_chunk = (char*) malloc(STRING_CHUNK_SIZE);
+      string_chunk_used = 0;
+    }
+    dest = string_chunk + string_chunk_used;
+    string_chunk_used += len + 1;
+  }
+
+  memcpy(dest, str, len);
+  dest[len] = '\0';
+  return dest;
+}
+
+static void insert_slot(uint32_t* table, uint32_t table_size, uint32_t hash, uint32_t id)
+{
+  uint32_t mask = table_size - 1;
+  for (uint32_t i = hash & mask; ; i = (i + 1) & mask)
+  {
+    if (table[i] == 0)
+    {
+      table[i] = id;
+      return;
+    }
+  }
+}
+
+static void grow_slots()
+{
+  uint32_t new_slot_count = slot_count == 0 ? 1024 : slot_count * 2;
+  uint32_t* new_slots = (uint32_t*) calloc(new_slot_count, sizeof(uint32_t));
+
+  for (uint32_t i = 0; i < slot_count; i++)
+  {
+    if (slots[i] != 0)
+      insert_slot(new_slots, new_slot_count, get_entry(slots[i]).hash, slots[i]);
+  }
+
+  free(slots);
+  slots = new_slots;
+  slot_count = new_slot_count;
+}
+
+static uint32_t push_entry(const char* str, uint32_t len, uint32_t hash)
+{
+  uint32_t id = entry_count;
+  uint32_t page = id >> ENTRY_PAGE_SHIFT;
+  if (entry_pages[page] == nullptr)
+    entry_pages[page] = (SymbolEntry*) malloc(ENTRY_PAGE_SIZE * sizeof(SymbolEntry));
+
+  entry_pages[page][id & (ENTRY_PAGE_SIZE - 1)] = {str, len, hash};
+  entry_count++;
+  return id;
+}
+
+
+const char* me::Symbol::c_str() const
+{
+  if (id == 0)
+    return "";
+  return get_entry(id).str;
+}
+
+size_t me::Symbol::size() const
+{
+  if (id == 0)
+    return 0;
+  return get_entry(id).len;
+}
+
+me::Symbol me::intern(const char* str, size_t len)
+{
+  if (len == 0)
+    return Symbol{0};
+
+  uint32_t hash = hash_string(str, len);
+
+  pthread_mutex_lock(&symbol_mutex);
+
+  /* id 0 is reserved for the empty string */
+  if (entry_count == 0)
+    push_entry("", 0, 0);
+
+  /* keep the load factor below 0.7 */
+  if ((entry_count + 1) * 10 >= slot_count * 7)
+    grow_slots();
+
+  uint32_t mask = slot_count - 1;
+  for (uint32_t i = hash & mask; slots[i] != 0; i = (i + 1) & mask)
+  {
+    const SymbolEntry &entry = get_entry(slots[i]);
+    if (entry.hash == hash && entry.len == len && memcmp(entry.str, str, len) == 0)
+    {
+      uint32_t id = slots[i];
+      pthread_mutex_unlock(&symbol_mutex);
+      return Symbol{id};
+    }
+  }
+
+  if ((entry_count >> ENTRY_PAGE_SHIFT) >= ENTRY_PAGE_COUNT)
+  {
+    pthread_mutex_unlock(&symbol_mutex);
+    throw exception("symbol table is full (%u symbols)", entry_count);
+  }
+
+  uint32_t id = push_entry(store_string(str, len), (uint32_t) len, hash);
+  insert_slot(slots, slot_count, hash, id);
+
+  pthread_mutex_unlock(&symbol_mutex);
+  return Symbol{id};
+}
+
+me::Symbol me::intern(const char* str)
+{
+  return intern(str, strlen(str));
+}
+
+me::Symbol me::intern(const string &str)
+{
+  return intern(str.c_str(), str.size());
+}
+
+me::Symbol me::intern(const string_view &str)
+{
+  char temp[str.size() + 1];
+  str.c_str(temp);
+  return intern(temp, str.size());
+}
@@ -0,0 +1,47 @@
+#ifndef ME_SYMBOL_HPP
+  #define ME_SYMBOL_HPP
+
+#include <lme/string.hpp>
+
+namespace me {
+
+  /* interned string. symbols interned from equal strings have the same id,
+   * so comparing two symbols is a single integer compare. id 0 is the empty string */
+  struct Symbol {
+
+    uint32_t id = 0;
+
+    bool operator==(const Symbol &symbol) const
+    {
+      return id == symbol.id;
+    }
+
+    bool operator!=(const Symbol &symbol) const
+    {
+      return id != symbol.id;
+    }
+
+    bool operator<(const Symbol &symbol) const
+    {
+      return id < symbol.id;
+    }
+
+    bool empty() const
+    {
+      return id == 0;
+    }
+
+    const char* c_str() const;
+    size_t size() const;
+
+  };
+
+  /* thread-safe. the returned symbol (and its string) is valid for the lifetime of the program */
+  Symbol intern(const char* str, size_t len);
+  Symbol intern(const char* str);
+  Symbol intern(const string &str);
+  Symbol intern(const string_view &str);
+
+}
+
+#endif
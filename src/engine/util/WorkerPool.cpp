@@ -0,0 +1,89 @@
+#include "WorkerPool.hpp"
+
+me::WorkerPool::WorkerPool(uint32_t worker_count)
+  : worker_count(worker_count < 1 ? 1 : (worker_count > MAX_WORKERS ? MAX_WORKERS : worker_count))
+{
+  pthread_mutex_init(&mutex, nullptr);
+  pthread_cond_init(&start_cond, nullptr);
+  pthread_cond_init(&done_cond, nullptr);
+
+  function = nullptr;
+  user_data = nullptr;
+  task_count = 0;
+  next_task = 0;
+  finished_tasks = 0;
+  generation = 0;
+  stopping = false;
+
+  for (uint32_t i = 0; i < this->worker_count; i++)
+  {
+    starts[i] = {this, i};
+    pthread_create(&threads[i], nullptr, worker_main, &starts[i]);
+  }
+}
+
+me::WorkerPool::~WorkerPool()
+{
+  pthread_mutex_lock(&mutex);
+  stopping = true;
+  pthread_cond_broadcast(&start_cond);
+  pthread_mutex_unlock(&mutex);
+
+  for (uint32_t i = 0; i < worker_count; i++)
+    pthread_join(threads[i], nullptr);
+
+  pthread_cond_destroy(&done_cond);
+  pthread_cond_destroy(&start_cond);
+  pthread_mutex_destroy(&mutex);
+}
+
+int me::WorkerPool::run(uint32_t task_count, TaskFunction function, void* user_data)
+{
+  if (task_count == 0)
+    return 0;
+
+  pthread_mutex_lock(&mutex);
+  this->function = function;
+  this->user_data = user_data;
+  this->task_count = task_count;
+  next_task = 0;
+  finished_tasks = 0;
+  generation++;
+  pthread_cond_broadcast(&start_cond);
+
+  while (finished_tasks < task_count)
+    pthread_cond_wait(&done_cond, &mutex);
+  pthread_mutex_unlock(&mutex);
+  return 0;
+}
+
+void* me::WorkerPool::worker_main(void* ptr)
+{
+  WorkerPool* pool = static_cast<WorkerStart*>(ptr)->pool;
+  uint32_t worker = static_cast<WorkerStart*>(ptr)->worker;
+  uint64_t seen_generation = 0;
+
+  pthread_mutex_lock(&pool->mutex);
+  for (;;)
+  {
+    while (!pool->stopping && pool->generation == seen_generation)
+      pthread_cond_wait(&pool->start_cond, &pool->mutex);
+    if (pool->stopping)
+      break;
+    seen_generation = pool->generation;
+
+    /* tasks are taken one at a time, so uneven tasks still spread over the workers */
+    while (pool->next_task < pool->task_count)
+    {
+      uint32_t task = pool->next_task++;
+      pthread_mutex_unlock(&pool->mutex);
+      pool->function(worker, task, pool->user_data);
+      pthread_mutex_lock(&pool->mutex);
+
+      if (++pool->finished_tasks == pool->task_count)
+	pthread_cond_signal(&pool->done_cond);
+    }
+  }
+  pthread_mutex_unlock(&pool->mutex);
+  return nullptr;
+}
@@ -0,0 +1,65 @@
+#ifndef ME_WORKER_POOL_HPP
+  #define ME_WORKER_POOL_HPP
+
+#include <pthread.h>
+#include <stdint.h>
+
+namespace me {
+
+  /* fixed set of threads that run the tasks of one 'run()' call at a time.
+   * every worker has an index, so per-worker resources (like command pools) need no locking */
+  class WorkerPool {
+
+  public:
+
+    static constexpr uint32_t MAX_WORKERS = 16;
+
+    /* 'worker' is the index of the thread running the task */
+    typedef void (*TaskFunction)(uint32_t worker, uint32_t task, void* user_data);
+
+  protected:
+
+    pthread_t threads[MAX_WORKERS];
+    uint32_t worker_count;
+
+    pthread_mutex_t mutex;
+    pthread_cond_t start_cond;
+    pthread_cond_t done_cond;
+
+    TaskFunction function;
+    void* user_data;
+    uint32_t task_count;
+    uint32_t next_task;
+    uint32_t finished_tasks;
+    uint64_t generation; /* incremented by every 'run()' */
+    bool stopping;
+
+  public:
+
+    explicit WorkerPool(uint32_t worker_count);
+    ~WorkerPool();
+
+    /* runs 'task_count' tasks on the workers and returns once all of them have finished */
+    int run(uint32_t task_count, TaskFunction function, void* user_data);
+
+    uint32_t get_worker_count() const
+    {
+      return worker_count;
+    }
+
+  protected:
+
+    struct WorkerStart {
+      WorkerPool* pool;
+      uint32_t worker;
+    };
+
+    WorkerStart starts[MAX_WORKERS];
+
+    static void* worker_main(void* ptr);
+
+  };
+
+}
+
+#endif
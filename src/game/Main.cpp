@@ -5,6 +5,8 @@
 
 #include "../engine/MurderEngine.hpp"
 
+#include <string.h>
+
 static int callback_init_surface(me::SurfaceModule::Config &config)
 {
   config.title = "game";
@@ -18,11 +20,25 @@ int main(int argc, char** argv)
   me::SurfaceModule::UserCallbacks surface_callbacks;
   surface_callbacks.init_surface = callback_init_surface;
 
+  /* '--offscreen' renders without a window and reads the frames back, for machines without a display.
+   * '--pipeline-cache <path>' replaces the pipeline cache file in the user's cache directory */
+  bool offscreen = false;
+  const char* pipeline_cache_path = nullptr;
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "--offscreen") == 0)
+      offscreen = true;
+    else if (strcmp(argv[i], "--pipeline-cache") == 0 && i + 1 < argc)
+      pipeline_cache_path = argv[++i];
+  }
+
+  uint32_t module_count = 0;
   me::Module* modules[4];
-  modules[0] = new Game;
-  modules[1] = new me::WindowSurface(surface_callbacks);
-  modules[2] = new me::Vulkan;
-  modules[3] = new SceneRenderer;
+  modules[module_count++] = new Game;
+  if (!offscreen)
+    modules[module_count++] = new me::WindowSurface(surface_callbacks);
+  modules[module_count++] = new me::Vulkan;
+  modules[module_count++] = new SceneRenderer(offscreen, pipeline_cache_path);
 
   me::ApplicationInfo app_info = {};
   app_info.name = "Game";
@@ -32,7 +48,7 @@ int main(int argc, char** argv)
   engine_info.application_info = app_info;
 
   me::EngineBus engine_bus = {};
-  engine_bus.module_count = 4;
+  engine_bus.module_count = module_count;
   engine_bus.modules = modules;
 
   me::MurderEngine engine(engine_info, engine_bus);
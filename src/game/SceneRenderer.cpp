@@ -2,6 +2,13 @@
 #include "../engine/renderer/Renderer.hpp"
 
 #include <lme/file.hpp>
+#include <lme/math/math.hpp>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/stat.h>
 
 static int create_queue(me::RendererModule* renderer, me::Device device, me::QueueType queue_type, me::Queue &queue)
 {
@@ -14,11 +21,49 @@ static int create_queue(me::RendererModule* renderer, me::Device device, me::Que
   return 0;
 }
 
+/* '$XDG_CACHE_HOME/murder_engine/pipeline_cache', or under '~/.cache' without it. the directory is created,
+ * the path stays empty if there is no home or the directory can't be created */
+static int get_user_pipeline_cache_path(char* path, size_t size)
+{
+  path[0] = '\0';
+
+  char directory[size];
+  const char* cache_home = getenv("XDG_CACHE_HOME");
+  const char* home = getenv("HOME");
+  int length;
+  if (cache_home != nullptr && cache_home[0] == '/')
+    length = snprintf(directory, size, "%s", cache_home);
+  else if (home != nullptr && home[0] == '/')
+    length = snprintf(directory, size, "%s/.cache", home);
+  else
+    return 0;
+
+  /* the cache home may not exist yet either */
+  if (length < 0 || static_cast<size_t>(length) >= size)
+    return 0;
+  mkdir(directory, 0700);
+
+  length = snprintf(directory + length, size - length, "/murder_engine") + length;
+  if (length < 0 || static_cast<size_t>(length) >= size || (mkdir(directory, 0700) != 0 && errno != EEXIST))
+    return 0;
+
+  length = snprintf(path, size, "%s/pipeline_cache", directory);
+  if (length < 0 || static_cast<size_t>(length) >= size)
+    path[0] = '\0';
+  return 0;
+}
+
 
-SceneRenderer::SceneRenderer()
-  : Module(me::MODULE_LOGIC_TYPE, "scene_renderer")
+SceneRenderer::SceneRenderer(bool offscreen, const char* pipeline_cache_path)
+  : Module(me::MODULE_LOGIC_TYPE, "scene_renderer"), logger("SceneRenderer"), offscreen(offscreen)
 {
-  mesh = new me::Mesh;
+  if (pipeline_cache_path != nullptr)
+    snprintf(this->pipeline_cache_path, PATH_MAX, "%s", pipeline_cache_path);
+  else
+    get_user_pipeline_cache_path(this->pipeline_cache_path, PATH_MAX);
+
+  scene = new me::Scene;
+  mesh = scene->arena.allocate<me::Mesh>(&scene->arena);
   mesh->vertices.push_back({{-0.5F, -0.5F, 0.0F}, {0.0F, 0.0F, 0.0F}, {0.0F, 0.0F}, {1.0F, 0.0F, 0.0F, 1.0F}});
   mesh->vertices.push_back({{0.5F, -0.5F, 0.0F}, {0.0F, 0.0F, 0.0F}, {0.0F, 0.0F}, {0.0F, 1.0F, 0.0F, 1.0F}});
   mesh->vertices.push_back({{0.5F, 0.5F, 0.0F}, {0.0F, 0.0F, 0.0F}, {0.0F, 0.0F}, {0.0F, 0.0F, 1.0F, 1.0F}});
@@ -30,18 +75,32 @@ SceneRenderer::SceneRenderer()
   mesh->indices.push_back({2});
   mesh->indices.push_back({3});
   mesh->indices.push_back({0});
+
+  me::MeshItem* mesh_item = scene->arena.allocate<me::MeshItem>();
+  mesh_item->mesh = mesh;
+  mesh_item->material = nullptr;
+  mesh_item->scale = {1.0F, 1.0F, 1.0F};
+  mesh_item->flags = me::MESH_VISIBLE_FLAG | me::MESH_ARENA_FLAG;
+  scene->meshes.push_back(mesh_item);
+
+  workers = new me::WorkerPool(WORKER_COUNT);
+  profiler = new me::Profiler();
 }
 
 int SceneRenderer::initialize(const me::ModuleInfo module_info)
 {
-  me::SurfaceModule* surface_module = module_info.engine_bus->get_active_surface_module();
+  me::SurfaceModule* surface_module = offscreen ? nullptr : module_info.engine_bus->get_active_surface_module();
   me::RendererModule* renderer = module_info.engine_bus->get_active_renderer_module();
 
-  uint32_t surface_width, surface_height;
-  surface_module->get_framebuffer_size(surface_width, surface_height);
-
-  uint32_t extension_count;
-  const char** extensions = surface_module->vk_get_required_surface_extensions(extension_count);
+  /* without a surface there is nothing to present to, so no instance extensions are needed */
+  uint32_t surface_width = OFFSCREEN_WIDTH, surface_height = OFFSCREEN_HEIGHT;
+  uint32_t extension_count = 0;
+  const char** extensions = nullptr;
+  if (!offscreen)
+  {
+    surface_module->get_framebuffer_size(surface_width, surface_height);
+    extensions = surface_module->vk_get_required_surface_extensions(extension_count);
+  }
 
   me::EngineInitInfo engine_init_info = {};
   engine_init_info.engine_info = module_info.engine_info;
@@ -59,47 +118,88 @@ int SceneRenderer::initialize(const me::ModuleInfo module_info)
   physical_device = physical_devices[0];
 
   /* creating a surface */
-  me::SurfaceCreateInfo surface_create_info = {};
-  surface_create_info.type = me::STRUCTURE_TYPE_SURFACE_CREATE_INFO;
-  surface_create_info.next = nullptr;
-  surface_create_info.physical_device = physical_device;
-  surface_create_info.surface_module = surface_module;
-  renderer->create_surface(surface_create_info, surface);
+  surface = nullptr;
+  if (!offscreen)
+  {
+    me::SurfaceCreateInfo surface_create_info = {};
+    surface_create_info.type = me::STRUCTURE_TYPE_SURFACE_CREATE_INFO;
+    surface_create_info.next = nullptr;
+    surface_create_info.physical_device = physical_device;
+    surface_create_info.surface_module = surface_module;
+    renderer->create_surface(surface_create_info, surface);
+  }
 
   /* creating a device */
+  if (pipeline_cache_path[0] == '\0')
+    logger.warn("no cache directory, pipelines are compiled again on every start");
+
   me::DeviceCreateInfo device_create_info = {};
   device_create_info.type = me::STRUCTURE_TYPE_DEVICE_CREATE_INFO;
   device_create_info.next = nullptr;
   device_create_info.surface = surface;
   device_create_info.physical_device_count = 1;
   device_create_info.physical_devices = &physical_device;
+  device_create_info.frame_count = FRAME_COUNT;
+  device_create_info.thread_count = 1 + WORKER_COUNT; /* the main thread records the primary command buffer */
+  device_create_info.pipeline_cache_path = pipeline_cache_path[0] != '\0' ? pipeline_cache_path : nullptr;
+  device_create_info.pipeline_thread_count = 1;
+  device_create_info.profiler = profiler;
   renderer->create_device(device_create_info, device);
 
   /* creating queues */
   create_queue(renderer, device, me::QUEUE_COMPUTE_TYPE, compute_queue);
   create_queue(renderer, device, me::QUEUE_GRAPHICS_TYPE, graphics_queue);
-  create_queue(renderer, device, me::QUEUE_PRESENT_TYPE, present_queue);
+  present_queue = nullptr;
+  if (!offscreen)
+    create_queue(renderer, device, me::QUEUE_PRESENT_TYPE, present_queue);
   create_queue(renderer, device, me::QUEUE_TRANSFER_TYPE, transfer_queue);
 
-  /* creating a swapchain */
-  me::SwapchainCreateInfo swapchain_create_info = {};
-  swapchain_create_info.type = me::STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO;
-  swapchain_create_info.next = nullptr;
-  swapchain_create_info.device = device;
-  swapchain_create_info.surface = surface;
-  renderer->create_swapchain(swapchain_create_info, swapchain);
-
-  /* creating swapchain images */
-  uint32_t swapchain_image_count;
-  renderer->get_swapchain_image_count(device, swapchain, swapchain_image_count);
-  swapchain_images.resize(swapchain_image_count);
-
-  me::SwapchainImageCreateInfo swapchain_image_create_info = {};
-  swapchain_image_create_info.type = me::STRUCTURE_TYPE_SWAPCHAIN_IMAGE_CREATE_INFO;
-  swapchain_image_create_info.next = nullptr;
-  swapchain_image_create_info.device = device;
-  swapchain_image_create_info.swapchain = swapchain;
-  renderer->create_swapchain_images(swapchain_image_create_info, swapchain_image_count, swapchain_images.data());
+  /* creating a swapchain, or the attachments an offscreen renderer renders into instead */
+  if (!offscreen)
+    create_swapchain(renderer, surface_module, nullptr);
+  else
+  {
+    swapchain = nullptr;
+    swapchain_extent = {OFFSCREEN_WIDTH, OFFSCREEN_HEIGHT};
+    framebuffers.resize(1);
+    framebuffers[0] = nullptr;
+
+    /* read back after the render pass, so neither can be transient */
+    static constexpr uint32_t offscreen_attachment_count = 2;
+    me::AttachmentDescription attachment_descriptions[offscreen_attachment_count];
+    attachment_descriptions[0].attachment_type = me::ATTACHMENT_TYPE_COLOR;
+    attachment_descriptions[0].format = me::FORMAT_VECTOR4_8UNORM;
+    attachment_descriptions[0].samples = me::SAMPLE_COUNT_1;
+    attachment_descriptions[0].transient = false;
+    attachment_descriptions[0].first_pass = 0;
+    attachment_descriptions[0].last_pass = 0;
+
+    attachment_descriptions[1].attachment_type = me::ATTACHMENT_TYPE_DEPTH;
+    attachment_descriptions[1].format = me::FORMAT_DEPTH_32FLOAT;
+    attachment_descriptions[1].samples = me::SAMPLE_COUNT_1;
+    attachment_descriptions[1].transient = false;
+    attachment_descriptions[1].first_pass = 0;
+    attachment_descriptions[1].last_pass = 0;
+
+    me::AttachmentCreateInfo attachment_create_info = {};
+    attachment_create_info.type = me::STRUCTURE_TYPE_ATTACHMENT_CREATE_INFO;
+    attachment_create_info.next = nullptr;
+    attachment_create_info.device = device;
+    attachment_create_info.size = swapchain_extent;
+    attachment_create_info.descriptions = attachment_descriptions;
+    offscreen_attachments.resize(offscreen_attachment_count);
+    renderer->create_attachments(attachment_create_info, offscreen_attachment_count, offscreen_attachments.data());
+
+    /* a slot per frame in flight and one for the copy being read */
+    me::ReadbackRingCreateInfo readback_ring_create_info = {};
+    readback_ring_create_info.type = me::STRUCTURE_TYPE_READBACK_RING_CREATE_INFO;
+    readback_ring_create_info.next = nullptr;
+    readback_ring_create_info.device = device;
+    readback_ring_create_info.size = swapchain_extent;
+    readback_ring_create_info.format = me::FORMAT_VECTOR4_8UNORM;
+    readback_ring_create_info.slot_count = FRAME_COUNT + 1;
+    renderer->create_readback_ring(readback_ring_create_info, readback_ring);
+  }
 
   /* creating frames */
   frames.resize(FRAME_COUNT);
@@ -115,27 +215,36 @@ int SceneRenderer::initialize(const me::ModuleInfo module_info)
   render_pass_create_info.next = nullptr;
   render_pass_create_info.device = device;
   render_pass_create_info.swapchain = swapchain;
+  render_pass_create_info.attachment_count = offscreen_attachments.size();
+  render_pass_create_info.attachments = offscreen_attachments.data();
+  render_pass_create_info.pass_index = 0;
   renderer->create_render_pass(render_pass_create_info, render_pass);
 
-  /* creating pipeline */
+  /* creating pipeline, without culling first so the first frames don't wait for the culled one */
   me::RasterizerCreateInfo rasterizer_create_info = {};
   rasterizer_create_info.type = me::STRUCTURE_TYPE_RASTERIZER_CREATE_INFO;
   rasterizer_create_info.next = nullptr;
   rasterizer_create_info.polygon_mode = me::POLYGON_MODE_FILL;
   rasterizer_create_info.front_face = me::FRONT_FACE_CLOCKWISE;
-  rasterizer_create_info.cull_mode = me::CULL_MODE_BACK;
+  rasterizer_create_info.cull_mode = me::CULL_MODE_NONE;
 
   me::MultisamplingCreateInfo multisampling_create_info = {};
   multisampling_create_info.type = me::STRUCTURE_TYPE_MULTISAMPLING_CREATE_INFO;
   multisampling_create_info.next = nullptr;
   multisampling_create_info.samples = me::SAMPLE_COUNT_1;
 
-  me::ShaderBinding vertex_binding = {
-    .binding = 0,
-    .stride = 0
-  };
+  /* the shader reads the vertices and, per instance, the data the instance batcher writes */
+  static constexpr uint32_t vertex_binding_count = 2;
+  me::ShaderBinding vertex_bindings[vertex_binding_count];
+  vertex_bindings[0].binding = 0;
+  vertex_bindings[0].stride = sizeof(me::Vertex);
+  vertex_bindings[0].per_instance = false;
 
-  static constexpr uint32_t vertex_attribute_count = 4;
+  vertex_bindings[1].binding = INSTANCE_BINDING;
+  vertex_bindings[1].stride = sizeof(me::InstanceData);
+  vertex_bindings[1].per_instance = true;
+
+  static constexpr uint32_t vertex_attribute_count = 7;
   me::ShaderAttribute vertex_attributes[vertex_attribute_count];
   vertex_attributes[0].name = "position";
   vertex_attributes[0].binding = 0;
@@ -161,6 +270,24 @@ int SceneRenderer::initialize(const me::ModuleInfo module_info)
   vertex_attributes[3].offset = offsetof(me::Vertex, color);
   vertex_attributes[3].format = me::FORMAT_VECTOR4_32FLOAT;
 
+  vertex_attributes[4].name = "instance_position";
+  vertex_attributes[4].binding = INSTANCE_BINDING;
+  vertex_attributes[4].location = 4;
+  vertex_attributes[4].offset = offsetof(me::InstanceData, position);
+  vertex_attributes[4].format = me::FORMAT_VECTOR4_32FLOAT;
+
+  vertex_attributes[5].name = "instance_rotation";
+  vertex_attributes[5].binding = INSTANCE_BINDING;
+  vertex_attributes[5].location = 5;
+  vertex_attributes[5].offset = offsetof(me::InstanceData, rotation);
+  vertex_attributes[5].format = me::FORMAT_VECTOR4_32FLOAT;
+
+  vertex_attributes[6].name = "instance_scale";
+  vertex_attributes[6].binding = INSTANCE_BINDING;
+  vertex_attributes[6].location = 6;
+  vertex_attributes[6].offset = offsetof(me::InstanceData, scale);
+  vertex_attributes[6].format = me::FORMAT_VECTOR4_32FLOAT;
+
   static constexpr uint32_t shader_count = 2;
   size_t vert_shader_len;
   char* vert_shader_data;
@@ -180,8 +307,8 @@ int SceneRenderer::initialize(const me::ModuleInfo module_info)
   me::ShaderCreateInfo shader_create_info = {};
   shader_create_info.type = me::STRUCTURE_TYPE_SHADER_CREATE_INFO;
   shader_create_info.next = nullptr;
-  shader_create_info.vertex_binding_count = 1;
-  shader_create_info.vertex_bindings = &vertex_binding;
+  shader_create_info.vertex_binding_count = vertex_binding_count;
+  shader_create_info.vertex_bindings = vertex_bindings;
   shader_create_info.vertex_attribute_count = vertex_attribute_count;
   shader_create_info.vertex_attributes = vertex_attributes;
   shader_create_info.shader_count = shader_count;
@@ -210,22 +337,17 @@ int SceneRenderer::initialize(const me::ModuleInfo module_info)
   pipeline_create_info.rasterizer_create_info = &rasterizer_create_info;
   pipeline_create_info.multisampling_create_info = &multisampling_create_info;
   pipeline_create_info.shader_create_info = &shader_create_info;
-  renderer->create_pipeline(pipeline_create_info, pipeline);
+  pipeline_create_info.descriptor_set_count = 0;
+  pipeline_create_info.descriptor_sets = nullptr;
+  pipeline_create_info.push_constant_size = 0;
+  pipeline_create_info.bindless = false;
+  renderer->create_pipeline(pipeline_create_info, fallback_pipeline);
 
-  /* creating framebuffers */
-  framebuffers.resize(swapchain_images.size());
-  for (uint32_t i = 0; i < swapchain_images.size(); i++)
-  {
-    me::FramebufferCreateInfo framebuffer_create_info = {};
-    framebuffer_create_info.type = me::STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-    framebuffer_create_info.next = nullptr;
-    framebuffer_create_info.device = device;
-    framebuffer_create_info.render_pass = render_pass;
-    framebuffer_create_info.image = swapchain_images[i];
-    framebuffer_create_info.offset = {0, 0};
-    framebuffer_create_info.size = {surface_width, surface_height};
-    renderer->create_framebuffer(framebuffer_create_info, framebuffers[i]);
-  }
+  /* the culled pipeline is compiled in the background and replaces the fallback in 'tick' once it is built */
+  rasterizer_create_info.cull_mode = me::CULL_MODE_BACK;
+  renderer->create_pipeline_async(pipeline_create_info, pipeline_build);
+  pipeline_build_status = me::PIPELINE_BUILD_STATUS_PENDING;
+  pipeline = fallback_pipeline;
 
   /* creating a descriptor pool */
   me::DescriptorPoolCreateInfo descriptor_pool_create_info = {};
@@ -233,12 +355,13 @@ int SceneRenderer::initialize(const me::ModuleInfo module_info)
   descriptor_pool_create_info.next = nullptr;
   descriptor_pool_create_info.device = device;
   descriptor_pool_create_info.descriptor_type = me::DESCRIPTOR_TYPE_UNIFORM;
-  descriptor_pool_create_info.descriptor_count = swapchain_images.size();
+  descriptor_pool_create_info.descriptor_count = FRAME_COUNT;
   renderer->create_descriptor_pool(descriptor_pool_create_info, descriptor_pool);
 
   /* creating uniform buffers */
-  uniform_buffers.resize(swapchain_images.size());
-  for (uint32_t i = 0; i < swapchain_images.size(); i++)
+  uniform_buffers.resize(FRAME_COUNT);
+  uniform_buffer_data.resize(FRAME_COUNT);
+  for (uint32_t i = 0; i < FRAME_COUNT; i++)
   {
     me::BufferCreateInfo buffer_create_info = {};
     buffer_create_info.type = me::STRUCTURE_TYPE_BUFFER_CREATE_INFO;
@@ -249,48 +372,50 @@ int SceneRenderer::initialize(const me::ModuleInfo module_info)
     buffer_create_info.write_method = me::BUFFER_WRITE_METHOD_STANDARD;
     buffer_create_info.size = sizeof(UniformBufferObject);
     renderer->create_buffer(buffer_create_info, uniform_buffers[i]);
+    renderer->get_buffer_data(uniform_buffers[i], uniform_buffer_data[i]);
+  }
+
+  /* creating instance buffers, mapped like the uniform buffers */
+  instance_buffers.resize(FRAME_COUNT);
+  for (uint32_t i = 0; i < FRAME_COUNT; i++)
+  {
+    me::BufferCreateInfo buffer_create_info = {};
+    buffer_create_info.type = me::STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    buffer_create_info.next = nullptr;
+    buffer_create_info.physical_device = physical_device;
+    buffer_create_info.device = device;
+    buffer_create_info.usage = me::BUFFER_USAGE_VERTEX_BUFFER;
+    buffer_create_info.write_method = me::BUFFER_WRITE_METHOD_STANDARD;
+    buffer_create_info.size = MAX_INSTANCE_COUNT * sizeof(me::InstanceData);
+    renderer->create_buffer(buffer_create_info, instance_buffers[i]);
   }
 
   /* creating descriptors */
-  descriptors.resize(swapchain_images.size());
+  descriptors.resize(FRAME_COUNT);
   me::DescriptorCreateInfo descriptor_create_info = {};
   descriptor_create_info.type = me::STRUCTURE_TYPE_DESCRIPTOR_CREATE_INFO;
   descriptor_create_info.next = nullptr;
   descriptor_create_info.device = device;
-  descriptor_create_info.pipeline = pipeline;
+  descriptor_create_info.pipeline = fallback_pipeline; /* the culled pipeline has the same set layouts */
   descriptor_create_info.descriptor_pool = descriptor_pool;
   descriptor_create_info.descriptor_type = me::DESCRIPTOR_TYPE_UNIFORM;
+  descriptor_create_info.set = 0;
   descriptor_create_info.buffer_count = uniform_buffers.size();
   descriptor_create_info.buffers = uniform_buffers.data();
   descriptor_create_info.offset = 0;
   descriptor_create_info.range = sizeof(UniformBufferObject);
   renderer->create_descriptors(descriptor_create_info, descriptors.size(), descriptors.data());
 
-  /* creating command pools */
-  me::CommandPoolCreateInfo graphics_command_pool_create_info = {};
-  graphics_command_pool_create_info.type = me::STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
-  graphics_command_pool_create_info.next = nullptr;
-  graphics_command_pool_create_info.device = device;
-  graphics_command_pool_create_info.queue = graphics_queue;
-  renderer->create_command_pool(graphics_command_pool_create_info, graphics_command_pool);
-
+  /* creating command pools, draw command buffers come from the device's per-frame pools */
   me::CommandPoolCreateInfo transfer_command_pool_create_info = {};
   transfer_command_pool_create_info.type = me::STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
   transfer_command_pool_create_info.next = nullptr;
   transfer_command_pool_create_info.device = device;
   transfer_command_pool_create_info.queue = transfer_queue;
+  transfer_command_pool_create_info.transient = false;
+  transfer_command_pool_create_info.resettable = false;
   renderer->create_command_pool(transfer_command_pool_create_info, transfer_command_pool);
 
-  /* creating command buffers */
-  me::CommandBufferCreateInfo command_buffer_create_info = {};
-  command_buffer_create_info.type = me::STRUCTURE_TYPE_COMMAND_BUFFER_CREATE_INFO;
-  command_buffer_create_info.next = nullptr;
-  command_buffer_create_info.device = device;
-  command_buffer_create_info.command_pool = graphics_command_pool;
-  command_buffer_create_info.usage = me::COMMAND_BUFFER_USAGE_RENDERING;
-  draw_command_buffers.resize(swapchain_images.size());
-  renderer->create_command_buffers(command_buffer_create_info, swapchain_images.size(), draw_command_buffers.data());
-
   /* creating mesh */
   me::SetupMeshInfo setup_mesh_info = {};
   setup_mesh_info.physical_device = physical_device;
@@ -298,38 +423,6 @@ int SceneRenderer::initialize(const me::ModuleInfo module_info)
   setup_mesh_info.transfer_queue = transfer_queue;
   setup_mesh_info.transfer_command_pool = transfer_command_pool;
   renderer->setup_mesh(setup_mesh_info, mesh);
-
-  for (uint32_t i = 0; i < draw_command_buffers.size(); i++)
-  {
-    me::CommandBuffer command_buffer = draw_command_buffers[i];
-    renderer->cmd_record_start(command_buffer);
-
-    me::CmdBeginRenderPassInfo cmd_begin_render_pass_info = {};
-    cmd_begin_render_pass_info.swapchain = swapchain;
-    cmd_begin_render_pass_info.render_pass = render_pass;
-    cmd_begin_render_pass_info.framebuffer = framebuffers[i];
-    cmd_begin_render_pass_info.clear_values[0] = 0.0F;
-    cmd_begin_render_pass_info.clear_values[1] = 0.0F;
-    cmd_begin_render_pass_info.clear_values[2] = 0.0F;
-    cmd_begin_render_pass_info.clear_values[3] = 1.0F;
-    renderer->cmd_begin_render_pass(cmd_begin_render_pass_info, command_buffer);
-
-    me::CmdBindDescriptorsInfo cmd_bind_descriptors_info = {};
-    cmd_bind_descriptors_info.pipeline = pipeline;
-    cmd_bind_descriptors_info.descriptor_count = 1;
-    cmd_bind_descriptors_info.descriptors = &descriptors[i];
-    renderer->cmd_bind_descriptors(cmd_bind_descriptors_info, command_buffer);
-
-    me::CmdDrawMeshesInfo cmd_draw_meshes_info = {};
-    cmd_draw_meshes_info.pipeline = pipeline;
-    cmd_draw_meshes_info.mesh_count = 1;
-    cmd_draw_meshes_info.meshes = &mesh;
-    renderer->cmd_draw_meshes(cmd_draw_meshes_info, command_buffer);
-
-    renderer->cmd_end_render_pass(command_buffer);
-
-    renderer->cmd_record_stop(command_buffer);
-  }
   return 0;
 }
 
@@ -337,20 +430,81 @@ int SceneRenderer::terminate(const me::ModuleInfo module_info)
 {
   me::RendererModule* renderer = module_info.engine_bus->get_active_renderer_module();
 
-  renderer->cleanup_command_buffers(device, graphics_command_pool, draw_command_buffers.size(), draw_command_buffers.data());
-  renderer->cleanup_command_pool(device, graphics_command_pool);
+  /* waits for the copies still in flight */
+  if (offscreen)
+  {
+    renderer->cleanup_readback_ring(device, readback_ring);
+    logger.info("read back %lu frames, %u copies dropped", readback_count, readback_dropped_count);
+  }
+
+  if (frame_number > 0)
+  {
+    double frame_count = static_cast<double>(frame_number);
+    logger.info("draw list: %.1f draws, %.1f pipeline and %.1f descriptor binds per frame sorted, %.1f and %.1f in submission order",
+	draw_list_stats.draw_count / frame_count, draw_list_stats.sorted_pipeline_binds / frame_count,
+	draw_list_stats.sorted_descriptor_binds / frame_count, draw_list_stats.unsorted_pipeline_binds / frame_count,
+	draw_list_stats.unsorted_descriptor_binds / frame_count);
+  }
+
+  /* the addresses of the destroyed states may be reused */
+  for (me::Descriptor descriptor : descriptors)
+    instance_batcher.release(descriptor);
+  for (me::MeshItem* mesh_item : scene->meshes)
+  {
+    instance_batcher.release(mesh_item->mesh);
+    instance_batcher.release(mesh_item->material);
+  }
+  instance_batcher.release(pipeline);
+  instance_batcher.release(fallback_pipeline);
+
+  renderer->cleanup_command_pool(device, transfer_command_pool);
+  delete workers;
   renderer->cleanup_descriptors(device, descriptor_pool, descriptors.size(), descriptors.data());
   renderer->cleanup_descriptor_pool(device, descriptor_pool);
+  for (me::Buffer &uniform_buffer : uniform_buffers)
+    renderer->cleanup_buffer(device, uniform_buffer);
+  for (me::Buffer &instance_buffer : instance_buffers)
+    renderer->cleanup_buffer(device, instance_buffer);
+
+  renderer->cleanup_mesh(device, mesh);
+  delete scene;
+  cleanup_retired_swapchains(renderer, true);
   for (me::Framebuffer &framebuffer : framebuffers)
-    renderer->cleanup_framebuffer(device, framebuffer);
+  {
+    if (framebuffer != nullptr)
+      renderer->cleanup_framebuffer(device, framebuffer);
+  }
+
+  if (offscreen)
+    renderer->cleanup_attachments(device, offscreen_attachments.size(), offscreen_attachments.data());
 
-  renderer->cleanup_pipeline(device, pipeline);
+  /* a build that is still pending would leave its pipeline behind */
+  while (pipeline_build_status == me::PIPELINE_BUILD_STATUS_PENDING)
+    renderer->get_pipeline_build(pipeline_build, fallback_pipeline, pipeline_build_status, pipeline);
+  renderer->cleanup_pipeline_build(device, pipeline_build);
+  if (pipeline != fallback_pipeline)
+    renderer->cleanup_pipeline(device, pipeline);
+  renderer->cleanup_pipeline(device, fallback_pipeline);
   renderer->cleanup_render_pass(device, render_pass);
   renderer->cleanup_frames(device, frames.size(), frames.data());
-  renderer->cleanup_swapchain_images(device, swapchain_images.size(), swapchain_images.data());
-  renderer->cleanup_swapchain(device, swapchain);
+  if (!offscreen)
+  {
+    renderer->cleanup_swapchain_images(device, swapchain_images.size(), swapchain_images.data());
+    renderer->cleanup_swapchain(device, swapchain);
+  }
   renderer->cleanup_device(device);
-  renderer->cleanup_surface(surface);
+  if (!offscreen)
+    renderer->cleanup_surface(surface);
+
+  me::vector<me::ProfileStats> profile_stats;
+  profiler->get_stats(profile_stats);
+  for (const me::ProfileStats &label_stats : profile_stats)
+  {
+    logger.info("%s %s: %.3f ms average, %.3f ms min, %.3f ms max over %lu", label_stats.source == me::PROFILE_SOURCE_GPU ? "gpu" : "cpu",
+	label_stats.label, static_cast<double>(label_stats.total_time) / label_stats.count / 1000000.0,
+	static_cast<double>(label_stats.min_time) / 1000000.0, static_cast<double>(label_stats.max_time) / 1000000.0, label_stats.count);
+  }
+  delete profiler;
 
   renderer->terminate_engine();
   return 0;
@@ -358,44 +512,166 @@ int SceneRenderer::terminate(const me::ModuleInfo module_info)
 
 int SceneRenderer::tick(const me::ModuleInfo module_info)
 {
+  me::SurfaceModule* surface_module = offscreen ? nullptr : module_info.engine_bus->get_active_surface_module();
   me::RendererModule* renderer = module_info.engine_bus->get_active_renderer_module();
 
+  profiler->begin_frame();
+  me::ProfileScope frame_scope(profiler, "frame");
+
+  if (!offscreen)
+  {
+    /* a minimized window has nothing to render to */
+    uint32_t surface_width, surface_height;
+    surface_module->get_framebuffer_size(surface_width, surface_height);
+    if (surface_width == 0 || surface_height == 0)
+      return 0;
+
+    /* not every platform reports a resize through the swapchain */
+    if (surface_width != surface_size[0] || surface_height != surface_size[1])
+      recreate_swapchain(renderer, surface_module);
+  }
+
   /* prepare */
   me::FramePrepareInfo frame_prepare_info = {};
   frame_prepare_info.device = device;
   frame_prepare_info.swapchain = swapchain;
   frame_prepare_info.frame = frames[frame_index];
+  frame_prepare_info.frame_index = frame_index;
 
   me::FramePrepared frame_prepared;
   renderer->frame_prepare(frame_prepare_info, frame_prepared);
 
-  uint32_t image_index;
-  renderer->frame_prepared_get_image_index(frame_prepared, image_index);
+  /* the frame's fence has signaled, so older frames are done with retired swapchains */
+  cleanup_retired_swapchains(renderer, false);
+
+  /* no image was acquired, the frame is rendered with the new swapchain next tick */
+  if (frame_prepared & me::FRAME_SWAPCHAIN_REFRESH_FLAG)
+  {
+    recreate_swapchain(renderer, surface_module);
+    return 0;
+  }
+
+  /* offscreen frames always render into the same attachments */
+  uint32_t image_index = 0;
+  if (!offscreen)
+    renderer->frame_prepared_get_image_index(frame_prepared, image_index);
+  me::Framebuffer framebuffer = get_framebuffer(renderer, image_index);
+
+  /* uniform buffers are persistently mapped */
+  memcpy(uniform_buffer_data[frame_index], &uniform_buffer_object, sizeof(UniformBufferObject));
+  renderer->buffer_flush(device, uniform_buffers[frame_index], 0, sizeof(UniformBufferObject));
+
+  /* 'frame_prepare' has recycled the command buffers of this frame index */
+  me::CommandBufferCreateInfo command_buffer_create_info = {};
+  command_buffer_create_info.type = me::STRUCTURE_TYPE_COMMAND_BUFFER_CREATE_INFO;
+  command_buffer_create_info.next = nullptr;
+  command_buffer_create_info.device = device;
+  command_buffer_create_info.command_pool = nullptr;
+  command_buffer_create_info.usage = me::COMMAND_BUFFER_USAGE_RENDERING;
+  command_buffer_create_info.thread_index = 0;
+  command_buffer_create_info.secondary = false;
+
+  me::CommandBuffer primary;
+  renderer->create_command_buffers(command_buffer_create_info, 1, &primary);
+  renderer->cmd_record_start(primary);
+
+  me::CmdBeginRenderPassInfo cmd_begin_render_pass_info = {};
+  cmd_begin_render_pass_info.swapchain = swapchain;
+  cmd_begin_render_pass_info.render_pass = render_pass;
+  cmd_begin_render_pass_info.framebuffer = framebuffer;
+  cmd_begin_render_pass_info.clear_values[0] = 0.0F;
+  cmd_begin_render_pass_info.clear_values[1] = 0.0F;
+  cmd_begin_render_pass_info.clear_values[2] = 0.0F;
+  cmd_begin_render_pass_info.clear_values[3] = 1.0F;
+  cmd_begin_render_pass_info.secondary = true;
+  renderer->cmd_begin_render_pass(cmd_begin_render_pass_info, primary);
+
+  /* the fallback is kept until terminate, frames in flight may still draw with it */
+  if (pipeline_build_status == me::PIPELINE_BUILD_STATUS_PENDING)
+  {
+    renderer->get_pipeline_build(pipeline_build, fallback_pipeline, pipeline_build_status, pipeline);
+    if (pipeline_build_status == me::PIPELINE_BUILD_STATUS_READY)
+    {
+      logger.info("culled pipeline built after %lu frames", frame_number);
+      instance_batcher.release(fallback_pipeline);
+    }else if (pipeline_build_status == me::PIPELINE_BUILD_STATUS_FAILED)
+      logger.warn("failed to build the culled pipeline, drawing without culling");
+  }
+
+  /* items with the same mesh and material become one instanced draw, the batches are sorted by state */
+  instance_batcher.build(pipeline, descriptors[frame_index], scene->meshes.size(), scene->meshes.data());
+  instance_batcher.write(renderer, device, instance_buffers[frame_index], MAX_INSTANCE_COUNT * sizeof(me::InstanceData));
+
+  draw_list.resize(0);
+  for (uint32_t i = 0; i < instance_batcher.get_batch_count(); i++)
+    draw_list.push_back(instance_batcher.get_batches()[i].mesh);
+
+  const me::DrawListStats &stats = instance_batcher.get_stats();
+  draw_list_stats.draw_count += stats.draw_count;
+  draw_list_stats.unsorted_pipeline_binds += stats.unsorted_pipeline_binds;
+  draw_list_stats.unsorted_descriptor_binds += stats.unsorted_descriptor_binds;
+  draw_list_stats.sorted_pipeline_binds += stats.sorted_pipeline_binds;
+  draw_list_stats.sorted_descriptor_binds += stats.sorted_descriptor_binds;
+
+  /* evicted meshes are streamed in here, the workers only record draws */
+  renderer->make_meshes_resident(device, draw_list.size(), draw_list.data());
+
+  /* after streaming, so the packed geometry pool has this frame's meshes. every command buffer
+   * is recorded again each frame, so the moved buffers need nothing else */
+  uint32_t moved_count;
+  renderer->defragment(device, DEFRAGMENT_BYTES_PER_FRAME, moved_count);
+
+  /* the sorted draws are split into chunks that the workers record in parallel */
+  uint32_t task_count = (instance_batcher.get_batch_count() + DRAWS_PER_TASK - 1) / DRAWS_PER_TASK;
+  task_buffers.resize(task_count);
+  recording_renderer = renderer;
+  recording_image_index = image_index;
+  {
+    me::ProfileScope record_scope(profiler, "record");
+    workers->run(task_count, record_task, this);
+  }
 
-  me::BufferWriteInfo buffer_write_info = {};
-  buffer_write_info.physical_device = physical_device;
-  buffer_write_info.device = device;
-  buffer_write_info.transfer_queue = transfer_queue;
-  buffer_write_info.transfer_command_pool = transfer_command_pool;
-  buffer_write_info.byte_count = sizeof(UniformBufferObject);
-  buffer_write_info.bytes = &uniform_buffer_object;
-  renderer->buffer_write(buffer_write_info, uniform_buffers[image_index]);
+  renderer->cmd_execute(primary, task_count, task_buffers.data());
+  renderer->cmd_end_render_pass(primary);
+
+  if (offscreen)
+  {
+    me::CmdReadbackInfo cmd_readback_info = {};
+    cmd_readback_info.readback_ring = readback_ring;
+    cmd_readback_info.attachment = offscreen_attachments[0];
+    cmd_readback_info.frame = frames[frame_index];
+    cmd_readback_info.tag = frame_number;
+    renderer->cmd_readback(cmd_readback_info, primary);
+  }
+  renderer->cmd_record_stop(primary);
 
   /* render */
   me::FrameRenderInfo frame_render_info = {};
   frame_render_info.device = device;
   frame_render_info.queue = graphics_queue;
   frame_render_info.prepared = frame_prepared;
-  frame_render_info.image = swapchain_images[image_index];
+  frame_render_info.image = offscreen ? nullptr : swapchain_images[image_index];
   frame_render_info.frame = frames[frame_index];
   frame_render_info.image_index = image_index;
   frame_render_info.frame_index = frame_index;
-  frame_render_info.command_buffer_count = draw_command_buffers.size();
-  frame_render_info.command_buffers = draw_command_buffers.data();
+  frame_render_info.command_buffer_count = 1;
+  frame_render_info.command_buffers = &primary;
 
   me::FrameRendered frame_rendered;
   renderer->frame_render(frame_render_info, frame_rendered);
 
+  if (offscreen)
+  {
+    frame_number++;
+    frame_index = (frame_index + 1) % FRAME_COUNT;
+
+    bool finished;
+    poll_readbacks(renderer, finished);
+    if (finished)
+      module_info.semaphore->flags |= me::MODULE_SEMAPHORE_TERMINATE_FLAG;
+    return 0;
+  }
+
   /* present */
   me::FramePresentInfo frame_present_info = {};
   frame_present_info.device = device;
@@ -411,8 +687,184 @@ int SceneRenderer::tick(const me::ModuleInfo module_info)
   me::FramePresented frame_presented;
   renderer->frame_present(frame_present_info, frame_presented);
 
+  frame_number++;
   frame_index++;
   if (frame_index >= FRAME_COUNT)
     frame_index = 0;
+
+  if (frame_presented & me::FRAME_SWAPCHAIN_REFRESH_FLAG)
+    recreate_swapchain(renderer, surface_module);
+  return 0;
+}
+
+int SceneRenderer::create_swapchain(me::RendererModule* renderer, me::SurfaceModule* surface_module, me::Swapchain old_swapchain)
+{
+  surface_module->get_framebuffer_size(surface_size[0], surface_size[1]);
+
+  me::SwapchainCreateInfo swapchain_create_info = {};
+  swapchain_create_info.type = me::STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO;
+  swapchain_create_info.next = nullptr;
+  swapchain_create_info.device = device;
+  swapchain_create_info.surface = surface;
+  swapchain_create_info.old_swapchain = old_swapchain;
+  renderer->create_swapchain(swapchain_create_info, swapchain);
+  renderer->get_swapchain_extent(swapchain, swapchain_extent);
+
+  /* creating swapchain images */
+  uint32_t swapchain_image_count;
+  renderer->get_swapchain_image_count(device, swapchain, swapchain_image_count);
+  swapchain_images.resize(swapchain_image_count);
+
+  me::SwapchainImageCreateInfo swapchain_image_create_info = {};
+  swapchain_image_create_info.type = me::STRUCTURE_TYPE_SWAPCHAIN_IMAGE_CREATE_INFO;
+  swapchain_image_create_info.next = nullptr;
+  swapchain_image_create_info.device = device;
+  swapchain_image_create_info.swapchain = swapchain;
+  renderer->create_swapchain_images(swapchain_image_create_info, swapchain_image_count, swapchain_images.data());
+
+  framebuffers.resize(swapchain_image_count);
+  for (uint32_t i = 0; i < swapchain_image_count; i++)
+    framebuffers[i] = nullptr;
+  return 0;
+}
+
+int SceneRenderer::recreate_swapchain(me::RendererModule* renderer, me::SurfaceModule* surface_module)
+{
+  RetiredSwapchain* retired_swapchain = new RetiredSwapchain;
+  retired_swapchain->swapchain = swapchain;
+  for (me::SwapchainImage &swapchain_image : swapchain_images)
+    retired_swapchain->images.push_back(swapchain_image);
+  for (me::Framebuffer &framebuffer : framebuffers)
+  {
+    if (framebuffer != nullptr)
+      retired_swapchain->framebuffers.push_back(framebuffer);
+  }
+  retired_swapchain->retire_frame = frame_number;
+  retired_swapchains.push_back(retired_swapchain);
+
+  /* the render pass and the pipeline only depend on the image format, which stays the same */
+  create_swapchain(renderer, surface_module, retired_swapchain->swapchain);
+  return 0;
+}
+
+int SceneRenderer::cleanup_retired_swapchains(me::RendererModule* renderer, bool all)
+{
+  /* frames before 'retire_frame' used the swapchain, every frame index has waited for its fence once 'FRAME_COUNT' more were prepared */
+  for (size_t i = 0; i < retired_swapchains.size();)
+  {
+    RetiredSwapchain* retired_swapchain = retired_swapchains[i];
+    if (!all && frame_number + 1 < retired_swapchain->retire_frame + FRAME_COUNT)
+    {
+      i++;
+      continue;
+    }
+
+    for (me::Framebuffer &framebuffer : retired_swapchain->framebuffers)
+      renderer->cleanup_framebuffer(device, framebuffer);
+    renderer->cleanup_swapchain_images(device, retired_swapchain->images.size(), retired_swapchain->images.data());
+    renderer->cleanup_swapchain(device, retired_swapchain->swapchain);
+    delete retired_swapchain;
+
+    retired_swapchains[i] = retired_swapchains[retired_swapchains.size() - 1];
+    retired_swapchains.resize(retired_swapchains.size() - 1);
+  }
+  return 0;
+}
+
+me::Framebuffer SceneRenderer::get_framebuffer(me::RendererModule* renderer, uint32_t image_index)
+{
+  if (framebuffers[image_index] != nullptr)
+    return framebuffers[image_index];
+
+  me::FramebufferCreateInfo framebuffer_create_info = {};
+  framebuffer_create_info.type = me::STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+  framebuffer_create_info.next = nullptr;
+  framebuffer_create_info.device = device;
+  framebuffer_create_info.render_pass = render_pass;
+  framebuffer_create_info.image = offscreen ? nullptr : swapchain_images[image_index];
+  framebuffer_create_info.offset = {0, 0};
+  framebuffer_create_info.size = swapchain_extent;
+  framebuffer_create_info.attachment_count = offscreen_attachments.size();
+  framebuffer_create_info.attachments = offscreen_attachments.data();
+  renderer->create_framebuffer(framebuffer_create_info, framebuffers[image_index]);
+  return framebuffers[image_index];
+}
+
+int SceneRenderer::poll_readbacks(me::RendererModule* renderer, bool &finished)
+{
+  finished = false;
+
+  me::Readback readback;
+  bool available;
+  renderer->readback_ring_acquire(readback_ring, readback, available);
+  while (available)
+  {
+    readback_count++;
+    readback_dropped_count += readback.dropped_count;
+
+    /* rgba rows, written as a binary ppm without the alpha */
+    if (readback.tag + 1 >= OFFSCREEN_FRAME_LIMIT && !finished)
+    {
+      FILE* file = fopen(OFFSCREEN_IMAGE_PATH, "wb");
+      if (file == nullptr)
+	throw me::exception("failed to open '%s'", OFFSCREEN_IMAGE_PATH);
+
+      fprintf(file, "P6\n%u %u\n255\n", readback.extent[0], readback.extent[1]);
+      const uint8_t* pixels = static_cast<const uint8_t*>(readback.data);
+      for (size_t i = 0; i < static_cast<size_t>(readback.extent[0]) * readback.extent[1]; i++)
+	fwrite(pixels + i * 4, 1, 3, file);
+      fclose(file);
+
+      logger.info("wrote frame %lu to '%s'", readback.tag, OFFSCREEN_IMAGE_PATH);
+      finished = true;
+    }
+
+    renderer->readback_ring_release(readback_ring);
+    renderer->readback_ring_acquire(readback_ring, readback, available);
+  }
   return 0;
 }
+
+void SceneRenderer::record_task(uint32_t worker, uint32_t task, void* user_data)
+{
+  SceneRenderer* scene_renderer = static_cast<SceneRenderer*>(user_data);
+  me::RendererModule* renderer = scene_renderer->recording_renderer;
+  uint32_t image_index = scene_renderer->recording_image_index;
+  /* thread 0 is the main thread */
+  me::CommandBufferCreateInfo command_buffer_create_info = {};
+  command_buffer_create_info.type = me::STRUCTURE_TYPE_COMMAND_BUFFER_CREATE_INFO;
+  command_buffer_create_info.next = nullptr;
+  command_buffer_create_info.device = scene_renderer->device;
+  command_buffer_create_info.command_pool = nullptr;
+  command_buffer_create_info.usage = me::COMMAND_BUFFER_USAGE_RENDERING;
+  command_buffer_create_info.thread_index = 1 + worker;
+  command_buffer_create_info.secondary = true;
+
+  me::CommandBuffer command_buffer;
+  renderer->create_command_buffers(command_buffer_create_info, 1, &command_buffer);
+  scene_renderer->task_buffers[task] = command_buffer;
+
+  me::CmdRecordSecondaryInfo cmd_record_secondary_info = {};
+  cmd_record_secondary_info.render_pass = scene_renderer->render_pass;
+  cmd_record_secondary_info.framebuffer = scene_renderer->framebuffers[image_index];
+  renderer->cmd_record_secondary_start(cmd_record_secondary_info, command_buffer);
+
+  /* the render pass is timed by the primary, the chunks inside it only from the secondaries */
+  me::ProfileRegion region;
+  renderer->cmd_begin_profile_region("draw chunk", command_buffer, region);
+
+  uint32_t first_draw = task * DRAWS_PER_TASK;
+  uint32_t draw_count = me::math::min(DRAWS_PER_TASK, scene_renderer->instance_batcher.get_batch_count() - first_draw);
+
+  me::CmdDrawListInfo cmd_draw_list_info = {};
+  cmd_draw_list_info.device = scene_renderer->device;
+  cmd_draw_list_info.draw_count = draw_count;
+  cmd_draw_list_info.draws = scene_renderer->instance_batcher.get_batches() + first_draw;
+  cmd_draw_list_info.descriptor_set = 0;
+  cmd_draw_list_info.instance_buffer = scene_renderer->instance_buffers[scene_renderer->frame_index];
+  cmd_draw_list_info.instance_binding = INSTANCE_BINDING;
+  renderer->cmd_draw_list(cmd_draw_list_info, command_buffer);
+
+  renderer->cmd_end_profile_region(region, command_buffer);
+  renderer->cmd_record_stop(command_buffer);
+}
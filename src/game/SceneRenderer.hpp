@@ -2,18 +2,41 @@
   #define SCENE_RENDERER_HPP
 
 #include "../engine/Module.hpp"
+#include "../engine/Logger.hpp"
 #include "../engine/renderer/Renderer.hpp"
+#include "../engine/renderer/Instancing.hpp"
+#include "../engine/scene/Scene.hpp"
+#include "../engine/util/WorkerPool.hpp"
+#include "../engine/util/Profiler.hpp"
 
 #include <lme/vector.hpp>
 #include <lme/math/matrix.hpp>
 
+#include <limits.h>
+
 class SceneRenderer : public me::Module {
 
 protected:
 
   static constexpr uint32_t FRAME_COUNT = 2;
+  static constexpr uint32_t WORKER_COUNT = 4;
+  static constexpr uint32_t DRAWS_PER_TASK = 256;
+  static constexpr size_t DEFRAGMENT_BYTES_PER_FRAME = 4 * 1024 * 1024;
+  static constexpr uint32_t MAX_INSTANCE_COUNT = 16 * 1024;
+  static constexpr uint32_t INSTANCE_BINDING = 1;
+  static constexpr uint32_t OFFSCREEN_WIDTH = 1280;
+  static constexpr uint32_t OFFSCREEN_HEIGHT = 720;
+  static constexpr uint64_t OFFSCREEN_FRAME_LIMIT = 1000; /* frames read back before an offscreen run terminates */
+  static constexpr const char* OFFSCREEN_IMAGE_PATH = "/tmp/murder_engine.offscreen.ppm"; /* the last frame, for image diffs */
+
+  me::Logger logger;
+  me::Profiler* profiler; /* cpu scopes of the tick and the gpu time of the frames */
 
+  me::Scene* scene; /* the mesh items and their geometry are in its arena */
   me::Mesh* mesh;
+  me::vector<me::Mesh*> draw_list; /* meshes of this frame's batches */
+  me::InstanceBatcher instance_batcher; /* the visible mesh items of the scene, batched again every frame */
+  me::DrawListStats draw_list_stats = {}; /* summed over the frames, logged on terminate */
 
   struct UniformBufferObject {
     me::math::mat4f view;
@@ -29,28 +52,74 @@ protected:
   me::Queue present_queue;
   me::Queue transfer_queue;
   me::Swapchain swapchain;
+  me::math::vec2u swapchain_extent;
   me::vector<me::SwapchainImage> swapchain_images;
   me::vector<me::Frame> frames;
   me::RenderPass render_pass;
-  me::Pipeline pipeline;
-  me::vector<me::Framebuffer> framebuffers;
+  me::Pipeline pipeline; /* the culled pipeline once it is built, 'fallback_pipeline' until then */
+  me::Pipeline fallback_pipeline; /* without culling, created before the first frame */
+  me::PipelineBuild pipeline_build;
+  me::PipelineBuildStatus pipeline_build_status;
+  me::vector<me::Framebuffer> framebuffers; /* per swapchain image, nullptr until the image is first rendered to */
   me::DescriptorPool descriptor_pool;
-  me::vector<me::Buffer> uniform_buffers;
+  me::vector<me::Buffer> uniform_buffers; /* per frame in flight, so they don't depend on the swapchain */
+  me::vector<void*> uniform_buffer_data;
   me::vector<me::Descriptor> descriptors;
-  me::CommandPool graphics_command_pool;
+  me::vector<me::Buffer> instance_buffers; /* per frame in flight, written by the instance batcher */
   me::CommandPool transfer_command_pool;
-  me::vector<me::CommandBuffer> draw_command_buffers;
+
+  me::WorkerPool* workers;
+  me::RendererModule* recording_renderer;
+  uint32_t recording_image_index;
+  me::vector<me::CommandBuffer> task_buffers; /* secondary command buffer of each task, executed in task order */
+
+  /* a replaced swapchain is kept until the frames that may still use it are done,
+   * so resizing never waits for the device */
+  struct RetiredSwapchain {
+    me::Swapchain swapchain;
+    me::vector<me::SwapchainImage> images;
+    me::vector<me::Framebuffer> framebuffers;
+    uint64_t retire_frame;
+  };
+
+  me::vector<RetiredSwapchain*> retired_swapchains;
+  me::math::vec2u surface_size; /* framebuffer size of the surface when the swapchain was last created */
+
+  /* an offscreen renderer has no surface, it renders into its own attachments and reads every frame back */
+  bool offscreen;
+  me::vector<me::Attachment> offscreen_attachments; /* color and depth */
+  me::ReadbackRing readback_ring;
+  uint64_t readback_count = 0;
+  uint32_t readback_dropped_count = 0;
 
   uint32_t frame_index = 0;
+  uint64_t frame_number = 0; /* frames rendered */
+
+  char pipeline_cache_path[PATH_MAX]; /* empty to keep the cache in memory only */
 
 public:
 
-  SceneRenderer();
+  /* without 'pipeline_cache_path' the cache is kept in the user's cache directory */
+  explicit SceneRenderer(bool offscreen = false, const char* pipeline_cache_path = nullptr);
 
   int initialize(const me::ModuleInfo) override;
   int terminate(const me::ModuleInfo) override;
   int tick(const me::ModuleInfo) override;
 
+protected:
+
+  /* the framebuffers are created lazily by 'get_framebuffer' */
+  int create_swapchain(me::RendererModule* renderer, me::SurfaceModule* surface_module, me::Swapchain old_swapchain);
+  int recreate_swapchain(me::RendererModule* renderer, me::SurfaceModule* surface_module);
+  /* 'all' also cleans up swapchains that frames may still use */
+  int cleanup_retired_swapchains(me::RendererModule* renderer, bool all);
+  me::Framebuffer get_framebuffer(me::RendererModule* renderer, uint32_t image_index);
+  /* reads the copies of finished frames without waiting, 'finished' once the frame at the limit was read and written out */
+  int poll_readbacks(me::RendererModule* renderer, bool &finished);
+
+  /* records one chunk of the draw list into a secondary command buffer of the worker's frame pool */
+  static void record_task(uint32_t worker, uint32_t task, void* user_data);
+
 };
 
 #endif
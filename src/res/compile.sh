@@ -1,2 +1,3 @@
 glslc shader_test.vert -o vert.spv
 glslc shader_test.frag -o frag.spv
+glslc cull.comp -o cull.spv
@@ -12,36 +12,29 @@ layout(location = 1) in vec3 in_normal;
 layout(location = 2) in vec2 in_tex_coord;
 layout(location = 3) in vec4 in_color;
 
-layout(location = 0) out vec4 frag_color;
-
-vec2 positions[4] = vec2[](
-    vec2(-0.5, -0.5),
-    vec2(0.5, -0.5),
-    vec2(0.5, 0.5),
-    vec2(-0.5, 0.5)
-);
+/* per instance, see 'me::InstanceData'. rotation is in radians around x, y and z */
+layout(location = 4) in vec4 in_instance_position;
+layout(location = 5) in vec4 in_instance_rotation;
+layout(location = 6) in vec4 in_instance_scale;
 
-vec3 colors[4] = vec3[](
-    vec3(1.0, 0.0, 0.0),
-    vec3(1.0, 0.0, 0.0),
-    vec3(1.0, 0.0, 0.0),
-    vec3(1.0, 0.0, 0.0)
-);
+layout(location = 0) out vec4 frag_color;
 
 
+vec3 instance_transform(vec3 position)
+{
+  vec3 s = sin(in_instance_rotation.xyz);
+  vec3 c = cos(in_instance_rotation.xyz);
+  mat3 rotation_x = mat3(1.0, 0.0, 0.0, 0.0, c.x, s.x, 0.0, -s.x, c.x);
+  mat3 rotation_y = mat3(c.y, 0.0, -s.y, 0.0, 1.0, 0.0, s.y, 0.0, c.y);
+  mat3 rotation_z = mat3(c.z, s.z, 0.0, -s.z, c.z, 0.0, 0.0, 0.0, 1.0);
+  return rotation_z * rotation_y * rotation_x * (position * in_instance_scale.xyz) + in_instance_position.xyz;
+}
 
 void main()
 {
   //gl_Position = ubo.proj * ubo.view * ubo.model * vec4(in_position, 1.0F);
   //gl_Position = vec4(in_position, 1.0F);
-  //frag_color = in_color;
-
-  gl_Position = vec4(positions[gl_VertexIndex], 0.0F, 1.0F);
 
-  frag_color = vec4(colors[gl_VertexIndex], 1.0F);
-  if (in_color.x == 1.0)
-  {
-    if (gl_VertexIndex == 2)
-      frag_color = vec4(0.0, 1.0, 0.0, 1.0F);
-  }
+  gl_Position = vec4(instance_transform(in_position).xy, 0.0F, 1.0F);
+  frag_color = in_color;
 }